@@ -44,6 +44,7 @@ ErrnoError Ftruncate(descriptor_t fd_desc, off_t lenght) WARN_UNUSED_RESULT;
 ErrnoError unlink(const std::string& path) WARN_UNUSED_RESULT;
 ErrnoError clear_file_by_descriptor(descriptor_t fd_desc) WARN_UNUSED_RESULT;
 ErrnoError close_descriptor(descriptor_t fd_desc) WARN_UNUSED_RESULT;
+ErrnoError duplicate_descriptor(descriptor_t fd_desc, descriptor_t* out_desc) WARN_UNUSED_RESULT;
 ErrnoError lock_descriptor(descriptor_t fd_desc) WARN_UNUSED_RESULT;
 ErrnoError unlock_descriptor(descriptor_t fd_desc) WARN_UNUSED_RESULT;
 ErrnoError seek_descriptor(descriptor_t fd_desc, off_t offset, int whence) WARN_UNUSED_RESULT;
@@ -0,0 +1,83 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/error.h>  // for ErrnoError
+#include <common/hash/md5.h>
+#include <common/hash/sha1.h>
+#include <common/hash/sha256.h>
+#include <common/types.h>  // for buffer_t
+
+#include <string>
+
+#define CRC64_HASH_LENGHT 8
+
+namespace common {
+namespace hash {
+
+// Streaming hash over md5/sha1/sha256/crc64 with a single interface.
+// Usage:
+//   Digest digest(Digest::SHA256);
+//   digest.Update(chunk1.data(), chunk1.size());
+//   ErrnoError err = digest.UpdateFromDescriptor(fd, nullptr, file_size);
+//   buffer_t result = digest.Final();
+class Digest {
+ public:
+  enum Type { MD5 = 0, SHA1, SHA256, CRC64 };
+
+  explicit Digest(Type type);
+
+  Type GetType() const;
+  // length of Final() result in bytes
+  size_t GetLength() const;
+
+  void Reset();
+  void Update(const void* data, size_t size);
+  void Update(const buffer_t& data);
+  // reads count bytes (or until EOF) through file_system::read_file_cb
+  ErrnoError UpdateFromDescriptor(descriptor_t fd, off_t* offset, size_t count) WARN_UNUSED_RESULT;
+
+  // returns raw digest bytes (crc64 as big endian) and resets the state
+  buffer_t Final();
+  // lower case hex of Final()
+  std::string FinalHex();
+
+ private:
+  const Type type_;
+  union {
+    MD5_CTX md5;
+    SHA1_CTX sha1;
+    SHA256_CTX sha256;
+    uint64_t crc64;
+  } ctx_;
+};
+
+}  // namespace hash
+}  // namespace common
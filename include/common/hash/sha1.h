@@ -30,7 +30,7 @@
 #pragma once
 
 #include <stddef.h>  // for size_t
-#include <stdint.h>  // for uint8_t, uint32_t
+#include <stdint.h>  // for uint8_t, uint32_t, uint64_t
 
 #define SHA1_HASH_LENGTH 20
 #define BLOCK_LENGTH 64
@@ -39,9 +39,9 @@ namespace common {
 namespace hash {
 
 typedef struct SHA1_CTX {
-  uint32_t buffer[BLOCK_LENGTH / 4];
+  uint32_t buffer[BLOCK_LENGTH / 4];  // pending input bytes, in stream order
   uint32_t state[SHA1_HASH_LENGTH / 4];
-  uint32_t byte_count;
+  uint64_t byte_count;
   uint8_t buffer_offset;
   uint8_t key_buffer[BLOCK_LENGTH];
   uint8_t inner_hash[SHA1_HASH_LENGTH];
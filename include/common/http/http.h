@@ -33,6 +33,7 @@
 #include <common/types.h>  // for buffer_t
 #include <common/uri/gurl.h>
 
+#include <array>    // for array
 #include <string>   // for string, basic_string
 #include <utility>  // for pair
 #include <vector>   // for vector
@@ -124,6 +125,77 @@ enum http_protocol { HP_1_0, HP_1_1, HP_2_0 };
 typedef HttpHeader header_t;
 typedef std::vector<header_t> headers_t;
 
+// Well-known header names, interned so that hot lookups are a table index instead of a scan.
+enum http_header_token {
+  HT_UNKNOWN = -1,
+  HT_ACCEPT = 0,
+  HT_ACCEPT_ENCODING,
+  HT_AUTHORIZATION,
+  HT_CACHE_CONTROL,
+  HT_CONNECTION,
+  HT_CONTENT_ENCODING,
+  HT_CONTENT_LENGTH,
+  HT_CONTENT_TYPE,
+  HT_COOKIE,
+  HT_DATE,
+  HT_HOST,
+  HT_KEEP_ALIVE,
+  HT_LOCATION,
+  HT_ORIGIN,
+  HT_RANGE,
+  HT_SEC_WEBSOCKET_ACCEPT,
+  HT_SEC_WEBSOCKET_KEY,
+  HT_SEC_WEBSOCKET_PROTOCOL,
+  HT_SEC_WEBSOCKET_VERSION,
+  HT_SERVER,
+  HT_SET_COOKIE,
+  HT_TRANSFER_ENCODING,
+  HT_UPGRADE,
+  HT_USER_AGENT,
+  HT_COUNT
+};
+
+// Case-insensitive, returns HT_UNKNOWN for names outside of the table.
+http_header_token LookupHeaderToken(const char* name, size_t len);
+http_header_token LookupHeaderToken(const std::string& name);
+const char* GetHeaderTokenName(http_header_token token);
+
+// Ordered header list with a position index for the well-known names.
+// Duplicated names keep the order they arrived in, the index points to the first one.
+class HttpHeaders {
+ public:
+  typedef headers_t::const_iterator const_iterator;
+
+  HttpHeaders();
+  explicit HttpHeaders(const headers_t& headers);
+  explicit HttpHeaders(headers_t&& headers);
+
+  const headers_t& GetHeaders() const;
+  size_t GetSize() const;
+  bool IsEmpty() const;
+  const_iterator begin() const;
+  const_iterator end() const;
+
+  void Add(const header_t& header);
+  void Add(header_t&& header);
+  void Clear();
+
+  // nullptr if not found, pointer is valid until the next modification
+  const header_t* Find(http_header_token token) const;
+  const header_t* Find(const std::string& key, bool case_sensitive) const;
+  const header_t* FindByValue(const std::string& value, bool case_sensitive) const;
+
+  bool Change(const std::string& key, bool case_sensitive, const header_t& new_value);
+  void Remove(const std::string& key, bool case_sensitive);
+
+ private:
+  void Reindex();
+  void IndexAt(size_t pos);
+
+  headers_t headers_;
+  std::array<size_t, HT_COUNT> index_;
+};
+
 class HttpRequest {
  public:
   typedef char_buffer_t body_t;
@@ -135,21 +207,28 @@ class HttpRequest {
               const headers_t& headers,
               const body_t& body);
 
+  HttpRequest(http_method method,
+              const path_t& relative_url,
+              http_protocol protocol,
+              HttpHeaders&& headers,
+              body_t&& body);
+
   http_protocol GetProtocol() const;
-  headers_t GetHeaders() const;
+  const headers_t& GetHeaders() const;
   bool IsValid() const;
 
-  path_t GetRelativeUrl() const;
+  const path_t& GetRelativeUrl() const;
   void SetRelativeUrl(const path_t& path);
 
   uri::GURL GetURL() const;
 
   http::http_method GetMethod() const;
-  body_t GetBody() const;
+  const body_t& GetBody() const;
 
   bool FindHeaderByKeyAndChange(const std::string& key, bool case_sensitive, header_t new_value);
   void RemoveHeaderByKey(const std::string& key, bool case_sensitive);
 
+  const header_t* GetHeader(http_header_token token) const;
   bool FindHeaderByKey(const std::string& key, bool case_sensitive, header_t* hdr) const;
   bool FindHeaderByValue(const std::string& value, bool case_sensitive, header_t* hdr) const;
 
@@ -158,7 +237,7 @@ class HttpRequest {
   path_t relative_url_;
   uri::GURL base_url_;
   http_protocol protocol_;
-  headers_t headers_;
+  HttpHeaders headers_;
   body_t body_;
 };
 
@@ -183,38 +262,33 @@ class HttpResponse {
 
   HttpResponse();
   HttpResponse(http_protocol protocol, http_status status, const headers_t& headers, const char_buffer_t& body);
+  HttpResponse(http_protocol protocol, http_status status, HttpHeaders&& headers, body_t&& body);
 
+  const header_t* GetHeader(http_header_token token) const;
   bool FindHeaderByKey(const std::string& key, bool case_sensitive, header_t* hdr) const;
 
   void SetBody(const body_t& body);
   bool IsEmptyBody() const;
-  body_t GetBody() const;
+  const body_t& GetBody() const;
 
   http_status GetStatus() const;
   http_protocol GetProtocol() const;
-  headers_t GetHeaders() const;
+  const headers_t& GetHeaders() const;
 
  private:
   http_protocol protocol_;
   http_status status_;
-  headers_t headers_;
+  HttpHeaders headers_;
   body_t body_;
 };
 
 Error parse_http_response(const std::string& response, HttpResponse* res_out, size_t* not_parsed) WARN_UNUSED_RESULT;
 
+// Case insensitive lookups in compile time perfect hash tables, nullptr if unknown.
 class MimeTypes {
  public:
   static const char* GetType(const char* path);
   static const char* GetExtension(const char* type);
-
- private:
-  struct entry {
-    const char* fileExtension;
-    const char* mimeType;
-  };
-  static MimeTypes::entry types[348];
-  static int strcmpi(const char* s1, const char* s2);
 };
 
 }  // namespace http
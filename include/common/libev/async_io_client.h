@@ -32,20 +32,24 @@
 #include <common/error.h>
 #include <common/libev/io_base.h>
 #include <common/libev/types.h>
+#include <common/memory/slab_pool.h>
+#include <common/net/buffer_chain.h>
 
 #include <string>
-#include <vector>
 
 namespace common {
 namespace libev {
 
 class IoLoop;
 
-class AsyncIoClient : public IoBase<AsyncIoClient> {
+class AsyncIoClient : public IoBase<AsyncIoClient>, public memory::PoolAllocated {
  public:
   friend class IoLoop;
   typedef IoBase<AsyncIoClient> base_class;
 
+  static const size_t kDefaultWriteLowWatermark = 64 * 1024;     // 64K
+  static const size_t kDefaultWriteHighWatermark = 1024 * 1024;  // 1M
+
   explicit AsyncIoClient(IoLoop* server, flags_t flags = EV_READ);
   ~AsyncIoClient() override;
 
@@ -62,7 +66,14 @@ class AsyncIoClient : public IoBase<AsyncIoClient> {
 
   // Async operations - buffer data and return immediately
   ErrnoError Write(const void* data, size_t size) WARN_UNUSED_RESULT;
-  ErrnoError Read(size_t size) WARN_UNUSED_RESULT;  // Request read, notify when complete
+  ErrnoError Write(char_buffer_t&& buffer) WARN_UNUSED_RESULT;  // queued without copying
+  ErrnoError Read(size_t size) WARN_UNUSED_RESULT;              // Request read, notify when complete
+
+  // Write queue backpressure: OnWriteQueueHigh once pending bytes grow above |high|,
+  // OnWriteQueueLow once they drain back to |low| or below.
+  void SetWriteWatermarks(size_t low, size_t high);
+  size_t GetPendingWriteBytes() const;
+  bool IsWriteQueueFull() const;
 
   // Get available data (non-blocking)
   size_t GetAvailableReadData() const;
@@ -77,6 +88,8 @@ class AsyncIoClient : public IoBase<AsyncIoClient> {
   // Virtual callbacks for completion
   virtual void OnWriteCompleted(size_t bytes_written);
   virtual void OnReadCompleted(size_t bytes_read);
+  virtual void OnWriteQueueHigh(size_t pending_bytes);
+  virtual void OnWriteQueueLow(size_t pending_bytes);
 
  protected:
   virtual descriptor_t GetFd() const = 0;
@@ -88,6 +101,7 @@ class AsyncIoClient : public IoBase<AsyncIoClient> {
   virtual ErrnoError DoClose() WARN_UNUSED_RESULT = 0;
 
   void StartAsyncWriteIfNeeded();
+  void CheckWriteWatermarks();
   void UpdateIoFlags();
 
  protected:
@@ -98,10 +112,13 @@ class AsyncIoClient : public IoBase<AsyncIoClient> {
   size_t read_bytes_;
 
  protected:
-  std::vector<char> write_buffer_;
-  std::vector<char> read_buffer_;
+  net::BufferChain write_buffer_;
+  net::BufferChain read_buffer_;
   size_t read_requested_size_;
   bool is_writing_;
+  size_t write_low_watermark_;
+  size_t write_high_watermark_;
+  bool write_queue_full_;
 
   DISALLOW_COPY_AND_ASSIGN(AsyncIoClient);
 };
@@ -48,6 +48,8 @@ class LibevIO : public LibevBase<struct ev_io, io_id_t> {
   bool Init(LibEvLoop* loop, io_loop_exec_function_t cb, descriptor_t fd, flags_t events) WARN_UNUSED_RESULT;
   void Start();
   void Stop();
+  // Makes the watcher pending with |revents| as if the descriptor reported them, stopping it drops the event.
+  void Feed(flags_t revents);
 
   flags_t GetEvents() const;
   void SetEvents(int events);
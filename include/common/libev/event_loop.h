@@ -31,7 +31,9 @@
 
 #include <common/libev/types.h>
 #include <common/threads/platform_thread.h>
+#include <common/threads/thread_placement.h>
 
+#include <string>
 #include <vector>
 
 struct ev_loop;
@@ -42,6 +44,9 @@ struct ev_async;
 namespace common {
 namespace libev {
 
+class LoopWatchdogState;
+struct LoopWatchdogSettings;
+
 class EvLoopObserver {
  public:
   virtual ~EvLoopObserver();
@@ -61,8 +66,19 @@ class LibEvLoop {
   typedef void child_callback_t(struct ev_loop* loop, fasto_ev_child* watcher, int revents);
 
   LibEvLoop();
+  // Falls back to LOOP_BACKEND_DEFAULT when |backend| isn't available in this process.
+  explicit LibEvLoop(LoopBackend backend);
   virtual ~LibEvLoop();
 
+  // Backend of loops created with the default constructor (e.g. by TcpServer).
+  // Only picks how readiness is waited for, the reads, writes, accepts and sendfile of the clients
+  // stay one syscall each on every backend, LOOP_BACKEND_IOURING included.
+  static void SetDefaultBackend(LoopBackend backend);
+  static LoopBackend GetDefaultBackend();
+  static bool IsBackendSupported(LoopBackend backend);
+
+  LoopBackend GetBackend() const;
+
   void SetObserver(EvLoopObserver* observer);
 
   timer_id_t CreateTimer(double sec, bool repeat);
@@ -78,6 +94,7 @@ class LibEvLoop {
   void InitIO(LibevIO* io, io_callback_t cb, descriptor_t fd, flags_t events);
   void StartIO(LibevIO* io);
   void StopIO(LibevIO* io);
+  void FeedIO(LibevIO* io, flags_t revents);
 
   // timer
   void InitTimer(LibevTimer* timer, timer_callback_t cb, double sec, bool repeat);
@@ -90,18 +107,35 @@ class LibEvLoop {
 
   void ExecInLoopThread(custom_loop_exec_function_t func);
 
+  // Applied by Exec to the thread running the loop, e.g. MakeThreadPlacement(policy, shard) for one loop per shard.
+  void SetPlacement(const threads::ThreadPlacement& placement);
+
   int Exec() WARN_UNUSED_RESULT;
   void Stop();
 
+  // Loop running in the calling thread or nullptr.
+  static LibEvLoop* Current();
+
   bool IsLoopThread() const;
   bool IsRunning() const;  // can be called only in LoopThread
 
+  // Stall/slow callback watchdog (see loop_watchdog.h), must be called before Exec or in the loop thread.
+  void EnableWatchdog(const LoopWatchdogSettings& settings);
+  void DisableWatchdog();
+
+  // Callback dispatch hooks, see ScopedDispatch. BeginDispatch returns 0 if the watchdog is disabled,
+  // EndDispatch returns the callback duration in msec if it was slow and 0 otherwise.
+  uint64_t BeginDispatch(const char* callback) { return watchdog_ ? BeginWatchdogDispatch(callback) : 0; }
+  time64_t EndDispatch(uint64_t started_ns);
+  void ReportSlowCallback(const char* callback, const std::string& target, time64_t duration_msec);
+
  protected:
   explicit LibEvLoop(struct ev_loop* loop);
 
  private:
   void Start();
   class AsyncCustom;
+  class LoopMetrics;
 
   static void stop_cb(LibEvLoop* loop, LibevAsync* async, flags_t revents);
   static void timer_cb(LibEvLoop* loop, LibevTimer* timer, flags_t revents);
@@ -110,15 +144,20 @@ class LibEvLoop {
   void HandleStop();
   void HandleTimer(timer_id_t id);
 
+  uint64_t BeginWatchdogDispatch(const char* callback);
+
   struct ev_loop* loop_;
   EvLoopObserver* observer_;
   threads::platform_thread_id_t exec_id_;
   LibevAsync* async_stop_;
 
   AsyncCustom* async_custom_;
+  LoopMetrics* metrics_;
+  LoopWatchdogState* watchdog_;
 
   std::vector<LibevTimer*> timers_;
   bool is_running_;
+  threads::ThreadPlacement placement_;
 };
 
 }  // namespace libev
@@ -56,6 +56,9 @@ class Http2ServerClient : public HttpServerClient {
                        bool is_keep_alive,
                        const HttpServerInfo& info) override WARN_UNUSED_RESULT;
   ErrnoError SendFileByFd(descriptor_t fdesc, off_t offset, size_t size) override WARN_UNUSED_RESULT;
+  // HTTP/2 data frames are sent synchronously, |done| is called before return.
+  ErrnoError SendFileByFdAsync(descriptor_t fdesc, off_t offset, size_t size, send_file_callback_t done) override
+      WARN_UNUSED_RESULT;
   ErrnoError SendHeaders(common::http::http_protocol protocol,
                          common::http::http_status status,
                          const common::http::headers_t& extra_headers,
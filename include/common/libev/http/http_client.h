@@ -76,6 +76,12 @@ class HttpServerClient : public HttpClient {
                       bool is_keep_alive,
                       const HttpServerInfo& info) WARN_UNUSED_RESULT;
 
+  // Replies with a snapshot of the process metrics in Prometheus text format.
+  ErrnoError SendMetrics(common::http::http_protocol protocol,
+                         const common::http::headers_t& extra_headers,
+                         bool is_keep_alive,
+                         const HttpServerInfo& info) WARN_UNUSED_RESULT;
+
   ErrnoError SendOk(common::http::http_protocol protocol,
                     const common::http::headers_t& extra_headers,
                     const char* text,
@@ -89,6 +95,12 @@ class HttpServerClient : public HttpClient {
                                bool is_keep_alive,
                                const HttpServerInfo& info) WARN_UNUSED_RESULT;
   virtual ErrnoError SendFileByFd(descriptor_t fdesc, off_t offset, size_t size) WARN_UNUSED_RESULT;
+  // Sends the file range without blocking the loop, driven by write readiness. |fdesc| is duplicated, the
+  // caller may close it right away. Nothing else may be written until |done| is called, it may be called
+  // before return and is the last use of the client, so the owner may close and delete it there. A Close()
+  // during the transfer calls |done| with ECANCELED, whoever called Close() deletes the client then.
+  virtual ErrnoError SendFileByFdAsync(descriptor_t fdesc, off_t offset, size_t size, send_file_callback_t done)
+      WARN_UNUSED_RESULT;
   virtual ErrnoError SendHeaders(common::http::http_protocol protocol,
                                  common::http::http_status status,
                                  const common::http::headers_t& extra_headers,
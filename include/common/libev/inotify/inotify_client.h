@@ -35,6 +35,8 @@
 #include <common/libev/descriptor_client.h>
 #include <common/libev/inotify/types.h>
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace common {
@@ -44,10 +46,14 @@ namespace inotify {
 struct InotifyNode {
   descriptor_t fd;
   file_system::ascii_directory_string_path directory;
+  uint32_t mask;    // events requested by the caller
+  bool recursive;  // new subdirectories get their own watch
 };
 
 class IoInotifyClientObserver;
 
+// Watches directories through one non blocking inotify descriptor. The owner calls ProcessRead() when the descriptor
+// is readable and, if coalescing is enabled, ProcessTimer() from IoLoopObserver::TimerEmited.
 class IoInotifyClient : public DescriptorClient {
  public:
   typedef DescriptorClient base_class;
@@ -58,10 +64,48 @@ class IoInotifyClient : public DescriptorClient {
   common::ErrnoError WatchDirectory(const file_system::ascii_directory_string_path& direcotry,
                                     uint32_t mask) WARN_UNUSED_RESULT;
 
+  // Watches |directory| and every subdirectory below it, subdirectories created later are added automatically and
+  // their existing entries are reported as EV_IN_CREATE (if requested by |mask|).
+  common::ErrnoError WatchDirectoryRecursive(const file_system::ascii_directory_string_path& directory,
+                                             uint32_t mask) WARN_UNUSED_RESULT;
+
+  // Changes of one path are merged (masks or-ed) and reported once the path was quiet for |window_msec|, 0 reports
+  // every event immediately (default).
+  void SetCoalescingWindow(time64_t window_msec);
+  time64_t GetCoalescingWindow() const;
+
+  size_t GetWatchesCount() const;
+  size_t GetPendingChangesCount() const;
+
+  // Drains the descriptor until EAGAIN.
   void ProcessRead();
 
+  // Returns false if |id| isn't the coalescing timer of this client.
+  bool ProcessTimer(timer_id_t id);
+
  private:
-  Optional<InotifyNode> FindInotifyNodeByDescriptor(descriptor_t fd) const;
+  struct PendingChange {
+    file_system::ascii_directory_string_path directory;
+    std::string name;
+    bool is_dir;
+    uint32_t mask;
+    time64_t deadline_msec;
+    uint64_t sequence;
+  };
+
+  const InotifyNode* FindInotifyNodeByDescriptor(descriptor_t fd) const;
+
+  common::ErrnoError AddWatch(const file_system::ascii_directory_string_path& directory,
+                              uint32_t mask,
+                              bool recursive,
+                              bool report_entries) WARN_UNUSED_RESULT;
+  void HandleEvent(descriptor_t wd, uint32_t mask, const char* name);
+  void Rescan();
+  void NotifyChange(const file_system::ascii_directory_string_path& directory,
+                    const std::string& name,
+                    bool is_dir,
+                    uint32_t mask);
+  void FlushPendingChanges(bool force);
 
   using base_class::Read;
   using base_class::SingleRead;
@@ -71,7 +115,13 @@ class IoInotifyClient : public DescriptorClient {
   ErrnoError DoClose() override;
 
   IoInotifyClientObserver* client_;
-  std::vector<InotifyNode> watched_directories_;
+  std::unordered_map<descriptor_t, InotifyNode> watches_;
+  std::vector<InotifyNode> recursive_roots_;
+
+  time64_t coalescing_window_msec_;
+  std::unordered_map<std::string, PendingChange> pending_changes_;
+  uint64_t pending_sequence_;
+  timer_id_t flush_timer_;
   DISALLOW_COPY_AND_ASSIGN(IoInotifyClient);
 };
 
@@ -49,6 +49,8 @@ class IoInotifyClientObserver {
                              const std::string& name,
                              bool is_dir,
                              uint32_t mask) = 0;
+  // Kernel queue overflowed and events were lost, watches of recursive trees are already rescanned.
+  virtual void HandleOverflow(IoInotifyClient* client);
   virtual ~IoInotifyClientObserver();
 };
 
@@ -32,19 +32,36 @@
 #include <common/error.h>
 #include <common/libev/io_base.h>
 #include <common/libev/types.h>
+#include <common/memory/slab_pool.h>
 
+#include <functional>
+#include <memory>
 #include <string>
 
 namespace common {
+namespace net {
+class BufferChain;
+class FileTransfer;
+class ReceiveBuffer;
+}
 namespace libev {
 
 class IoLoop;
 
-class IoClient : public IoBase<IoClient> {
+class IoClient : public IoBase<IoClient>, public memory::PoolAllocated {
  public:
   friend class IoLoop;
   typedef IoBase<IoClient> base_class;
 
+  // What happens when the write queue grows beyond its limit.
+  enum SlowConsumerPolicy {
+    SLOW_CONSUMER_NOTIFY,     // keep queueing, WriteQueueHigh/WriteQueueLow are reported to the observer
+    SLOW_CONSUMER_DROP,       // writes which don't fit are refused whole with ENOBUFS
+    SLOW_CONSUMER_DISCONNECT  // the queue is discarded and the connection shut down, ECONNABORTED
+  };
+
+  static const size_t kDefaultWriteQueueLimit = 1024 * 1024;  // 1M
+
   explicit IoClient(IoLoop* server, flags_t flags = EV_READ);
   ~IoClient() override;
 
@@ -65,12 +82,53 @@ class IoClient : public IoBase<IoClient> {
   ErrnoError SingleWrite(const void* data, size_t size, size_t* nwrite_out) WARN_UNUSED_RESULT;
   ErrnoError SingleRead(void* out_data, size_t max_size, size_t* nread_out) WARN_UNUSED_RESULT;
 
+  // Queued write mode for non blocking descriptors: Write and SingleWrite send what the descriptor takes and
+  // queue the rest (|nwrite_out| counts queued bytes too), the queue drains on write readiness. Once more than
+  // |max_pending| bytes are queued |policy| applies; WriteQueueLow is reported at half of the limit.
+  void EnableWriteQueue(size_t max_pending = kDefaultWriteQueueLimit,
+                        SlowConsumerPolicy policy = SLOW_CONSUMER_NOTIFY);
+  bool IsWriteQueueEnabled() const;
+  size_t GetPendingWriteBytes() const;
+  bool IsWriteQueueFull() const;
+  // Writes queued data until the descriptor would block, called by IoLoop on write readiness.
+  ErrnoError FlushWriteQueue() WARN_UNUSED_RESULT;
+
+  // Library managed receive buffer: ReadToBuffer appends whatever is available with a single read, the
+  // protocol parses GetReadBuffer() in place and consumes what it handled, partial messages stay buffered.
+  ErrnoError ReadToBuffer(size_t* nread_out) WARN_UNUSED_RESULT;
+  char* GetReadBuffer();
+  const char* GetReadBuffer() const;
+  size_t GetReadBufferSize() const;
+  void ConsumeReadBuffer(size_t size);
+  // Reports DataReceived again in this loop iteration without a socket event, for protocols which handle
+  // one message per call while complete messages are still buffered.
+  void ScheduleBufferedRead();
+
   ErrnoError SendFile(descriptor_t file_fd, off_t offset, size_t file_size) WARN_UNUSED_RESULT;
 
+  // Called once the async send finished, |err| is set on failure or cancel.
+  typedef std::function<void(ErrnoError err, size_t sent)> send_file_callback_t;
+  // Non blocking send of a file range, driven by write readiness of the loop
+  // in bounded chunks. The descriptor must be non blocking, |done| may be
+  // called before return. DataReadyToWrite isn't reported while it runs.
+  ErrnoError SendFileAsync(descriptor_t file_fd, off_t offset, size_t file_size, send_file_callback_t done)
+      WARN_UNUSED_RESULT;
+  bool IsSendingFile() const;
+
+  // Set by the protocol layer from the start of a request until its reply is handed over, e.g. while the
+  // reply is computed on a thread pool; a draining server doesn't close the client meanwhile.
+  void SetRequestInFlight(bool in_flight);
+  bool IsRequestInFlight() const;
+  // Bytes which arrived on the descriptor but weren't read yet, 0 when it can't tell.
+  size_t GetUnreadBytes() const;
+
   ErrnoError SetBlocking(bool block) WARN_UNUSED_RESULT;
 
  protected:  // executed IoLoop
   virtual descriptor_t GetFd() const = 0;
+  // True when file data may be written to GetFd() directly (sendfile/splice),
+  // otherwise SendFileAsync copies through DoSingleWrite (e.g. TLS).
+  virtual bool IsZeroCopySendSupported() const;
 
  private:
   virtual ErrnoError DoSingleWrite(const void* data, size_t size, size_t* nwrite_out) WARN_UNUSED_RESULT = 0;
@@ -78,11 +136,27 @@ class IoClient : public IoBase<IoClient> {
   virtual ErrnoError DoSendFile(descriptor_t file_fd, off_t offset, size_t file_size) WARN_UNUSED_RESULT = 0;
   virtual ErrnoError DoClose() WARN_UNUSED_RESULT = 0;
 
+  void ContinueSendFile();
+  void FinishSendFile(ErrnoError err);
+  void SetWriteWatching(bool enable);
+
+  ErrnoError QueueWrite(const void* data, size_t size, size_t* nwrite_out) WARN_UNUSED_RESULT;
+  ErrnoError CheckWriteQueue() WARN_UNUSED_RESULT;
+  void HandleWriteReady();
+
   IoLoop* server_;
   LibevIO* read_write_io_;
   flags_t flags_;
   size_t wrote_bytes_;
   size_t read_bytes_;
+  std::unique_ptr<net::ReceiveBuffer> read_buffer_;
+  std::unique_ptr<net::BufferChain> write_queue_;
+  size_t write_queue_limit_;
+  SlowConsumerPolicy slow_consumer_policy_;
+  bool write_queue_full_;
+  std::unique_ptr<net::FileTransfer> file_transfer_;
+  send_file_callback_t file_transfer_done_;
+  bool request_in_flight_;
   DISALLOW_COPY_AND_ASSIGN(IoClient);
 };
 
@@ -31,6 +31,9 @@
 
 #include <common/libev/event_loop.h>
 #include <common/libev/io_base.h>
+#include <common/memory/slab_pool.h>
+
+#include <atomic>
 
 namespace common {
 namespace libev {
@@ -49,6 +52,11 @@ class IoLoop : public EvLoopObserver, public IoBase<IoLoop> {
   int Exec() WARN_UNUSED_RESULT;
   virtual void Stop();
 
+  // Serve clients, watchers and socket holders created in the loop thread (e.g. by TcpServer::CreateClient)
+  // from per-loop slab pools instead of the global heap. Must be called before Exec.
+  void SetObjectPoolsEnabled(bool enabled);
+  std::vector<memory::SlabPoolStats> GetObjectPoolsStats() const;
+
   virtual bool IsCanBeRegistered(IoClient* client) const WARN_UNUSED_RESULT = 0;
 
   bool RegisterClient(IoClient* client) WARN_UNUSED_RESULT;
@@ -93,6 +101,7 @@ class IoLoop : public EvLoopObserver, public IoBase<IoLoop> {
 
  private:
    static void read_write_cb(LibEvLoop* loop, LibevIO* io, flags_t revents);
+   static void read_write_async_cb(LibEvLoop* loop, LibevIO* io, flags_t revents);
    void ReadWrite(LibEvLoop* loop, IoClient* client, flags_t revents);
    void ReadWriteAsync(LibEvLoop* loop, AsyncIoClient* client, flags_t revents);
 
@@ -108,6 +117,10 @@ protected:
   const patterns::id_counter<IoLoop> id_;
 
   std::string name_;
+
+ private:
+  bool pools_enabled_;
+  std::atomic<memory::SlabPools*> pools_;
 };
 
 }  // namespace libev
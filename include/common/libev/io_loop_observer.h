@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <common/error.h>
 #include <common/libev/types.h>
 
 namespace common {
@@ -57,9 +58,15 @@ class IoLoopObserver {
 
   virtual void DataReceived(IoClient* client) = 0;
   virtual void DataReadyToWrite(IoClient* client) = 0;
+  virtual void WriteQueueHigh(IoClient* client, size_t pending_bytes);  // slow consumer, see EnableWriteQueue
+  virtual void WriteQueueLow(IoClient* client, size_t pending_bytes);
+  // The queued data could not be sent and was discarded, e.g. the peer reset the connection.
+  virtual void WriteQueueFailed(IoClient* client, ErrnoError err);
 
   virtual void AsyncDataWriteCompleted(AsyncIoClient* client, size_t bytes_written) = 0;
   virtual void AsyncDataReadCompleted(AsyncIoClient* client, size_t bytes_read) = 0;
+  virtual void AsyncWriteQueueHigh(AsyncIoClient* client, size_t pending_bytes);  // stop producing
+  virtual void AsyncWriteQueueLow(AsyncIoClient* client, size_t pending_bytes);   // producing can resume
 
   virtual void PostLooped(IoLoop* server) = 0;
 
@@ -0,0 +1,116 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/error.h>
+#include <common/libev/types.h>
+#include <common/macros.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace common {
+namespace libev {
+
+class IoClient;
+class IoLoop;
+
+// Continuation style reads, writes and sleeps on an IoClient, for framed protocols which would otherwise keep a
+// hand-rolled state machine across partial reads. Data is collected in the client receive buffer and handed to the
+// callback in place once the request is complete, so a frame split over any number of reads is seen whole.
+//
+// All calls and callbacks happen in the loop thread. The owner feeds the stream from its IoLoopObserver:
+// OnDataReceived() from DataReceived() and OnTimer() from TimerEmited(). A callback may issue the next request, it is
+// served from the buffer after the callback returns, without recursion. Only one read is pending at a time and the
+// stream must not be destroyed from its own callbacks. Destroying the stream fails pending requests with ECANCELED.
+class IoStream {
+ public:
+  typedef std::function<void(ErrnoError err, const char* data, size_t size)> read_callback_t;
+  typedef std::function<void(ErrnoError err)> done_callback_t;
+
+  static const size_t kDefaultMaxReadUntil = 64 * 1024;  // 64K
+
+  explicit IoStream(IoClient* client);
+  ~IoStream();
+
+  IoClient* GetClient() const;
+  bool IsReadPending() const;
+
+  // |data| is valid until the callback returns and consumed from the buffer afterwards.
+  void ReadExactly(size_t size, read_callback_t done);
+  // Completes with everything up to and including |delimiter|, fails with EMSGSIZE if |max_size| bytes arrive
+  // without it.
+  void ReadUntil(const std::string& delimiter, read_callback_t done, size_t max_size = kDefaultMaxReadUntil);
+
+  // Enables the client write queue on first use, so the whole buffer is either sent or queued.
+  ErrnoError Write(const void* data, size_t size) WARN_UNUSED_RESULT;
+
+  // One-shot loop timer, needs a client which belongs to a loop.
+  void Sleep(time64_t milliseconds, done_callback_t done);
+
+  // Pulls what the descriptor has into the buffer and completes the pending read. A read error or the peer closing
+  // the connection (ECONNRESET) fails the pending read and is returned.
+  ErrnoError OnDataReceived() WARN_UNUSED_RESULT;
+  // Returns true if |id| is one of the stream sleep timers.
+  bool OnTimer(timer_id_t id);
+
+  // Fails the pending read and all sleeps with |err|.
+  void Cancel(ErrnoError err);
+
+ private:
+  enum ReadKind { READ_NONE, READ_EXACTLY, READ_UNTIL };
+
+  struct Sleeper {
+    timer_id_t id;
+    done_callback_t done;
+  };
+
+  void DispatchRead();
+  // True if the pending read can finish now, with |size| buffered bytes or with |err|.
+  bool CompleteRead(size_t* size, ErrnoError* err);
+  void FailRead(ErrnoError err);
+
+  IoClient* const client_;
+
+  ReadKind read_kind_;
+  size_t read_size_;
+  std::string read_delimiter_;
+  read_callback_t read_done_;
+  size_t delimiter_scanned_;
+  bool dispatching_;
+
+  std::vector<Sleeper> sleepers_;
+
+  DISALLOW_COPY_AND_ASSIGN(IoStream);
+};
+
+}  // namespace libev
+}  // namespace common
@@ -0,0 +1,175 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/libev/io_loop.h>
+#include <common/libev/io_stream.h>
+#include <common/string_piece.h>
+
+// Coroutine front end of IoStream for translation units built as C++20, the library itself stays C++17:
+//
+//   coro::IoTask ServeFrames(IoStream* stream) {
+//     coro::IoReadResult header = co_await coro::ReadExactly(stream, 2);
+//     ...
+//   }
+//
+// Coroutines start in the calling thread and are resumed from IoStream callbacks or ExecInLoopThread(), so a task
+// started in the loop thread only ever runs there.
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define HAVE_IO_TASK_COROUTINES 1
+#endif
+#endif
+
+#if defined(HAVE_IO_TASK_COROUTINES)
+#include <coroutine>
+#include <exception>
+#include <string>
+
+namespace common {
+namespace libev {
+namespace coro {
+
+// Detached task: runs eagerly until the first suspension and frees itself when it finishes.
+class IoTask {
+ public:
+  struct promise_type {
+    IoTask get_return_object() { return IoTask(); }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// |data| points into the client receive buffer and stays valid until the coroutine suspends again.
+struct IoReadResult {
+  ErrnoError err;
+  StringPiece data;
+};
+
+namespace detail {
+
+class ReadAwaiter {
+ public:
+  bool await_ready() const { return false; }
+  IoReadResult await_resume() const { return result_; }
+
+ protected:
+  IoStream::read_callback_t Resumer(std::coroutine_handle<> handle) {
+    return [this, handle](ErrnoError err, const char* data, size_t size) {
+      result_.err = err;
+      result_.data = StringPiece(data, size);
+      handle.resume();
+    };
+  }
+
+  IoReadResult result_;
+};
+
+}  // namespace detail
+
+class ReadExactly : public detail::ReadAwaiter {
+ public:
+  ReadExactly(IoStream* stream, size_t size) : stream_(stream), size_(size) {}
+
+  void await_suspend(std::coroutine_handle<> handle) { stream_->ReadExactly(size_, Resumer(handle)); }
+
+ private:
+  IoStream* const stream_;
+  const size_t size_;
+};
+
+class ReadUntil : public detail::ReadAwaiter {
+ public:
+  ReadUntil(IoStream* stream, std::string delimiter, size_t max_size = IoStream::kDefaultMaxReadUntil)
+      : stream_(stream), delimiter_(std::move(delimiter)), max_size_(max_size) {}
+
+  void await_suspend(std::coroutine_handle<> handle) { stream_->ReadUntil(delimiter_, Resumer(handle), max_size_); }
+
+ private:
+  IoStream* const stream_;
+  const std::string delimiter_;
+  const size_t max_size_;
+};
+
+// Writes never suspend, the data is sent or queued on the client right away.
+class Write {
+ public:
+  Write(IoStream* stream, const void* data, size_t size) : err_(stream->Write(data, size)) {}
+  Write(IoStream* stream, StringPiece data) : Write(stream, data.data(), data.size()) {}
+
+  bool await_ready() const { return true; }
+  void await_suspend(std::coroutine_handle<>) {}
+  ErrnoError await_resume() const { return err_; }
+
+ private:
+  const ErrnoError err_;
+};
+
+class Sleep {
+ public:
+  Sleep(IoStream* stream, time64_t milliseconds) : stream_(stream), milliseconds_(milliseconds) {}
+
+  bool await_ready() const { return false; }
+  void await_suspend(std::coroutine_handle<> handle) {
+    stream_->Sleep(milliseconds_, [this, handle](ErrnoError err) {
+      err_ = err;
+      handle.resume();
+    });
+  }
+  ErrnoError await_resume() const { return err_; }
+
+ private:
+  IoStream* const stream_;
+  const time64_t milliseconds_;
+  ErrnoError err_;
+};
+
+// Continues the coroutine in the loop thread of |loop|, immediately if it is already running there.
+class ExecInLoopThread {
+ public:
+  explicit ExecInLoopThread(IoLoop* loop) : loop_(loop) {}
+
+  bool await_ready() const { return loop_->IsLoopThread(); }
+  void await_suspend(std::coroutine_handle<> handle) {
+    loop_->ExecInLoopThread([handle]() { handle.resume(); });
+  }
+  void await_resume() const {}
+
+ private:
+  IoLoop* const loop_;
+};
+
+}  // namespace coro
+}  // namespace libev
+}  // namespace common
+#endif
@@ -0,0 +1,102 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <common/libev/event_loop.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace common {
+namespace libev {
+
+struct SlowCallbackInfo {
+  std::string callback;  // kind of callback, e.g. "read_write"
+  std::string target;    // formated name of the client/child the callback was dispatched for
+  time64_t duration_msec;
+};
+
+struct LoopStallInfo {
+  std::string callback;  // kind of callback the loop thread is stuck in
+  time64_t stalled_msec;
+  std::vector<std::string> stack;  // frames of the stuck thread, empty if capture is unsupported
+};
+
+struct LoopWatchdogSettings {
+  typedef std::function<void(const SlowCallbackInfo&)> slow_callback_handler_t;
+  typedef std::function<void(const LoopStallInfo&)> stall_handler_t;
+
+  LoopWatchdogSettings();
+
+  time64_t slow_callback_msec;  // report callbacks running longer, 0 disables
+  time64_t stall_timeout_msec;  // report loops stuck in one callback longer, 0 disables
+  // Signal the stuck thread and capture its stack (Linux/macOS only). The first watchdog with it enabled
+  // installs a process wide SIGURG handler; nothing is installed and no stack captured when the
+  // application already handles SIGURG itself, disable it if SIGURG is installed later.
+  bool capture_stack;
+
+  // Called in the loop thread, logs a warning if not set.
+  slow_callback_handler_t on_slow_callback;
+  // Called in the watchdog thread, logs an error if not set. Must not enable/disable watchdogs.
+  stall_handler_t on_stall;
+};
+
+// Marks a callback dispatch on a loop. describe() runs only when the watchdog is enabled, and it runs
+// before the callback, because callbacks may destroy their client.
+template <typename Describe>
+class ScopedDispatch {
+ public:
+  ScopedDispatch(LibEvLoop* loop, const char* callback, Describe describe)
+      : loop_(loop), callback_(callback), target_(), started_ns_(loop->BeginDispatch(callback)) {
+    if (started_ns_) {
+      target_ = describe();
+    }
+  }
+
+  ~ScopedDispatch() {
+    if (started_ns_) {
+      const time64_t slow_msec = loop_->EndDispatch(started_ns_);
+      if (slow_msec) {
+        loop_->ReportSlowCallback(callback_, target_, slow_msec);
+      }
+    }
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ScopedDispatch);
+
+  LibEvLoop* const loop_;
+  const char* const callback_;
+  std::string target_;
+  const uint64_t started_ns_;
+};
+
+}  // namespace libev
+}  // namespace common
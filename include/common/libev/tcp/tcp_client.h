@@ -53,6 +53,7 @@ class TcpClient : public IoClient {
 
  protected:
   descriptor_t GetFd() const override;
+  bool IsZeroCopySendSupported() const override;
 
  private:
   ErrnoError DoSingleWrite(const void* data, size_t size, size_t* nwrite_out) override WARN_UNUSED_RESULT;
@@ -54,11 +54,28 @@ class TcpServer : public IoLoop {
   using IoLoop::RegisterClient;
   IoClient* RegisterClient(const net::socket_info& info, void* user) WARN_UNUSED_RESULT;
 
+  // Stops accepting and lets connected clients finish: idle clients are closed right away, busy ones once
+  // they become idle, the rest when |timeout_msec| elapses. Then the loop stops. Can be called from any thread.
+  // Protocols answering after DataReceived returned mark the client with IoClient::SetRequestInFlight.
+  void Drain(time64_t timeout_msec);
+  bool IsDraining() const;
+
+#if defined(OS_POSIX)
+  // Zero downtime restart: passes the listening socket to the process on the other end of |unix_sock|, which
+  // serves it with ServerSocketEvTcp(host, fd) while this server drains.
+  ErrnoError SendListener(net::socket_descr_t unix_sock) const WARN_UNUSED_RESULT;
+  static ErrnoError ReceiveListener(net::socket_descr_t unix_sock, net::socket_descr_t* listening_fd)
+      WARN_UNUSED_RESULT;
+#endif
+
   static IoLoop* FindExistServerByHost(const net::HostAndPort& host);
 
  protected:
   net::IServerSocketEv* GetSocket() const;
 
+  // Client has nothing in progress and may be closed while draining.
+  virtual bool IsClientIdle(IoClient* client) const;
+
  private:
   virtual IoClient* CreateClient(const net::socket_info& info, void* user);
   IoChild* CreateChild() override;
@@ -66,6 +83,10 @@ class TcpServer : public IoLoop {
   void PostLooped(LibEvLoop* loop) override;
 
   void Stopped(LibEvLoop* loop) override;
+  void TimerEmited(LibEvLoop* loop, timer_id_t id) override;
+
+  void StartDrain(time64_t timeout_msec);
+  void CheckDrain();
 
   static void accept_cb(LibEvLoop* loop, LibevIO* io, int revents);
 
@@ -73,6 +94,10 @@ class TcpServer : public IoLoop {
 
   const std::unique_ptr<net::IServerSocketEv> sock_;
   LibevIO* accept_io_;
+
+  std::atomic<bool> draining_;
+  time64_t drain_deadline_msec_;
+  timer_id_t drain_timer_;
 };
 
 }  // namespace tcp
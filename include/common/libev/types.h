@@ -30,8 +30,11 @@
 #pragma once
 
 #include <common/macros.h>                 // for DISALLOW_COPY_AND_ASSIGN
+#include <common/memory/slab_pool.h>       // for PoolAllocated
 #include <common/patterns/crtp_pattern.h>  // for id_counter
 
+#include <string.h>  // for memset
+
 #include <functional>  // for function
 
 #define INVALID_TIMER_ID -1
@@ -90,25 +93,32 @@ enum {
 
 typedef int flags_t;
 
+// Kernel readiness mechanism of a loop, watchers stay level triggered whatever is used.
+enum LoopBackend {
+  LOOP_BACKEND_DEFAULT = 0,  // best one libev recommends for the platform
+  LOOP_BACKEND_SELECT,
+  LOOP_BACKEND_POLL,
+  LOOP_BACKEND_EPOLL,
+  LOOP_BACKEND_KQUEUE,
+  LOOP_BACKEND_IOURING  // linux 5.1+, only the polls go through the ring, reads and writes stay syscalls
+};
+
 typedef intmax_t timer_id_t;
 typedef uintmax_t io_id_t;
 typedef uintmax_t async_id_t;
 typedef uintmax_t child_id_t;
 
 template <typename handle_t, typename id_t>
-class LibevBase : public patterns::id_counter<LibevBase<handle_t, id_t>, id_t> {
+class LibevBase : public patterns::id_counter<LibevBase<handle_t, id_t>, id_t>, public memory::PoolAllocated {
  public:
   typedef void* user_data_t;
-  LibevBase() : handle_(static_cast<handle_t*>(calloc(1, sizeof(handle_t)))), user_data_(nullptr) {
-    if (handle_) {
-      handle_->data = this;
-    }
+  LibevBase() : handle_(static_cast<handle_t*>(memory::PoolAllocate(sizeof(handle_t)))), user_data_(nullptr) {
+    memset(handle_, 0, sizeof(handle_t));
+    handle_->data = this;
   }
   ~LibevBase() {
-    if (handle_) {
-      free(handle_);
-      handle_ = nullptr;
-    }
+    memory::PoolFree(handle_);
+    handle_ = nullptr;
   }
   handle_t* GetHandle() const { return handle_; }
   void SetUserData(user_data_t user_data) { user_data_ = user_data; }
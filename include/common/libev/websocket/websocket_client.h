@@ -85,7 +85,6 @@ class WebSocketServerClient : public WebSocketClient {
   ErrnoError SendPong() WARN_UNUSED_RESULT;
 
   frame_t frame_;
-  size_t ntoread_;
   WsStep step_;
 };
 
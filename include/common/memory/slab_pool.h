@@ -0,0 +1,142 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <common/macros.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+namespace common {
+namespace memory {
+
+struct SlabPoolStats {
+  SlabPoolStats();
+
+  size_t object_size;
+  size_t slabs;
+  size_t objects_in_use;
+  size_t objects_free;
+  uint64_t allocations;
+  uint64_t remote_frees;
+};
+
+// Fixed size objects carved out of large slabs and recycled through a free list.
+// Allocate/Deallocate are owner thread only, DeallocateRemote may be called from any thread and is
+// reclaimed by the owner on a later Allocate.
+class SlabPool {
+ public:
+  SlabPool(size_t object_size, size_t objects_per_slab);
+  ~SlabPool();
+
+  void* Allocate();
+  void Deallocate(void* ptr);
+  void DeallocateRemote(void* ptr);
+
+  SlabPoolStats GetStats() const;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SlabPool);
+
+  struct FreeNode {
+    FreeNode* next;
+  };
+
+  void Grow();
+  bool ReclaimRemote();
+
+  const size_t object_size_;
+  const size_t objects_per_slab_;
+  std::vector<char*> slabs_;
+  FreeNode* free_list_;
+  std::atomic<FreeNode*> remote_free_;
+
+  std::atomic<size_t> in_use_;
+  std::atomic<size_t> free_;
+  std::atomic<uint64_t> allocations_;
+  std::atomic<uint64_t> remote_frees_;
+};
+
+// Size class pools for one thread (usually an IoLoop). Objects are returned to the pools they came from,
+// the pools stay alive until Release() was called and every object handed out was freed.
+class SlabPools {
+ public:
+  enum : size_t { kGranularity = 16, kMaxObjectSize = 2048, kClassesCount = kMaxObjectSize / kGranularity };
+  enum : size_t { kSlabBytes = 64 * 1024 };
+
+  SlabPools();
+
+  void* Allocate(size_t size);  // thread for which the pools are current only, size <= kMaxObjectSize
+  void Release();
+
+  std::vector<SlabPoolStats> GetStats() const;  // non-empty classes
+
+  // Pools serving PoolAllocate in the calling thread, nullptr if allocations go to the heap.
+  static SlabPools* Current();
+
+  class ScopedCurrent {
+   public:
+    explicit ScopedCurrent(SlabPools* pools);
+    ~ScopedCurrent();
+
+   private:
+    DISALLOW_COPY_AND_ASSIGN(ScopedCurrent);
+    SlabPools* const previous_;
+  };
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SlabPools);
+  friend void PoolFree(void* ptr);
+
+  ~SlabPools();
+
+  void Free(void* slot, size_t size_class);
+  void Unref();
+
+  std::atomic<SlabPool*> pools_[kClassesCount];
+  std::atomic<size_t> refs_;
+};
+
+// Allocates from SlabPools::Current() when set, from the heap otherwise. Memory must be freed with PoolFree,
+// which may be called from any thread.
+void* PoolAllocate(size_t size);
+void PoolFree(void* ptr);
+
+// Routes new/delete of derived classes through PoolAllocate/PoolFree.
+class PoolAllocated {
+ public:
+  static void* operator new(size_t size) { return PoolAllocate(size); }
+  static void operator delete(void* ptr) { PoolFree(ptr); }
+};
+
+}  // namespace memory
+}  // namespace common
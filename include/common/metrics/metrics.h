@@ -0,0 +1,211 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <common/macros.h>
+#include <common/patterns/singleton_pattern.h>
+
+#include <stdint.h>
+
+#if defined(COMPILER_MSVC)
+#include <intrin.h>
+#endif
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace common {
+namespace metrics {
+
+enum { kCacheLineSize = 64, kCounterShards = 16 };
+
+// Monotonic clock reading used for latency measurements.
+uint64_t MonotonicNowNs();
+
+// Stable per-thread shard index in [0, kCounterShards).
+size_t CurrentShard();
+
+inline unsigned HighestBitIndex(uint64_t value) {
+#if defined(COMPILER_MSVC)
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return index;
+#else
+  return 63 - __builtin_clzll(value);
+#endif
+}
+
+enum metric_t { METRIC_COUNTER = 0, METRIC_GAUGE, METRIC_HISTOGRAM };
+
+class Metric {
+ public:
+  virtual ~Metric();
+
+  metric_t GetType() const;
+  const std::string& GetName() const;
+  const std::string& GetHelp() const;
+
+ protected:
+  Metric(metric_t type, const std::string& name, const std::string& help);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(Metric);
+
+  const metric_t type_;
+  const std::string name_;
+  const std::string help_;
+};
+
+// Monotonically increasing value, sharded per thread so concurrent writers do not share a cache line.
+class Counter : public Metric {
+ public:
+  Counter(const std::string& name, const std::string& help);
+
+  void Increment(uint64_t delta = 1) { shards_[CurrentShard()].value.fetch_add(delta, std::memory_order_relaxed); }
+
+  uint64_t GetValue() const;
+
+ private:
+  struct alignas(kCacheLineSize) Shard {
+    std::atomic<uint64_t> value;
+  };
+
+  Shard shards_[kCounterShards];
+};
+
+// Value which can go up and down (queue depth, connections).
+class Gauge : public Metric {
+ public:
+  Gauge(const std::string& name, const std::string& help);
+
+  void Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  void Add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+  void Sub(int64_t delta) { value_.fetch_sub(delta, std::memory_order_relaxed); }
+  void Increment() { Add(1); }
+  void Decrement() { Sub(1); }
+
+  int64_t GetValue() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<int64_t> value_;
+};
+
+struct HistogramSnapshot {
+  HistogramSnapshot();
+
+  // Smallest recorded bucket upper bound covering quantile q in [0, 1].
+  uint64_t ValueAtQuantile(double q) const;
+
+  uint64_t count;
+  uint64_t sum;
+  std::vector<uint64_t> buckets;
+};
+
+// Log-linear (HDR style) histogram: every power of two is split into kSubBuckets linear buckets,
+// so a recorded value keeps ~12% relative precision over the whole uint64_t range.
+class Histogram : public Metric {
+ public:
+  enum {
+    kSubBucketBits = 3,
+    kSubBuckets = 1 << kSubBucketBits,
+    kBucketsCount = (64 - kSubBucketBits + 1) * kSubBuckets
+  };
+
+  // export_scale converts recorded units for exposition, e.g. 1e-9 for nanoseconds reported as seconds.
+  Histogram(const std::string& name, const std::string& help, double export_scale);
+
+  void Record(uint64_t value) {
+    buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  double GetExportScale() const;
+  HistogramSnapshot TakeSnapshot() const;
+
+  static size_t BucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+      return static_cast<size_t>(value);
+    }
+    const unsigned shift = HighestBitIndex(value) - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + ((value >> shift) & (kSubBuckets - 1));
+  }
+  static uint64_t BucketUpperBound(size_t index);
+
+ private:
+  const double export_scale_;
+  std::atomic<uint64_t> buckets_[kBucketsCount];
+  std::atomic<uint64_t> sum_;
+};
+
+// Records the time between construction and destruction into a histogram in nanoseconds.
+class ScopedLatency {
+ public:
+  explicit ScopedLatency(Histogram* histogram) : histogram_(histogram), start_(MonotonicNowNs()) {}
+  ~ScopedLatency() { histogram_->Record(MonotonicNowNs() - start_); }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ScopedLatency);
+
+  Histogram* const histogram_;
+  const uint64_t start_;
+};
+
+// Process wide metrics. Metrics are created on first lookup and are never freed, so callers cache the
+// returned pointers (lookups take a mutex) and may record from static destructors.
+class MetricsRegistry : public patterns::TSSingleton<MetricsRegistry> {
+ public:
+  friend class patterns::TSSingleton<MetricsRegistry>;
+  static constexpr double kNanosecondsToSeconds = 1e-9;
+
+  Counter* GetCounter(const std::string& name, const std::string& help);
+  Gauge* GetGauge(const std::string& name, const std::string& help);
+  Histogram* GetHistogram(const std::string& name, const std::string& help, double export_scale = 1.0);
+  Histogram* GetLatencyHistogram(const std::string& name, const std::string& help);
+
+  // Prometheus text exposition format (version 0.0.4), histograms are exported as summaries.
+  std::string ExportPrometheus() const;
+
+ private:
+  MetricsRegistry();
+  ~MetricsRegistry();
+
+  Metric* FindMetric(const std::string& name, metric_t type) const;
+
+  mutable std::mutex metrics_mutex_;
+  std::map<std::string, std::unique_ptr<Metric>> metrics_;
+};
+
+}  // namespace metrics
+}  // namespace common
+
+#define METRICS() common::metrics::MetricsRegistry::GetInstance()
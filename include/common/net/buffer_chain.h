@@ -0,0 +1,108 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/error.h>
+#include <common/net/socket_info.h>
+#include <common/types.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace common {
+namespace net {
+
+// Byte queue made of segments, so that consuming from the front never moves
+// the remaining data. Small writes are packed into pooled fixed size blocks,
+// large caller buffers are adopted as they are. The socket helpers drain the
+// queue with a single writev() and read straight into free tail space with
+// readv().
+class BufferChain {
+ public:
+  static const size_t kBlockSize = 16 * 1024;  // 16K
+  static const size_t kMaxSpareBlocks = 8;
+  static const size_t kMaxIovecs = 64;
+  static const size_t kAdoptThreshold = 1024;  // smaller buffers are cheaper to copy
+
+  BufferChain();
+  ~BufferChain();
+
+  size_t GetSize() const;
+  bool IsEmpty() const;
+  size_t GetSegmentsCount() const;
+
+  void Append(const void* data, size_t size);
+  // Takes |buffer| storage over without copying it.
+  void Append(char_buffer_t&& buffer);
+
+  size_t Peek(void* out, size_t size) const;
+  size_t Read(void* out, size_t size);
+  void Consume(size_t size);
+  void Clear();
+
+  // EAGAIN/EWOULDBLOCK are returned as errors, nothing is consumed then.
+  ErrnoError WriteToSocket(socket_descr_t fd, size_t* nwrite_out) WARN_UNUSED_RESULT;
+  // Reads at most |max_size| bytes, ECONNRESET on orderly shutdown like read_from_socket.
+  ErrnoError ReadFromSocket(socket_descr_t fd, size_t max_size, size_t* nread_out) WARN_UNUSED_RESULT;
+
+ private:
+  typedef std::unique_ptr<char[]> block_t;
+
+  struct Segment {
+    Segment();
+    explicit Segment(block_t&& block);
+    explicit Segment(char_buffer_t&& buffer);
+
+    char* GetData();
+    const char* GetData() const;
+    bool IsPooled() const;
+    size_t GetSize() const;
+    size_t GetFreeSpace() const;
+
+    block_t block;
+    char_buffer_t adopted;
+    size_t capacity;
+    size_t head;
+    size_t tail;
+  };
+
+  block_t TakeBlock();
+  void ReturnBlock(block_t&& block);
+
+  std::deque<Segment> segments_;
+  std::vector<block_t> spare_blocks_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferChain);
+};
+
+}  // namespace net
+}  // namespace common
@@ -0,0 +1,101 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/error.h>
+#include <common/net/socket_info.h>
+#include <sys/types.h>
+
+#include <functional>
+#include <vector>
+
+namespace common {
+namespace net {
+
+// Resumable transfer of a file range to a socket, suitable for non blocking
+// sockets: every Step() moves at most one bounded chunk and reports EAGAIN
+// when the socket can't take more, the caller waits for write readiness and
+// calls Step() again.
+//
+// Zero copy is used where possible: sendfile() for regular files and splice()
+// through a pipe for other descriptors (pipes, sockets, devices) on Linux.
+// Everything else (TLS sockets, other platforms) goes through a bounded
+// read buffer and |writer|.
+class FileTransfer {
+ public:
+  typedef std::function<ErrnoError(const void* data, size_t size, size_t* nwrite_out)> write_function_t;
+  enum TransferMode { SENDFILE = 0, SPLICE, COPY };
+  static const size_t kDefaultChunkSize = 256 * 1024;  // 256K
+
+  // Zero copy into |out_fd|.
+  FileTransfer(descriptor_t file_fd, off_t offset, size_t size, socket_descr_t out_fd);
+  // Buffered copy through |writer|, e.g. for TLS sockets.
+  FileTransfer(descriptor_t file_fd, off_t offset, size_t size, write_function_t writer);
+  ~FileTransfer();
+
+  TransferMode GetMode() const;
+  size_t GetSent() const;
+  size_t GetLeft() const;
+  bool IsDone() const;
+
+  // Sends at most |max_chunk| bytes, |*nsent| may be less. Returns an EAGAIN
+  // error when the output is full (nothing is lost, just call again later).
+  ErrnoError Step(size_t max_chunk, size_t* nsent) WARN_UNUSED_RESULT;
+  // Loops Step() until done, for blocking sockets.
+  ErrnoError Run(size_t max_chunk = kDefaultChunkSize) WARN_UNUSED_RESULT;
+
+ private:
+  void Init();
+  ErrnoError StepSendFile(size_t count, size_t* nsent);
+  ErrnoError StepSplice(size_t count, size_t* nsent);
+  ErrnoError StepCopy(size_t count, size_t* nsent);
+
+  const descriptor_t file_fd_;
+  off_t offset_;
+  size_t left_;
+  size_t sent_;
+  const socket_descr_t out_fd_;
+  write_function_t writer_;
+  TransferMode mode_;
+  bool seekable_;
+
+  // splice: bytes already moved from the file into the pipe
+  descriptor_t pipe_[2];
+  size_t in_pipe_;
+
+  // copy: bytes read from the file but not written yet
+  std::vector<char> buffer_;
+  size_t buffer_pos_;
+
+  DISALLOW_COPY_AND_ASSIGN(FileTransfer);
+};
+
+}  // namespace net
+}  // namespace common
@@ -35,12 +35,21 @@
 #include <common/net/types.h>
 #include <common/uri/gurl.h>
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 namespace common {
 namespace net {
 
 class IHttpClient {
  public:
   typedef std::string url_t;
+  // Receives the decoded body piece by piece, an error aborts the read.
+  typedef std::function<ErrnoError(const char* data, size_t size)> body_callback_t;
   virtual ErrnoError Connect(struct timeval* tv = nullptr) WARN_UNUSED_RESULT = 0;
   virtual bool IsConnected() const = 0;
   virtual ErrnoError Disconnect() WARN_UNUSED_RESULT = 0;
@@ -53,18 +62,41 @@ class IHttpClient {
   Error Get(const url_t& path, const http::headers_t& extra_headers) WARN_UNUSED_RESULT;
   Error Head(const url_t& path, const http::headers_t& extra_headers) WARN_UNUSED_RESULT;
 
+  // Reads exactly one response, the body is framed by Content-Length or
+  // chunked encoding so that the connection can carry the next request.
   Error ReadResponse(http::HttpResponse* response) WARN_UNUSED_RESULT;
+  // Same, but the body is passed to |on_body| as it arrives instead of being
+  // stored in |response|.
+  Error ReadResponse(http::HttpResponse* response, body_callback_t on_body) WARN_UNUSED_RESULT;
+  Error ReadResponseToDescriptor(http::HttpResponse* response, descriptor_t fd) WARN_UNUSED_RESULT;
+
+  // True when the last response was read completely and the server did not
+  // ask to close the connection.
+  bool IsKeepAlive() const;
+
   virtual ~IHttpClient();
 
  protected:
   explicit IHttpClient(net::ISocket* sock);
   net::ISocket* GetSocket() const;
+  // Drops the state of the previous connection, call on connect/disconnect.
+  void ResetReadState();
 
  private:
   Error SendRequest(const http::HttpRequest& request_headers) WARN_UNUSED_RESULT;
+  Error ReadResponseHeaders(http::HttpResponse* response) WARN_UNUSED_RESULT;
+  Error ReadBodyByLength(size_t body_len, const body_callback_t& on_body) WARN_UNUSED_RESULT;
+  Error ReadBodyChunked(const body_callback_t& on_body) WARN_UNUSED_RESULT;
+  Error ReadBodyUntilClose(const body_callback_t& on_body) WARN_UNUSED_RESULT;
+  // Appends the next portion from the socket to |read_buffer_|, 0 bytes means
+  // the peer closed the connection.
+  ErrnoError FillReadBuffer(size_t* nread) WARN_UNUSED_RESULT;
 
   net::ISocket* sock_;
   Optional<http::HttpRequest> last_request_;
+  // Received but not consumed bytes, may hold the start of the next response.
+  char_buffer_t read_buffer_;
+  bool keep_alive_;
 };
 
 class HttpClient : public IHttpClient {
@@ -76,6 +108,41 @@ class HttpClient : public IHttpClient {
   ErrnoError SendFile(descriptor_t file_fd, off_t offset, size_t file_size) override;
 
   HostAndPort GetHost() const override;
+
+  // Keep-alive connection which the server has not closed in the meantime.
+  bool IsReusable() const;
+};
+
+// Keeps idle keep-alive connections per host, thread safe.
+// Usage:
+//   std::unique_ptr<HttpClient> cl;
+//   ErrnoError errn = pool.Acquire(host, &cl);
+//   ... cl->Get(path, {}) / cl->ReadResponse(&resp) ...
+//   pool.Release(std::move(cl));
+// A server can still close an idle connection right after it was handed out,
+// retry a failed first request on a fresh connection.
+class HttpClientPool {
+ public:
+  typedef std::unique_ptr<HttpClient> client_t;
+  static const size_t kDefaultMaxIdlePerHost = 4;
+
+  explicit HttpClientPool(size_t max_idle_per_host = kDefaultMaxIdlePerHost);
+  ~HttpClientPool();
+
+  // Hands out an idle connection to |host| or connects a new one.
+  ErrnoError Acquire(const HostAndPort& host, client_t* client, struct timeval* tv = nullptr) WARN_UNUSED_RESULT;
+  // Takes |client| back, it is closed unless it can carry another request.
+  void Release(client_t client);
+
+  size_t GetIdleCount(const HostAndPort& host) const;
+  void Clear();
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(HttpClientPool);
+
+  const size_t max_idle_per_host_;
+  mutable std::mutex idle_mutex_;
+  std::map<std::string, std::vector<client_t>> idle_;
 };
 
 Error GetHttpFile(const uri::GURL& url,
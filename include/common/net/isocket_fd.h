@@ -48,6 +48,11 @@ class ISocketFd : public ISocket {
 #endif
 
   ErrnoError SendFile(descriptor_t file_fd, off_t offset, size_t file_size) WARN_UNUSED_RESULT;
+  // False when written bytes are transformed on the way (TLS), file data
+  // can't be passed to the descriptor with sendfile/splice then.
+  virtual bool IsZeroCopySendSupported() const;
+  // False when received bytes must be decoded first (TLS), GetFd() can't be read directly then.
+  virtual bool IsRawReadSupported() const;
 
   bool IsValid() const override;
 
@@ -55,12 +55,18 @@ ErrnoError connect(const socket_info& info, struct timeval* timeout, socket_info
 ErrnoError close(socket_descr_t fd) WARN_UNUSED_RESULT;
 
 ErrnoError set_blocking_socket(socket_descr_t sock, bool blocking) WARN_UNUSED_RESULT;
+// Bytes received by the kernel which weren't read yet (FIONREAD).
+ErrnoError get_unread_bytes(socket_descr_t sock, size_t* nbytes_out) WARN_UNUSED_RESULT;
 
 #if defined(OS_POSIX)
 ErrnoError write_ev_to_socket(socket_descr_t fd, const struct iovec* iovec, int count, size_t* nwritten_out);
 ErrnoError read_ev_to_socket(socket_descr_t fd, const struct iovec* iovec, int count, size_t* nread_out);
 ErrnoError write_to_socket(socket_descr_t fd, const void* data, size_t size, size_t* nwritten_out) WARN_UNUSED_RESULT;
 ErrnoError read_from_socket(socket_descr_t fd, void* buf, size_t size, size_t* nread_out) WARN_UNUSED_RESULT;
+
+// Passes a duplicate of |fd| over a connected unix domain socket (SCM_RIGHTS).
+ErrnoError send_descriptor(socket_descr_t unix_sock, descriptor_t fd) WARN_UNUSED_RESULT;
+ErrnoError recv_descriptor(socket_descr_t unix_sock, descriptor_t* fd_out) WARN_UNUSED_RESULT;
 #endif
 
 ErrnoError write_to_tcp_socket(socket_descr_t fd, const void* data, size_t size, size_t* nwritten_out)
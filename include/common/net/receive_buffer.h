@@ -0,0 +1,81 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/macros.h>
+
+#include <stddef.h>
+
+#include <memory>
+
+namespace common {
+namespace net {
+
+// Contiguous receive buffer: the socket reads into free tail space, the
+// protocol parses the unconsumed region in place and marks what it used.
+// Consumed bytes at the front are reclaimed by compaction before growing,
+// capacity grows in whole blocks and is released when the buffer drains.
+class ReceiveBuffer {
+ public:
+  static const size_t kBlockSize = 16 * 1024;        // 16K
+  static const size_t kMaxIdleCapacity = 64 * 1024;  // kept after draining
+
+  ReceiveBuffer();
+  ~ReceiveBuffer();
+
+  // Unconsumed bytes.
+  const char* GetData() const;
+  char* GetData();
+  size_t GetSize() const;
+  bool IsEmpty() const;
+
+  size_t GetCapacity() const;
+  size_t GetFreeSpace() const;
+
+  // Returns tail space of at least |min_size| bytes to read into, compacts or grows when needed.
+  char* PrepareWrite(size_t min_size, size_t* available_out);
+  void CommitWrite(size_t size);
+
+  void Consume(size_t size);
+  void Clear();
+
+ private:
+  void Reserve(size_t min_free);
+
+  std::unique_ptr<char[]> data_;
+  size_t capacity_;
+  size_t head_;
+  size_t tail_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReceiveBuffer);
+};
+
+}  // namespace net
+}  // namespace common
@@ -29,13 +29,14 @@
 
 #pragma once
 
+#include <common/memory/slab_pool.h>
 #include <common/net/isocket_fd.h>
 #include <common/net/types.h>
 
 namespace common {
 namespace net {
 
-class TcpSocketHolder : public ISocketFd {
+class TcpSocketHolder : public ISocketFd, public memory::PoolAllocated {
  public:
   explicit TcpSocketHolder(const socket_info& info);
   explicit TcpSocketHolder(socket_descr_t fd);
@@ -103,6 +104,9 @@ class ServerSocketTcp : public TcpSocketHolder {
   typedef TcpSocketHolder base_class;
 
   explicit ServerSocketTcp(const HostAndPort& host);
+  // Serves a listening socket inherited from another process (see recv_descriptor), Bind adopts it
+  // instead of binding a new one and |host| only provides its address family.
+  ServerSocketTcp(const HostAndPort& host, socket_descr_t listening_fd);
 
   HostAndPort GetHost() const;
 
@@ -117,6 +121,7 @@ class ServerSocketTcp : public TcpSocketHolder {
   using TcpSocketHolder::WriteBuffer;
 
   HostAndPort host_;
+  socket_descr_t inherited_fd_;
 
   DISALLOW_COPY_AND_ASSIGN(ServerSocketTcp);
 };
@@ -124,6 +129,7 @@ class ServerSocketTcp : public TcpSocketHolder {
 class ServerSocketEvTcp : public IServerSocketEv {
  public:
   ServerSocketEvTcp(const HostAndPort& host);
+  ServerSocketEvTcp(const HostAndPort& host, socket_descr_t listening_fd);
 
   socket_descr_t GetFd() const override;
 
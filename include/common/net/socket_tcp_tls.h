@@ -30,14 +30,52 @@
 #pragma once
 
 #include <common/net/socket_tcp.h>
+#include <common/patterns/singleton_pattern.h>
+
+#include <map>
+#include <mutex>
+#include <string>
 
 typedef struct ssl_st SSL;
 typedef struct ssl_ctx_st SSL_CTX;
+typedef struct ssl_session_st SSL_SESSION;
 
 namespace common {
 namespace net {
 
 #if defined(HAVE_OPENSSL)
+// Sessions of ClientSocketTcpTls connections keyed by host, later connects to the same host resume them.
+class TlsClientSessionCache : public patterns::LazySingleton<TlsClientSessionCache> {
+ public:
+  friend class patterns::LazySingleton<TlsClientSessionCache>;
+  enum { kMaxSessions = 1024 };
+
+  void Put(const HostAndPort& host, SSL_SESSION* session);  // takes over the reference
+  SSL_SESSION* Get(const HostAndPort& host) const;           // new reference or nullptr
+  void Remove(const HostAndPort& host);
+  void Clear();
+  size_t GetSize() const;
+
+ private:
+  TlsClientSessionCache();
+  ~TlsClientSessionCache();
+
+  mutable std::mutex mutex_;
+  std::map<std::string, SSL_SESSION*> sessions_;
+};
+
+struct TlsServerSettings {
+  TlsServerSettings();
+
+  size_t session_cache_size;  // session id cache entries, 0 disables it
+  long session_timeout_sec;
+  bool session_tickets;
+  // Ticket keys are random per process unless set (80 bytes), share them between processes serving the same
+  // listener (e.g. after TcpServer::SendListener) to keep issued tickets valid.
+  char_buffer_t ticket_keys;
+  bool kernel_tls;  // kTLS offload when OpenSSL and the kernel support it, makes SendFile real sendfile
+};
+
 class TcpTlsSocketHolder : public TcpSocketHolder {
  public:
   typedef TcpSocketHolder base_class;
@@ -48,6 +86,12 @@ class TcpTlsSocketHolder : public TcpSocketHolder {
   socket_descr_t GetFd() const override;
 
   bool IsValid() const override;
+  // True once the kernel does the record encryption (kTLS), plain data may then go to GetFd() directly.
+  bool IsZeroCopySendSupported() const override;
+  // Alerts and handshake records still come through SSL_read, even with kTLS.
+  bool IsRawReadSupported() const override;
+
+  bool IsSessionReused() const;
 
  protected:
   void SetSSL(SSL* ssl);
@@ -88,11 +132,18 @@ class ClientSocketTcpTls : public SocketTcpTls {
 
   explicit ClientSocketTcpTls(const HostAndPort& host);
 
+  // Resumes sessions through TlsClientSessionCache, on by default. Both must be set before Connect.
+  void SetSessionResumption(bool enabled);
+  void SetKernelTlsEnabled(bool enabled);
+
   ErrnoError Connect(struct timeval* tv = nullptr) WARN_UNUSED_RESULT;
   ErrnoError Disconnect() WARN_UNUSED_RESULT;
   bool IsConnected() const;
 
  private:
+  bool session_resumption_;
+  bool kernel_tls_;
+
   DISALLOW_COPY_AND_ASSIGN(ClientSocketTcpTls);
 };
 
@@ -103,6 +154,8 @@ class ServerSocketTcpTls : public ServerSocketTcp {
   explicit ServerSocketTcpTls(const HostAndPort& host);
 
   ErrnoError LoadCertificates(const std::string& cert, const std::string& key);
+  // Applied to the current and to later loaded contexts.
+  ErrnoError SetSettings(const TlsServerSettings& settings) WARN_UNUSED_RESULT;
 
   ErrnoError Accept(socket_info* info, SSL** out) WARN_UNUSED_RESULT;
 
@@ -110,6 +163,7 @@ class ServerSocketTcpTls : public ServerSocketTcp {
 
  private:
   SSL_CTX* ctx_;
+  TlsServerSettings settings_;
 
   DISALLOW_COPY_AND_ASSIGN(ServerSocketTcpTls);
 };
@@ -131,6 +185,7 @@ class ServerSocketEvTcpTls : public IServerSocketEv {
   ErrnoError Accept(socket_info* info, void** user) override WARN_UNUSED_RESULT;
 
   ErrnoError LoadCertificates(const std::string& cert, const std::string& key);
+  ErrnoError SetSettings(const TlsServerSettings& settings) WARN_UNUSED_RESULT;
 
  private:
   ServerSocketTcpTls sock_;
@@ -0,0 +1,136 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#if defined(OS_LINUX)
+
+#include <common/error.h>
+#include <common/time.h>
+#include <sys/types.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace common {
+namespace process {
+
+struct ProcessSample {
+  time64_t timestamp_msec = 0;  // UTC
+  time64_t user_cpu_msec = 0;   // cumulative
+  time64_t system_cpu_msec = 0;
+  double cpu_usage = 0;  // percent of one core since the previous sample
+  size_t rss_bytes = 0;
+  size_t pss_bytes = 0;  // 0 unless sampled, see SetSamplePss()
+  uint64_t voluntary_context_switches = 0;
+  uint64_t involuntary_context_switches = 0;
+  uint64_t read_bytes = 0;  // storage I/O, cumulative
+  uint64_t write_bytes = 0;
+  size_t threads_count = 0;
+  size_t open_fds = 0;  // without the sampler's own descriptors when it samples its own process
+};
+
+struct ThreadSample {
+  pid_t tid = 0;
+  char name[16] = {0};
+  time64_t cpu_msec = 0;  // cumulative user and system time
+  double cpu_usage = 0;   // percent of one core since the previous sample
+};
+
+// Samples /proc/<pid> at a fixed interval from a background thread into a ring buffer. The /proc files stay open and
+// are parsed in place, so a steady state sample doesn't allocate (only a new thread of the process does). Snapshot
+// accessors copy under a short lock and can be called from any thread, e.g. by health endpoints.
+// The sampler holds up to six descriptors of its own plus one per thread of the process for the first 64 threads,
+// the stat files of further threads are reopened on every sample.
+class ProcessSampler {
+ public:
+  explicit ProcessSampler(pid_t pid, size_t history_size = 60);
+  ~ProcessSampler();
+
+  // Must be called before Start().
+  void SetSampleThreads(bool enabled);
+  // PSS comes from smaps_rollup, the kernel walks the page tables for it, so it is off by default.
+  void SetSamplePss(bool enabled);
+
+  // Opens the /proc files and starts sampling every |interval_msec|, the first sample is taken before returning.
+  ErrnoError Start(time64_t interval_msec) WARN_UNUSED_RESULT;
+  void Stop();
+
+  // Takes one sample in the calling thread, for callers which drive sampling themselves (without Start()). The files
+  // are opened on first use.
+  bool Sample();
+
+  bool GetLatest(ProcessSample* sample) const WARN_UNUSED_RESULT;
+  // Oldest first, at most |history_size| samples.
+  std::vector<ProcessSample> GetHistory() const;
+  // Threads as seen by the latest sample.
+  std::vector<ThreadSample> GetThreads() const;
+
+ private:
+  class Files;
+  struct ThreadState;
+
+  ErrnoError OpenFiles();
+  bool SampleThreads(uint64_t elapsed_ns);
+  void Run(time64_t interval_msec);
+
+  const pid_t pid_;
+  bool sample_threads_;
+  bool sample_pss_;
+
+  // Used by the sampling thread only.
+  std::unique_ptr<Files> files_;
+  std::unordered_map<pid_t, std::unique_ptr<ThreadState>> thread_states_;
+  size_t thread_files_;  // thread stat files kept open
+  uint64_t generation_;
+  uint64_t last_sample_ns_;
+  time64_t last_cpu_msec_;
+  std::vector<ThreadSample> threads_scratch_;
+
+  mutable std::mutex mutex_;
+  std::vector<ProcessSample> history_;  // ring buffer
+  size_t history_head_;
+  size_t history_count_;
+  std::vector<ThreadSample> threads_;
+
+  std::condition_variable stop_condition_;
+  bool stop_;
+  std::thread thread_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProcessSampler);
+};
+
+}  // namespace process
+}  // namespace common
+
+#endif
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <common/libev/io_client.h>
+#include <common/metrics/metrics.h>
 #include <common/protocols/json_rpc/json_rpc.h>
 #include <common/text_decoders/iedcoder.h>
 
@@ -41,6 +42,9 @@ ErrnoError WriteResponse(libev::IoClient* client,
                          IEDcoder* compressor,
                          const JsonRPCResponse& response) WARN_UNUSED_RESULT;
 ErrnoError ReadCommand(libev::IoClient* client, IEDcoder* compressor, std::string* out) WARN_UNUSED_RESULT;
+
+metrics::Gauge* InFlightRequestsGauge();
+metrics::Histogram* RequestRoundTripHistogram();
 }  // namespace detail
 
 template <typename Client>
@@ -55,13 +59,24 @@ class ProtocolClient : public Client {
 
   template <typename... Args>
   explicit ProtocolClient(compressor_t compressor, Args... args)
-      : base_class(args...), compressor_(compressor), id_(0) {}
+      : base_class(args...),
+        compressor_(compressor),
+        id_(0),
+        in_flight_(detail::InFlightRequestsGauge()),
+        round_trip_(detail::RequestRoundTripHistogram()) {}
+
+  ~ProtocolClient() override { in_flight_->Sub(requests_queue_.size()); }
 
   ErrnoError WriteRequest(const JsonRPCRequest& request, callback_t cb = callback_t()) WARN_UNUSED_RESULT {
     // INFO_LOG() << "WriteRequest: " << request.ToString();
     ErrnoError err = detail::WriteRequest(this, compressor_.get(), request);
     if (!err && !request.IsNotification()) {
-      requests_queue_[request.id] = std::make_pair(request, cb);
+      pending_request_t& pending = requests_queue_[request.id];
+      if (!pending.sent_ns) {
+        in_flight_->Increment();
+      }
+      pending.entry = std::make_pair(request, cb);
+      pending.sent_ns = metrics::MonotonicNowNs();
     }
     return err;
   }
@@ -85,12 +100,14 @@ class ProtocolClient : public Client {
       return false;
     }
 
-    request_save_entry_t it = found_it->second;
-    *req = it.first;
+    const pending_request_t& pending = found_it->second;
+    round_trip_->Record(metrics::MonotonicNowNs() - pending.sent_ns);
+    *req = pending.entry.first;
     if (cb) {
-      *cb = it.second;
+      *cb = pending.entry.second;
     }
     requests_queue_.erase(found_it);
+    in_flight_->Decrement();
     return true;
   }
 
@@ -103,9 +120,18 @@ class ProtocolClient : public Client {
   }
 
  private:
+  struct pending_request_t {
+    pending_request_t() : entry(), sent_ns(0) {}
+
+    request_save_entry_t entry;
+    uint64_t sent_ns;
+  };
+
   const compressor_t compressor_;
-  std::map<json_rpc_id, request_save_entry_t> requests_queue_;
+  std::map<json_rpc_id, pending_request_t> requests_queue_;
   seq_id_t id_;
+  metrics::Gauge* const in_flight_;
+  metrics::Histogram* const round_trip_;
   using Client::Read;
   using Client::Write;
 };
@@ -0,0 +1,272 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <common/string_piece.h>
+
+namespace common {
+
+template <typename T>
+struct StaticStringMapEntry {
+  const char* key;
+  T value;
+};
+
+namespace internal {
+
+constexpr char StaticToLowerASCII(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+constexpr size_t StaticStringLength(const char* str) {
+  size_t len = 0;
+  while (str[len]) {
+    ++len;
+  }
+  return len;
+}
+
+constexpr bool StaticEqualsCaseInsensitiveASCII(const char* left, const char* right, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (StaticToLowerASCII(left[i]) != StaticToLowerASCII(right[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr bool StaticEqualsASCII(const char* left, const char* right, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (left[i] != right[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// FNV-1a of the lower cased key with the murmur3 finaliser, so that every seed gives an independent hash.
+constexpr uint32_t StaticStringHash(const char* str, size_t len, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+  for (size_t i = 0; i < len; ++i) {
+    hash ^= static_cast<unsigned char>(StaticToLowerASCII(str[i]));
+    hash *= 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6Bu;
+  hash ^= hash >> 13;
+  hash *= 0xC2B2AE35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+constexpr size_t StaticTableSize(size_t count) {
+  size_t size = 1;
+  while (size < count) {
+    size <<= 1;
+  }
+  return size;
+}
+
+}  // namespace internal
+
+// Read-only string keyed map built at compile time as a two level perfect hash (hash and displace): the first hash
+// picks a bucket, the bucket stores the seed of a second hash, or directly the slot of its only key, which lands on a
+// slot owned by exactly one key. A lookup is two hashes of the key and one compare, without probing or allocation.
+//
+// Keys hash case-insensitively, so Find() ignores ASCII case and FindCaseSensitive() compares exactly. Keys which
+// differ only in case are duplicates, the first one wins. Declare maps constexpr and check them with
+// static_assert(map.IsPerfect()) so that a failed build shows up at compile time:
+//
+//   constexpr StaticStringMapEntry<http_method> kMethods[] = {{"GET", HM_GET}, {"HEAD", HM_HEAD}};
+//   constexpr auto kMethodsMap = MakeStaticStringMap(kMethods);
+//   static_assert(kMethodsMap.IsPerfect(), "method table has no perfect hash");
+template <typename T, size_t N>
+class StaticStringMap {
+ public:
+  typedef StaticStringMapEntry<T> entry_t;
+
+  static constexpr size_t kSlotsCount = internal::StaticTableSize(N);
+  static constexpr size_t kBucketsCount = kSlotsCount > 1 ? kSlotsCount / 2 : 1;
+  static_assert(N > 0 && N < 32768, "unsupported number of keys");
+
+  constexpr explicit StaticStringMap(const entry_t (&entries)[N])
+      : entries_(), lengths_(), seeds_(), slots_(), perfect_(false) {
+    for (size_t i = 0; i < N; ++i) {
+      entries_[i] = entries[i];
+      lengths_[i] = internal::StaticStringLength(entries[i].key);
+    }
+    for (size_t i = 0; i < kSlotsCount; ++i) {
+      slots_[i] = -1;
+    }
+    perfect_ = Build();
+  }
+
+  constexpr bool IsPerfect() const { return perfect_; }
+  constexpr size_t size() const { return N; }
+
+  const T* Find(const StringPiece& key) const {
+    const entry_t* entry = Lookup(key);
+    if (!entry || !internal::StaticEqualsCaseInsensitiveASCII(entry->key, key.data(), key.size())) {
+      return nullptr;
+    }
+    return &entry->value;
+  }
+
+  const T* FindCaseSensitive(const StringPiece& key) const {
+    const entry_t* entry = Lookup(key);
+    if (!entry || !internal::StaticEqualsASCII(entry->key, key.data(), key.size())) {
+      return nullptr;
+    }
+    return &entry->value;
+  }
+
+ private:
+  static constexpr int32_t kMaxSeed = 1 << 16;
+  static constexpr size_t kMaxBucketKeys = 16;
+
+  static constexpr size_t BucketOf(const char* key, size_t len) {
+    return internal::StaticStringHash(key, len, 0) & (kBucketsCount - 1);
+  }
+
+  static constexpr size_t SlotOf(const char* key, size_t len, uint32_t seed) {
+    return internal::StaticStringHash(key, len, seed) & (kSlotsCount - 1);
+  }
+
+  const entry_t* Lookup(const StringPiece& key) const {
+    const int32_t seed = seeds_[BucketOf(key.data(), key.size())];
+    if (seed == 0) {
+      return nullptr;
+    }
+    const size_t slot = seed < 0 ? static_cast<size_t>(-seed - 1) : SlotOf(key.data(), key.size(), seed);
+    const int16_t index = slots_[slot];
+    if (index < 0 || lengths_[index] != key.size()) {
+      return nullptr;
+    }
+    return &entries_[index];
+  }
+
+  constexpr bool IsSameKey(size_t left, size_t right) const {
+    return lengths_[left] == lengths_[right] &&
+           internal::StaticEqualsCaseInsensitiveASCII(entries_[left].key, entries_[right].key, lengths_[left]);
+  }
+
+  constexpr bool Build() {
+    // group the keys by bucket, in table order so that the first of duplicate keys is kept
+    size_t starts[kBucketsCount + 1] = {};
+    size_t buckets[N] = {};
+    for (size_t i = 0; i < N; ++i) {
+      buckets[i] = BucketOf(entries_[i].key, lengths_[i]);
+      starts[buckets[i] + 1]++;
+    }
+    for (size_t b = 0; b < kBucketsCount; ++b) {
+      starts[b + 1] += starts[b];
+    }
+    size_t members[N] = {};
+    size_t filled[kBucketsCount] = {};
+    size_t counts[kBucketsCount] = {};
+    size_t max_count = 0;
+    for (size_t i = 0; i < N; ++i) {
+      const size_t b = buckets[i];
+      bool duplicate = false;
+      for (size_t j = starts[b]; j < starts[b] + filled[b]; ++j) {
+        duplicate = duplicate || IsSameKey(members[j], i);
+      }
+      if (!duplicate) {
+        members[starts[b] + filled[b]++] = i;
+        counts[b] = filled[b];
+        max_count = counts[b] > max_count ? counts[b] : max_count;
+      }
+    }
+
+    // largest buckets first, while the table is still empty
+    for (size_t count = max_count; count > 1; --count) {
+      for (size_t b = 0; b < kBucketsCount; ++b) {
+        if (counts[b] == count && !PlaceBucket(members + starts[b], count, &seeds_[b])) {
+          return false;
+        }
+      }
+    }
+
+    // single keys take any free slot directly
+    size_t free_slot = 0;
+    for (size_t b = 0; b < kBucketsCount; ++b) {
+      if (counts[b] != 1) {
+        continue;
+      }
+      while (slots_[free_slot] >= 0) {
+        ++free_slot;
+      }
+      slots_[free_slot] = static_cast<int16_t>(members[starts[b]]);
+      seeds_[b] = -static_cast<int32_t>(free_slot) - 1;
+    }
+    return true;
+  }
+
+  constexpr bool PlaceBucket(const size_t* members, size_t count, int32_t* seed_out) {
+    if (count > kMaxBucketKeys) {
+      return false;
+    }
+    for (int32_t seed = 1; seed < kMaxSeed; ++seed) {
+      size_t slots[kMaxBucketKeys] = {};
+      bool placed = true;
+      for (size_t i = 0; placed && i < count; ++i) {
+        slots[i] = SlotOf(entries_[members[i]].key, lengths_[members[i]], seed);
+        placed = slots_[slots[i]] < 0;
+        for (size_t j = 0; placed && j < i; ++j) {
+          placed = slots[j] != slots[i];
+        }
+      }
+      if (placed) {
+        for (size_t i = 0; i < count; ++i) {
+          slots_[slots[i]] = static_cast<int16_t>(members[i]);
+        }
+        *seed_out = seed;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  entry_t entries_[N];
+  size_t lengths_[N];
+  int32_t seeds_[kBucketsCount];  // 0 for an empty bucket, a second level seed or -(slot + 1) of the only key
+  int16_t slots_[kSlotsCount];    // entry index or -1
+  bool perfect_;
+};
+
+template <typename T, size_t N>
+constexpr StaticStringMap<T, N> MakeStaticStringMap(const StaticStringMapEntry<T> (&entries)[N]) {
+  return StaticStringMap<T, N>(entries);
+}
+
+}  // namespace common
@@ -79,6 +79,39 @@ string16 NumberToString16(float value, int prec);
 std::string NumberToString(double value, int prec);
 string16 NumberToString16(double value, int prec);
 
+// Shortest representation which parses back to exactly |value| via
+// StringToDouble()/StringToFloat(), e.g. 0.1 -> "0.1", 1e21 -> "1e+21".
+std::string NumberToString(float value);
+std::string NumberToString(double value);
+
+// Allocation free variants of the above, they write into a caller supplied
+// buffer and return the number of characters written, or 0 when |out| is too
+// small (nothing useful is written then). kMaxNumberChars is always enough,
+// except for the fixed notation of huge values with a big |prec|.
+constexpr size_t kMaxNumberChars = 32;
+size_t ToChars(span<char> out, int value);
+size_t ToChars(span<char> out, unsigned int value);
+size_t ToChars(span<char> out, long value);
+size_t ToChars(span<char> out, unsigned long value);
+size_t ToChars(span<char> out, long long value);
+size_t ToChars(span<char> out, unsigned long long value);
+size_t ToChars(span<char> out, float value);
+size_t ToChars(span<char> out, double value);
+size_t ToChars(span<char> out, float value, int prec);
+size_t ToChars(span<char> out, double value, int prec);
+
+// Appends the same text as NumberToString() to |*out|, reusing its capacity.
+void AppendToString(std::string* out, int value);
+void AppendToString(std::string* out, unsigned int value);
+void AppendToString(std::string* out, long value);
+void AppendToString(std::string* out, unsigned long value);
+void AppendToString(std::string* out, long long value);
+void AppendToString(std::string* out, unsigned long long value);
+void AppendToString(std::string* out, float value);
+void AppendToString(std::string* out, double value);
+void AppendToString(std::string* out, float value, int prec);
+void AppendToString(std::string* out, double value, int prec);
+
 // String -> number conversions ------------------------------------------------
 
 // Perform a best-effort conversion of the input string to a numeric type,
@@ -120,8 +153,13 @@ bool StringToSizeT(StringPiece16 input, size_t* output);
 // If your input is locale specific, use ICU to read the number.
 // WARNING: Will write to |output| even when returning false.
 //          Read the comments here and above StringToInt() carefully.
-/*bool StringToDouble(StringPiece input, double* output);
-bool StringToDouble(StringPiece16 input, double* output);*/
+// A single leading '+' is accepted. On overflow |*output| is set to +/-HUGE_VAL
+// and on underflow to 0, in both cases false is returned.
+bool StringToDouble(StringPiece input, double* output);
+bool StringToDouble(StringPiece16 input, double* output);
+
+bool StringToFloat(StringPiece input, float* output);
+bool StringToFloat(StringPiece16 input, float* output);
 
 // Hex encoding ----------------------------------------------------------------
 
@@ -42,11 +42,35 @@ class CPU final {
  public:
   explicit CPU();
 
+  // The processor the process runs on, detected once. Runtime dispatch to SIMD code paths queries this one.
+  static const CPU& Current();
+
   // Accessors for CPU information.
   const std::string& vendor_name() const { return cpu_vendor_; }
   bool is_running_in_vm() const { return is_running_in_vm_; }
   const std::string& cpu_brand() const { return cpu_brand_; }
 
+  // Instruction set extensions, the AVX flags also require OS support for saving the wider registers.
+  bool has_mmx() const { return has_mmx_; }
+  bool has_sse() const { return has_sse_; }
+  bool has_sse2() const { return has_sse2_; }
+  bool has_sse3() const { return has_sse3_; }
+  bool has_ssse3() const { return has_ssse3_; }
+  bool has_sse41() const { return has_sse41_; }
+  bool has_sse42() const { return has_sse42_; }
+  bool has_popcnt() const { return has_popcnt_; }
+  bool has_avx() const { return has_avx_; }
+  bool has_avx2() const { return has_avx2_; }
+  bool has_avx512f() const { return has_avx512f_; }
+  bool has_fma3() const { return has_fma3_; }
+  bool has_aesni() const { return has_aesni_; }
+  bool has_sha() const { return has_sha_; }
+  bool has_bmi2() const { return has_bmi2_; }
+  bool has_neon() const { return has_neon_; }
+
+  // Space separated names of the flags above, e.g. "sse2 sse42 avx2".
+  std::string GetFeatures() const;
+
  private:
   // Query the processor for CPUID information.
   void Initialize();
@@ -54,6 +78,23 @@ class CPU final {
   bool is_running_in_vm_ = false;
   std::string cpu_vendor_ = "Unknown";
   std::string cpu_brand_;
+
+  bool has_mmx_ = false;
+  bool has_sse_ = false;
+  bool has_sse2_ = false;
+  bool has_sse3_ = false;
+  bool has_ssse3_ = false;
+  bool has_sse41_ = false;
+  bool has_sse42_ = false;
+  bool has_popcnt_ = false;
+  bool has_avx_ = false;
+  bool has_avx2_ = false;
+  bool has_avx512f_ = false;
+  bool has_fma3_ = false;
+  bool has_aesni_ = false;
+  bool has_sha_ = false;
+  bool has_bmi2_ = false;
+  bool has_neon_ = false;
 };
 
 }  // namespace system_info
@@ -0,0 +1,99 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/macros.h>
+#include <common/system_info/types.h>  // for lcpu_count_t
+
+#include <string>
+#include <vector>
+
+namespace common {
+namespace system_info {
+
+struct LogicalCpu {
+  lcpu_count_t id;    // as used by the scheduler (cpuN in sysfs)
+  size_t core;        // physical core, unique in the whole system
+  size_t package;     // socket
+  size_t numa_node;
+  size_t smt_index;   // position among the SMT siblings of |core|, 0 for the first hardware thread
+};
+
+enum CacheType { CACHE_DATA = 0, CACHE_INSTRUCTION, CACHE_UNIFIED };
+
+struct CpuCache {
+  int level;
+  CacheType type;
+  size_t size;       // bytes
+  size_t line_size;  // bytes
+  std::vector<lcpu_count_t> shared_cpus;
+};
+
+// Cores, SMT siblings, caches and NUMA nodes of the online CPUs. Linux reads sysfs, elsewhere every logical CPU is
+// reported as its own core of a single package and node.
+class CpuTopology {
+ public:
+  CpuTopology();
+  // |cpus| with |core| numbered per package (like sysfs core_id) are renumbered, |smt_index| is recomputed.
+  explicit CpuTopology(const std::vector<LogicalCpu>& cpus, const std::vector<CpuCache>& caches = {});
+
+  static CpuTopology Detect();
+  // Detected once and cached.
+  static const CpuTopology& Current();
+
+  const std::vector<LogicalCpu>& GetCpus() const { return cpus_; }
+  const std::vector<CpuCache>& GetCaches() const { return caches_; }
+
+  size_t GetLogicalCpusCount() const { return cpus_.size(); }
+  size_t GetPhysicalCoresCount() const { return cores_count_; }
+  size_t GetPackagesCount() const { return packages_count_; }
+  size_t GetNumaNodesCount() const { return numa_nodes_.size(); }
+
+  // CPUs of physical core |core| / NUMA node |node|, ascending.
+  std::vector<lcpu_count_t> GetCoreCpus(size_t core) const;
+  std::vector<lcpu_count_t> GetNumaNodeCpus(size_t node) const;
+  // Node ids as reported by the kernel, which need not be contiguous.
+  const std::vector<size_t>& GetNumaNodes() const { return numa_nodes_; }
+
+  const LogicalCpu* FindCpu(lcpu_count_t id) const;
+
+ private:
+  std::vector<LogicalCpu> cpus_;
+  std::vector<CpuCache> caches_;
+  size_t cores_count_;
+  size_t packages_count_;
+  std::vector<size_t> numa_nodes_;
+};
+
+// Parses the kernel cpu list format, e.g. "0-3,8,10-11".
+bool ParseCpuList(const std::string& list, std::vector<lcpu_count_t>* cpus) WARN_UNUSED_RESULT;
+
+}  // namespace system_info
+}  // namespace common
@@ -12,14 +12,21 @@
     along with Rixjob.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #pragma once
 
-#include <condition_variable>
-#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include <common/macros.h>
 
 namespace common {
 namespace threads {
 
+// Reusable barrier for |count| threads. Arriving threads spin briefly and then park on the generation counter, the
+// last one to arrive releases the others and resets the barrier for the next round.
 class barrier {
  public:
   explicit barrier(size_t count);
@@ -27,11 +34,12 @@ class barrier {
   void Wait();
 
  private:
-  std::mutex mutex_;
-  std::condition_variable cond_;
-  const size_t threshold_;
-  size_t count_;
-  size_t generation_;
+  const uint32_t threshold_;
+  std::atomic<uint32_t> count_;
+  std::atomic<uint32_t> generation_;  // futex word
+  std::atomic<uint32_t> sleepers_;
+
+  DISALLOW_COPY_AND_ASSIGN(barrier);
 };
 
 }  // namespace threads
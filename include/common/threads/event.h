@@ -36,6 +36,8 @@
 namespace common {
 namespace threads {
 
+// Manual or auto reset event. Set(), Reset() and a Wait() on a signaled event are a single atomic operation, the
+// caller only blocks (on a futex where available) when the event is not signaled.
 class Event {
  public:
   Event(int manual_reset, int initially_signaled);
@@ -45,6 +47,9 @@ class Event {
   void Reset();
   bool Wait(time64_t milliseconds);
 
+  // Non-blocking check which, unlike Wait(0), never resets an auto reset event.
+  bool IsSignaled() const;
+
  private:
   struct event_t;
   event_t* const event_;
@@ -29,8 +29,10 @@
 
 #pragma once
 
+#include <common/metrics/metrics.h>
 #include <common/threads/event_dispatcher.h>
 #include <common/threads/thread_manager.h>
+#include <common/threads/thread_placement.h>
 
 #include <atomic>
 #include <condition_variable>
@@ -61,20 +63,25 @@ class EventThread {
   void UnSubscribe(listener_t* listener, events_size_t id) { dispatcher_.UnSubscribe(listener, id); }
 
  private:
-  EventThread()
+  explicit EventThread(const ThreadPlacement& placement)
       : dispatcher_(),
         thread_(THREAD_MANAGER()->CreateThread(&EventThread::Exec, this)),
         stop_(false),
+        placement_(placement),
         queue_mutex_(),
         events_(),
-        condition_() {}
+        condition_(),
+        posted_(METRICS()->GetCounter("common_event_bus_events_total", "Events posted to event bus threads")),
+        queued_(METRICS()->GetGauge("common_event_bus_queued_events", "Events waiting in event bus queues")) {}
 
   void PostEvent(event_t* event) {
+    posted_->Increment();
     if (IsCurrentThread(thread_.get())) {
       dispatcher_.ProcessEvent(event);
     } else {
       mutex_lock_t lock(queue_mutex_);
       events_.push_back(event);
+      queued_->Increment();
       condition_.notify_one();
     }
   }
@@ -92,6 +99,7 @@ class EventThread {
 
  private:
   int Exec() {
+    ignore_result(ApplyThreadPlacement(placement_));
     while (!stop_.load()) {
       event_t* event = nullptr;
       {
@@ -100,6 +108,7 @@ class EventThread {
         if (!stop_.load()) {
           event = events_.front();
           events_.pop_front();
+          queued_->Decrement();
         }
       }
       dispatcher_.ProcessEvent(event);
@@ -110,6 +119,7 @@ class EventThread {
       for (size_t i = 0; i < events_.size(); ++i) {
         delete events_[i];
       }
+      queued_->Sub(events_.size());
       events_.clear();
     }
 
@@ -120,10 +130,14 @@ class EventThread {
 
   std::shared_ptr<event_thread_t> thread_;
   std::atomic_bool stop_;
+  const ThreadPlacement placement_;
 
   std::mutex queue_mutex_;
   std::deque<event_t*> events_;
   std::condition_variable condition_;
+
+  metrics::Counter* const posted_;
+  metrics::Gauge* const queued_;
 };
 
 class EventBus : public patterns::TSSingleton<EventBus> {
@@ -195,13 +209,14 @@ class EventBus : public patterns::TSSingleton<EventBus> {
     thread->Stop();
   }
 
+  // |placement| is applied by the event thread itself, see MakeThreadPlacement().
   template <typename type_t>
-  EventThread<type_t>* CreateEventThread() {
+  EventThread<type_t>* CreateEventThread(const ThreadPlacement& placement = ThreadPlacement()) {
     if (stop_.load()) {
       return nullptr;
     }
 
-    EventThread<type_t>* thread = new EventThread<type_t>();
+    EventThread<type_t>* thread = new EventThread<type_t>(placement);
     RegisterThread(thread);
     return thread;
   }
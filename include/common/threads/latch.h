@@ -0,0 +1,63 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <common/macros.h>
+#include <common/types.h>
+
+namespace common {
+namespace threads {
+
+// Single use countdown latch: threads block in Wait() until CountDown() has been called |count| times in total.
+// Waiters spin briefly and then park on the counter itself, CountDown() only enters the kernel if somebody is parked.
+class Latch {
+ public:
+  explicit Latch(uint32_t count);
+
+  void CountDown(uint32_t n = 1);
+  void ArriveAndWait(uint32_t n = 1);
+
+  bool TryWait() const;
+  void Wait();
+  bool WaitFor(time64_t milliseconds);
+
+ private:
+  std::atomic<uint32_t> count_;  // futex word
+  std::atomic<uint32_t> waiters_;
+
+  DISALLOW_COPY_AND_ASSIGN(Latch);
+};
+
+}  // namespace threads
+}  // namespace common
@@ -0,0 +1,150 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace common {
+namespace threads {
+
+class ThreadPool;
+
+// Cooperative cancellation for the parallel algorithms below: chunks which have not started yet are skipped once
+// Cancel() has been called, chunks already running finish normally.
+class CancellationFlag {
+ public:
+  CancellationFlag() : cancelled_(false) {}
+
+  void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool IsCancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<bool> cancelled_;
+};
+
+// Processes the half-open range [begin, end) in chunks of |grain| indexes (0 picks a grain from the pool size).
+typedef std::function<void(size_t chunk_begin, size_t chunk_end)> parallel_chunk_t;
+
+// Splits [begin, end) into chunks and runs |body| on them using |pool| workers and the calling thread. The caller
+// claims chunks itself instead of blocking on the pool, so this is safe to call from a pool worker and degrades to a
+// sequential loop when |pool| is null, not started, stopped or busy. Returns false if |cancel| was triggered.
+bool ParallelFor(ThreadPool* pool,
+                 size_t begin,
+                 size_t end,
+                 size_t grain,
+                 const parallel_chunk_t& body,
+                 const CancellationFlag* cancel = nullptr);
+
+// Chunk length ParallelFor() uses for [begin, end) and |grain|, about four chunks per participating thread when
+// |grain| is 0.
+size_t ParallelGrainSize(ThreadPool* pool, size_t begin, size_t end, size_t grain);
+
+// Maps every chunk to a partial result with |map(chunk_begin, chunk_end, identity)| and folds the partials with
+// |combine| in index order, so |combine| has to be associative but not commutative. Partials of cancelled chunks stay
+// |identity|.
+template <typename T, typename Map, typename Combine>
+T ParallelReduce(ThreadPool* pool,
+                 size_t begin,
+                 size_t end,
+                 size_t grain,
+                 const T& identity,
+                 Map map,
+                 Combine combine,
+                 const CancellationFlag* cancel = nullptr) {
+  if (begin >= end) {
+    return identity;
+  }
+
+  const size_t chunk = ParallelGrainSize(pool, begin, end, grain);
+  std::vector<T> partials((end - begin + chunk - 1) / chunk, identity);
+  ParallelFor(
+      pool, begin, end, chunk,
+      [&](size_t chunk_begin, size_t chunk_end) {
+        partials[(chunk_begin - begin) / chunk] = map(chunk_begin, chunk_end, identity);
+      },
+      cancel);
+
+  T result = identity;
+  for (const T& partial : partials) {
+    result = combine(result, partial);
+  }
+  return result;
+}
+
+// Sorts runs of |grain| elements in parallel, then merges neighbouring runs pairwise, also in parallel. Not stable.
+// Returns false if |cancel| was triggered, the range is then left partially sorted.
+template <typename RandomIt, typename Compare>
+bool ParallelSort(ThreadPool* pool,
+                  RandomIt first,
+                  RandomIt last,
+                  Compare comp,
+                  size_t grain = 0,
+                  const CancellationFlag* cancel = nullptr) {
+  const size_t size = std::distance(first, last);
+  if (size < 2) {
+    return true;
+  }
+
+  const size_t run = ParallelGrainSize(pool, 0, size, grain);
+  bool completed = ParallelFor(
+      pool, 0, size, run,
+      [first, comp](size_t chunk_begin, size_t chunk_end) { std::sort(first + chunk_begin, first + chunk_end, comp); },
+      cancel);
+
+  for (size_t width = run; completed && width < size; width *= 2) {
+    const size_t pairs = (size + 2 * width - 1) / (2 * width);
+    completed = ParallelFor(
+        pool, 0, pairs, 1,
+        [first, comp, size, width](size_t pair_begin, size_t pair_end) {
+          for (size_t pair = pair_begin; pair < pair_end; ++pair) {
+            const size_t lo = pair * 2 * width;
+            const size_t mid = std::min(lo + width, size);
+            const size_t hi = std::min(lo + 2 * width, size);
+            std::inplace_merge(first + lo, first + mid, first + hi, comp);
+          }
+        },
+        cancel);
+  }
+  return completed;
+}
+
+template <typename RandomIt>
+bool ParallelSort(ThreadPool* pool, RandomIt first, RandomIt last) {
+  return ParallelSort(pool, first, last, std::less<typename std::iterator_traits<RandomIt>::value_type>());
+}
+
+}  // namespace threads
+}  // namespace common
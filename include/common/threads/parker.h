@@ -0,0 +1,65 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <common/macros.h>
+#include <common/types.h>
+
+namespace common {
+namespace threads {
+
+// Per-thread park/unpark token. Only the owning thread parks, any thread may unpark it. An Unpark() which happens
+// before Park() is remembered, so the next Park() returns immediately; several Unpark() calls collapse into one token.
+// Park() may also return spuriously, callers re-check their own condition.
+class Parker {
+ public:
+  Parker();
+
+  void Park();
+  // Returns true if woken by Unpark(), false on timeout.
+  bool ParkFor(time64_t milliseconds);
+  void Unpark();
+
+ private:
+  enum State : uint32_t { EMPTY = 0, NOTIFIED = 1, PARKED = 2 };
+
+  bool TryConsumeToken();
+
+  std::atomic<uint32_t> state_;  // futex word
+
+  DISALLOW_COPY_AND_ASSIGN(Parker);
+};
+
+}  // namespace threads
+}  // namespace common
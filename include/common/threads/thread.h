@@ -66,7 +66,7 @@ class Thread final : public ThreadBase {
   typedef RT result_type;
   typedef std::function<result_type()> function_type;
 
-  bool IsRunning() { return event_.Wait(0) && base_class::handle_.GetTid() != invalid_tid; }
+  bool IsRunning() const { return event_.IsSignaled() && base_class::handle_.GetTid() != invalid_tid; }
 
   // Sets the thread's priority. Must be called before start().
   ThreadPriority GetPriority() const { return priority_; }
@@ -85,13 +85,15 @@ class Thread final : public ThreadBase {
       return false;
     }
 
+    // signaled before the thread exists, so that IsRunning() already holds inside of it
+    event_.Set();
     bool created = PlatformThread::Create(&(base_class::handle_), &thread_start, this, priority_);
     if (!created) {
+      event_.Reset();
       DNOTREACHED();
       return false;
     }
 
-    event_.Set();
     return true;
   }
 
@@ -139,7 +141,7 @@ class Thread<void> : public ThreadBase {
   typedef void result_type;
   typedef std::function<result_type()> function_type;
 
-  bool IsRunning() { return event_.Wait(0) && base_class::handle_.GetTid() != invalid_tid; }
+  bool IsRunning() const { return event_.IsSignaled() && base_class::handle_.GetTid() != invalid_tid; }
 
   // Sets the thread's priority. Must be called before start().
   ThreadPriority GetPriority() const { return priority_; }
@@ -158,13 +160,15 @@ class Thread<void> : public ThreadBase {
       return false;
     }
 
+    // signaled before the thread exists, so that IsRunning() already holds inside of it
+    event_.Set();
     bool created = PlatformThread::Create(&(base_class::handle_), &thread_start, this, priority_);
     if (!created) {
+      event_.Reset();
       DNOTREACHED();
       return false;
     }
 
-    event_.Set();
     return true;
   }
 
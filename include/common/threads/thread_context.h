@@ -0,0 +1,79 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/threads/platform_thread.h>
+
+namespace common {
+namespace libev {
+class LibEvLoop;
+}
+
+namespace threads {
+
+class ThreadBase;
+
+enum ThreadRole {
+  THREAD_ROLE_UNKNOWN = 0,  // not started through Thread, e.g. std::thread
+  THREAD_ROLE_MAIN,         // thread which created the ThreadManager
+  THREAD_ROLE_WORKER,       // started through Thread
+  THREAD_ROLE_LOOP          // inside LibEvLoop::Exec
+};
+
+// Identity of the calling thread, filled once at thread start (Thread::thread_start, LibEvLoop::Exec) so that identity
+// checks are a TLS load and a compare instead of a gettid syscall or pthread_getspecific.
+struct ThreadContext {
+  platform_thread_id_t tid;  // invalid_tid until first used
+  ThreadBase* thread;        // wrapping Thread, nullptr for foreign threads
+  libev::LibEvLoop* loop;    // loop running in this thread
+  ThreadRole role;
+};
+
+namespace internal {
+// Trivially constructible, so access needs no TLS init guard.
+extern thread_local ThreadContext g_thread_context;
+platform_thread_id_t InitCurrentThreadId();
+}  // namespace internal
+
+inline ThreadContext* CurrentThreadContext() {
+  return &internal::g_thread_context;
+}
+
+// Cached PlatformThread::GetCurrentId(), refreshed in the child after fork.
+inline platform_thread_id_t CurrentThreadId() {
+  const platform_thread_id_t tid = internal::g_thread_context.tid;
+  if (UNLIKELY(tid == invalid_tid)) {
+    return internal::InitCurrentThreadId();
+  }
+  return tid;
+}
+
+}  // namespace threads
+}  // namespace common
@@ -34,6 +34,7 @@
 #include <common/system_info/types.h>           // for lcpu_count_t
 #include <common/threads/platform_thread.h>     // for PlatformThread, etc
 #include <common/threads/thread.h>
+#include <common/threads/thread_context.h>
 
 #include <memory>
 
@@ -65,7 +66,7 @@ class ThreadManager : public patterns::TSSingleton<ThreadManager> {
 
   template <typename RT>
   Thread<RT>* CurrentThread() const {
-    return static_cast<Thread<RT>*>(PlatformThread::GetTlsDataByKey(key_));
+    return static_cast<Thread<RT>*>(CurrentThreadContext()->thread);
   }
 
   template <typename RT>
@@ -78,7 +79,9 @@ class ThreadManager : public patterns::TSSingleton<ThreadManager> {
   // for inner use
   template <typename RT>
   void WrapThread(Thread<RT>* thr) {
-    PlatformThread::SetTlsDataByKey(key_, thr);
+    ThreadContext* context = CurrentThreadContext();
+    context->thread = thr;
+    context->role = THREAD_ROLE_WORKER;
   }
 
   template <typename RT>
@@ -88,7 +91,6 @@ class ThreadManager : public patterns::TSSingleton<ThreadManager> {
   ThreadManager();
   ~ThreadManager();
 
-  platform_tls_t key_;
   Thread<int>* const main_thread_;
 };
 
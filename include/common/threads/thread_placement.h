@@ -0,0 +1,66 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/macros.h>
+#include <common/system_info/cpu_topology.h>
+
+#include <vector>
+
+namespace common {
+namespace threads {
+
+enum PlacementPolicy {
+  PLACEMENT_NONE = 0,       // let the scheduler decide
+  PLACEMENT_COMPACT,        // fill SMT siblings, cores and nodes in order, one logical CPU per thread
+  PLACEMENT_SPREAD,         // round robin over NUMA nodes, first hardware threads of all cores before siblings
+  PLACEMENT_PHYSICAL_CORE,  // one physical core (with its SMT siblings) per thread
+  PLACEMENT_NUMA_NODE       // all CPUs of one NUMA node per thread, nodes round robin
+};
+
+struct ThreadPlacement {
+  static const size_t kAnyNode = static_cast<size_t>(-1);
+
+  bool IsPinned() const { return !cpus.empty(); }
+
+  std::vector<lcpu_count_t> cpus;  // empty if not pinned
+  size_t numa_node = kAnyNode;     // node preferred for memory allocations
+};
+
+// Placement of the |index|-th thread of a group placed by |policy|.
+ThreadPlacement MakeThreadPlacement(const system_info::CpuTopology& topology, PlacementPolicy policy, size_t index);
+ThreadPlacement MakeThreadPlacement(PlacementPolicy policy, size_t index);
+
+// Pins the calling thread and, on multi-node systems, makes its allocations prefer |placement.numa_node| so that
+// memory first touched by the thread is local to it. Must run before the thread allocates its working set.
+bool ApplyThreadPlacement(const ThreadPlacement& placement) WARN_UNUSED_RESULT;
+
+}  // namespace threads
+}  // namespace common
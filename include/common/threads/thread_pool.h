@@ -14,6 +14,11 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <common/threads/thread_placement.h>
+
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
@@ -22,6 +27,12 @@
 #include <vector>
 
 namespace common {
+namespace metrics {
+class Counter;
+class Gauge;
+class Histogram;
+}  // namespace metrics
+
 namespace threads {
 
 class ThreadPool {
@@ -29,26 +40,40 @@ class ThreadPool {
   typedef std::thread thread_t;
   typedef std::vector<thread_t> workers_t;
   typedef std::function<void()> task_t;
-  typedef std::queue<task_t> tasks_t;
+  struct queued_task_t {
+    task_t task;
+    uint64_t posted_ns;
+  };
+  typedef std::queue<queued_task_t> tasks_t;
   ThreadPool();
   ~ThreadPool();
 
   void Post(task_t task);
-  void Start(size_t count_threads);
+  // Worker i is placed by MakeThreadPlacement(placement, i) before it runs tasks.
+  void Start(size_t count_threads, PlacementPolicy placement = PLACEMENT_NONE);
   void Stop();
   void Restart();
 
+  size_t GetThreadsCount() const;
+  // False before Start() and after Stop(), posted tasks are not run then.
+  bool IsRunning() const;
+
  private:
   void InitWork(size_t threads);
   void WaitFinishWork();
 
-  void RunWork();
+  void RunWork(size_t index);
 
   workers_t workers_;
   tasks_t tasks_;
   std::mutex queue_mutex_;
   std::condition_variable condition_;
-  bool stop_;
+  std::atomic<bool> stop_;
+  PlacementPolicy placement_;
+
+  metrics::Gauge* const queued_;
+  metrics::Counter* const executed_;
+  metrics::Histogram* const wait_time_;
 };
 }  // namespace threads
 }  // namespace common
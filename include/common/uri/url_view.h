@@ -0,0 +1,147 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/string_piece.h>
+#include <common/uri/url_canon.h>
+#include <common/uri/url_parse.h>
+
+namespace common {
+namespace uri {
+
+class GURL;
+
+// Schemes known at compile time, resolved through a perfect hash instead of the scheme registry.
+enum KnownScheme {
+  KNOWN_SCHEME_NONE = 0,  // no scheme, e.g. an origin-form request target
+  KNOWN_SCHEME_HTTP,
+  KNOWN_SCHEME_HTTPS,
+  KNOWN_SCHEME_WS,
+  KNOWN_SCHEME_WSS,
+  KNOWN_SCHEME_FTP,
+  KNOWN_SCHEME_FILE,
+  KNOWN_SCHEME_DEV,
+  KNOWN_SCHEME_GS,
+  KNOWN_SCHEME_S3,
+  KNOWN_SCHEME_UNKNOWN,
+  KNOWN_SCHEME_UDP,
+  KNOWN_SCHEME_RTP,
+  KNOWN_SCHEME_SRT,
+  KNOWN_SCHEME_TCP,
+  KNOWN_SCHEME_RTMP,
+  KNOWN_SCHEME_RTMPS,
+  KNOWN_SCHEME_RTMPT,
+  KNOWN_SCHEME_RTMPE,
+  KNOWN_SCHEME_RTMFP,
+  KNOWN_SCHEME_WEBRTC,
+  KNOWN_SCHEME_WEBRTCS,
+  KNOWN_SCHEME_RTSP,
+  KNOWN_SCHEME_DATA,
+  KNOWN_SCHEME_TEL,
+  KNOWN_SCHEME_OTHER  // a scheme outside of this list, see the scheme registry
+};
+
+// Case insensitive lookup of |scheme| (without the colon).
+KnownScheme LookupKnownScheme(StringPiece scheme);
+
+// Non-owning view of a URL or an origin-form request target ("/path?query#ref"). Construction only splits the input
+// into uri::Parsed components, it does not copy, unescape, canonicalise or allocate, so |spec| must outlive the view.
+// Use Canonicalize() or ToGURL() when the canonical form is needed.
+//
+// Unlike GURL, tabs and newlines inside the input are not removed and components are returned exactly as written.
+class UrlView {
+ public:
+  UrlView();
+  explicit UrlView(StringPiece spec);
+
+  // True if the input has a scheme or is an origin-form target starting with '/'. This is a structural check only,
+  // the canonical URL can still be invalid.
+  bool is_valid() const { return is_valid_; }
+  bool is_origin_form() const { return is_valid_ && !parsed_.scheme.is_valid(); }
+
+  StringPiece spec() const { return spec_; }
+  const Parsed& parsed() const { return parsed_; }
+  KnownScheme known_scheme() const { return known_scheme_; }
+
+  bool IsStandard() const;
+  bool SchemeIs(StringPiece lower_ascii_scheme) const;
+  bool SchemeIsHTTPOrHTTPS() const;
+  bool SchemeIsWSOrWSS() const;
+
+  bool has_scheme() const { return parsed_.scheme.len >= 0; }
+  StringPiece scheme_piece() const { return ComponentPiece(parsed_.scheme); }
+
+  bool has_username() const { return parsed_.username.len >= 0; }
+  StringPiece username_piece() const { return ComponentPiece(parsed_.username); }
+
+  bool has_password() const { return parsed_.password.len >= 0; }
+  StringPiece password_piece() const { return ComponentPiece(parsed_.password); }
+
+  bool has_host() const { return parsed_.host.len > 0; }
+  StringPiece host_piece() const { return ComponentPiece(parsed_.host); }
+
+  bool has_port() const { return parsed_.port.len >= 0; }
+  StringPiece port_piece() const { return ComponentPiece(parsed_.port); }
+
+  bool has_path() const { return parsed_.path.len >= 0; }
+  StringPiece path_piece() const { return ComponentPiece(parsed_.path); }
+
+  bool has_query() const { return parsed_.query.len >= 0; }
+  StringPiece query_piece() const { return ComponentPiece(parsed_.query); }
+
+  bool has_ref() const { return parsed_.ref.len >= 0; }
+  StringPiece ref_piece() const { return ComponentPiece(parsed_.ref); }
+
+  // Returns the port number, PORT_UNSPECIFIED or PORT_INVALID.
+  int IntPort() const;
+
+  // Path and query without the reference. An empty path gives "/", the query is then only available through
+  // query_piece().
+  StringPiece PathForRequestPiece() const;
+
+  // Appends the canonical path and query to |output|: dot segments are resolved and escapes normalised like
+  // GURL does for the path of a standard URL. Works for origin-form targets too, false on an invalid path.
+  bool CanonicalizePathForRequest(CanonOutput* output) const;
+
+  // Canonicalises the viewed URL into |output|. Origin-form targets have no canonical form and fail.
+  bool Canonicalize(CanonOutput* output, Parsed* output_parsed) const;
+  GURL ToGURL() const;
+
+ private:
+  StringPiece ComponentPiece(const Component& comp) const;
+
+  StringPiece spec_;
+  Parsed parsed_;
+  KnownScheme known_scheme_;
+  bool is_valid_;
+};
+
+}  // namespace uri
+}  // namespace common
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON reports.
+
+usage: compare_benchmarks.py baseline.json contender.json [--threshold 0.05] [--metric cpu_time]
+
+Reports are produced with --benchmark_out=<file> --benchmark_out_format=json
+(make run_benchmarks writes benchmarks.json in the build directory).
+When benchmarks were run with repetitions the mean aggregate is compared.
+Exits with 1 if any benchmark got slower than the threshold allows.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path, metric):
+    with open(path) as report:
+        data = json.load(report)
+
+    results = {}
+    for bench in data.get('benchmarks', []):
+        if bench.get('error_occurred'):
+            continue
+        run_type = bench.get('run_type', 'iteration')
+        name = bench.get('run_name', bench['name'])
+        if run_type == 'aggregate':
+            if bench.get('aggregate_name') != 'mean':
+                continue
+        elif name in results:
+            continue  # first repetition, overridden by the mean if present
+        results[name] = bench[metric]
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare two benchmark JSON reports.')
+    parser.add_argument('baseline')
+    parser.add_argument('contender')
+    parser.add_argument('--threshold', type=float, default=0.05,
+                        help='allowed relative slowdown, default 0.05 (5%%)')
+    parser.add_argument('--metric', default='cpu_time', choices=['cpu_time', 'real_time'])
+    args = parser.parse_args()
+
+    baseline = load(args.baseline, args.metric)
+    contender = load(args.contender, args.metric)
+
+    regressions = 0
+    width = max([len(name) for name in baseline] + [len('Benchmark')])
+    print('%-*s %14s %14s %9s' % (width, 'Benchmark', 'baseline', 'contender', 'change'))
+    for name in sorted(set(baseline) | set(contender)):
+        if name not in baseline or name not in contender:
+            side = 'only in baseline' if name in baseline else 'only in contender'
+            print('%-*s %s' % (width, name, side))
+            continue
+
+        old = baseline[name]
+        new = contender[name]
+        change = (new - old) / old if old else 0.0
+        mark = ''
+        if change > args.threshold:
+            mark = ' REGRESSION'
+            regressions += 1
+        elif change < -args.threshold:
+            mark = ' improved'
+        print('%-*s %14.1f %14.1f %+8.1f%%%s' % (width, name, old, new, change * 100, mark))
+
+    if regressions:
+        print('%d benchmark(s) regressed by more than %.1f%%' % (regressions, args.threshold * 100))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
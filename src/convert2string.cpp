@@ -570,73 +570,93 @@ Buffer ConvertToBytesT(bool value) {
 
 template <typename Buffer>
 Buffer ConvertToBytesT(char value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(unsigned char value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(short value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(unsigned short value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(int value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(unsigned int value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(long value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(unsigned long value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(long long value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(unsigned long long value) {
-  const std::string str = ConvertToString(value);  // more readable
-  return Buffer(str.begin(), str.end());
+  char buffer[kMaxNumberChars];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value);
+  return Buffer(buffer, buffer + len);
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(float value, int prec) {
-  const std::string str = ConvertToString(value, prec);  // more readable
+  char buffer[64];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value, prec);
+  if (len) {
+    return Buffer(buffer, buffer + len);
+  }
+  const std::string str = ConvertToString(value, prec);  // too long for the stack buffer
   return Buffer(str.begin(), str.end());
 }
 
 template <typename Buffer>
 Buffer ConvertToBytesT(double value, int prec) {
-  const std::string str = ConvertToString(value, prec);  // more readable
+  char buffer[64];
+  const size_t len = ToChars(make_span(buffer, sizeof(buffer)), value, prec);
+  if (len) {
+    return Buffer(buffer, buffer + len);
+  }
+  const std::string str = ConvertToString(value, prec);  // too long for the stack buffer
   return Buffer(str.begin(), str.end());
 }
 
@@ -1265,9 +1285,8 @@ bool ConvertFromString(const std::string& from, float* out) {
     return true;
   }
 
-  size_t end_number_pos;
-  float d = std::stof(from.c_str(), &end_number_pos);
-  if (end_number_pos != from.size()) {
+  float d;
+  if (!StringToFloat(from, &d)) {
     return false;
   }
   *out = d;
@@ -1289,9 +1308,8 @@ bool ConvertFromString(const std::string& from, double* out) {
     return true;
   }
 
-  size_t end_number_pos;
-  double d = std::stod(from.c_str(), &end_number_pos);
-  if (end_number_pos != from.size()) {
+  double d;
+  if (!StringToDouble(from, &d)) {
     return false;
   }
   *out = d;
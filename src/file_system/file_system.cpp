@@ -290,7 +290,8 @@ ErrnoError read_file_cb(descriptor_t in_fd, off_t* offset, size_t count, read_cb
   }
 
   while (count > 0) {
-    ssize_t num_read = read(in_fd, buf, FS_BUF_SIZE);
+    const size_t to_read = count < FS_BUF_SIZE ? count : FS_BUF_SIZE;
+    ssize_t num_read = read(in_fd, buf, to_read);
     if (num_read == -1) {
       return make_error_perror("read", errno);
     }
@@ -304,6 +305,9 @@ ErrnoError read_file_cb(descriptor_t in_fd, off_t* offset, size_t count, read_cb
       return err;
     }
 
+    if (num_sent >= count) {
+      break;
+    }
     count -= num_sent;
   }
 
@@ -562,6 +566,20 @@ ErrnoError close_descriptor(descriptor_t fd_desc) {
   return ErrnoError();
 }
 
+ErrnoError duplicate_descriptor(descriptor_t fd_desc, descriptor_t* out_desc) {
+  if (fd_desc == INVALID_DESCRIPTOR || !out_desc) {
+    return make_error_perror("duplicate_descriptor", EINVAL);
+  }
+
+  descriptor_t res = dup(fd_desc);
+  if (res == INVALID_DESCRIPTOR) {
+    return make_error_perror("dup", errno);
+  }
+
+  *out_desc = res;
+  return ErrnoError();
+}
+
 ErrnoError write_to_descriptor(descriptor_t fd_desc, const void* buf, size_t size, size_t* nwrite_out) {
   if (fd_desc == INVALID_DESCRIPTOR || !buf || size == 0 || !nwrite_out) {
     return make_error_perror("write_to_descriptor", EINVAL);
@@ -0,0 +1,54 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <common/macros.h>
+#include <common/system_info/cpu_info.h>
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__GNUC__)
+#define HASH_HAVE_X86_SHA_NI 1
+#define HASH_SHA_NI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+
+namespace common {
+namespace hash {
+namespace internal {
+
+#if defined(HASH_HAVE_X86_SHA_NI)
+// SHA extensions plus SSSE3/SSE4.1 used for byte shuffles and blends.
+inline bool CpuHasShaNi() {
+  const system_info::CPU& cpu = system_info::CPU::Current();
+  return cpu.has_sha() && cpu.has_ssse3() && cpu.has_sse41();
+}
+#endif
+
+}  // namespace internal
+}  // namespace hash
+}  // namespace common
@@ -0,0 +1,157 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/hash/digest.h>
+
+#include <common/convert2string.h>
+#include <common/file_system/file_system.h>
+#include <common/utils.h>
+
+namespace common {
+namespace hash {
+
+namespace {
+ErrnoError digest_read_cb(const char* buff, size_t buff_len, void* user_data, size_t* processed) {
+  Digest* digest = static_cast<Digest*>(user_data);
+  digest->Update(buff, buff_len);
+  *processed = buff_len;
+  return ErrnoError();
+}
+}  // namespace
+
+Digest::Digest(Type type) : type_(type), ctx_() {
+  Reset();
+}
+
+Digest::Type Digest::GetType() const {
+  return type_;
+}
+
+size_t Digest::GetLength() const {
+  switch (type_) {
+    case MD5:
+      return MD5_HASH_LENGHT;
+    case SHA1:
+      return SHA1_HASH_LENGTH;
+    case SHA256:
+      return SHA256_HASH_LENGHT;
+    case CRC64:
+      return CRC64_HASH_LENGHT;
+  }
+
+  NOTREACHED();
+  return 0;
+}
+
+void Digest::Reset() {
+  switch (type_) {
+    case MD5:
+      MD5_Init(&ctx_.md5);
+      return;
+    case SHA1:
+      SHA1_Init(&ctx_.sha1);
+      return;
+    case SHA256:
+      SHA256_Init(&ctx_.sha256);
+      return;
+    case CRC64:
+      ctx_.crc64 = 0;
+      return;
+  }
+
+  NOTREACHED();
+}
+
+void Digest::Update(const void* data, size_t size) {
+  if (!data || !size) {
+    return;
+  }
+
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  switch (type_) {
+    case MD5:
+      MD5_Update(&ctx_.md5, bytes, size);
+      return;
+    case SHA1:
+      SHA1_Update(&ctx_.sha1, bytes, size);
+      return;
+    case SHA256:
+      SHA256_Update(&ctx_.sha256, bytes, size);
+      return;
+    case CRC64:
+      ctx_.crc64 = utils::hash::crc64(ctx_.crc64, bytes, size);
+      return;
+  }
+
+  NOTREACHED();
+}
+
+void Digest::Update(const buffer_t& data) {
+  Update(data.data(), data.size());
+}
+
+ErrnoError Digest::UpdateFromDescriptor(descriptor_t fd, off_t* offset, size_t count) {
+  return file_system::read_file_cb(fd, offset, count, &digest_read_cb, this);
+}
+
+buffer_t Digest::Final() {
+  buffer_t result;
+  result.resize(GetLength());
+  switch (type_) {
+    case MD5:
+      MD5_Final(&ctx_.md5, result.data());
+      break;
+    case SHA1:
+      SHA1_Final(&ctx_.sha1, result.data());
+      break;
+    case SHA256:
+      SHA256_Final(&ctx_.sha256, result.data());
+      break;
+    case CRC64:
+      for (size_t i = 0; i < CRC64_HASH_LENGHT; ++i) {
+        result[i] = static_cast<byte_t>(ctx_.crc64 >> (56 - i * 8));
+      }
+      break;
+  }
+
+  Reset();
+  return result;
+}
+
+std::string Digest::FinalHex() {
+  const buffer_t raw = Final();
+  std::string hexed;
+  if (!utils::hex::encode(MAKE_CHAR_BUFFER_SIZE(raw.data(), raw.size()), true, &hexed)) {
+    return std::string();
+  }
+  return hexed;
+}
+
+}  // namespace hash
+}  // namespace common
@@ -28,10 +28,15 @@
 */
 
 #include <common/hash/sha1.h>
-#include <common/portable_endian.h>
 #include <stdint.h>
 #include <string.h>
 
+#include "cpu_features.h"
+
+#if defined(HASH_HAVE_X86_SHA_NI)
+#include <immintrin.h>
+#endif
+
 /* code */
 #define SHA1_K0 0x5a827999
 #define SHA1_K20 0x6ed9eba1
@@ -41,84 +46,123 @@
 namespace common {
 namespace hash {
 namespace {
+
+typedef void (*sha1_transform_t)(uint32_t state[5], const uint8_t* data, size_t blocks);
+
 uint32_t sha1_rol32(uint32_t number, uint8_t bits) {
   return ((number << bits) | (number >> (32 - bits)));
 }
 
-void sha1_hashBlock(SHA1_CTX* s) {
+void sha1_transform_generic(uint32_t state[5], const uint8_t* data, size_t blocks) {
   uint8_t i;
   uint32_t a, b, c, d, e, t;
+  uint32_t w[16];
 
-  a = s->state[0];
-  b = s->state[1];
-  c = s->state[2];
-  d = s->state[3];
-  e = s->state[4];
-  for (i = 0; i < 80; i++) {
-    if (i >= 16) {
-      t = s->buffer[(i + 13) & 15] ^ s->buffer[(i + 8) & 15] ^ s->buffer[(i + 2) & 15] ^ s->buffer[i & 15];
-      s->buffer[i & 15] = sha1_rol32(t, 1);
+  for (; blocks; --blocks, data += BLOCK_LENGTH) {
+    for (i = 0; i < 16; ++i) {
+      const uint8_t* p = data + i * 4;
+      w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
     }
-    if (i < 20) {
-      t = (d ^ (b & (c ^ d))) + SHA1_K0;
-    } else if (i < 40) {
-      t = (b ^ c ^ d) + SHA1_K20;
-    } else if (i < 60) {
-      t = ((b & c) | (d & (b | c))) + SHA1_K40;
-    } else {
-      t = (b ^ c ^ d) + SHA1_K60;
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    for (i = 0; i < 80; i++) {
+      if (i >= 16) {
+        t = w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15];
+        w[i & 15] = sha1_rol32(t, 1);
+      }
+      if (i < 20) {
+        t = (d ^ (b & (c ^ d))) + SHA1_K0;
+      } else if (i < 40) {
+        t = (b ^ c ^ d) + SHA1_K20;
+      } else if (i < 60) {
+        t = ((b & c) | (d & (b | c))) + SHA1_K40;
+      } else {
+        t = (b ^ c ^ d) + SHA1_K60;
+      }
+      t += sha1_rol32(a, 5) + e + w[i & 15];
+      e = d;
+      d = c;
+      c = sha1_rol32(b, 30);
+      b = a;
+      a = t;
     }
-    t += sha1_rol32(a, 5) + e + s->buffer[i & 15];
-    e = d;
-    d = c;
-    c = sha1_rol32(b, 30);
-    b = a;
-    a = t;
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
   }
-  s->state[0] += a;
-  s->state[1] += b;
-  s->state[2] += c;
-  s->state[3] += d;
-  s->state[4] += e;
 }
 
-void sha1_addUncounted(SHA1_CTX* s, uint8_t data) {
-  uint8_t* const b = reinterpret_cast<uint8_t*>(s->buffer);
-#if defined(ARCH_CPU_BIG_ENDIAN)
-  b[s->buffer_offset] = data;
-#else
-  b[s->buffer_offset ^ 3] = data;
-#endif
-  s->buffer_offset++;
-  if (s->buffer_offset == BLOCK_LENGTH) {
-    sha1_hashBlock(s);
-    s->buffer_offset = 0;
+#if defined(HASH_HAVE_X86_SHA_NI)
+HASH_SHA_NI_TARGET __m128i sha1_rnds4(__m128i abcd, __m128i e, int group) {
+  // the round function selector must be an immediate
+  switch (group / 5) {
+    case 0:
+      return _mm_sha1rnds4_epu32(abcd, e, 0);
+    case 1:
+      return _mm_sha1rnds4_epu32(abcd, e, 1);
+    case 2:
+      return _mm_sha1rnds4_epu32(abcd, e, 2);
+    default:
+      return _mm_sha1rnds4_epu32(abcd, e, 3);
   }
 }
 
-void sha1_updatebyte(SHA1_CTX* s, uint8_t data) {
-  ++s->byte_count;
-  sha1_addUncounted(s, data);
-}
+// Intel SHA extensions: each sha1rnds4 does four rounds, sha1nexte derives E for the next group.
+HASH_SHA_NI_TARGET void sha1_transform_shani(uint32_t state[5], const uint8_t* data, size_t blocks) {
+  const __m128i shuf_mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+  __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+  __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+
+  for (; blocks; --blocks, data += BLOCK_LENGTH) {
+    const __m128i abcd_save = abcd;
+    const __m128i e0_save = e0;
+
+    __m128i msg[4];
+    __m128i e_prev = e0;
+    for (int g = 0; g < 20; ++g) {
+      __m128i& m = msg[g & 3];
+      if (g < 4) {
+        m = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + g * 16)), shuf_mask);
+      } else {
+        // W[t] = rol1(W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16])
+        m = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(m, msg[(g + 1) & 3]), msg[(g + 2) & 3]),
+                               msg[(g + 3) & 3]);
+      }
+
+      const __m128i e = g == 0 ? _mm_add_epi32(e0, m) : _mm_sha1nexte_epu32(e_prev, m);
+      e_prev = abcd;
+      abcd = sha1_rnds4(abcd, e, g);
+    }
 
-void sha1_pad(SHA1_CTX* s) {
-  // Implement SHA-1 padding (fips180-2 Â§5.1.1)
+    e0 = _mm_sha1nexte_epu32(e_prev, e0_save);
+    abcd = _mm_add_epi32(abcd, abcd_save);
+  }
 
-  // Pad with 0x80 followed by 0x00 until the end of the block
-  sha1_addUncounted(s, 0x80);
-  while (s->buffer_offset != 56) {
-    sha1_addUncounted(s, 0x00);
+  abcd = _mm_shuffle_epi32(abcd, 0x1B);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+  state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+#endif
+
+sha1_transform_t sha1_select_transform() {
+#if defined(HASH_HAVE_X86_SHA_NI)
+  if (internal::CpuHasShaNi()) {
+    return &sha1_transform_shani;
   }
+#endif
+  return &sha1_transform_generic;
+}
 
-  // Append length in the last 8 bytes
-  sha1_addUncounted(s, 0);                    // We're only using 32 bit lengths
-  sha1_addUncounted(s, 0);                    // But SHA-1 supports 64 bit lengths
-  sha1_addUncounted(s, 0);                    // So zero pad the top bits
-  sha1_addUncounted(s, s->byte_count >> 29);  // Shifting to multiply by 8
-  sha1_addUncounted(s, s->byte_count >> 21);  // as SHA-1 supports bitstreams as well as
-  sha1_addUncounted(s, s->byte_count >> 13);  // byte.
-  sha1_addUncounted(s, s->byte_count >> 5);
-  sha1_addUncounted(s, s->byte_count << 3);
+void sha1_transform(SHA1_CTX* s, const uint8_t* data, size_t blocks) {
+  static const sha1_transform_t transform = sha1_select_transform();
+  transform(s->state, data, blocks);
 }
 
 }  // namespace
@@ -134,26 +178,64 @@ void SHA1_Init(SHA1_CTX* s) {
 }
 
 void SHA1_Update(SHA1_CTX* s, const unsigned char* data, size_t len) {
-  for (; len--;) {
-    sha1_updatebyte(s, *data++);
+  uint8_t* const buffer = reinterpret_cast<uint8_t*>(s->buffer);
+  s->byte_count += len;
+
+  if (s->buffer_offset) {
+    size_t fill = BLOCK_LENGTH - s->buffer_offset;
+    if (len < fill) {
+      memcpy(buffer + s->buffer_offset, data, len);
+      s->buffer_offset += len;
+      return;
+    }
+
+    memcpy(buffer + s->buffer_offset, data, fill);
+    sha1_transform(s, buffer, 1);
+    s->buffer_offset = 0;
+    data += fill;
+    len -= fill;
+  }
+
+  // hash whole blocks straight from the caller buffer
+  size_t blocks = len / BLOCK_LENGTH;
+  if (blocks) {
+    sha1_transform(s, data, blocks);
+    data += blocks * BLOCK_LENGTH;
+    len -= blocks * BLOCK_LENGTH;
+  }
+
+  if (len) {
+    memcpy(buffer, data, len);
+    s->buffer_offset = len;
   }
 }
 
 void SHA1_Final(SHA1_CTX* s, uint8_t* result) {
-  // Pad to complete the last block
-  sha1_pad(s);
-
-#ifndef ARCH_CPU_BIG_ENDIAN
-  // Swap byte order back
-  int i;
-  for (i = 0; i < 5; i++) {
-    s->state[i] = (((s->state[i]) << 24) & 0xff000000) | (((s->state[i]) << 8) & 0x00ff0000) |
-                  (((s->state[i]) >> 8) & 0x0000ff00) | (((s->state[i]) >> 24) & 0x000000ff);
+  // Implement SHA-1 padding (fips180-2 5.1.1)
+  uint8_t* const buffer = reinterpret_cast<uint8_t*>(s->buffer);
+  const uint64_t bit_count = s->byte_count << 3;
+
+  // Pad with 0x80 followed by 0x00 until the end of the block
+  buffer[s->buffer_offset++] = 0x80;
+  if (s->buffer_offset > 56) {
+    memset(buffer + s->buffer_offset, 0, BLOCK_LENGTH - s->buffer_offset);
+    sha1_transform(s, buffer, 1);
+    s->buffer_offset = 0;
   }
-#endif
+  memset(buffer + s->buffer_offset, 0, 56 - s->buffer_offset);
 
-  // Return pointer to hash (20 characters)
-  memcpy(result, reinterpret_cast<uint8_t*>(s->state), SHA1_HASH_LENGTH);
+  // Append length in bits as big endian in the last 8 bytes
+  for (int i = 0; i < 8; ++i) {
+    buffer[56 + i] = static_cast<uint8_t>(bit_count >> (56 - i * 8));
+  }
+  sha1_transform(s, buffer, 1);
+
+  for (int i = 0; i < 5; ++i) {
+    result[i * 4] = static_cast<uint8_t>(s->state[i] >> 24);
+    result[i * 4 + 1] = static_cast<uint8_t>(s->state[i] >> 16);
+    result[i * 4 + 2] = static_cast<uint8_t>(s->state[i] >> 8);
+    result[i * 4 + 3] = static_cast<uint8_t>(s->state[i]);
+  }
 }
 
 }  // namespace hash
@@ -29,8 +29,15 @@
 
 #include <common/hash/sha256.h>
 #include <memory.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+#include "cpu_features.h"
+
+#if defined(HASH_HAVE_X86_SHA_NI)
+#include <immintrin.h>
+#endif
+
 #define ROTLEFT(a, b) (((a) << (b)) | ((a) >> (32 - (b))))
 #define ROTRIGHT(a, b) (((a) >> (b)) | ((a) << (32 - (b))))
 
@@ -41,6 +48,8 @@
 #define SIG0(x) (ROTRIGHT(x, 7) ^ ROTRIGHT(x, 18) ^ ((x) >> 3))
 #define SIG1(x) (ROTRIGHT(x, 17) ^ ROTRIGHT(x, 19) ^ ((x) >> 10))
 
+#define SHA256_BLOCK_LENGTH 64
+
 namespace common {
 namespace hash {
 
@@ -55,46 +64,112 @@ const unsigned int k[64] = {
     0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
     0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
 
-void sha256_transform(SHA256_CTX* ctx, const unsigned char data[]) {
+typedef void (*sha256_transform_t)(unsigned int state[8], const unsigned char* data, size_t blocks);
+
+void sha256_transform_generic(unsigned int state[8], const unsigned char* data, size_t blocks) {
   unsigned int a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
 
-  for (i = 0, j = 0; i < 16; ++i, j += 4) {
-    m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+  for (; blocks; --blocks, data += SHA256_BLOCK_LENGTH) {
+    for (i = 0, j = 0; i < 16; ++i, j += 4) {
+      m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+    }
+    for (; i < 64; ++i) {
+      m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; ++i) {
+      t1 = h + EP1(e) + CH(e, f, g) + k[i] + m[i];
+      t2 = EP0(a) + MAJ(a, b, c);
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
   }
-  for (; i < 64; ++i) {
-    m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+}
+
+#if defined(HASH_HAVE_X86_SHA_NI)
+// Intel SHA extensions: the state is kept as ABEF/CDGH pairs, each sha256rnds2 does two rounds.
+HASH_SHA_NI_TARGET void sha256_transform_shani(unsigned int state[8], const unsigned char* data, size_t blocks) {
+  const __m128i shuf_mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+  __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+  tmp = _mm_shuffle_epi32(tmp, 0xB1);                // CDAB
+  state1 = _mm_shuffle_epi32(state1, 0x1B);          // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);       // CDGH
+
+  for (; blocks; --blocks, data += SHA256_BLOCK_LENGTH) {
+    const __m128i abef_save = state0;
+    const __m128i cdgh_save = state1;
+
+    __m128i msg[4];
+    for (int i = 0; i < 4; ++i) {
+      msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16)), shuf_mask);
+    }
+
+    for (int i = 0; i < 16; ++i) {
+      __m128i wk = _mm_add_epi32(msg[i & 3], _mm_loadu_si128(reinterpret_cast<const __m128i*>(&k[i * 4])));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+      if (i < 12) {
+        // W[t] = s1(W[t-2]) + W[t-7] + s0(W[t-15]) + W[t-16] for the group four steps ahead.
+        __m128i next = _mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]);
+        next = _mm_add_epi32(next, _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4));
+        msg[i & 3] = _mm_sha256msg2_epu32(next, msg[(i + 3) & 3]);
+      }
+      wk = _mm_shuffle_epi32(wk, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+    }
+
+    state0 = _mm_add_epi32(state0, abef_save);
+    state1 = _mm_add_epi32(state1, cdgh_save);
   }
 
-  a = ctx->state[0];
-  b = ctx->state[1];
-  c = ctx->state[2];
-  d = ctx->state[3];
-  e = ctx->state[4];
-  f = ctx->state[5];
-  g = ctx->state[6];
-  h = ctx->state[7];
-
-  for (i = 0; i < 64; ++i) {
-    t1 = h + EP1(e) + CH(e, f, g) + k[i] + m[i];
-    t2 = EP0(a) + MAJ(a, b, c);
-    h = g;
-    g = f;
-    f = e;
-    e = d + t1;
-    d = c;
-    c = b;
-    b = a;
-    a = t1 + t2;
+  tmp = _mm_shuffle_epi32(state0, 0x1B);        // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xB1);     // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xF0);  // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8);     // HGFE
+
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+#endif
+
+sha256_transform_t sha256_select_transform() {
+#if defined(HASH_HAVE_X86_SHA_NI)
+  if (internal::CpuHasShaNi()) {
+    return &sha256_transform_shani;
   }
+#endif
+  return &sha256_transform_generic;
+}
 
-  ctx->state[0] += a;
-  ctx->state[1] += b;
-  ctx->state[2] += c;
-  ctx->state[3] += d;
-  ctx->state[4] += e;
-  ctx->state[5] += f;
-  ctx->state[6] += g;
-  ctx->state[7] += h;
+void sha256_transform(SHA256_CTX* ctx, const unsigned char* data, size_t blocks) {
+  static const sha256_transform_t transform = sha256_select_transform();
+  transform(ctx->state, data, blocks);
 }
 
 }  // namespace
@@ -113,14 +188,34 @@ void SHA256_Init(SHA256_CTX* ctx) {
 }
 
 void SHA256_Update(SHA256_CTX* ctx, const unsigned char* data, size_t len) {
-  for (unsigned int i = 0; i < len; ++i) {
-    ctx->data[ctx->datalen] = data[i];
-    ctx->datalen++;
-    if (ctx->datalen == 64) {
-      sha256_transform(ctx, ctx->data);
-      ctx->bitlen += 512;
-      ctx->datalen = 0;
+  if (ctx->datalen) {
+    size_t fill = SHA256_BLOCK_LENGTH - ctx->datalen;
+    if (len < fill) {
+      memcpy(ctx->data + ctx->datalen, data, len);
+      ctx->datalen += len;
+      return;
     }
+
+    memcpy(ctx->data + ctx->datalen, data, fill);
+    sha256_transform(ctx, ctx->data, 1);
+    ctx->bitlen += 512;
+    ctx->datalen = 0;
+    data += fill;
+    len -= fill;
+  }
+
+  // hash whole blocks straight from the caller buffer
+  size_t blocks = len / SHA256_BLOCK_LENGTH;
+  if (blocks) {
+    sha256_transform(ctx, data, blocks);
+    ctx->bitlen += static_cast<unsigned long long>(blocks) * 512;
+    data += blocks * SHA256_BLOCK_LENGTH;
+    len -= blocks * SHA256_BLOCK_LENGTH;
+  }
+
+  if (len) {
+    memcpy(ctx->data, data, len);
+    ctx->datalen = len;
   }
 }
 
@@ -137,7 +232,7 @@ void SHA256_Final(SHA256_CTX* ctx, unsigned char* hash) {
     while (i < 64) {
       ctx->data[i++] = 0x00;
     }
-    sha256_transform(ctx, ctx->data);
+    sha256_transform(ctx, ctx->data, 1);
     memset(ctx->data, 0, 56);
   }
 
@@ -150,7 +245,7 @@ void SHA256_Final(SHA256_CTX* ctx, unsigned char* hash) {
   ctx->data[58] = ctx->bitlen >> 40;
   ctx->data[57] = ctx->bitlen >> 48;
   ctx->data[56] = ctx->bitlen >> 56;
-  sha256_transform(ctx, ctx->data);
+  sha256_transform(ctx, ctx->data, 1);
 
   for (i = 0; i < 4; ++i) {
     hash[i] = (ctx->state[0] >> (24 - i * 8)) & 0x000000ff;
@@ -0,0 +1,122 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "header_tokens.h"
+
+#include <common/http/http2.h>
+#include <common/static_string_map.h>
+
+namespace common {
+namespace http {
+namespace internal {
+
+namespace {
+
+// The HPACK token names in http2_token order, then the HTTP/1 only ones. Lower case as HTTP/2 sends them.
+constexpr StaticStringMapEntry<HeaderTokens> kHeaderTokens[] = {
+    {":authority", {http2::HTTP2_TOKEN__AUTHORITY, HT_UNKNOWN}},
+    {":method", {http2::HTTP2_TOKEN__METHOD, HT_UNKNOWN}},
+    {":path", {http2::HTTP2_TOKEN__PATH, HT_UNKNOWN}},
+    {":scheme", {http2::HTTP2_TOKEN__SCHEME, HT_UNKNOWN}},
+    {":status", {http2::HTTP2_TOKEN__STATUS, HT_UNKNOWN}},
+    {"accept-charset", {http2::HTTP2_TOKEN_ACCEPT_CHARSET, HT_UNKNOWN}},
+    {"accept-encoding", {http2::HTTP2_TOKEN_ACCEPT_ENCODING, HT_ACCEPT_ENCODING}},
+    {"accept-language", {http2::HTTP2_TOKEN_ACCEPT_LANGUAGE, HT_UNKNOWN}},
+    {"accept-ranges", {http2::HTTP2_TOKEN_ACCEPT_RANGES, HT_UNKNOWN}},
+    {"accept", {http2::HTTP2_TOKEN_ACCEPT, HT_ACCEPT}},
+    {"access-control-allow-origin", {http2::HTTP2_TOKEN_ACCESS_CONTROL_ALLOW_ORIGIN, HT_UNKNOWN}},
+    {"age", {http2::HTTP2_TOKEN_AGE, HT_UNKNOWN}},
+    {"allow", {http2::HTTP2_TOKEN_ALLOW, HT_UNKNOWN}},
+    {"authorization", {http2::HTTP2_TOKEN_AUTHORIZATION, HT_AUTHORIZATION}},
+    {"cache-control", {http2::HTTP2_TOKEN_CACHE_CONTROL, HT_CACHE_CONTROL}},
+    {"content-disposition", {http2::HTTP2_TOKEN_CONTENT_DISPOSITION, HT_UNKNOWN}},
+    {"content-encoding", {http2::HTTP2_TOKEN_CONTENT_ENCODING, HT_CONTENT_ENCODING}},
+    {"content-language", {http2::HTTP2_TOKEN_CONTENT_LANGUAGE, HT_UNKNOWN}},
+    {"content-length", {http2::HTTP2_TOKEN_CONTENT_LENGTH, HT_CONTENT_LENGTH}},
+    {"content-location", {http2::HTTP2_TOKEN_CONTENT_LOCATION, HT_UNKNOWN}},
+    {"content-range", {http2::HTTP2_TOKEN_CONTENT_RANGE, HT_UNKNOWN}},
+    {"content-type", {http2::HTTP2_TOKEN_CONTENT_TYPE, HT_CONTENT_TYPE}},
+    {"cookie", {http2::HTTP2_TOKEN_COOKIE, HT_COOKIE}},
+    {"date", {http2::HTTP2_TOKEN_DATE, HT_DATE}},
+    {"etag", {http2::HTTP2_TOKEN_ETAG, HT_UNKNOWN}},
+    {"expect", {http2::HTTP2_TOKEN_EXPECT, HT_UNKNOWN}},
+    {"expires", {http2::HTTP2_TOKEN_EXPIRES, HT_UNKNOWN}},
+    {"from", {http2::HTTP2_TOKEN_FROM, HT_UNKNOWN}},
+    {"host", {http2::HTTP2_TOKEN_HOST, HT_HOST}},
+    {"if-match", {http2::HTTP2_TOKEN_IF_MATCH, HT_UNKNOWN}},
+    {"if-modified-since", {http2::HTTP2_TOKEN_IF_MODIFIED_SINCE, HT_UNKNOWN}},
+    {"if-none-match", {http2::HTTP2_TOKEN_IF_NONE_MATCH, HT_UNKNOWN}},
+    {"if-range", {http2::HTTP2_TOKEN_IF_RANGE, HT_UNKNOWN}},
+    {"if-unmodified-since", {http2::HTTP2_TOKEN_IF_UNMODIFIED_SINCE, HT_UNKNOWN}},
+    {"last-modified", {http2::HTTP2_TOKEN_LAST_MODIFIED, HT_UNKNOWN}},
+    {"link", {http2::HTTP2_TOKEN_LINK, HT_UNKNOWN}},
+    {"location", {http2::HTTP2_TOKEN_LOCATION, HT_LOCATION}},
+    {"max-forwards", {http2::HTTP2_TOKEN_MAX_FORWARDS, HT_UNKNOWN}},
+    {"proxy-authenticate", {http2::HTTP2_TOKEN_PROXY_AUTHENTICATE, HT_UNKNOWN}},
+    {"proxy-authorization", {http2::HTTP2_TOKEN_PROXY_AUTHORIZATION, HT_UNKNOWN}},
+    {"range", {http2::HTTP2_TOKEN_RANGE, HT_RANGE}},
+    {"referer", {http2::HTTP2_TOKEN_REFERER, HT_UNKNOWN}},
+    {"refresh", {http2::HTTP2_TOKEN_REFRESH, HT_UNKNOWN}},
+    {"retry-after", {http2::HTTP2_TOKEN_RETRY_AFTER, HT_UNKNOWN}},
+    {"server", {http2::HTTP2_TOKEN_SERVER, HT_SERVER}},
+    {"set-cookie", {http2::HTTP2_TOKEN_SET_COOKIE, HT_SET_COOKIE}},
+    {"strict-transport-security", {http2::HTTP2_TOKEN_STRICT_TRANSPORT_SECURITY, HT_UNKNOWN}},
+    {"transfer-encoding", {http2::HTTP2_TOKEN_TRANSFER_ENCODING, HT_TRANSFER_ENCODING}},
+    {"user-agent", {http2::HTTP2_TOKEN_USER_AGENT, HT_USER_AGENT}},
+    {"vary", {http2::HTTP2_TOKEN_VARY, HT_UNKNOWN}},
+    {"via", {http2::HTTP2_TOKEN_VIA, HT_UNKNOWN}},
+    {"www-authenticate", {http2::HTTP2_TOKEN_WWW_AUTHENTICATE, HT_UNKNOWN}},
+    {"te", {http2::HTTP2_TOKEN_TE, HT_UNKNOWN}},
+    {"connection", {http2::HTTP2_TOKEN_CONNECTION, HT_CONNECTION}},
+    {"keep-alive", {http2::HTTP2_TOKEN_KEEP_ALIVE, HT_KEEP_ALIVE}},
+    {"proxy-connection", {http2::HTTP2_TOKEN_PROXY_CONNECTION, HT_UNKNOWN}},
+    {"upgrade", {http2::HTTP2_TOKEN_UPGRADE, HT_UPGRADE}},
+    {"origin", {-1, HT_ORIGIN}},
+    {"sec-websocket-accept", {-1, HT_SEC_WEBSOCKET_ACCEPT}},
+    {"sec-websocket-key", {-1, HT_SEC_WEBSOCKET_KEY}},
+    {"sec-websocket-protocol", {-1, HT_SEC_WEBSOCKET_PROTOCOL}},
+    {"sec-websocket-version", {-1, HT_SEC_WEBSOCKET_VERSION}},
+};
+constexpr auto kHeaderTokensMap = MakeStaticStringMap(kHeaderTokens);
+static_assert(kHeaderTokensMap.IsPerfect(), "header token table has no perfect hash");
+
+}  // namespace
+
+const HeaderTokens* FindHeaderTokens(const char* name, size_t len, bool case_sensitive) {
+  if (!name || len == 0) {
+    return nullptr;
+  }
+
+  const StringPiece key(name, len);
+  return case_sensitive ? kHeaderTokensMap.FindCaseSensitive(key) : kHeaderTokensMap.Find(key);
+}
+
+}  // namespace internal
+}  // namespace http
+}  // namespace common
@@ -30,13 +30,32 @@
 #include <common/convert2string.h>  // for ConvertFromString
 #include <common/http/http.h>
 #include <common/sprintf.h>
+#include <common/static_string_map.h>
 #include <common/string_split.h>
 #include <common/uri/gurl.h>
 #include <common/uri/url_util.h>
+#include <common/uri/url_view.h>
 #include <common/utils.h>
 
+#include "header_tokens.h"
+
 namespace common {
 
+namespace {
+
+constexpr StaticStringMapEntry<http::http_protocol> kProtocols[] = {{HTTP_1_0_PROTOCOL_NAME, http::HP_1_0},
+                                                                     {HTTP_1_1_PROTOCOL_NAME, http::HP_1_1},
+                                                                     {HTTP_2_0_PROTOCOL_NAME, http::HP_2_0}};
+constexpr auto kProtocolsMap = MakeStaticStringMap(kProtocols);
+static_assert(kProtocolsMap.IsPerfect(), "protocol table has no perfect hash");
+
+constexpr StaticStringMapEntry<http::http_method> kMethods[] = {
+    {"GET", http::HM_GET}, {"HEAD", http::HM_HEAD}, {"POST", http::HM_POST}};
+constexpr auto kMethodsMap = MakeStaticStringMap(kMethods);
+static_assert(kMethodsMap.IsPerfect(), "method table has no perfect hash");
+
+}  // namespace
+
 std::string ConvertToString(http::http_protocol protocol) {
   if (protocol == http::HP_1_0) {
     return HTTP_1_0_PROTOCOL_NAME;
@@ -55,25 +74,47 @@ bool ConvertFromString(const std::string& from, http::http_protocol* out) {
     return false;
   }
 
-  if (from == HTTP_1_0_PROTOCOL_NAME) {
-    *out = http::HP_1_0;
-    return true;
-  } else if (from == HTTP_1_1_PROTOCOL_NAME) {
-    *out = http::HP_1_1;
-    return true;
-  } else if (from == HTTP_2_0_PROTOCOL_NAME) {
-    *out = http::HP_2_0;
-    return true;
+  const http::http_protocol* protocol = kProtocolsMap.FindCaseSensitive(from);
+  if (!protocol) {
+    DNOTREACHED() << "Unknown protocol: " << from;
+    return false;
   }
 
-  DNOTREACHED() << "Unknown protocol: " << from;
-  return false;
+  *out = *protocol;
+  return true;
 }
 
 namespace http {
 
 namespace {
 
+const char* const kHeaderTokenNames[HT_COUNT] = {"Accept",
+                                                 "Accept-Encoding",
+                                                 "Authorization",
+                                                 "Cache-Control",
+                                                 "Connection",
+                                                 "Content-Encoding",
+                                                 "Content-Length",
+                                                 "Content-Type",
+                                                 "Cookie",
+                                                 "Date",
+                                                 "Host",
+                                                 "Keep-Alive",
+                                                 "Location",
+                                                 "Origin",
+                                                 "Range",
+                                                 "Sec-WebSocket-Accept",
+                                                 "Sec-WebSocket-Key",
+                                                 "Sec-WebSocket-Protocol",
+                                                 "Sec-WebSocket-Version",
+                                                 "Server",
+                                                 "Set-Cookie",
+                                                 "Transfer-Encoding",
+                                                 "Upgrade",
+                                                 "User-Agent"};
+
+const size_t kNoHeaderIndex = static_cast<size_t>(-1);
+
 common::Error ParseHttpHeader(const std::string& line, HttpHeader* out) {
   if (line.empty() || !out) {
     return common::make_error_inval();
@@ -101,7 +142,7 @@ common::Error ParseHttpHeaders(const std::string& headers_data, HttpResponse* ou
   }
 
   http_protocol lprotocol = HP_1_0;
-  headers_t lheaders;
+  HttpHeaders lheaders;
   uint16_t lstatus = 0;
 
   std::vector<std::string> result = common::SplitString(headers_data, "\r\n", TRIM_WHITESPACE, SPLIT_WANT_ALL);
@@ -140,81 +181,16 @@ common::Error ParseHttpHeaders(const std::string& headers_data, HttpResponse* ou
     HttpHeader lhead;
     common::Error perr = ParseHttpHeader(result[i], &lhead);
     if (!perr) {
-      lheaders.push_back(lhead);
+      lheaders.Add(std::move(lhead));
     }
   }
 
-  *out = HttpResponse(lprotocol, static_cast<http_status>(lstatus), lheaders, char_buffer_t());
+  *out = HttpResponse(lprotocol, static_cast<http_status>(lstatus), std::move(lheaders), char_buffer_t());
   return common::Error();
 }
 
-}  // namespace
-
-const char* MimeTypes::GetType(const char* extension) {
-  const char* dot = strrchr(extension, '.');
-  if (dot) {
-    if (dot != extension) {
-      extension = dot;
-    }
-
-    extension++;
-  }
-
-  int min = 0;
-  int max = (sizeof(types) / sizeof(*types) - 1);
-
-  while (min <= max) {
-    int i = (int)(((max + min) / 2) + 0.5);
-    int order = strcmpi(extension, types[i].fileExtension);
-
-    if (order == 0) {
-      return types[i].mimeType;
-    } else if (order > 0) {
-      min = i + 1;
-    } else {
-      max = i - 1;
-    }
-  }
-
-  return NULL;
-}
-
-const char* MimeTypes::GetExtension(const char* type) {
-  int length = (sizeof(types) / sizeof(*types));
-
-  for (int i = 0; i < length; i++) {
-    if (strcmpi(type, types[i].mimeType) == 0) {
-      return types[i].fileExtension;
-    }
-  }
-
-  return NULL;
-}
-
-// https://www.geeksforgeeks.org/write-your-own-strcmp-which-ignores-cases/
-int MimeTypes::strcmpi(const char* s1, const char* s2) {
-  int i;
-
-  for (i = 0; s1[i] && s2[i]; ++i) {
-    if (s1[i] == s2[i] || (s1[i] ^ 32) == s2[i]) {
-      continue;
-    } else {
-      break;
-    }
-  }
-
-  if (s1[i] == s2[i]) {
-    return 0;
-  }
-
-  if ((s1[i] | 32) < (s2[i] | 32)) {
-    return -1;
-  }
-
-  return 1;
-}
-
-MimeTypes::entry MimeTypes::types[348] = {
+// Sorted by extension, several extensions may share a type.
+constexpr StaticStringMapEntry<const char*> kMimeTypes[] = {
     {"*3gpp", "audio/3gpp"},
     {"*jpm", "video/jpm"},
     {"*mp3", "audio/mp3"},
@@ -566,6 +542,43 @@ MimeTypes::entry MimeTypes::types[348] = {
     {"zip", "application/zip"},
 };
 
+constexpr auto kMimeTypesMap = MakeStaticStringMap(kMimeTypes);
+static_assert(kMimeTypesMap.IsPerfect(), "mime types table has no perfect hash");
+
+template <size_t N>
+constexpr StaticStringMap<const char*, N> MakeExtensionsMap(const StaticStringMapEntry<const char*> (&types)[N]) {
+  StaticStringMapEntry<const char*> extensions[N] = {};
+  for (size_t i = 0; i < N; ++i) {
+    extensions[i] = {types[i].value, types[i].key};
+  }
+  return StaticStringMap<const char*, N>(extensions);
+}
+
+// The first extension listed for a type wins.
+constexpr auto kExtensionsMap = MakeExtensionsMap(kMimeTypes);
+static_assert(kExtensionsMap.IsPerfect(), "mime extensions table has no perfect hash");
+
+}  // namespace
+
+const char* MimeTypes::GetType(const char* extension) {
+  const char* dot = strrchr(extension, '.');
+  if (dot) {
+    if (dot != extension) {
+      extension = dot;
+    }
+
+    extension++;
+  }
+
+  const char* const* type = kMimeTypesMap.Find(extension);
+  return type ? *type : nullptr;
+}
+
+const char* MimeTypes::GetExtension(const char* type) {
+  const char* const* extension = kExtensionsMap.Find(type);
+  return extension ? *extension : nullptr;
+}
+
 HttpHeader::HttpHeader() : key(), value() {}
 
 HttpHeader::HttpHeader(const std::string& key, const std::string& value) : key(key), value(value) {}
@@ -578,6 +591,146 @@ std::string HttpHeader::as_string() const {
   return MemSPrintf("%s: %s", key, value);
 }
 
+http_header_token LookupHeaderToken(const char* name, size_t len) {
+  const internal::HeaderTokens* tokens = internal::FindHeaderTokens(name, len, false);
+  return tokens ? tokens->http : HT_UNKNOWN;
+}
+
+http_header_token LookupHeaderToken(const std::string& name) {
+  return LookupHeaderToken(name.data(), name.size());
+}
+
+const char* GetHeaderTokenName(http_header_token token) {
+  if (token <= HT_UNKNOWN || token >= HT_COUNT) {
+    return nullptr;
+  }
+  return kHeaderTokenNames[token];
+}
+
+HttpHeaders::HttpHeaders() : headers_(), index_() {
+  index_.fill(kNoHeaderIndex);
+}
+
+HttpHeaders::HttpHeaders(const headers_t& headers) : headers_(headers), index_() {
+  Reindex();
+}
+
+HttpHeaders::HttpHeaders(headers_t&& headers) : headers_(std::move(headers)), index_() {
+  Reindex();
+}
+
+const headers_t& HttpHeaders::GetHeaders() const {
+  return headers_;
+}
+
+size_t HttpHeaders::GetSize() const {
+  return headers_.size();
+}
+
+bool HttpHeaders::IsEmpty() const {
+  return headers_.empty();
+}
+
+HttpHeaders::const_iterator HttpHeaders::begin() const {
+  return headers_.begin();
+}
+
+HttpHeaders::const_iterator HttpHeaders::end() const {
+  return headers_.end();
+}
+
+void HttpHeaders::Add(const header_t& header) {
+  headers_.push_back(header);
+  IndexAt(headers_.size() - 1);
+}
+
+void HttpHeaders::Add(header_t&& header) {
+  headers_.push_back(std::move(header));
+  IndexAt(headers_.size() - 1);
+}
+
+void HttpHeaders::Clear() {
+  headers_.clear();
+  index_.fill(kNoHeaderIndex);
+}
+
+const header_t* HttpHeaders::Find(http_header_token token) const {
+  if (token <= HT_UNKNOWN || token >= HT_COUNT) {
+    return nullptr;
+  }
+
+  const size_t pos = index_[token];
+  if (pos == kNoHeaderIndex) {
+    return nullptr;
+  }
+  return &headers_[pos];
+}
+
+const header_t* HttpHeaders::Find(const std::string& key, bool case_sensitive) const {
+  const http_header_token token = LookupHeaderToken(key);
+  if (token != HT_UNKNOWN) {
+    const header_t* found = Find(token);
+    if (!found) {
+      return nullptr;
+    }
+    // the index holds the first case-insensitive match, an exact match may only come later
+    if (!case_sensitive || found->key == key) {
+      return found;
+    }
+  }
+
+  for (size_t i = 0; i < headers_.size(); ++i) {
+    if (EqualsASCII(headers_[i].key, key, case_sensitive)) {
+      return &headers_[i];
+    }
+  }
+  return nullptr;
+}
+
+const header_t* HttpHeaders::FindByValue(const std::string& value, bool case_sensitive) const {
+  for (size_t i = 0; i < headers_.size(); ++i) {
+    if (EqualsASCII(headers_[i].value, value, case_sensitive)) {
+      return &headers_[i];
+    }
+  }
+  return nullptr;
+}
+
+bool HttpHeaders::Change(const std::string& key, bool case_sensitive, const header_t& new_value) {
+  const header_t* found = Find(key, case_sensitive);
+  if (!found) {
+    return false;
+  }
+
+  headers_[found - headers_.data()] = new_value;
+  Reindex();
+  return true;
+}
+
+void HttpHeaders::Remove(const std::string& key, bool case_sensitive) {
+  const header_t* found = Find(key, case_sensitive);
+  if (!found) {
+    return;
+  }
+
+  headers_.erase(headers_.begin() + (found - headers_.data()));
+  Reindex();
+}
+
+void HttpHeaders::Reindex() {
+  index_.fill(kNoHeaderIndex);
+  for (size_t i = 0; i < headers_.size(); ++i) {
+    IndexAt(i);
+  }
+}
+
+void HttpHeaders::IndexAt(size_t pos) {
+  const http_header_token token = LookupHeaderToken(headers_[pos].key);
+  if (token != HT_UNKNOWN && index_[token] == kNoHeaderIndex) {
+    index_[token] = pos;
+  }
+}
+
 HttpRequest::HttpRequest() : method_(), relative_url_(), base_url_(), protocol_(), headers_(), body_() {}
 
 HttpRequest::HttpRequest(http_method method,
@@ -587,19 +740,31 @@ HttpRequest::HttpRequest(http_method method,
                          const body_t& body)
     : method_(method), relative_url_(relative_url), base_url_(), protocol_(protocol), headers_(headers), body_(body) {}
 
+HttpRequest::HttpRequest(http_method method,
+                         const path_t& relative_url,
+                         http_protocol protocol,
+                         HttpHeaders&& headers,
+                         body_t&& body)
+    : method_(method),
+      relative_url_(relative_url),
+      base_url_(),
+      protocol_(protocol),
+      headers_(std::move(headers)),
+      body_(std::move(body)) {}
+
 http::http_protocol HttpRequest::GetProtocol() const {
   return protocol_;
 }
 
-headers_t HttpRequest::GetHeaders() const {
-  return headers_;
+const headers_t& HttpRequest::GetHeaders() const {
+  return headers_.GetHeaders();
 }
 
 bool HttpRequest::IsValid() const {
   return !relative_url_.empty();
 }
 
-HttpRequest::path_t HttpRequest::GetRelativeUrl() const {
+const HttpRequest::path_t& HttpRequest::GetRelativeUrl() const {
   return relative_url_;
 }
 
@@ -613,9 +778,9 @@ uri::GURL HttpRequest::GetURL() const {
   }
 
   std::string host = "localhost";
-  header_t server;
-  if (FindHeaderByKey("Host", false, &server)) {
-    host = server.value;
+  const header_t* server = headers_.Find(HT_HOST);
+  if (server) {
+    host = server->value;
   }
   return uri::GURL(MemSPrintf("http://%s%s", host, relative_url_));
 }
@@ -624,30 +789,20 @@ http::http_method HttpRequest::GetMethod() const {
   return method_;
 }
 
-HttpRequest::body_t HttpRequest::GetBody() const {
+const HttpRequest::body_t& HttpRequest::GetBody() const {
   return body_;
 }
 
 bool HttpRequest::FindHeaderByKeyAndChange(const std::string& key, bool case_sensitive, header_t new_value) {
-  for (size_t i = 0; i < headers_.size(); ++i) {
-    std::string cur_key = headers_[i].key;
-    if (EqualsASCII(cur_key, key, case_sensitive)) {
-      headers_[i] = new_value;
-      return true;
-    }
-  }
-
-  return false;
+  return headers_.Change(key, case_sensitive, new_value);
 }
 
 void HttpRequest::RemoveHeaderByKey(const std::string& key, bool case_sensitive) {
-  for (size_t i = 0; i < headers_.size(); ++i) {
-    std::string curKey = headers_[i].key;
-    if (EqualsASCII(curKey, key, case_sensitive)) {
-      headers_.erase(headers_.begin(), headers_.begin() + i);
-      return;
-    }
-  }
+  headers_.Remove(key, case_sensitive);
+}
+
+const header_t* HttpRequest::GetHeader(http_header_token token) const {
+  return headers_.Find(token);
 }
 
 bool HttpRequest::FindHeaderByKey(const std::string& key, bool case_sensitive, header_t* hdr) const {
@@ -655,15 +810,13 @@ bool HttpRequest::FindHeaderByKey(const std::string& key, bool case_sensitive, h
     return false;
   }
 
-  for (size_t i = 0; i < headers_.size(); ++i) {
-    std::string curKey = headers_[i].key;
-    if (EqualsASCII(curKey, key, case_sensitive)) {
-      *hdr = headers_[i];
-      return true;
-    }
+  const header_t* found = headers_.Find(key, case_sensitive);
+  if (!found) {
+    return false;
   }
 
-  return false;
+  *hdr = *found;
+  return true;
 }
 
 bool HttpRequest::FindHeaderByValue(const std::string& value, bool case_sensitive, header_t* hdr) const {
@@ -671,15 +824,13 @@ bool HttpRequest::FindHeaderByValue(const std::string& value, bool case_sensitiv
     return false;
   }
 
-  for (size_t i = 0; i < headers_.size(); ++i) {
-    std::string curKey = headers_[i].value;
-    if (EqualsASCII(curKey, value, case_sensitive)) {
-      *hdr = headers_[i];
-      return true;
-    }
+  const header_t* found = headers_.FindByValue(value, case_sensitive);
+  if (!found) {
+    return false;
   }
 
-  return false;
+  *hdr = *found;
+  return true;
 }
 
 Optional<HttpRequest> MakeHeadRequest(const std::string& path, http_protocol protocol, const headers_t& headers) {
@@ -720,7 +871,7 @@ std::pair<http_status, Error> parse_http_request(const char* request, size_t len
   http_method lmethod = HM_GET;
   std::string lpath;
   http_protocol lprotocol = HP_1_0;
-  headers_t lheaders;
+  HttpHeaders lheaders;
 
   const char* pos = nullptr;
   size_t start = 0;
@@ -752,14 +903,13 @@ std::pair<http_status, Error> parse_http_request(const char* request, size_t len
             if (!ConvertFromString(protocol_str, &lprotocol)) {
               DNOTREACHED() << "Unknown protocol: " << protocol_str;
             }
-            common::uri::GURL url(path);
-            if (url.is_valid()) {
-              lpath = url.PathForRequest();
-            } else if (path[0] == '/') {
-              lpath = path;
-            } else {
-              lpath = "/" + path;
+            // dot segments and escapes must not reach the handlers as written, e.g. when serving files
+            const uri::UrlView url(path);
+            uri::RawCanonOutputT<char> canon_path;
+            if (!url.CanonicalizePathForRequest(&canon_path)) {
+              return std::make_pair(HS_BAD_REQUEST, make_error("Bad filename."));
             }
+            lpath.assign(canon_path.data(), canon_path.length());
           } else {
             return std::make_pair(HS_FORBIDDEN, make_error("Not allowed."));
           }
@@ -773,7 +923,7 @@ std::pair<http_status, Error> parse_http_request(const char* request, size_t len
       HttpHeader lhead;
       common::Error perr = ParseHttpHeader(line, &lhead);
       if (!perr) {
-        lheaders.push_back(lhead);
+        lheaders.Add(std::move(lhead));
       }
     }
     line_count++;
@@ -790,8 +940,8 @@ std::pair<http_status, Error> parse_http_request(const char* request, size_t len
     return std::make_pair(HS_BAD_REQUEST, make_error("Not found CRLF"));
   }
 
-  *req_out =
-      HttpRequest(lmethod, lpath, lprotocol, lheaders, MAKE_CHAR_BUFFER_SIZE(unescaped.data(), unescaped.length()));
+  *req_out = HttpRequest(lmethod, lpath, lprotocol, std::move(lheaders),
+                         MAKE_CHAR_BUFFER_SIZE(unescaped.data(), unescaped.length()));
   return std::make_pair(HS_OK, Error());
 }
 
@@ -811,20 +961,25 @@ HttpResponse::HttpResponse(http_protocol protocol,
                            const char_buffer_t& body)
     : protocol_(protocol), status_(status), headers_(headers), body_(body) {}
 
+HttpResponse::HttpResponse(http_protocol protocol, http_status status, HttpHeaders&& headers, body_t&& body)
+    : protocol_(protocol), status_(status), headers_(std::move(headers)), body_(std::move(body)) {}
+
+const header_t* HttpResponse::GetHeader(http_header_token token) const {
+  return headers_.Find(token);
+}
+
 bool HttpResponse::FindHeaderByKey(const std::string& key, bool case_sensitive, header_t* hdr) const {
   if (!hdr) {
     return false;
   }
 
-  for (size_t i = 0; i < headers_.size(); ++i) {
-    std::string curKey = headers_[i].key;
-    if (EqualsASCII(curKey, key, case_sensitive)) {
-      *hdr = headers_[i];
-      return true;
-    }
+  const header_t* found = headers_.Find(key, case_sensitive);
+  if (!found) {
+    return false;
   }
 
-  return false;
+  *hdr = *found;
+  return true;
 }
 
 void HttpResponse::SetBody(const body_t& body) {
@@ -835,7 +990,7 @@ bool HttpResponse::IsEmptyBody() const {
   return body_.empty();
 }
 
-HttpResponse::body_t HttpResponse::GetBody() const {
+const HttpResponse::body_t& HttpResponse::GetBody() const {
   return body_;
 }
 
@@ -847,8 +1002,8 @@ http_protocol HttpResponse::GetProtocol() const {
   return protocol_;
 }
 
-headers_t HttpResponse::GetHeaders() const {
-  return headers_;
+const headers_t& HttpResponse::GetHeaders() const {
+  return headers_.GetHeaders();
 }
 
 Error parse_http_response(const std::string& response, HttpResponse* res_out, size_t* not_parsed) {
@@ -872,10 +1027,10 @@ Error parse_http_response(const std::string& response, HttpResponse* res_out, si
   }
 
   size_t lnot_parsed = body_data.size();
-  http::header_t cont;
-  if (lres.FindHeaderByKey("Content-Length", false, &cont)) {
+  const http::header_t* cont = lres.GetHeader(HT_CONTENT_LENGTH);
+  if (cont) {
     size_t body_len = 0;
-    if (ConvertFromString(cont.value, &body_len)) {
+    if (ConvertFromString(cont->value, &body_len)) {
       if (lnot_parsed == body_len) {  // full
         lres.SetBody(MAKE_CHAR_BUFFER_SIZE(body_data.data(), body_len));
         lnot_parsed = 0;
@@ -886,7 +1041,7 @@ Error parse_http_response(const std::string& response, HttpResponse* res_out, si
   }
 
   *not_parsed = lnot_parsed;
-  *res_out = lres;
+  *res_out = std::move(lres);
   return Error();
 }
 
@@ -907,18 +1062,13 @@ bool ConvertFromString(const std::string& from, http::http_method* out) {
     return false;
   }
 
-  if (from == "GET") {
-    *out = http::HM_GET;
-    return true;
-  } else if (from == "HEAD") {
-    *out = http::HM_HEAD;
-    return true;
-  } else if (from == "POST") {
-    *out = http::HM_POST;
-    return true;
+  const http::http_method* method = kMethodsMap.FindCaseSensitive(from);
+  if (!method) {
+    return false;
   }
 
-  return false;
+  *out = *method;
+  return true;
 }
 
 std::string ConvertToString(http::http_status status) {
@@ -1037,9 +1187,9 @@ std::string ConvertToString(http::HttpRequest request) {
 
   std::string headerout = MemSPrintf("%s %s %s\r\n", ConvertToString(method), upath,
                                      ConvertToString(request.GetProtocol()));  // "GET /hello.htm HTTP/1.1\r\n"
-  http::headers_t headers = request.GetHeaders();
+  const http::headers_t& headers = request.GetHeaders();
   for (size_t i = 0; i < headers.size(); ++i) {
-    http::header_t header = headers[i];
+    const http::header_t& header = headers[i];
     std::string headerStr = ConvertToString(header);
     if (!headerStr.empty()) {
       headerout += headerStr + "\r\n";
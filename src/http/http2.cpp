@@ -32,11 +32,11 @@
 #include <common/portable_endian.h>
 #include <string.h>
 
+#include "header_tokens.h"
+
 #define MAKE_STATIC_ENT(N, V, T, H) \
   { {MAKE_BUFFER(N), MAKE_BUFFER(V), 0}, nullptr, 0, (H), (T) }
 
-#define lstreq(A, B, N) ((sizeof((A)) - 1) == (N) && memcmp((A), (B), (N)) == 0)
-
 #define INDEX_RANGE_VALID(context, idx) ((idx) < (context)->hd_table.len + HTTP2_STATIC_TABLE_LENGTH)
 
 namespace common {
@@ -563,383 +563,10 @@ void hd_context_shrink_table_size(http2_context* context, http2_map* map) {
 }
 
 int lookup_token(const uint8_t* name, uint32_t namelen) {
-  switch (namelen) {
-    case 2:
-      switch (name[1]) {
-        case 'e':
-          if (lstreq("t", name, 1)) {
-            return HTTP2_TOKEN_TE;
-          }
-          break;
-      }
-      break;
-    case 3:
-      switch (name[2]) {
-        case 'a':
-          if (lstreq("vi", name, 2)) {
-            return HTTP2_TOKEN_VIA;
-          }
-          break;
-        case 'e':
-          if (lstreq("ag", name, 2)) {
-            return HTTP2_TOKEN_AGE;
-          }
-          break;
-      }
-      break;
-    case 4:
-      switch (name[3]) {
-        case 'e':
-          if (lstreq("dat", name, 3)) {
-            return HTTP2_TOKEN_DATE;
-          }
-          break;
-        case 'g':
-          if (lstreq("eta", name, 3)) {
-            return HTTP2_TOKEN_ETAG;
-          }
-          break;
-        case 'k':
-          if (lstreq("lin", name, 3)) {
-            return HTTP2_TOKEN_LINK;
-          }
-          break;
-        case 'm':
-          if (lstreq("fro", name, 3)) {
-            return HTTP2_TOKEN_FROM;
-          }
-          break;
-        case 't':
-          if (lstreq("hos", name, 3)) {
-            return HTTP2_TOKEN_HOST;
-          }
-          break;
-        case 'y':
-          if (lstreq("var", name, 3)) {
-            return HTTP2_TOKEN_VARY;
-          }
-          break;
-      }
-      break;
-    case 5:
-      switch (name[4]) {
-        case 'e':
-          if (lstreq("rang", name, 4)) {
-            return HTTP2_TOKEN_RANGE;
-          }
-          break;
-        case 'h':
-          if (lstreq(":pat", name, 4)) {
-            return HTTP2_TOKEN__PATH;
-          }
-          if (lstreq(":pat", name, 4)) {
-            return HTTP2_TOKEN__PATH;
-          }
-          break;
-        case 'w':
-          if (lstreq("allo", name, 4)) {
-            return HTTP2_TOKEN_ALLOW;
-          }
-          break;
-      }
-      break;
-    case 6:
-      switch (name[5]) {
-        case 'e':
-          if (lstreq("cooki", name, 5)) {
-            return HTTP2_TOKEN_COOKIE;
-          }
-          break;
-        case 'r':
-          if (lstreq("serve", name, 5)) {
-            return HTTP2_TOKEN_SERVER;
-          }
-          break;
-        case 't':
-          if (lstreq("accep", name, 5)) {
-            return HTTP2_TOKEN_ACCEPT;
-          }
-          if (lstreq("expec", name, 5)) {
-            return HTTP2_TOKEN_EXPECT;
-          }
-          break;
-      }
-      break;
-    case 7:
-      switch (name[6]) {
-        case 'd':
-          if (lstreq(":metho", name, 6)) {
-            return HTTP2_TOKEN__METHOD;
-          }
-          if (lstreq(":metho", name, 6)) {
-            return HTTP2_TOKEN__METHOD;
-          }
-          break;
-        case 'e':
-          if (lstreq(":schem", name, 6)) {
-            return HTTP2_TOKEN__SCHEME;
-          }
-          if (lstreq(":schem", name, 6)) {
-            return HTTP2_TOKEN__SCHEME;
-          }
-          if (lstreq("upgrad", name, 6)) {
-            return HTTP2_TOKEN_UPGRADE;
-          }
-          break;
-        case 'h':
-          if (lstreq("refres", name, 6)) {
-            return HTTP2_TOKEN_REFRESH;
-          }
-          break;
-        case 'r':
-          if (lstreq("refere", name, 6)) {
-            return HTTP2_TOKEN_REFERER;
-          }
-          break;
-        case 's':
-          if (lstreq(":statu", name, 6)) {
-            return HTTP2_TOKEN__STATUS;
-          }
-          if (lstreq(":statu", name, 6)) {
-            return HTTP2_TOKEN__STATUS;
-          }
-          if (lstreq(":statu", name, 6)) {
-            return HTTP2_TOKEN__STATUS;
-          }
-          if (lstreq(":statu", name, 6)) {
-            return HTTP2_TOKEN__STATUS;
-          }
-          if (lstreq(":statu", name, 6)) {
-            return HTTP2_TOKEN__STATUS;
-          }
-          if (lstreq(":statu", name, 6)) {
-            return HTTP2_TOKEN__STATUS;
-          }
-          if (lstreq(":statu", name, 6)) {
-            return HTTP2_TOKEN__STATUS;
-          }
-          if (lstreq("expire", name, 6)) {
-            return HTTP2_TOKEN_EXPIRES;
-          }
-          break;
-      }
-      break;
-    case 8:
-      switch (name[7]) {
-        case 'e':
-          if (lstreq("if-rang", name, 7)) {
-            return HTTP2_TOKEN_IF_RANGE;
-          }
-          break;
-        case 'h':
-          if (lstreq("if-matc", name, 7)) {
-            return HTTP2_TOKEN_IF_MATCH;
-          }
-          break;
-        case 'n':
-          if (lstreq("locatio", name, 7)) {
-            return HTTP2_TOKEN_LOCATION;
-          }
-          break;
-      }
-      break;
-    case 10:
-      switch (name[9]) {
-        case 'e':
-          if (lstreq("keep-aliv", name, 9)) {
-            return HTTP2_TOKEN_KEEP_ALIVE;
-          }
-          if (lstreq("set-cooki", name, 9)) {
-            return HTTP2_TOKEN_SET_COOKIE;
-          }
-          break;
-        case 'n':
-          if (lstreq("connectio", name, 9)) {
-            return HTTP2_TOKEN_CONNECTION;
-          }
-          break;
-        case 't':
-          if (lstreq("user-agen", name, 9)) {
-            return HTTP2_TOKEN_USER_AGENT;
-          }
-          break;
-        case 'y':
-          if (lstreq(":authorit", name, 9)) {
-            return HTTP2_TOKEN__AUTHORITY;
-          }
-          break;
-      }
-      break;
-    case 11:
-      switch (name[10]) {
-        case 'r':
-          if (lstreq("retry-afte", name, 10)) {
-            return HTTP2_TOKEN_RETRY_AFTER;
-          }
-          break;
-      }
-      break;
-    case 12:
-      switch (name[11]) {
-        case 'e':
-          if (lstreq("content-typ", name, 11)) {
-            return HTTP2_TOKEN_CONTENT_TYPE;
-          }
-          break;
-        case 's':
-          if (lstreq("max-forward", name, 11)) {
-            return HTTP2_TOKEN_MAX_FORWARDS;
-          }
-          break;
-      }
-      break;
-    case 13:
-      switch (name[12]) {
-        case 'd':
-          if (lstreq("last-modifie", name, 12)) {
-            return HTTP2_TOKEN_LAST_MODIFIED;
-          }
-          break;
-        case 'e':
-          if (lstreq("content-rang", name, 12)) {
-            return HTTP2_TOKEN_CONTENT_RANGE;
-          }
-          break;
-        case 'h':
-          if (lstreq("if-none-matc", name, 12)) {
-            return HTTP2_TOKEN_IF_NONE_MATCH;
-          }
-          break;
-        case 'l':
-          if (lstreq("cache-contro", name, 12)) {
-            return HTTP2_TOKEN_CACHE_CONTROL;
-          }
-          break;
-        case 'n':
-          if (lstreq("authorizatio", name, 12)) {
-            return HTTP2_TOKEN_AUTHORIZATION;
-          }
-          break;
-        case 's':
-          if (lstreq("accept-range", name, 12)) {
-            return HTTP2_TOKEN_ACCEPT_RANGES;
-          }
-          break;
-      }
-      break;
-    case 14:
-      switch (name[13]) {
-        case 'h':
-          if (lstreq("content-lengt", name, 13)) {
-            return HTTP2_TOKEN_CONTENT_LENGTH;
-          }
-          break;
-        case 't':
-          if (lstreq("accept-charse", name, 13)) {
-            return HTTP2_TOKEN_ACCEPT_CHARSET;
-          }
-          break;
-      }
-      break;
-    case 15:
-      switch (name[14]) {
-        case 'e':
-          if (lstreq("accept-languag", name, 14)) {
-            return HTTP2_TOKEN_ACCEPT_LANGUAGE;
-          }
-          break;
-        case 'g':
-          if (lstreq("accept-encodin", name, 14)) {
-            return HTTP2_TOKEN_ACCEPT_ENCODING;
-          }
-          break;
-      }
-      break;
-    case 16:
-      switch (name[15]) {
-        case 'e':
-          if (lstreq("content-languag", name, 15)) {
-            return HTTP2_TOKEN_CONTENT_LANGUAGE;
-          }
-          if (lstreq("www-authenticat", name, 15)) {
-            return HTTP2_TOKEN_WWW_AUTHENTICATE;
-          }
-          break;
-        case 'g':
-          if (lstreq("content-encodin", name, 15)) {
-            return HTTP2_TOKEN_CONTENT_ENCODING;
-          }
-          break;
-        case 'n':
-          if (lstreq("content-locatio", name, 15)) {
-            return HTTP2_TOKEN_CONTENT_LOCATION;
-          }
-          if (lstreq("proxy-connectio", name, 15)) {
-            return HTTP2_TOKEN_PROXY_CONNECTION;
-          }
-          break;
-      }
-      break;
-    case 17:
-      switch (name[16]) {
-        case 'e':
-          if (lstreq("if-modified-sinc", name, 16)) {
-            return HTTP2_TOKEN_IF_MODIFIED_SINCE;
-          }
-          break;
-        case 'g':
-          if (lstreq("transfer-encodin", name, 16)) {
-            return HTTP2_TOKEN_TRANSFER_ENCODING;
-          }
-          break;
-      }
-      break;
-    case 18:
-      switch (name[17]) {
-        case 'e':
-          if (lstreq("proxy-authenticat", name, 17)) {
-            return HTTP2_TOKEN_PROXY_AUTHENTICATE;
-          }
-          break;
-      }
-      break;
-    case 19:
-      switch (name[18]) {
-        case 'e':
-          if (lstreq("if-unmodified-sinc", name, 18)) {
-            return HTTP2_TOKEN_IF_UNMODIFIED_SINCE;
-          }
-          break;
-        case 'n':
-          if (lstreq("content-dispositio", name, 18)) {
-            return HTTP2_TOKEN_CONTENT_DISPOSITION;
-          }
-          if (lstreq("proxy-authorizatio", name, 18)) {
-            return HTTP2_TOKEN_PROXY_AUTHORIZATION;
-          }
-          break;
-      }
-      break;
-    case 25:
-      switch (name[24]) {
-        case 'y':
-          if (lstreq("strict-transport-securit", name, 24)) {
-            return HTTP2_TOKEN_STRICT_TRANSPORT_SECURITY;
-          }
-          break;
-      }
-      break;
-    case 27:
-      switch (name[26]) {
-        case 'n':
-          if (lstreq("access-control-allow-origi", name, 26)) {
-            return HTTP2_TOKEN_ACCESS_CONTROL_ALLOW_ORIGIN;
-          }
-          break;
-      }
-      break;
-  }
-  return -1;
+  // field names are lower case in HTTP/2
+  const http::internal::HeaderTokens* tokens =
+      http::internal::FindHeaderTokens(reinterpret_cast<const char*>(name), namelen, true);
+  return tokens ? tokens->hpack : -1;
 }
 
 int emit_indexed_header(http2_nv* nv_out, int* token_out, http2_entry* ent) {
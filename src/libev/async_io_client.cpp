@@ -33,12 +33,14 @@
 #include <common/libev/io_loop.h>
 #include <common/libev/io_loop_observer.h>
 
-#include <cstring>
 #include <algorithm>
 
 namespace common {
 namespace libev {
 
+const size_t AsyncIoClient::kDefaultWriteLowWatermark;
+const size_t AsyncIoClient::kDefaultWriteHighWatermark;
+
 AsyncIoClient::AsyncIoClient(IoLoop* server, flags_t flags)
     : base_class(),
       server_(server),
@@ -49,7 +51,10 @@ AsyncIoClient::AsyncIoClient(IoLoop* server, flags_t flags)
       write_buffer_(),
       read_buffer_(),
       read_requested_size_(0),
-      is_writing_(false) {
+      is_writing_(false),
+      write_low_watermark_(kDefaultWriteLowWatermark),
+      write_high_watermark_(kDefaultWriteHighWatermark),
+      write_queue_full_(false) {
   read_write_io_->SetUserData(this);
 }
 
@@ -90,8 +95,8 @@ ErrnoError AsyncIoClient::Write(const void* data, size_t size) {
   }
 
   // Buffer the data
-  write_buffer_.insert(write_buffer_.end(), static_cast<const char*>(data),
-                       static_cast<const char*>(data) + size);
+  write_buffer_.Append(data, size);
+  CheckWriteWatermarks();
 
   // Start writing if not already
   StartAsyncWriteIfNeeded();
@@ -99,6 +104,17 @@ ErrnoError AsyncIoClient::Write(const void* data, size_t size) {
   return ErrnoError();
 }
 
+ErrnoError AsyncIoClient::Write(char_buffer_t&& buffer) {
+  if (buffer.empty()) {
+    return make_errno_error_inval();
+  }
+
+  write_buffer_.Append(std::move(buffer));
+  CheckWriteWatermarks();
+  StartAsyncWriteIfNeeded();
+  return ErrnoError();
+}
+
 ErrnoError AsyncIoClient::Read(size_t size) {
   if (!size) {
     return make_errno_error_inval();
@@ -107,7 +123,7 @@ ErrnoError AsyncIoClient::Read(size_t size) {
   read_requested_size_ = size;
 
   // If we already have enough data, notify immediately
-  if (read_buffer_.size() >= size) {
+  if (read_buffer_.GetSize() >= size) {
     OnReadCompleted(size);
     read_requested_size_ = 0;
   }
@@ -116,7 +132,7 @@ ErrnoError AsyncIoClient::Read(size_t size) {
 }
 
 size_t AsyncIoClient::GetAvailableReadData() const {
-  return read_buffer_.size();
+  return read_buffer_.GetSize();
 }
 
 ErrnoError AsyncIoClient::ReadAvailable(void* out_data, size_t max_size, size_t* nread_out) {
@@ -124,16 +140,9 @@ ErrnoError AsyncIoClient::ReadAvailable(void* out_data, size_t max_size, size_t*
     return make_errno_error_inval();
   }
 
-  size_t to_read = std::min(max_size, read_buffer_.size());
-  if (to_read > 0) {
-    memcpy(out_data, read_buffer_.data(), to_read);
-    read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + to_read);
-    *nread_out = to_read;
-    read_bytes_ += to_read;
-  } else {
-    *nread_out = 0;
-  }
-
+  const size_t nread = read_buffer_.Read(out_data, max_size);
+  read_bytes_ += nread;
+  *nread_out = nread;
   return ErrnoError();
 }
 
@@ -154,14 +163,14 @@ void AsyncIoClient::HandleReadEvent() {
   }
 
   // Check if we have enough data for the requested read
-  if (read_requested_size_ > 0 && read_buffer_.size() >= read_requested_size_) {
+  if (read_requested_size_ > 0 && read_buffer_.GetSize() >= read_requested_size_) {
     OnReadCompleted(read_requested_size_);
     read_requested_size_ = 0;
   }
 }
 
 void AsyncIoClient::HandleWriteEvent() {
-  if (write_buffer_.empty()) {
+  if (write_buffer_.IsEmpty()) {
     is_writing_ = false;
     UpdateIoFlags();
     return;
@@ -173,7 +182,8 @@ void AsyncIoClient::HandleWriteEvent() {
     return;
   }
 
-  if (write_buffer_.empty()) {
+  CheckWriteWatermarks();
+  if (write_buffer_.IsEmpty()) {
     is_writing_ = false;
     OnWriteCompleted(wrote_bytes_);  // Could track per operation
     UpdateIoFlags();
@@ -181,7 +191,7 @@ void AsyncIoClient::HandleWriteEvent() {
 }
 
 void AsyncIoClient::StartAsyncWriteIfNeeded() {
-  if (!is_writing_ && !write_buffer_.empty()) {
+  if (!is_writing_ && !write_buffer_.IsEmpty()) {
     is_writing_ = true;
     UpdateIoFlags();
     // The next EV_WRITE event will trigger HandleWriteEvent
@@ -200,13 +210,60 @@ void AsyncIoClient::OnReadCompleted(size_t bytes_read) {
   }
 }
 
+void AsyncIoClient::OnWriteQueueHigh(size_t pending_bytes) {
+  if (server_ && server_->GetObserver()) {
+    server_->GetObserver()->AsyncWriteQueueHigh(this, pending_bytes);
+  }
+}
+
+void AsyncIoClient::OnWriteQueueLow(size_t pending_bytes) {
+  if (server_ && server_->GetObserver()) {
+    server_->GetObserver()->AsyncWriteQueueLow(this, pending_bytes);
+  }
+}
+
+void AsyncIoClient::SetWriteWatermarks(size_t low, size_t high) {
+  DCHECK_LE(low, high);
+  write_low_watermark_ = low;
+  write_high_watermark_ = high;
+  CheckWriteWatermarks();
+}
+
+size_t AsyncIoClient::GetPendingWriteBytes() const {
+  return write_buffer_.GetSize();
+}
+
+bool AsyncIoClient::IsWriteQueueFull() const {
+  return write_queue_full_;
+}
+
+void AsyncIoClient::CheckWriteWatermarks() {
+  const size_t pending = write_buffer_.GetSize();
+  if (!write_queue_full_ && pending > write_high_watermark_) {
+    write_queue_full_ = true;
+    OnWriteQueueHigh(pending);
+  } else if (write_queue_full_ && pending <= write_low_watermark_) {
+    write_queue_full_ = false;
+    OnWriteQueueLow(pending);
+  }
+}
+
 void AsyncIoClient::UpdateIoFlags() {
-  // Simplified: just update flags, assume IoLoop handles re-registration if needed
   flags_t new_flags = EV_READ;
-  if (!write_buffer_.empty() || is_writing_) {
+  if (!write_buffer_.IsEmpty() || is_writing_) {
     new_flags |= EV_WRITE;
   }
+  if (new_flags == flags_) {
+    return;
+  }
+
   flags_ = new_flags;
+  if (server_ && read_write_io_->GetFd() != INVALID_DESCRIPTOR) {
+    // libev doesn't allow to change events of an active watcher
+    read_write_io_->Stop();
+    read_write_io_->SetEvents(flags_);
+    read_write_io_->Start();
+  }
 }
 
 }  // namespace libev
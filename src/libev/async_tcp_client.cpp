@@ -62,14 +62,25 @@ ErrnoError AsyncTcpClient::DoAsyncWrite() {
     return make_error_perror("AsyncTcpClient::DoAsyncWrite", EINVAL);
   }
 
-  if (write_buffer_.empty()) {
+  if (write_buffer_.IsEmpty()) {
     return ErrnoError();
   }
 
-  size_t n;
-  ErrnoError err = sock_->Write(write_buffer_.data(), write_buffer_.size(), &n);
+  size_t n = 0;
+  ErrnoError err;
+  if (sock_->IsZeroCopySendSupported()) {
+    err = write_buffer_.WriteToSocket(sock_->GetFd(), &n);
+  } else {
+    // TLS encrypts on the way, a copied chunk goes through the holder
+    char chunk[net::BufferChain::kBlockSize];
+    const size_t size = write_buffer_.Peek(chunk, sizeof(chunk));
+    err = sock_->Write(chunk, size, &n);
+    if (!err) {
+      write_buffer_.Consume(n);
+    }
+  }
+
   if (!err) {
-    write_buffer_.erase(write_buffer_.begin(), write_buffer_.begin() + n);
     wrote_bytes_ += n;
   } else if (err->GetErrorCode() == EAGAIN || err->GetErrorCode() == EWOULDBLOCK) {
     // Would block, try again later
@@ -84,13 +95,20 @@ ErrnoError AsyncTcpClient::DoAsyncRead() {
     return make_error_perror("AsyncTcpClient::DoAsyncRead", EINVAL);
   }
 
-  char buffer[4096];
   size_t n;
-  ErrnoError err = sock_->Read(buffer, sizeof(buffer), &n);
-  if (!err && n > 0) {
-    read_buffer_.insert(read_buffer_.end(), buffer, buffer + n);
-    read_bytes_ += n;
-  } else if (err && err->GetErrorCode() != EAGAIN && err->GetErrorCode() != EWOULDBLOCK) {
+  ErrnoError err;
+  if (sock_->IsRawReadSupported()) {
+    // straight into the tail blocks of the read chain
+    err = read_buffer_.ReadFromSocket(sock_->GetFd(), net::BufferChain::kBlockSize, &n);
+  } else {
+    // one TLS record at most, it fits the chunk
+    char chunk[net::BufferChain::kBlockSize];
+    err = sock_->Read(chunk, sizeof(chunk), &n);
+    if (!err) {
+      read_buffer_.Append(chunk, n);
+    }
+  }
+  if (err && err->GetErrorCode() != EAGAIN && err->GetErrorCode() != EWOULDBLOCK) {
     return err;
   }
 
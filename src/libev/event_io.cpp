@@ -80,6 +80,14 @@ void LibevIO::Stop() {
   loop_->StopIO(this);
 }
 
+void LibevIO::Feed(flags_t revents) {
+  if (!loop_) {
+    return;
+  }
+
+  loop_->FeedIO(this, revents);
+}
+
 void LibevIO::io_callback(struct ev_loop* loop, struct ev_io* watcher, int revents) {
   UNUSED(loop);
   UNUSED(revents);
@@ -27,14 +27,20 @@
     OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <common/convert2string.h>
 #include <common/libev/event_async.h>
 #include <common/libev/event_child.h>
 #include <common/libev/event_io.h>
 #include <common/libev/event_loop.h>
 #include <common/libev/event_timer.h>
+#include <common/libev/loop_watchdog.h>
+#include <common/logger.h>
+#include <common/metrics/metrics.h>
+#include <common/threads/thread_context.h>
 #include <ev.h>
 #include <stdlib.h>
 
+#include <atomic>
 #include <mutex>
 
 #if !EV_CHILD_ENABLE
@@ -67,23 +73,79 @@ static void WINAPI win32_deadchild_callback(PVOID user_data, BOOLEAN) {
 namespace common {
 namespace libev {
 
+// io_uring backend appeared in libev 4.31, libev submits only its poll requests through the ring
+#if EV_VERSION_MAJOR > 4 || (EV_VERSION_MAJOR == 4 && EV_VERSION_MINOR >= 31)
+#define LIBEV_IOURING_ENABLE 1
+#else
+#define LIBEV_IOURING_ENABLE 0
+#endif
+
+namespace {
+std::atomic<LoopBackend> g_default_backend(LOOP_BACKEND_DEFAULT);
+
+unsigned int BackendFlag(LoopBackend backend) {
+  switch (backend) {
+    case LOOP_BACKEND_SELECT:
+      return EVBACKEND_SELECT;
+    case LOOP_BACKEND_POLL:
+      return EVBACKEND_POLL;
+    case LOOP_BACKEND_EPOLL:
+      return EVBACKEND_EPOLL;
+    case LOOP_BACKEND_KQUEUE:
+      return EVBACKEND_KQUEUE;
+#if LIBEV_IOURING_ENABLE
+    case LOOP_BACKEND_IOURING:
+      return EVBACKEND_IOURING;
+#endif
+    default:
+      return 0;
+  }
+}
+
+struct ev_loop* CreateLoop(LoopBackend backend) {
+  const unsigned int flag = BackendFlag(backend);
+  if (flag && (ev_supported_backends() & flag)) {
+    // the kernel may still refuse it (old version, seccomp), then libev returns nullptr
+    struct ev_loop* loop = ev_loop_new(flag);
+    if (loop) {
+      return loop;
+    }
+  }
+
+  if (flag) {
+    WARNING_LOG() << "Loop backend " << backend << " isn't available, using the default one";
+  }
+  return ev_loop_new(0);
+}
+}  // namespace
+
 class LibEvLoop::AsyncCustom : public LibevAsync {
  public:
   typedef std::unique_lock<std::mutex> mutex_lock_t;
-  AsyncCustom() : queue_mutex_(), custom_callbacks_() {}
-  ~AsyncCustom() { custom_callbacks_.clear(); }
+  AsyncCustom()
+      : queue_mutex_(),
+        custom_callbacks_(),
+        pending_(METRICS()->GetGauge("common_libev_loop_pending_callbacks",
+                                     "Callbacks queued by ExecInLoopThread and not yet executed")),
+        executed_(METRICS()->GetCounter("common_libev_loop_callbacks_total",
+                                        "Callbacks executed through ExecInLoopThread")) {}
+  ~AsyncCustom() {
+    pending_->Sub(custom_callbacks_.size());
+    custom_callbacks_.clear();
+  }
   void Push(custom_loop_exec_function_t func) {
     {
       mutex_lock_t lock(queue_mutex_);
       custom_callbacks_.push_back(func);
     }
+    pending_->Increment();
     Notify();
   }
 
   static void custom_cb(LibEvLoop* loop, LibevAsync* async, flags_t revents) {
-    UNUSED(loop);
     UNUSED(revents);
 
+    ScopedDispatch dispatch(loop, "exec_in_loop", []() { return std::string("ExecInLoopThread"); });
     AsyncCustom* custom = static_cast<AsyncCustom*>(async);
     custom->Pop();
   }
@@ -96,6 +158,8 @@ class LibEvLoop::AsyncCustom : public LibevAsync {
       custom_callbacks_.swap(copy);
     }
 
+    pending_->Sub(copy.size());
+    executed_->Increment(copy.size());
     for (size_t i = 0; i < copy.size(); ++i) {
       custom_loop_exec_function_t func = copy[i];
       func();
@@ -103,11 +167,73 @@ class LibEvLoop::AsyncCustom : public LibevAsync {
   }
   std::mutex queue_mutex_;
   std::vector<custom_loop_exec_function_t> custom_callbacks_;
+  metrics::Gauge* const pending_;
+  metrics::Counter* const executed_;
+};
+
+// Measures how long each iteration spends dispatching callbacks: the check watcher runs right after
+// the backend poll returns and the prepare watcher right before the next poll.
+class LibEvLoop::LoopMetrics {
+ public:
+  LoopMetrics()
+      : prepare_(),
+        check_(),
+        woken_at_(0),
+        iteration_(METRICS()->GetLatencyHistogram("common_libev_loop_iteration_seconds",
+                                                  "Time spent dispatching callbacks per loop iteration")),
+        iterations_(METRICS()->GetCounter("common_libev_loop_iterations_total", "Event loop iterations")) {
+    ev_prepare_init(&prepare_, prepare_cb);
+    prepare_.data = this;
+    ev_check_init(&check_, check_cb);
+    check_.data = this;
+  }
+
+  void Start(struct ev_loop* loop) {
+    ev_prepare_start(loop, &prepare_);
+    ev_check_start(loop, &check_);
+    // statistics watchers must not keep the loop alive
+    ev_unref(loop);
+    ev_unref(loop);
+  }
+
+  void Stop(struct ev_loop* loop) {
+    ev_ref(loop);
+    ev_ref(loop);
+    ev_check_stop(loop, &check_);
+    ev_prepare_stop(loop, &prepare_);
+    woken_at_ = 0;
+  }
+
+ private:
+  static void prepare_cb(struct ev_loop* loop, ev_prepare* watcher, int revents) {
+    UNUSED(loop);
+    UNUSED(revents);
+    LoopMetrics* self = static_cast<LoopMetrics*>(watcher->data);
+    if (self->woken_at_) {
+      self->iteration_->Record(metrics::MonotonicNowNs() - self->woken_at_);
+      self->iterations_->Increment();
+    }
+  }
+
+  static void check_cb(struct ev_loop* loop, ev_check* watcher, int revents) {
+    UNUSED(loop);
+    UNUSED(revents);
+    LoopMetrics* self = static_cast<LoopMetrics*>(watcher->data);
+    self->woken_at_ = metrics::MonotonicNowNs();
+  }
+
+  ev_prepare prepare_;
+  ev_check check_;
+  uint64_t woken_at_;
+  metrics::Histogram* const iteration_;
+  metrics::Counter* const iterations_;
 };
 
 EvLoopObserver::~EvLoopObserver() {}
 
-LibEvLoop::LibEvLoop() : LibEvLoop(ev_loop_new(0)) {}
+LibEvLoop::LibEvLoop() : LibEvLoop(GetDefaultBackend()) {}
+
+LibEvLoop::LibEvLoop(LoopBackend backend) : LibEvLoop(CreateLoop(backend)) {}
 
 LibEvLoop::LibEvLoop(struct ev_loop* loop)
     : loop_(loop),
@@ -115,18 +241,68 @@ LibEvLoop::LibEvLoop(struct ev_loop* loop)
       exec_id_(),
       async_stop_(new LibevAsync),
       async_custom_(new AsyncCustom),
+      metrics_(new LoopMetrics),
+      watchdog_(nullptr),
       timers_(),
-      is_running_(false) {
+      is_running_(false),
+      placement_() {
   CHECK(loop_) << "Must be evloop!";
   ev_set_userdata(loop_, this);
 }  // namespace libev
 
 LibEvLoop::~LibEvLoop() {
+  DisableWatchdog();
+  destroy(&metrics_);
   destroy(&async_custom_);
   destroy(&async_stop_);
   ev_loop_destroy(loop_);
 }
 
+void LibEvLoop::SetDefaultBackend(LoopBackend backend) {
+  g_default_backend.store(backend);
+}
+
+LoopBackend LibEvLoop::GetDefaultBackend() {
+  return g_default_backend.load();
+}
+
+bool LibEvLoop::IsBackendSupported(LoopBackend backend) {
+  const unsigned int flag = BackendFlag(backend);
+  if (!flag) {
+    return true;
+  }
+
+  if (!(ev_supported_backends() & flag)) {
+    return false;
+  }
+
+  struct ev_loop* loop = ev_loop_new(flag);
+  if (!loop) {
+    return false;
+  }
+  ev_loop_destroy(loop);
+  return true;
+}
+
+LoopBackend LibEvLoop::GetBackend() const {
+  switch (ev_backend(loop_)) {
+    case EVBACKEND_SELECT:
+      return LOOP_BACKEND_SELECT;
+    case EVBACKEND_POLL:
+      return LOOP_BACKEND_POLL;
+    case EVBACKEND_EPOLL:
+      return LOOP_BACKEND_EPOLL;
+    case EVBACKEND_KQUEUE:
+      return LOOP_BACKEND_KQUEUE;
+#if LIBEV_IOURING_ENABLE
+    case EVBACKEND_IOURING:
+      return LOOP_BACKEND_IOURING;
+#endif
+    default:
+      return LOOP_BACKEND_DEFAULT;
+  }
+}
+
 void LibEvLoop::SetObserver(EvLoopObserver* observer) {
   observer_ = observer;
 }
@@ -193,6 +369,12 @@ void LibEvLoop::StopIO(LibevIO* io) {
   ev_io_stop(loop_, eio);
 }
 
+void LibEvLoop::FeedIO(LibevIO* io, flags_t revents) {
+  CHECK(IsLoopThread()) << "Must be called in loop thread!";
+  ev_io* eio = io->GetHandle();
+  ev_feed_event(loop_, eio, revents);
+}
+
 void LibEvLoop::InitTimer(LibevTimer* timer, timer_callback_t cb, double sec, bool repeat) {
   ev_timer* eit = timer->GetHandle();
   ev_timer_init(eit, cb, sec, repeat ? sec : 0);
@@ -272,8 +454,19 @@ void LibEvLoop::ExecInLoopThread(custom_loop_exec_function_t func) {
   async_custom_->Push(func);
 }
 
+void LibEvLoop::SetPlacement(const threads::ThreadPlacement& placement) {
+  placement_ = placement;
+}
+
 int LibEvLoop::Exec() {
-  exec_id_ = threads::PlatformThread::GetCurrentId();
+  if (!threads::ApplyThreadPlacement(placement_)) {
+    WARNING_LOG() << "Failed to apply loop thread placement";
+  }
+  exec_id_ = threads::CurrentThreadId();
+  threads::ThreadContext* context = threads::CurrentThreadContext();
+  const threads::ThreadContext outer = *context;
+  context->loop = this;
+  context->role = threads::THREAD_ROLE_LOOP;
 
   async_custom_->Init(this, AsyncCustom::custom_cb);
   async_custom_->Start();
@@ -282,18 +475,26 @@ int LibEvLoop::Exec() {
   if (observer_) {
     observer_->PreLooped(this);
   }
+  metrics_->Start(loop_);
   is_running_ = true;
   Start();
   ev_loop(loop_, 0);
   is_running_ = false;
+  metrics_->Stop(loop_);
   if (observer_) {
     observer_->PostLooped(this);
   }
+  context->loop = outer.loop;
+  context->role = outer.role;
   return EXIT_SUCCESS;
 }
 
+LibEvLoop* LibEvLoop::Current() {
+  return threads::CurrentThreadContext()->loop;
+}
+
 bool LibEvLoop::IsLoopThread() const {
-  return exec_id_ == threads::PlatformThread::GetCurrentId();
+  return exec_id_ == threads::CurrentThreadId();
 }
 
 bool LibEvLoop::IsRunning() const {
@@ -323,7 +524,9 @@ void LibEvLoop::timer_cb(LibEvLoop* loop, LibevTimer* timer, flags_t revents) {
   }
 
   DCHECK(revents & EV_TIMEOUT);
-  loop->HandleTimer(timer->get_id());
+  const timer_id_t id = timer->get_id();
+  ScopedDispatch dispatch(loop, "timer", [id]() { return "timer " + ConvertToString(id); });
+  loop->HandleTimer(id);
 }
 
 void LibEvLoop::HandleTimer(timer_id_t id) {
@@ -164,6 +164,27 @@ ErrnoError Http2ServerClient::SendFileByFd(descriptor_t fdesc, off_t offset, siz
   return HttpServerClient::SendFileByFd(fdesc, offset, size);
 }
 
+ErrnoError Http2ServerClient::SendFileByFdAsync(descriptor_t fdesc,
+                                                off_t offset,
+                                                size_t size,
+                                                send_file_callback_t done) {
+  if (!IsHttp2()) {
+    return HttpServerClient::SendFileByFdAsync(fdesc, offset, size, done);
+  }
+
+  if (!done) {
+    return make_error_perror("SendFileByFdAsync", EINVAL);
+  }
+
+  ErrnoError err = SendFileByFd(fdesc, offset, size);
+  if (err) {
+    return err;
+  }
+
+  done(ErrnoError(), size);
+  return ErrnoError();
+}
+
 ErrnoError Http2ServerClient::SendHeaders(common::http::http_protocol protocol,
                                           common::http::http_status status,
                                           const common::http::headers_t& extra_headers,
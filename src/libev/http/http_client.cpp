@@ -31,6 +31,7 @@
 #include <common/file_system/file_system.h>
 #include <common/libev/http/http_client.h>
 #include <common/logger.h>
+#include <common/metrics/metrics.h>
 #include <common/net/net.h>
 #include <common/sprintf.h>
 #include <inttypes.h>
@@ -191,6 +192,24 @@ ErrnoError HttpServerClient::SendJson(common::http::http_protocol protocol,
   return Write(text, len, &nwrite);
 }
 
+ErrnoError HttpServerClient::SendMetrics(common::http::http_protocol protocol,
+                                         const common::http::headers_t& extra_headers,
+                                         bool is_keep_alive,
+                                         const HttpServerInfo& info) {
+  DCHECK(protocol <= common::http::HP_1_1);
+
+  const std::string text = METRICS()->ExportPrometheus();
+  size_t len = text.size();
+  ErrnoError err = SendHeaders(protocol, common::http::HS_OK, extra_headers, "text/plain; version=0.0.4", &len,
+                               nullptr, is_keep_alive, info);
+  if (err) {
+    return err;
+  }
+
+  size_t nwrite = 0;
+  return Write(text.data(), len, &nwrite);
+}
+
 ErrnoError HttpServerClient::SendOk(common::http::http_protocol protocol,
                                     const common::http::headers_t& extra_headers,
                                     const char* text,
@@ -225,6 +244,53 @@ ErrnoError HttpServerClient::SendFileByFd(descriptor_t fdesc, off_t offset, size
   return SendFile(fdesc, offset, size);
 }
 
+ErrnoError HttpServerClient::SendFileByFdAsync(descriptor_t fdesc,
+                                               off_t offset,
+                                               size_t size,
+                                               send_file_callback_t done) {
+  if (!done) {
+    return make_error_perror("SendFileByFdAsync", EINVAL);
+  }
+
+  if (IsSendingFile()) {
+    return make_error_perror("SendFileByFdAsync", EBUSY);
+  }
+
+  descriptor_t file_fd = INVALID_DESCRIPTOR;
+  ErrnoError err = file_system::duplicate_descriptor(fdesc, &file_fd);
+  if (err) {
+    return err;
+  }
+
+  // queued write clients are non blocking anyway, the others only while the file is sent
+  const bool restore_blocking = !IsWriteQueueEnabled();
+  if (restore_blocking) {
+    err = SetBlocking(false);
+    if (err) {
+      ignore_result(file_system::close_descriptor(file_fd));
+      return err;
+    }
+  }
+
+  err = SendFileAsync(file_fd, offset, size, [this, file_fd, restore_blocking, done](ErrnoError err, size_t sent) {
+    ignore_result(file_system::close_descriptor(file_fd));
+    if (restore_blocking) {
+      ignore_result(SetBlocking(true));
+    }
+    done(err, sent);
+  });
+  if (err) {
+    ignore_result(file_system::close_descriptor(file_fd));
+    if (restore_blocking) {
+      ignore_result(SetBlocking(true));
+    }
+    return err;
+  }
+
+  // |done| may already have deleted the client
+  return ErrnoError();
+}
+
 ErrnoError HttpServerClient::SendHeaders(common::http::http_protocol protocol,
                                          common::http::http_status status,
                                          const common::http::headers_t& extra_headers,
@@ -29,7 +29,16 @@
 
 #include <common/libev/inotify/inotify_client.h>
 #include <common/libev/inotify/inotify_client_observer.h>
+#include <common/libev/io_loop.h>
+#include <common/logger.h>
+#include <common/time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
 #include <sys/inotify.h>
+#include <sys/stat.h>
+
+#include <algorithm>
 
 #define EVENT_SIZE (sizeof(struct inotify_event))
 #define BUF_SIZE (1024 * (EVENT_SIZE + 16))
@@ -38,14 +47,90 @@ namespace common {
 namespace libev {
 namespace inotify {
 
+namespace {
+
+// Subdirectories show up as created or moved in, both are needed to follow them.
+const uint32_t kRecursiveMask = IN_CREATE | IN_MOVED_TO;
+
+template <typename Callback>
+void ForEachEntry(const file_system::ascii_directory_string_path& directory, Callback cb) {
+  const std::string dir_str = directory.GetPath();
+  DIR* dirp = opendir(dir_str.c_str());
+  if (!dirp) {
+    return;
+  }
+
+  struct dirent* dent;
+  while ((dent = readdir(dirp)) != nullptr) {
+    if (!strcmp(dent->d_name, ".") || !strcmp(dent->d_name, "..")) {
+      continue;
+    }
+
+    bool is_dir = dent->d_type == DT_DIR;
+    if (dent->d_type == DT_UNKNOWN) {
+      // some file systems (e.g. xfs without ftype, reiserfs) don't fill d_type, links aren't followed like above
+      struct stat st;
+      is_dir = fstatat(dirfd(dirp), dent->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+    }
+    cb(std::string(dent->d_name), is_dir);
+  }
+  closedir(dirp);
+}
+
+}  // namespace
+
 IoInotifyClient::IoInotifyClient(IoLoop* server, IoInotifyClientObserver* client, flags_t flags)
-    : base_class(server, inotify_init(), flags), client_(client) {}
+    : base_class(server, inotify_init1(IN_NONBLOCK | IN_CLOEXEC), flags),
+      client_(client),
+      watches_(),
+      recursive_roots_(),
+      coalescing_window_msec_(0),
+      pending_changes_(),
+      pending_sequence_(0),
+      flush_timer_(INVALID_TIMER_ID) {}
 
 IoInotifyClient::~IoInotifyClient() {}
 
 common::ErrnoError IoInotifyClient::WatchDirectory(const file_system::ascii_directory_string_path& direcotry,
                                                    uint32_t mask) {
-  if (!direcotry.IsValid()) {
+  return AddWatch(direcotry, mask, false, false);
+}
+
+common::ErrnoError IoInotifyClient::WatchDirectoryRecursive(const file_system::ascii_directory_string_path& directory,
+                                                            uint32_t mask) {
+  common::ErrnoError err = AddWatch(directory, mask, true, false);
+  if (err) {
+    return err;
+  }
+
+  recursive_roots_.push_back({INVALID_DESCRIPTOR, directory, mask, true});
+  return common::ErrnoError();
+}
+
+void IoInotifyClient::SetCoalescingWindow(time64_t window_msec) {
+  coalescing_window_msec_ = window_msec > 0 ? window_msec : 0;
+  if (coalescing_window_msec_ == 0) {
+    FlushPendingChanges(true);
+  }
+}
+
+time64_t IoInotifyClient::GetCoalescingWindow() const {
+  return coalescing_window_msec_;
+}
+
+size_t IoInotifyClient::GetWatchesCount() const {
+  return watches_.size();
+}
+
+size_t IoInotifyClient::GetPendingChangesCount() const {
+  return pending_changes_.size();
+}
+
+common::ErrnoError IoInotifyClient::AddWatch(const file_system::ascii_directory_string_path& directory,
+                                             uint32_t mask,
+                                             bool recursive,
+                                             bool report_entries) {
+  if (!directory.IsValid()) {
     return common::make_errno_error_inval();
   }
 
@@ -54,66 +139,208 @@ common::ErrnoError IoInotifyClient::WatchDirectory(const file_system::ascii_dire
     return common::make_errno_error("Invalid inode", EINVAL);
   }
 
-  const std::string dir_str = direcotry.GetPath();
-  descriptor_t watcher_fd = inotify_add_watch(inode, dir_str.c_str(), mask);
+  const std::string dir_str = directory.GetPath();
+  const uint32_t kernel_mask = recursive ? (mask | kRecursiveMask) : mask;
+  descriptor_t watcher_fd = inotify_add_watch(inode, dir_str.c_str(), kernel_mask);
   if (watcher_fd == ERROR_RESULT_VALUE) {
     return common::make_errno_error(errno);
   }
 
-  watched_directories_.push_back({watcher_fd, direcotry});
+  watches_[watcher_fd] = {watcher_fd, directory, mask, recursive};
+  if (!recursive) {
+    return common::ErrnoError();
+  }
+
+  // Entries created before the watch existed would be missed otherwise.
+  ForEachEntry(directory, [this, &directory, mask, report_entries](const std::string& name, bool is_dir) {
+    if (report_entries && (mask & IN_CREATE)) {
+      NotifyChange(directory, name, is_dir, IN_CREATE | (is_dir ? IN_ISDIR : 0));
+    }
+    if (!is_dir) {
+      return;
+    }
+    const auto subdir = directory.MakeDirectoryStringPath(name);
+    if (subdir) {
+      common::ErrnoError err = AddWatch(*subdir, mask, true, report_entries);
+      if (err) {
+        WARNING_LOG() << "Failed to watch directory " << subdir->GetPath() << ", error: " << err->GetDescription();
+      }
+    }
+  });
   return common::ErrnoError();
 }
 
 void IoInotifyClient::ProcessRead() {
-  char data[BUF_SIZE] = {0};
-  size_t nread = 0;
-  common::ErrnoError errn = SingleRead(data, BUF_SIZE, &nread);
-  if ((errn && errn->GetErrorCode() != EAGAIN) || nread == 0) {
+  alignas(struct inotify_event) char data[BUF_SIZE];
+  while (true) {
+    size_t nread = 0;
+    common::ErrnoError errn = SingleRead(data, BUF_SIZE, &nread);
+    if (errn) {
+      if (errn->GetErrorCode() != EAGAIN && errn->GetErrorCode() != EWOULDBLOCK) {
+        WARNING_LOG() << "Inotify read error: " << errn->GetDescription();
+      }
+      break;
+    }
+    if (nread == 0) {
+      break;
+    }
+
+    size_t i = 0;
+    while (i < nread) {
+      const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(data + i);
+      HandleEvent(event->wd, event->mask, event->len ? event->name : nullptr);
+      i += EVENT_SIZE + event->len;
+    }
+  }
+}
+
+void IoInotifyClient::HandleEvent(descriptor_t wd, uint32_t mask, const char* name) {
+  if (mask & IN_Q_OVERFLOW) {
+    Rescan();
+    return;
+  }
+
+  const InotifyNode* node = FindInotifyNodeByDescriptor(wd);
+  if (!node) {
+    // Events may still be queued for a watch which was removed.
+    return;
+  }
+
+  if (mask & IN_IGNORED) {
+    watches_.erase(wd);
+    return;
+  }
+
+  if (!name) {
     return;
   }
 
-  size_t i = 0;
-  while (i < nread) {
-    struct inotify_event* event = reinterpret_cast<struct inotify_event*>(data + i);
-    if (event->len) {
-      const auto inode = FindInotifyNodeByDescriptor(event->wd);
-      if (inode) {
-        if (client_) {
-          client_->HandleChanges(this, inode->directory, event->name, event->mask & IN_ISDIR, event->mask);
-        }
-      } else {
-        DNOTREACHED();
+  // The node can be rehashed away by AddWatch below, keep what is needed.
+  const file_system::ascii_directory_string_path directory = node->directory;
+  const uint32_t requested = node->mask;
+  const bool is_dir = mask & IN_ISDIR;
+  if (node->recursive && is_dir && (mask & kRecursiveMask)) {
+    const auto subdir = directory.MakeDirectoryStringPath(name);
+    if (subdir) {
+      common::ErrnoError err = AddWatch(*subdir, requested, true, true);
+      if (err) {
+        WARNING_LOG() << "Failed to watch directory " << subdir->GetPath() << ", error: " << err->GetDescription();
       }
     }
-    i += EVENT_SIZE + event->len;
+  }
+
+  if (mask & requested) {
+    NotifyChange(directory, name, is_dir, mask);
   }
 }
 
-Optional<InotifyNode> IoInotifyClient::FindInotifyNodeByDescriptor(descriptor_t fd) const {
-  if (fd == INVALID_DESCRIPTOR) {
-    return Optional<InotifyNode>();
+void IoInotifyClient::Rescan() {
+  WARNING_LOG() << "Inotify queue overflow, rescanning " << recursive_roots_.size() << " tree(s).";
+  for (const InotifyNode& root : recursive_roots_) {
+    common::ErrnoError err = AddWatch(root.directory, root.mask, true, false);
+    if (err) {
+      WARNING_LOG() << "Failed to rescan directory " << root.directory.GetPath()
+                    << ", error: " << err->GetDescription();
+    }
+  }
+
+  if (client_) {
+    client_->HandleOverflow(this);
   }
+}
 
-  for (size_t i = 0; i < watched_directories_.size(); ++i) {
-    if (watched_directories_[i].fd == fd) {
-      return watched_directories_[i];
+void IoInotifyClient::NotifyChange(const file_system::ascii_directory_string_path& directory,
+                                   const std::string& name,
+                                   bool is_dir,
+                                   uint32_t mask) {
+  if (coalescing_window_msec_ == 0) {
+    if (client_) {
+      client_->HandleChanges(this, directory, name, is_dir, mask);
     }
+    return;
+  }
+
+  const time64_t deadline = time::current_utc_mstime() + coalescing_window_msec_;
+  const std::string key = directory.GetPath() + name;
+  auto it = pending_changes_.find(key);
+  if (it != pending_changes_.end()) {
+    it->second.mask |= mask;
+    it->second.is_dir |= is_dir;
+    it->second.deadline_msec = deadline;
+    return;
   }
 
-  return Optional<InotifyNode>();
+  const PendingChange change = {directory, name, is_dir, mask, deadline, pending_sequence_++};
+  pending_changes_.insert(std::make_pair(key, change));
+  if (flush_timer_ == INVALID_TIMER_ID) {
+    // Half a window of granularity, so a change is reported at most 1.5 windows after it settled.
+    const double interval_sec = std::max<time64_t>(coalescing_window_msec_ / 2, 1) / 1000.0;
+    flush_timer_ = GetServer()->CreateTimer(interval_sec, true);
+  }
+}
+
+bool IoInotifyClient::ProcessTimer(timer_id_t id) {
+  if (id == INVALID_TIMER_ID || id != flush_timer_) {
+    return false;
+  }
+
+  FlushPendingChanges(false);
+  return true;
+}
+
+void IoInotifyClient::FlushPendingChanges(bool force) {
+  const time64_t now = time::current_utc_mstime();
+  std::vector<PendingChange> ready;
+  for (auto it = pending_changes_.begin(); it != pending_changes_.end();) {
+    if (force || it->second.deadline_msec <= now) {
+      ready.push_back(std::move(it->second));
+      it = pending_changes_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (pending_changes_.empty() && flush_timer_ != INVALID_TIMER_ID) {
+    GetServer()->RemoveTimer(flush_timer_);
+    flush_timer_ = INVALID_TIMER_ID;
+  }
+
+  std::sort(ready.begin(), ready.end(),
+            [](const PendingChange& lhs, const PendingChange& rhs) { return lhs.sequence < rhs.sequence; });
+  for (const PendingChange& change : ready) {
+    if (client_) {
+      client_->HandleChanges(this, change.directory, change.name, change.is_dir, change.mask);
+    }
+  }
+}
+
+const InotifyNode* IoInotifyClient::FindInotifyNodeByDescriptor(descriptor_t fd) const {
+  const auto it = watches_.find(fd);
+  if (it == watches_.end()) {
+    return nullptr;
+  }
+
+  return &it->second;
 }
 
 ErrnoError IoInotifyClient::DoClose() {
+  pending_changes_.clear();
+  if (flush_timer_ != INVALID_TIMER_ID) {
+    GetServer()->RemoveTimer(flush_timer_);
+    flush_timer_ = INVALID_TIMER_ID;
+  }
+  recursive_roots_.clear();
+
   descriptor_t inode = GetFd();
   if (inode == INVALID_DESCRIPTOR) {
-    watched_directories_.clear();
+    watches_.clear();
     return ErrnoError();
   }
 
-  for (size_t i = 0; i < watched_directories_.size(); ++i) {
-    inotify_rm_watch(inode, watched_directories_[i].fd);
+  for (const auto& watch : watches_) {
+    inotify_rm_watch(inode, watch.first);
   }
-  watched_directories_.clear();
+  watches_.clear();
   return base_class::DoClose();
 }
 
@@ -33,6 +33,10 @@ namespace common {
 namespace libev {
 namespace inotify {
 
+void IoInotifyClientObserver::HandleOverflow(IoInotifyClient* client) {
+  UNUSED(client);
+}
+
 IoInotifyClientObserver::~IoInotifyClientObserver() {}
 
 }  // namespace inotify
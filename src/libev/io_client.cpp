@@ -31,12 +31,46 @@
 #include <common/file_system/file_system.h>
 #include <common/libev/io_client.h>
 #include <common/libev/io_loop.h>
+#include <common/libev/io_loop_observer.h>
+#include <common/net/buffer_chain.h>
+#include <common/net/file_transfer.h>
+#include <common/net/net.h>
+#include <common/net/receive_buffer.h>
+
+#if defined(OS_POSIX)
+#include <sys/socket.h>
+#else
+#include <winsock2.h>
+#endif
+
+#include <algorithm>
 
 namespace common {
 namespace libev {
 
+namespace {
+bool IsWouldBlock(const ErrnoError& err) {
+  return err->GetErrorCode() == EAGAIN || err->GetErrorCode() == EWOULDBLOCK;
+}
+}  // namespace
+
+const size_t IoClient::kDefaultWriteQueueLimit;
+
 IoClient::IoClient(IoLoop* server, flags_t flags)
-    : base_class(), server_(server), read_write_io_(new LibevIO), flags_(flags), wrote_bytes_(), read_bytes_() {
+    : base_class(),
+      server_(server),
+      read_write_io_(new LibevIO),
+      flags_(flags),
+      wrote_bytes_(),
+      read_bytes_(),
+      read_buffer_(),
+      write_queue_(),
+      write_queue_limit_(kDefaultWriteQueueLimit),
+      slow_consumer_policy_(SLOW_CONSUMER_NOTIFY),
+      write_queue_full_(false),
+      file_transfer_(),
+      file_transfer_done_(),
+      request_in_flight_(false) {
   read_write_io_->SetUserData(this);
 }
 
@@ -45,6 +79,9 @@ IoClient::~IoClient() {
 }
 
 ErrnoError IoClient::Close() {
+  if (file_transfer_) {
+    FinishSendFile(make_error_perror("SendFileAsync", ECANCELED));
+  }
   if (server_) {
     server_->CloseClient(this);
   }
@@ -79,9 +116,13 @@ ErrnoError IoClient::Write(const void* data, size_t size, size_t* nwrite_out) {
   size_t total = 0;          // how many bytes we've sent
   size_t bytes_left = size;  // how many we have left to send
 
+  if (write_queue_) {
+    return QueueWrite(data, size, nwrite_out);
+  }
+
   while (total < size) {
     size_t n;
-    ErrnoError err = SingleWrite(data, size, &n);
+    ErrnoError err = SingleWrite(static_cast<const char*>(data) + total, bytes_left, &n);
     if (err || n == 0) {
       *nwrite_out = 0;
       return err;
@@ -118,6 +159,203 @@ ErrnoError IoClient::Read(void* out_data, size_t max_size, size_t* nread_out) {
   return ErrnoError();
 }
 
+void IoClient::EnableWriteQueue(size_t max_pending, SlowConsumerPolicy policy) {
+  if (!write_queue_) {
+    write_queue_.reset(new net::BufferChain);
+  }
+  write_queue_limit_ = max_pending;
+  slow_consumer_policy_ = policy;
+}
+
+bool IoClient::IsWriteQueueEnabled() const {
+  return write_queue_ != nullptr;
+}
+
+size_t IoClient::GetPendingWriteBytes() const {
+  return write_queue_ ? write_queue_->GetSize() : 0;
+}
+
+bool IoClient::IsWriteQueueFull() const {
+  return write_queue_full_;
+}
+
+ErrnoError IoClient::FlushWriteQueue() {
+  // TLS and other non zero copy clients must go through DoSingleWrite
+  static const size_t kCopyChunkSize = net::BufferChain::kBlockSize;
+
+  while (GetPendingWriteBytes()) {
+    size_t nwrite = 0;
+    ErrnoError err;
+    if (IsZeroCopySendSupported()) {
+      err = write_queue_->WriteToSocket(GetFd(), &nwrite);
+    } else {
+      char chunk[kCopyChunkSize];
+      const size_t size = write_queue_->Peek(chunk, sizeof(chunk));
+      err = DoSingleWrite(chunk, size, &nwrite);
+      if (!err) {
+        write_queue_->Consume(nwrite);
+      }
+    }
+
+    if (err) {
+      return err;
+    }
+    wrote_bytes_ += nwrite;
+  }
+
+  return CheckWriteQueue();
+}
+
+ErrnoError IoClient::QueueWrite(const void* data, size_t size, size_t* nwrite_out) {
+  const size_t pending = write_queue_->GetSize();
+  if (pending + size > write_queue_limit_ && slow_consumer_policy_ == SLOW_CONSUMER_DROP) {
+    *nwrite_out = 0;
+    return make_error_perror("Write", ENOBUFS);
+  }
+
+  // queued data and a running file transfer go first
+  size_t total = 0;
+  if (!pending && !file_transfer_) {
+    while (total < size) {
+      size_t n = 0;
+      ErrnoError err = DoSingleWrite(static_cast<const char*>(data) + total, size - total, &n);
+      if (err) {
+        if (!IsWouldBlock(err)) {
+          *nwrite_out = total;
+          return err;
+        }
+        break;
+      }
+      wrote_bytes_ += n;
+      total += n;
+    }
+  }
+
+  if (total == size) {
+    *nwrite_out = size;
+    return ErrnoError();
+  }
+
+  write_queue_->Append(static_cast<const char*>(data) + total, size - total);
+  SetWriteWatching(true);
+  ErrnoError err = CheckWriteQueue();
+  // a disconnected slow consumer loses the queue, only what went out was accepted
+  *nwrite_out = err ? total : size;
+  return err;
+}
+
+ErrnoError IoClient::CheckWriteQueue() {
+  const size_t pending = GetPendingWriteBytes();
+  IoLoopObserver* observer = server_ ? server_->GetObserver() : nullptr;
+  if (!write_queue_full_ && pending > write_queue_limit_) {
+    if (slow_consumer_policy_ == SLOW_CONSUMER_DISCONNECT) {
+      write_queue_->Clear();
+      SetWriteWatching(false);
+      // the owner sees the closed connection on the next read like any other peer reset
+#if defined(OS_POSIX)
+      ::shutdown(GetFd(), SHUT_RDWR);
+#else
+      ::shutdown(GetFd(), SD_BOTH);
+#endif
+      return make_error_perror("Write", ECONNABORTED);
+    }
+
+    write_queue_full_ = true;
+    if (observer) {
+      observer->WriteQueueHigh(this, pending);
+    }
+  } else if (write_queue_full_ && pending <= write_queue_limit_ / 2) {
+    write_queue_full_ = false;
+    if (observer) {
+      observer->WriteQueueLow(this, pending);
+    }
+  }
+  return ErrnoError();
+}
+
+void IoClient::HandleWriteReady() {
+  if (GetPendingWriteBytes()) {
+    ErrnoError err = FlushWriteQueue();
+    if (err && !IsWouldBlock(err)) {
+      write_queue_->Clear();
+      if (!file_transfer_) {
+        SetWriteWatching(false);
+      }
+      // the observer may close the client
+      if (server_ && server_->GetObserver()) {
+        server_->GetObserver()->WriteQueueFailed(this, err);
+      }
+      return;
+    }
+    if (GetPendingWriteBytes()) {
+      return;
+    }
+
+    if (!file_transfer_) {
+      SetWriteWatching(false);
+      return;
+    }
+  }
+
+  if (file_transfer_) {
+    ContinueSendFile();
+    return;
+  }
+
+  if (server_ && server_->GetObserver()) {
+    server_->GetObserver()->DataReadyToWrite(this);
+  }
+}
+
+ErrnoError IoClient::ReadToBuffer(size_t* nread_out) {
+  if (!nread_out) {
+    return make_errno_error_inval();
+  }
+
+  if (!read_buffer_) {
+    read_buffer_.reset(new net::ReceiveBuffer);
+  }
+
+  size_t available = 0;
+  char* tail = read_buffer_->PrepareWrite(net::ReceiveBuffer::kBlockSize, &available);
+  size_t nread = 0;
+  ErrnoError err = DoSingleRead(tail, available, &nread);
+  if (err) {
+    *nread_out = 0;
+    return err;
+  }
+
+  read_buffer_->CommitWrite(nread);
+  read_bytes_ += nread;
+  *nread_out = nread;
+  return ErrnoError();
+}
+
+char* IoClient::GetReadBuffer() {
+  return read_buffer_ ? read_buffer_->GetData() : nullptr;
+}
+
+const char* IoClient::GetReadBuffer() const {
+  return read_buffer_ ? read_buffer_->GetData() : nullptr;
+}
+
+size_t IoClient::GetReadBufferSize() const {
+  return read_buffer_ ? read_buffer_->GetSize() : 0;
+}
+
+void IoClient::ConsumeReadBuffer(size_t size) {
+  if (!read_buffer_) {
+    DCHECK_EQ(size, 0);
+    return;
+  }
+
+  read_buffer_->Consume(size);
+}
+
+void IoClient::ScheduleBufferedRead() {
+  read_write_io_->Feed(EV_CUSTOM);
+}
+
 ErrnoError IoClient::SendFile(descriptor_t file_fd, off_t offset, size_t file_size) {
   if (file_fd == INVALID_DESCRIPTOR) {
     return make_error_perror("SendFile", EINVAL);
@@ -126,11 +364,120 @@ ErrnoError IoClient::SendFile(descriptor_t file_fd, off_t offset, size_t file_si
   return DoSendFile(file_fd, offset, file_size);
 }
 
+ErrnoError IoClient::SendFileAsync(descriptor_t file_fd,
+                                   off_t offset,
+                                   size_t file_size,
+                                   send_file_callback_t done) {
+  if (file_fd == INVALID_DESCRIPTOR || !done) {
+    return make_error_perror("SendFileAsync", EINVAL);
+  }
+
+  if (file_transfer_) {
+    return make_error_perror("SendFileAsync", EBUSY);
+  }
+
+  if (IsZeroCopySendSupported()) {
+    file_transfer_.reset(new net::FileTransfer(file_fd, offset, file_size, GetFd()));
+  } else {
+    auto writer = [this](const void* data, size_t size, size_t* nwrite_out) {
+      return DoSingleWrite(data, size, nwrite_out);
+    };
+    file_transfer_.reset(new net::FileTransfer(file_fd, offset, file_size, writer));
+  }
+  file_transfer_done_ = done;
+  ContinueSendFile();
+  return ErrnoError();
+}
+
+bool IoClient::IsSendingFile() const {
+  return file_transfer_ != nullptr;
+}
+
+void IoClient::SetRequestInFlight(bool in_flight) {
+  request_in_flight_ = in_flight;
+}
+
+bool IoClient::IsRequestInFlight() const {
+  return request_in_flight_;
+}
+
+size_t IoClient::GetUnreadBytes() const {
+  size_t nbytes = 0;
+  ErrnoError err = net::get_unread_bytes(GetFd(), &nbytes);
+  if (err) {
+    return 0;
+  }
+  return nbytes;
+}
+
+bool IoClient::IsZeroCopySendSupported() const {
+  return false;
+}
+
+void IoClient::ContinueSendFile() {
+  // don't starve other clients of the loop with one big file
+  static const size_t kMaxBytesPerEvent = 4 * net::FileTransfer::kDefaultChunkSize;
+
+  if (GetPendingWriteBytes()) {
+    SetWriteWatching(true);
+    return;
+  }
+
+  size_t budget = kMaxBytesPerEvent;
+  while (!file_transfer_->IsDone() && budget) {
+    size_t nsent = 0;
+    ErrnoError err = file_transfer_->Step(std::min(budget, net::FileTransfer::kDefaultChunkSize), &nsent);
+    if (err) {
+      if (err->GetErrorCode() == EAGAIN || err->GetErrorCode() == EWOULDBLOCK) {
+        SetWriteWatching(true);
+        return;
+      }
+      FinishSendFile(err);
+      return;
+    }
+
+    wrote_bytes_ += nsent;
+    budget -= nsent;
+  }
+
+  if (file_transfer_->IsDone()) {
+    FinishSendFile(ErrnoError());
+    return;
+  }
+  SetWriteWatching(true);
+}
+
+void IoClient::FinishSendFile(ErrnoError err) {
+  SetWriteWatching(false);
+  const size_t sent = file_transfer_->GetSent();
+  send_file_callback_t done = file_transfer_done_;
+  file_transfer_.reset();
+  file_transfer_done_ = send_file_callback_t();
+  done(err, sent);
+}
+
+void IoClient::SetWriteWatching(bool enable) {
+  const bool watch = enable || GetPendingWriteBytes();
+  const flags_t events = watch ? (flags_ | EV_WRITE) : flags_;
+  if (read_write_io_->GetEvents() == events) {
+    return;
+  }
+
+  // libev doesn't allow to change events of an active watcher
+  read_write_io_->Stop();
+  read_write_io_->SetEvents(events);
+  read_write_io_->Start();
+}
+
 ErrnoError IoClient::SingleWrite(const void* data, size_t size, size_t* nwrite_out) {
   if (!data || !size || !nwrite_out) {
     return make_errno_error_inval();
   }
 
+  if (write_queue_) {
+    return QueueWrite(data, size, nwrite_out);
+  }
+
   ErrnoError err = DoSingleWrite(data, size, nwrite_out);
   if (!err) {
     wrote_bytes_ += *nwrite_out;
@@ -34,6 +34,8 @@
 #include <common/libev/io_client.h>
 #include <common/libev/io_loop.h>
 #include <common/libev/io_loop_observer.h>
+#include <common/libev/loop_watchdog.h>
+#include <common/metrics/metrics.h>
 #include <common/sprintf.h>
 
 #include <algorithm>
@@ -44,17 +46,38 @@ namespace {
 std::mutex g_exists_loops_mutex;
 std::vector<common::libev::IoLoop*> g_exists_loops;
 
+struct IoLoopMetrics {
+  IoLoopMetrics()
+      : clients(METRICS()->GetGauge("common_libev_clients", "Clients registered in io loops")),
+        registered(METRICS()->GetCounter("common_libev_clients_registered_total", "Clients registered in io loops")),
+        closed(METRICS()->GetCounter("common_libev_clients_closed_total", "Clients closed by io loops")) {}
+
+  common::metrics::Gauge* const clients;
+  common::metrics::Counter* const registered;
+  common::metrics::Counter* const closed;
+};
+
+const IoLoopMetrics& GetIoLoopMetrics() {
+  static const IoLoopMetrics metrics;
+  return metrics;
+}
+
 }  // namespace
 
 namespace common {
 namespace libev {
 
-IoLoop::IoLoop(LibEvLoop* loop, IoLoopObserver* observer) : loop_(loop), observer_(observer), clients_(), id_() {
+IoLoop::IoLoop(LibEvLoop* loop, IoLoopObserver* observer)
+    : loop_(loop), observer_(observer), clients_(), id_(), pools_enabled_(false), pools_(nullptr) {
   loop_->SetObserver(this);
 }
 
 IoLoop::~IoLoop() {
   delete loop_;
+  memory::SlabPools* pools = pools_.exchange(nullptr);
+  if (pools) {
+    pools->Release();
+  }
 }
 
 bool IoLoop::IsRunning() const {
@@ -62,10 +85,29 @@ bool IoLoop::IsRunning() const {
 }
 
 int IoLoop::Exec() {
+  memory::SlabPools* pools = pools_.load();
+  if (pools_enabled_ && !pools) {
+    pools = new memory::SlabPools;
+    pools_.store(pools);
+  }
+
+  memory::SlabPools::ScopedCurrent scoped_pools(pools_enabled_ ? pools : nullptr);
   int res = loop_->Exec();
   return res;
 }
 
+void IoLoop::SetObjectPoolsEnabled(bool enabled) {
+  pools_enabled_ = enabled;
+}
+
+std::vector<memory::SlabPoolStats> IoLoop::GetObjectPoolsStats() const {
+  memory::SlabPools* pools = pools_.load();
+  if (!pools) {
+    return std::vector<memory::SlabPoolStats>();
+  }
+  return pools->GetStats();
+}
+
 void IoLoop::Stop() {
   loop_->Stop();
 }
@@ -89,6 +131,7 @@ void IoLoop::UnRegisterClient(IoClient* client) {
   }
 
   clients_.erase(std::remove(clients_.begin(), clients_.end(), client), clients_.end());
+  GetIoLoopMetrics().clients->Decrement();
   DEBUG_LOG() << "Successfully unregister client[" << formated_name << "], from server[" << GetFormatedName() << "], "
               << clients_.size() << " client(s) connected.";
 }
@@ -125,6 +168,8 @@ bool IoLoop::RegisterClient(IoClient* client) {
   }
 
   clients_.push_back(client);
+  GetIoLoopMetrics().clients->Increment();
+  GetIoLoopMetrics().registered->Increment();
   DEBUG_LOG() << "Successfully connected with client[" << formated_name << "], from server[" << GetFormatedName()
               << "], " << clients_.size() << " client(s) connected.";
   return true;
@@ -147,7 +192,7 @@ bool IoLoop::RegisterAsyncClient(AsyncIoClient* client) {
 
  // Initialize and start watcher to read client requests
  LibevIO* client_ev = client->read_write_io_;
- bool is_inited = client_ev->Init(loop_, read_write_cb, client->GetFd(), client->GetFlags());
+ bool is_inited = client_ev->Init(loop_, read_write_async_cb, client->GetFd(), client->GetFlags());
  if (!is_inited) {
    DNOTREACHED();
    return false;
@@ -159,6 +204,8 @@ bool IoLoop::RegisterAsyncClient(AsyncIoClient* client) {
  }
 
  async_clients_.push_back(client);
+ GetIoLoopMetrics().clients->Increment();
+ GetIoLoopMetrics().registered->Increment();
  DEBUG_LOG() << "Successfully connected with async client[" << formated_name << "], from server[" << GetFormatedName()
              << "], " << async_clients_.size() << " async client(s) connected.";
  return true;
@@ -183,6 +230,7 @@ void IoLoop::UnRegisterAsyncClient(AsyncIoClient* client) {
  }
 
  async_clients_.erase(std::remove(async_clients_.begin(), async_clients_.end(), client), async_clients_.end());
+ GetIoLoopMetrics().clients->Decrement();
  DEBUG_LOG() << "Successfully unregister async client[" << formated_name << "], from server[" << GetFormatedName() << "], "
              << async_clients_.size() << " async client(s) connected.";
 }
@@ -204,6 +252,8 @@ void IoLoop::CloseAsyncClient(AsyncIoClient* client) {
    observer_->Closed(client);
  }
  async_clients_.erase(std::remove(async_clients_.begin(), async_clients_.end(), client), async_clients_.end());
+ GetIoLoopMetrics().clients->Decrement();
+ GetIoLoopMetrics().closed->Increment();
  DEBUG_LOG() << "Successfully disconnected async client[" << formated_name << "], from server[" << GetFormatedName() << "], "
              << async_clients_.size() << " async client(s) connected.";
 }
@@ -225,6 +275,8 @@ void IoLoop::CloseClient(IoClient* client) {
     observer_->Closed(client);
   }
   clients_.erase(std::remove(clients_.begin(), clients_.end(), client), clients_.end());
+  GetIoLoopMetrics().clients->Decrement();
+  GetIoLoopMetrics().closed->Increment();
   DEBUG_LOG() << "Successfully disconnected client[" << formated_name << "], from server[" << GetFormatedName() << "], "
               << clients_.size() << " client(s) connected.";
 }
@@ -336,21 +388,19 @@ std::vector<AsyncIoClient*> IoLoop::GetAsyncClients() const {
 }
 
 void IoLoop::read_write_cb(LibEvLoop* loop, LibevIO* io, flags_t revents) {
-  void* user_data = io->GetUserData();
-  IoLoop* pserver = nullptr;
-
-  // Check if it's an IoClient
-  IoClient* pclient = reinterpret_cast<IoClient*>(user_data);
+  IoClient* pclient = reinterpret_cast<IoClient*>(io->GetUserData());
   if (pclient && pclient->GetServer()) {
-    pserver = pclient->GetServer();
+    IoLoop* pserver = pclient->GetServer();
+    ScopedDispatch dispatch(loop, "read_write", [pclient]() { return pclient->GetFormatedName(); });
     pserver->ReadWrite(loop, pclient, revents);
-    return;
   }
+}
 
-  // Check if it's an AsyncIoClient
-  AsyncIoClient* aclient = reinterpret_cast<AsyncIoClient*>(user_data);
+void IoLoop::read_write_async_cb(LibEvLoop* loop, LibevIO* io, flags_t revents) {
+  AsyncIoClient* aclient = reinterpret_cast<AsyncIoClient*>(io->GetUserData());
   if (aclient && aclient->server_) {
-    pserver = aclient->server_;
+    IoLoop* pserver = aclient->server_;
+    ScopedDispatch dispatch(loop, "read_write_async", [aclient]() { return aclient->GetFormatedName(); });
     pserver->ReadWriteAsync(loop, aclient, revents);
   }
 }
@@ -365,16 +415,16 @@ void IoLoop::ReadWrite(LibEvLoop* loop, IoClient* client, flags_t revents) {
     return;
   }
 
-  if (revents & EV_READ) {
+  // EV_CUSTOM comes from ScheduleBufferedRead, the buffer may have been drained by a socket event meanwhile
+  const bool buffered = (revents & EV_CUSTOM) && client->GetReadBufferSize();
+  if ((revents & EV_READ) || buffered) {
     if (observer_) {
       observer_->DataReceived(client);
     }
   }
 
   if (revents & EV_WRITE) {
-    if (observer_) {
-      observer_->DataReadyToWrite(client);
-    }
+    client->HandleWriteReady();
   }
 }
 
@@ -400,6 +450,7 @@ void IoLoop::ReadWriteAsync(LibEvLoop* loop, AsyncIoClient* client, flags_t reve
 void IoLoop::child_cb(LibEvLoop* loop, LibevChild* child, int status, int signal, flags_t revents) {
   IoChild* pchild = reinterpret_cast<IoChild*>(child->GetUserData());
   IoLoop* pserver = pchild->GetServer();
+  ScopedDispatch dispatch(loop, "child", [pchild]() { return pchild->GetFormatedName(); });
   pserver->ChildStatus(loop, pchild, status, signal, revents);
 }
 
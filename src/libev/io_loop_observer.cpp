@@ -32,6 +32,31 @@
 namespace common {
 namespace libev {
 
+void IoLoopObserver::WriteQueueHigh(IoClient* client, size_t pending_bytes) {
+  UNUSED(client);
+  UNUSED(pending_bytes);
+}
+
+void IoLoopObserver::WriteQueueLow(IoClient* client, size_t pending_bytes) {
+  UNUSED(client);
+  UNUSED(pending_bytes);
+}
+
+void IoLoopObserver::WriteQueueFailed(IoClient* client, ErrnoError err) {
+  UNUSED(client);
+  UNUSED(err);
+}
+
+void IoLoopObserver::AsyncWriteQueueHigh(AsyncIoClient* client, size_t pending_bytes) {
+  UNUSED(client);
+  UNUSED(pending_bytes);
+}
+
+void IoLoopObserver::AsyncWriteQueueLow(AsyncIoClient* client, size_t pending_bytes) {
+  UNUSED(client);
+  UNUSED(pending_bytes);
+}
+
 IoLoopObserver::~IoLoopObserver() {}
 
 }  // namespace libev
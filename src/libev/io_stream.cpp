@@ -0,0 +1,219 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/libev/io_stream.h>
+
+#include <errno.h>
+
+#include <algorithm>
+
+#include <common/libev/io_client.h>
+#include <common/libev/io_loop.h>
+
+namespace common {
+namespace libev {
+
+IoStream::IoStream(IoClient* client)
+    : client_(client),
+      read_kind_(READ_NONE),
+      read_size_(0),
+      read_delimiter_(),
+      read_done_(),
+      delimiter_scanned_(0),
+      dispatching_(false),
+      sleepers_() {
+  CHECK(client_);
+}
+
+IoStream::~IoStream() {
+  Cancel(make_errno_error("Stream destroyed", ECANCELED));
+}
+
+IoClient* IoStream::GetClient() const {
+  return client_;
+}
+
+bool IoStream::IsReadPending() const {
+  return read_kind_ != READ_NONE;
+}
+
+void IoStream::ReadExactly(size_t size, read_callback_t done) {
+  DCHECK(!IsReadPending()) << "only one read may be pending";
+  read_kind_ = READ_EXACTLY;
+  read_size_ = size;
+  read_done_ = std::move(done);
+  if (!dispatching_) {
+    DispatchRead();
+  }
+}
+
+void IoStream::ReadUntil(const std::string& delimiter, read_callback_t done, size_t max_size) {
+  DCHECK(!IsReadPending()) << "only one read may be pending";
+  DCHECK(!delimiter.empty());
+  read_kind_ = READ_UNTIL;
+  read_size_ = max_size;
+  read_delimiter_ = delimiter;
+  read_done_ = std::move(done);
+  delimiter_scanned_ = 0;
+  if (!dispatching_) {
+    DispatchRead();
+  }
+}
+
+ErrnoError IoStream::Write(const void* data, size_t size) {
+  if (!client_->IsWriteQueueEnabled()) {
+    client_->EnableWriteQueue();
+  }
+  size_t nwrite = 0;
+  return client_->Write(data, size, &nwrite);
+}
+
+void IoStream::Sleep(time64_t milliseconds, done_callback_t done) {
+  IoLoop* server = client_->GetServer();
+  if (!server) {
+    done(make_errno_error("Stream client has no loop", EINVAL));
+    return;
+  }
+
+  const timer_id_t id = server->CreateTimer(static_cast<double>(milliseconds) / 1000, false);
+  sleepers_.push_back({id, std::move(done)});
+}
+
+ErrnoError IoStream::OnDataReceived() {
+  size_t nread = 0;
+  ErrnoError err = client_->ReadToBuffer(&nread);
+  if (err) {
+    const int code = err->GetErrorCode();
+    if (code == EAGAIN || code == EWOULDBLOCK) {
+      return ErrnoError();
+    }
+    FailRead(err);
+    return err;
+  }
+  if (nread == 0) {
+    err = make_errno_error("Connection closed", ECONNRESET);
+    FailRead(err);
+    return err;
+  }
+
+  if (!dispatching_) {
+    DispatchRead();
+  }
+  return ErrnoError();
+}
+
+bool IoStream::OnTimer(timer_id_t id) {
+  const auto it = std::find_if(sleepers_.begin(), sleepers_.end(), [id](const Sleeper& sleeper) {
+    return sleeper.id == id;
+  });
+  if (it == sleepers_.end()) {
+    return false;
+  }
+
+  client_->GetServer()->RemoveTimer(id);
+  done_callback_t done = std::move(it->done);
+  sleepers_.erase(it);
+  done(ErrnoError());
+  return true;
+}
+
+void IoStream::Cancel(ErrnoError err) {
+  FailRead(err);
+
+  std::vector<Sleeper> sleepers;
+  sleepers.swap(sleepers_);
+  for (Sleeper& sleeper : sleepers) {
+    client_->GetServer()->RemoveTimer(sleeper.id);
+    sleeper.done(err);
+  }
+}
+
+void IoStream::DispatchRead() {
+  dispatching_ = true;
+  while (IsReadPending()) {
+    ErrnoError err;
+    size_t size = 0;
+    if (!CompleteRead(&size, &err)) {
+      break;
+    }
+
+    read_callback_t done = std::move(read_done_);
+    read_done_ = read_callback_t();
+    read_kind_ = READ_NONE;
+    if (err) {
+      done(err, nullptr, 0);
+      continue;
+    }
+
+    done(ErrnoError(), client_->GetReadBuffer(), size);
+    client_->ConsumeReadBuffer(size);
+  }
+  dispatching_ = false;
+}
+
+bool IoStream::CompleteRead(size_t* size, ErrnoError* err) {
+  const char* data = client_->GetReadBuffer();
+  const size_t buffered = client_->GetReadBufferSize();
+  if (read_kind_ == READ_EXACTLY) {
+    *size = read_size_;
+    return buffered >= read_size_;
+  }
+
+  // READ_UNTIL, the scan resumes where the previous attempt stopped
+  const size_t delimiter_size = read_delimiter_.size();
+  if (buffered >= delimiter_size) {
+    const char* begin = data + delimiter_scanned_;
+    const char* end = data + buffered;
+    const char* found = std::search(begin, end, read_delimiter_.begin(), read_delimiter_.end());
+    if (found != end) {
+      *size = found - data + delimiter_size;
+      return true;
+    }
+    delimiter_scanned_ = buffered - delimiter_size + 1;
+  }
+  if (buffered >= read_size_) {
+    *err = make_errno_error("Delimiter not found", EMSGSIZE);
+    return true;
+  }
+  return false;
+}
+
+void IoStream::FailRead(ErrnoError err) {
+  if (!IsReadPending()) {
+    return;
+  }
+
+  read_callback_t done = std::move(read_done_);
+  read_done_ = read_callback_t();
+  read_kind_ = READ_NONE;
+  done(err, nullptr, 0);
+}
+
+}  // namespace libev
+}  // namespace common
@@ -0,0 +1,382 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <common/libev/loop_watchdog.h>
+
+#include <common/metrics/metrics.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(OS_LINUX) || defined(OS_MACOSX)
+#include <execinfo.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#define HAVE_STACK_CAPTURE 1
+#endif
+
+namespace common {
+namespace libev {
+
+namespace {
+
+const uint64_t kNsInMsec = 1000000;
+const time64_t kMinPollMsec = 10;
+const time64_t kMaxPollMsec = 1000;
+
+#if defined(HAVE_STACK_CAPTURE)
+// Stack capture runs in a SIGURG handler on the stuck thread, SIGURG is ignored by default so a
+// late or unrelated delivery is harmless. Only the watchdog thread requests captures, one at a time.
+const int kStackSignal = SIGURG;
+enum { kMaxFrames = 64 };
+
+void* g_frames[kMaxFrames];
+std::atomic<int> g_frames_count(0);
+std::atomic<bool> g_capture_requested(false);
+std::atomic<bool> g_capture_done(false);
+
+void stack_signal_handler(int sig) {
+  UNUSED(sig);
+  if (!g_capture_requested.exchange(false)) {
+    return;
+  }
+
+  g_frames_count.store(backtrace(g_frames, kMaxFrames), std::memory_order_relaxed);
+  g_capture_done.store(true, std::memory_order_release);
+}
+
+// Takes SIGURG over once, unless the application installed its own handler for it.
+bool InstallStackSignalHandler() {
+  static const bool installed = []() {
+    struct sigaction current;
+    if (sigaction(kStackSignal, nullptr, &current) != 0) {
+      return false;
+    }
+    if ((current.sa_flags & SA_SIGINFO) || (current.sa_handler != SIG_DFL && current.sa_handler != SIG_IGN)) {
+      WARNING_LOG() << "SIGURG is handled by the application, loop stall stacks are not captured";
+      return false;
+    }
+
+    // backtrace lazily loads libgcc on first use, which is not async-signal-safe
+    void* warmup[1];
+    ignore_result(backtrace(warmup, 1));
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stack_signal_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return sigaction(kStackSignal, &action, nullptr) == 0;
+  }();
+  return installed;
+}
+
+std::vector<std::string> CaptureStack(threads::platform_handle_t thread) {
+  std::vector<std::string> stack;
+  g_capture_done.store(false);
+  g_capture_requested.store(true);
+  if (pthread_kill(thread, kStackSignal) != 0) {
+    g_capture_requested.store(false);
+    return stack;
+  }
+
+  for (int i = 0; i < 100 && !g_capture_done.load(std::memory_order_acquire); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (!g_capture_done.load(std::memory_order_acquire)) {
+    g_capture_requested.store(false);
+    return stack;
+  }
+
+  const int count = g_frames_count.load(std::memory_order_relaxed);
+  char** symbols = backtrace_symbols(g_frames, count);
+  if (!symbols) {
+    return stack;
+  }
+
+  // skip the signal handler and the trampoline frames
+  for (int i = 2; i < count; ++i) {
+    stack.push_back(symbols[i]);
+  }
+  free(symbols);
+  return stack;
+}
+#endif
+
+}  // namespace
+
+class LoopWatchdogState {
+ public:
+  explicit LoopWatchdogState(const LoopWatchdogSettings& settings)
+      : settings_(settings),
+        busy_since_(0),
+        callback_(nullptr),
+        has_thread_(false),
+        thread_(),
+        reported_since_(0),
+        callbacks_(METRICS()->GetLatencyHistogram("common_libev_callback_seconds",
+                                                  "Duration of callbacks dispatched by watched loops")),
+        slow_callbacks_(METRICS()->GetCounter("common_libev_slow_callbacks_total",
+                                              "Callbacks exceeding the watchdog slow callback threshold")),
+        stalls_(METRICS()->GetCounter("common_libev_loop_stalls_total", "Loop stalls detected by the watchdog")) {}
+
+  const LoopWatchdogSettings& GetSettings() const { return settings_; }
+
+  uint64_t Begin(const char* callback) {
+    if (!has_thread_.load(std::memory_order_relaxed)) {
+      thread_ = threads::PlatformThread::GetCurrentHandle();
+      has_thread_.store(true, std::memory_order_release);
+    }
+
+    const uint64_t now = metrics::MonotonicNowNs();
+    callback_.store(callback, std::memory_order_relaxed);
+    busy_since_.store(now, std::memory_order_release);
+    return now;
+  }
+
+  time64_t End(uint64_t started_ns) {
+    busy_since_.store(0, std::memory_order_release);
+    const uint64_t elapsed = metrics::MonotonicNowNs() - started_ns;
+    callbacks_->Record(elapsed);
+    if (!settings_.slow_callback_msec || elapsed < settings_.slow_callback_msec * kNsInMsec) {
+      return 0;
+    }
+
+    slow_callbacks_->Increment();
+    return std::max<time64_t>(elapsed / kNsInMsec, 1);
+  }
+
+  // Watchdog thread only, fills |info| once per stalled dispatch.
+  bool IsStalled(uint64_t now, LoopStallInfo* info) {
+    if (!settings_.stall_timeout_msec) {
+      return false;
+    }
+
+    const uint64_t busy_since = busy_since_.load(std::memory_order_acquire);
+    if (!busy_since || busy_since == reported_since_ || now < busy_since ||
+        now - busy_since < settings_.stall_timeout_msec * kNsInMsec) {
+      return false;
+    }
+
+    reported_since_ = busy_since;
+    stalls_->Increment();
+
+    const char* callback = callback_.load(std::memory_order_relaxed);
+    info->callback = callback ? callback : "unknown";
+    info->stalled_msec = (now - busy_since) / kNsInMsec;
+    return true;
+  }
+
+  // Watchdog thread only, may wait for the stuck thread to capture its stack.
+  void ReportStall(LoopStallInfo* info) {
+#if defined(HAVE_STACK_CAPTURE)
+    if (settings_.capture_stack && has_thread_.load(std::memory_order_acquire) && InstallStackSignalHandler()) {
+      info->stack = CaptureStack(thread_);
+    }
+#endif
+
+    if (settings_.on_stall) {
+      settings_.on_stall(*info);
+      return;
+    }
+
+    ERROR_LOG() << "Loop stalled in " << info->callback << " callback for " << info->stalled_msec << " msec";
+    for (size_t i = 0; i < info->stack.size(); ++i) {
+      ERROR_LOG() << "  #" << i << " " << info->stack[i];
+    }
+  }
+
+ private:
+  const LoopWatchdogSettings settings_;
+  std::atomic<uint64_t> busy_since_;
+  std::atomic<const char*> callback_;
+  std::atomic<bool> has_thread_;
+  threads::platform_handle_t thread_;
+  uint64_t reported_since_;
+
+  metrics::Histogram* const callbacks_;
+  metrics::Counter* const slow_callbacks_;
+  metrics::Counter* const stalls_;
+};
+
+namespace {
+
+// Single thread polling every watched loop, started with the first watched loop and joined with the last.
+class LoopWatchdog {
+ public:
+  static LoopWatchdog* GetInstance() {
+    static LoopWatchdog* watchdog = new LoopWatchdog;
+    return watchdog;
+  }
+
+  void Register(LoopWatchdogState* state) {
+#if defined(HAVE_STACK_CAPTURE)
+    if (state->GetSettings().capture_stack) {
+      ignore_result(InstallStackSignalHandler());
+    }
+#endif
+    std::unique_lock<std::mutex> lock(mutex_);
+    states_.push_back(state);
+    if (!running_) {
+      running_ = true;
+      thread_ = std::thread(&LoopWatchdog::Run, this, ++generation_);
+    }
+  }
+
+  void UnRegister(LoopWatchdogState* state) {
+    std::thread finished;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      states_.erase(std::remove(states_.begin(), states_.end(), state), states_.end());
+      reported_.wait(lock, [this, state]() { return reporting_ != state; });
+      if (states_.empty() && running_) {
+        running_ = false;
+        finished.swap(thread_);
+        condition_.notify_all();
+      }
+    }
+    if (finished.joinable()) {
+      finished.join();
+    }
+  }
+
+ private:
+  LoopWatchdog()
+      : mutex_(),
+        condition_(),
+        reported_(),
+        states_(),
+        reporting_(nullptr),
+        running_(false),
+        generation_(0),
+        thread_() {}
+
+  time64_t PollInterval() const {
+    time64_t interval = kMaxPollMsec;
+    for (const LoopWatchdogState* state : states_) {
+      const time64_t timeout = state->GetSettings().stall_timeout_msec;
+      if (timeout) {
+        interval = std::min(interval, timeout / 4);
+      }
+    }
+    return std::max(interval, kMinPollMsec);
+  }
+
+  // generation keeps a thread which is being joined from running on if a new loop is registered meanwhile
+  void Run(uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_ && generation == generation_) {
+      condition_.wait_for(lock, std::chrono::milliseconds(PollInterval()));
+      if (!running_ || generation != generation_) {
+        break;
+      }
+
+      const uint64_t now = metrics::MonotonicNowNs();
+      const std::vector<LoopWatchdogState*> states = states_;
+      for (LoopWatchdogState* state : states) {
+        LoopStallInfo info;
+        if (std::find(states_.begin(), states_.end(), state) == states_.end() || !state->IsStalled(now, &info)) {
+          continue;
+        }
+
+        // the stack capture waits for the stuck thread, UnRegister of this state waits for the report instead
+        reporting_ = state;
+        lock.unlock();
+        state->ReportStall(&info);
+        lock.lock();
+        reporting_ = nullptr;
+        reported_.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::condition_variable reported_;
+  std::vector<LoopWatchdogState*> states_;
+  LoopWatchdogState* reporting_;
+  bool running_;
+  uint64_t generation_;
+  std::thread thread_;
+};
+
+}  // namespace
+
+LoopWatchdogSettings::LoopWatchdogSettings()
+    : slow_callback_msec(50), stall_timeout_msec(1000), capture_stack(true), on_slow_callback(), on_stall() {}
+
+void LibEvLoop::EnableWatchdog(const LoopWatchdogSettings& settings) {
+  CHECK(!is_running_ || IsLoopThread()) << "Must be called before Exec or in loop thread!";
+
+  DisableWatchdog();
+  watchdog_ = new LoopWatchdogState(settings);
+  LoopWatchdog::GetInstance()->Register(watchdog_);
+}
+
+void LibEvLoop::DisableWatchdog() {
+  if (!watchdog_) {
+    return;
+  }
+
+  CHECK(!is_running_ || IsLoopThread()) << "Must be called before Exec or in loop thread!";
+  LoopWatchdog::GetInstance()->UnRegister(watchdog_);
+  destroy(&watchdog_);
+}
+
+uint64_t LibEvLoop::BeginWatchdogDispatch(const char* callback) {
+  return watchdog_->Begin(callback);
+}
+
+time64_t LibEvLoop::EndDispatch(uint64_t started_ns) {
+  if (!watchdog_) {
+    return 0;
+  }
+
+  return watchdog_->End(started_ns);
+}
+
+void LibEvLoop::ReportSlowCallback(const char* callback, const std::string& target, time64_t duration_msec) {
+  if (!watchdog_) {
+    return;
+  }
+
+  const LoopWatchdogSettings& settings = watchdog_->GetSettings();
+  if (settings.on_slow_callback) {
+    settings.on_slow_callback({callback, target, duration_msec});
+    return;
+  }
+
+  WARNING_LOG() << "Slow " << callback << " callback for " << target << ": " << duration_msec << " msec";
+}
+
+}  // namespace libev
+}  // namespace common
@@ -50,6 +50,10 @@ descriptor_t TcpClient::GetFd() const {
   return sock_->GetFd();
 }
 
+bool TcpClient::IsZeroCopySendSupported() const {
+  return sock_->IsZeroCopySendSupported();
+}
+
 ErrnoError TcpClient::SetBlocking(bool block) {
   return sock_->SetBlocking(block);
 }
@@ -31,7 +31,11 @@
 #include <common/libev/event_io.h>
 #include <common/libev/io_child.h>
 #include <common/libev/io_loop.h>
+#include <common/libev/loop_watchdog.h>
 #include <common/libev/tcp/tcp_server.h>
+#include <common/metrics/metrics.h>
+#include <common/net/net.h>
+#include <common/time.h>
 #include <errno.h>
 #include <signal.h>
 #include <stdlib.h>
@@ -73,7 +77,12 @@ namespace tcp {
 
 // server
 TcpServer::TcpServer(net::IServerSocketEv* sock, bool is_default, IoLoopObserver* observer)
-    : IoLoop(is_default ? new LibEvDefaultLoop : new LibEvLoop, observer), sock_(sock), accept_io_(new LibevIO) {
+    : IoLoop(is_default ? new LibEvDefaultLoop : new LibEvLoop, observer),
+      sock_(sock),
+      accept_io_(new LibevIO),
+      draining_(false),
+      drain_deadline_msec_(0),
+      drain_timer_(INVALID_TIMER_ID) {
   accept_io_->SetUserData(this);
 }
 
@@ -109,6 +118,62 @@ IoClient* TcpServer::RegisterClient(const net::socket_info& info, void* user) {
   return nullptr;
 }
 
+void TcpServer::Drain(time64_t timeout_msec) {
+  ExecInLoopThread([this, timeout_msec]() { StartDrain(timeout_msec); });
+}
+
+bool TcpServer::IsDraining() const {
+  return draining_;
+}
+
+#if defined(OS_POSIX)
+ErrnoError TcpServer::SendListener(net::socket_descr_t unix_sock) const {
+  return net::send_descriptor(unix_sock, sock_->GetFd());
+}
+
+ErrnoError TcpServer::ReceiveListener(net::socket_descr_t unix_sock, net::socket_descr_t* listening_fd) {
+  return net::recv_descriptor(unix_sock, listening_fd);
+}
+#endif
+
+bool TcpServer::IsClientIdle(IoClient* client) const {
+  if (client->IsRequestInFlight() || client->IsSendingFile()) {
+    return false;
+  }
+  // a keep alive client may have sent its next request already, the read watcher reports it soon
+  return client->GetReadBufferSize() == 0 && client->GetPendingWriteBytes() == 0 && client->GetUnreadBytes() == 0;
+}
+
+void TcpServer::StartDrain(time64_t timeout_msec) {
+  if (draining_) {
+    return;
+  }
+
+  draining_ = true;
+  accept_io_->Stop();
+  drain_deadline_msec_ = time::current_utc_mstime() + timeout_msec;
+  drain_timer_ = CreateTimer(0.05, true);
+  INFO_LOG() << "Draining server[" << GetFormatedName() << "], " << clients_.size() << " client(s) connected.";
+  CheckDrain();
+}
+
+void TcpServer::CheckDrain() {
+  const std::vector<IoClient*> clients = GetClients();
+  for (IoClient* client : clients) {
+    if (IsClientIdle(client)) {
+      ErrnoError err = client->Close();
+      DCHECK(!err) << err->GetDescription();
+      delete client;
+    }
+  }
+
+  if (clients_.empty() || time::current_utc_mstime() >= drain_deadline_msec_) {
+    RemoveTimer(drain_timer_);
+    drain_timer_ = INVALID_TIMER_ID;
+    Stop();
+  }
+}
+
 net::IServerSocketEv* TcpServer::GetSocket() const {
   return sock_.get();
 }
@@ -139,6 +204,15 @@ void TcpServer::PostLooped(LibEvLoop* loop) {
   IoLoop::PostLooped(loop);
 }
 
+void TcpServer::TimerEmited(LibEvLoop* loop, timer_id_t id) {
+  if (id == drain_timer_) {
+    CheckDrain();
+    return;
+  }
+
+  IoLoop::TimerEmited(loop, id);
+}
+
 void TcpServer::Stopped(LibEvLoop* loop) {
   loop->StopIO(accept_io_);
   IoLoop::Stopped(loop);
@@ -187,14 +261,22 @@ void TcpServer::accept_cb(LibEvLoop* loop, LibevIO* io, int revents) {
     return;
   }
 
+  ScopedDispatch dispatch(loop, "accept", [pserver]() { return pserver->GetFormatedName(); });
+  static metrics::Counter* const accepted =
+      METRICS()->GetCounter("common_libev_tcp_accepted_total", "Connections accepted by tcp servers");
+  static metrics::Counter* const accept_errors =
+      METRICS()->GetCounter("common_libev_tcp_accept_errors_total", "Failed accept calls of tcp servers");
+
   net::socket_info sinfo;
   void* user = nullptr;
   ErrnoError err = pserver->Accept(&sinfo, &user);
   if (err) {
+    accept_errors->Increment();
     DNOTREACHED() << err->GetDescription();
     return;
   }
 
+  accepted->Increment();
   ignore_result(pserver->RegisterClient(sinfo, user));
 }
 
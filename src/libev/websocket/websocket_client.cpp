@@ -32,7 +32,6 @@
 #include <common/libev/websocket/websocket_client.h>
 #include <common/utils.h>
 
-#define BUF_SIZE 4096
 #define MAX_PAYLOAD_SIZE (1024 * 1024)
 
 namespace {
@@ -281,7 +280,7 @@ ErrnoError WebSocketClient::SendEOS() {
 }
 
 WebSocketServerClient::WebSocketServerClient(libev::IoLoop* server, const net::socket_info& info)
-    : WebSocketClient(server, info), frame_{}, ntoread_(0), step_(ZERO) {}
+    : WebSocketClient(server, info), frame_{}, step_(ZERO) {}
 
 WebSocketServerClient::~WebSocketServerClient() {}
 
@@ -310,111 +309,72 @@ ErrnoError WebSocketServerClient::SendPong() {
 }
 
 ErrnoError WebSocketServerClient::ProcessFrame(std::function<void(char*, size_t)> pred) {
-  if (step_ == common::libev::websocket::ONE) {
-    char buff[BUF_SIZE] = {0};
-    size_t nread = 0;
-    common::ErrnoError errn = SingleRead(buff, ntoread_, &nread);
-    if (errn || nread == 0) {
-      if (nread == 0) {
-        return make_errno_error("Connection closed", EAGAIN);
-      }
-      return errn;
+  size_t nread = 0;
+  common::ErrnoError errn = ReadToBuffer(&nread);
+  if (errn) {
+    return errn;
+  }
+  if (nread == 0) {
+    return make_errno_error("Connection closed", EAGAIN);
+  }
+
+  // one read may carry several frames, handle all complete ones and keep the tail buffered
+  while (true) {
+    char* buff = GetReadBuffer();
+    const size_t size = GetReadBufferSize();
+    if (size < 2) {
+      step_ = ONE;
+      break;
     }
 
-    if (parse_frame_header(buff, &frame_)) {
-      if (frame_.payload_len <= 125) {
-        step_ = THREE;
-        ntoread_ = 4;
-      } else if (frame_.payload_len == 126) {
-        step_ = TWO;
-        ntoread_ = 2;
-      } else if (frame_.payload_len == 127) {
-        step_ = TWO;
-        ntoread_ = 8;
-      }
+    parse_frame_header(buff, &frame_);
+    size_t header_len = 2;
+    if (frame_.payload_len == 126) {
+      header_len += 2;
+    } else if (frame_.payload_len == 127) {
+      header_len += 8;
     }
-  } else if (step_ == common::libev::websocket::TWO) {
-    char* tmp = (char*)malloc(ntoread_);
-    size_t nread = 0;
-    common::ErrnoError errn = SingleRead(tmp, ntoread_, &nread);
-    if (errn || nread == 0) {
-      free(tmp);
-      if (nread == 0) {
-        return make_errno_error("Connection closed", EAGAIN);
-      }
-      return errn;
+    if (size < header_len) {
+      step_ = TWO;
+      break;
     }
 
     if (frame_.payload_len == 126) {
-      frame_.payload_len = ntohs(*(uint16_t*)tmp);
+      uint16_t len;
+      memcpy(&len, buff + 2, sizeof(len));
+      frame_.payload_len = ntohs(len);
     } else if (frame_.payload_len == 127) {
-      frame_.payload_len = myntohll(*(uint64_t*)tmp);
+      uint64_t len;
+      memcpy(&len, buff + 2, sizeof(len));
+      frame_.payload_len = myntohll(len);
     }
-    free(tmp);
-    step_ = THREE;
-    ntoread_ = 4;
-  } else if (step_ == common::libev::websocket::THREE) {
-    char buff[BUF_SIZE] = {0};
-    size_t nread = 0;
-    common::ErrnoError errn = SingleRead(buff, ntoread_, &nread);
-    if (errn || nread == 0) {
-      if (nread == 0) {
-        return make_errno_error("Connection closed", EAGAIN);
-      }
-      return errn;
+    if (frame_.payload_len > MAX_PAYLOAD_SIZE) {
+      return make_errno_error("Payload too large", E2BIG);
     }
 
-    memcpy(frame_.masking_key, buff, ntoread_);
-    if (frame_.payload_len > 0) {
-      step_ = FOUR;
-      ntoread_ = frame_.payload_len;
-    } else if (frame_.payload_len == 0) {
-      /*recv a whole frame*/
-      if (frame_.mask == 0) {
-        // recv an unmasked frame
-      }
-      if (frame_.fin == 1 && frame_.opcode == 0x8) {
-        // 0x8 denotes a connection close
-        SendEOS();
-        return make_errno_error("Connection closed", EAGAIN);
-      } else if (frame_.fin == 1 && frame_.opcode == 0x9) {
-        // 0x9 denotes a ping
-        SendPong();
-      } else {
+    if (frame_.mask == 1) {
+      if (size < header_len + 4) {
+        step_ = THREE;
+        break;
       }
-
-      step_ = ONE;
-      ntoread_ = 2;
-      memset(&frame_, 0, sizeof(frame_t));
+      memcpy(frame_.masking_key, buff + header_len, 4);
+      header_len += 4;
     }
-  } else if (step_ == common::libev::websocket::FOUR) {
-    if (frame_.payload_len > MAX_PAYLOAD_SIZE) {
-      return make_errno_error("Payload too large", E2BIG);
+
+    const size_t frame_len = header_len + frame_.payload_len;
+    if (size < frame_len) {
+      step_ = FOUR;
+      break;
     }
+
+    char* payload = buff + header_len;
     if (frame_.payload_len > 0) {
-      char* buff = new char[frame_.payload_len];
-      if (!buff) {
-        return make_errno_error("Memory allocation failed", ENOMEM);
-      }
-      size_t total_read = 0;
-      while (total_read < frame_.payload_len) {
-        size_t nread = 0;
-        common::ErrnoError errn = SingleRead(buff + total_read, frame_.payload_len - total_read, &nread);
-        if (errn || nread == 0) {
-          delete[] buff;
-          if (nread == 0) {
-            return make_errno_error("Connection closed", EAGAIN);
-          }
-          return errn;
-        }
-        total_read += nread;
-      }
       if (frame_.mask == 1) {
-        unmask_payload_data((const char*)frame_.masking_key, buff, frame_.payload_len);
+        unmask_payload_data((const char*)frame_.masking_key, payload, frame_.payload_len);
       }
-      pred(buff, total_read);
-      delete[] buff;
+      pred(payload, frame_.payload_len);
     }
+    ConsumeReadBuffer(frame_len);
 
     /*recv a whole frame*/
     if (frame_.fin == 1 && frame_.opcode == 0x8) {
@@ -428,13 +388,6 @@ ErrnoError WebSocketServerClient::ProcessFrame(std::function<void(char*, size_t)
       // execute custom operation
     }
 
-    if (frame_.opcode == 0x1) {  // 0x1 denotes a text frame
-    }
-    if (frame_.opcode == 0x2) {  // 0x1 denotes a binary frame
-    }
-
-    step_ = ONE;
-    ntoread_ = 2;
     memset(&frame_, 0, sizeof(frame_t));
   }
   return ErrnoError();
@@ -469,7 +422,6 @@ ErrnoError WebSocketServerClient::SendSwitchProtocolsResponse(const std::string&
       SendResponse(common::http::http_protocol::HP_1_1, common::http::http_status::HS_SWITCH_PROTOCOL, headers, info);
   if (!errn) {
     step_ = ONE;
-    ntoread_ = 2;
     memset(&frame_, 0, sizeof(frame_t));
   }
   return errn;
@@ -0,0 +1,248 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <common/memory/slab_pool.h>
+
+#include <algorithm>
+#include <new>
+
+namespace common {
+namespace memory {
+
+namespace {
+
+// Precedes every block handed out by PoolAllocate, keeps payloads 16 byte aligned.
+struct alignas(16) AllocationHeader {
+  SlabPools* pools;  // nullptr for heap blocks
+  size_t size_class;
+};
+
+const size_t kHeaderSize = sizeof(AllocationHeader);
+
+thread_local SlabPools* g_current_pools = nullptr;
+
+}  // namespace
+
+SlabPoolStats::SlabPoolStats()
+    : object_size(0), slabs(0), objects_in_use(0), objects_free(0), allocations(0), remote_frees(0) {}
+
+SlabPool::SlabPool(size_t object_size, size_t objects_per_slab)
+    : object_size_(std::max(object_size, sizeof(FreeNode))),
+      objects_per_slab_(objects_per_slab),
+      slabs_(),
+      free_list_(nullptr),
+      remote_free_(nullptr),
+      in_use_(0),
+      free_(0),
+      allocations_(0),
+      remote_frees_(0) {}
+
+SlabPool::~SlabPool() {
+  for (char* slab : slabs_) {
+    ::operator delete(slab);
+  }
+}
+
+void* SlabPool::Allocate() {
+  if (!free_list_ && !ReclaimRemote()) {
+    Grow();
+  }
+
+  FreeNode* node = free_list_;
+  free_list_ = node->next;
+  free_.fetch_sub(1, std::memory_order_relaxed);
+  in_use_.fetch_add(1, std::memory_order_relaxed);
+  allocations_.fetch_add(1, std::memory_order_relaxed);
+  return node;
+}
+
+void SlabPool::Deallocate(void* ptr) {
+  FreeNode* node = static_cast<FreeNode*>(ptr);
+  node->next = free_list_;
+  free_list_ = node;
+  in_use_.fetch_sub(1, std::memory_order_relaxed);
+  free_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SlabPool::DeallocateRemote(void* ptr) {
+  FreeNode* node = static_cast<FreeNode*>(ptr);
+  FreeNode* head = remote_free_.load(std::memory_order_relaxed);
+  do {
+    node->next = head;
+  } while (!remote_free_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+  remote_frees_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool SlabPool::ReclaimRemote() {
+  FreeNode* remote = remote_free_.exchange(nullptr, std::memory_order_acquire);
+  if (!remote) {
+    return false;
+  }
+
+  size_t reclaimed = 0;
+  FreeNode* tail = remote;
+  while (true) {
+    reclaimed++;
+    if (!tail->next) {
+      break;
+    }
+    tail = tail->next;
+  }
+  tail->next = free_list_;
+  free_list_ = remote;
+  in_use_.fetch_sub(reclaimed, std::memory_order_relaxed);
+  free_.fetch_add(reclaimed, std::memory_order_relaxed);
+  return true;
+}
+
+void SlabPool::Grow() {
+  char* slab = static_cast<char*>(::operator new(object_size_ * objects_per_slab_));
+  slabs_.push_back(slab);
+  // thread the free list front to back so fresh objects are handed out in address order
+  for (size_t i = objects_per_slab_; i > 0; --i) {
+    FreeNode* node = reinterpret_cast<FreeNode*>(slab + (i - 1) * object_size_);
+    node->next = free_list_;
+    free_list_ = node;
+  }
+  free_.fetch_add(objects_per_slab_, std::memory_order_relaxed);
+}
+
+SlabPoolStats SlabPool::GetStats() const {
+  SlabPoolStats stats;
+  stats.object_size = object_size_;
+  // remote frees count as in use until the owner reclaims them, so in_use + free covers every slab object
+  stats.objects_in_use = in_use_.load(std::memory_order_relaxed);
+  stats.objects_free = free_.load(std::memory_order_relaxed);
+  stats.slabs = (stats.objects_in_use + stats.objects_free) / objects_per_slab_;
+  stats.allocations = allocations_.load(std::memory_order_relaxed);
+  stats.remote_frees = remote_frees_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+SlabPools::SlabPools() : pools_(), refs_(1) {
+  for (size_t i = 0; i < kClassesCount; ++i) {
+    pools_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+SlabPools::~SlabPools() {
+  for (size_t i = 0; i < kClassesCount; ++i) {
+    delete pools_[i].load(std::memory_order_relaxed);
+  }
+}
+
+void* SlabPools::Allocate(size_t size) {
+  DCHECK(g_current_pools == this);
+  DCHECK(size && size <= kMaxObjectSize);
+
+  const size_t size_class = (size - 1) / kGranularity;
+  SlabPool* pool = pools_[size_class].load(std::memory_order_relaxed);
+  if (!pool) {
+    const size_t slot_size = kHeaderSize + (size_class + 1) * kGranularity;
+    pool = new SlabPool(slot_size, std::max<size_t>(kSlabBytes / slot_size, 8));
+    pools_[size_class].store(pool, std::memory_order_release);
+  }
+
+  AllocationHeader* header = static_cast<AllocationHeader*>(pool->Allocate());
+  header->pools = this;
+  header->size_class = size_class;
+  refs_.fetch_add(1, std::memory_order_relaxed);
+  return header + 1;
+}
+
+void SlabPools::Free(void* slot, size_t size_class) {
+  SlabPool* pool = pools_[size_class].load(std::memory_order_relaxed);
+  if (g_current_pools == this) {
+    pool->Deallocate(slot);
+  } else {
+    pool->DeallocateRemote(slot);
+  }
+  Unref();
+}
+
+void SlabPools::Release() {
+  Unref();
+}
+
+void SlabPools::Unref() {
+  if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete this;
+  }
+}
+
+std::vector<SlabPoolStats> SlabPools::GetStats() const {
+  std::vector<SlabPoolStats> stats;
+  for (size_t i = 0; i < kClassesCount; ++i) {
+    const SlabPool* pool = pools_[i].load(std::memory_order_acquire);
+    if (pool) {
+      stats.push_back(pool->GetStats());
+    }
+  }
+  return stats;
+}
+
+SlabPools* SlabPools::Current() {
+  return g_current_pools;
+}
+
+SlabPools::ScopedCurrent::ScopedCurrent(SlabPools* pools) : previous_(g_current_pools) {
+  g_current_pools = pools;
+}
+
+SlabPools::ScopedCurrent::~ScopedCurrent() {
+  g_current_pools = previous_;
+}
+
+void* PoolAllocate(size_t size) {
+  SlabPools* pools = g_current_pools;
+  if (pools && size && size <= SlabPools::kMaxObjectSize) {
+    return pools->Allocate(size);
+  }
+
+  AllocationHeader* header = static_cast<AllocationHeader*>(::operator new(kHeaderSize + size));
+  header->pools = nullptr;
+  header->size_class = 0;
+  return header + 1;
+}
+
+void PoolFree(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+
+  AllocationHeader* header = static_cast<AllocationHeader*>(ptr) - 1;
+  if (!header->pools) {
+    ::operator delete(header);
+    return;
+  }
+
+  header->pools->Free(header, header->size_class);
+}
+
+}  // namespace memory
+}  // namespace common
@@ -0,0 +1,248 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+#include <common/metrics/metrics.h>
+
+#include <common/convert2string.h>
+
+#include <chrono>
+
+namespace common {
+namespace metrics {
+
+namespace {
+
+const double kExportQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+std::atomic<size_t> g_next_shard(0);
+
+void AppendHeader(const Metric* metric, const char* type, std::string* out) {
+  out->append("# HELP ").append(metric->GetName()).append(" ").append(metric->GetHelp()).append("\n");
+  out->append("# TYPE ").append(metric->GetName()).append(" ").append(type).append("\n");
+}
+
+std::string ScaledValue(uint64_t value, double scale) {
+  if (scale == 1.0) {
+    return ConvertToString(value);
+  }
+  return ConvertToString(static_cast<double>(value) * scale, 9);
+}
+
+}  // namespace
+
+uint64_t MonotonicNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t CurrentShard() {
+  static thread_local size_t shard = g_next_shard.fetch_add(1, std::memory_order_relaxed) % kCounterShards;
+  return shard;
+}
+
+Metric::Metric(metric_t type, const std::string& name, const std::string& help)
+    : type_(type), name_(name), help_(help) {}
+
+Metric::~Metric() {}
+
+metric_t Metric::GetType() const {
+  return type_;
+}
+
+const std::string& Metric::GetName() const {
+  return name_;
+}
+
+const std::string& Metric::GetHelp() const {
+  return help_;
+}
+
+Counter::Counter(const std::string& name, const std::string& help) : Metric(METRIC_COUNTER, name, help), shards_() {
+  for (size_t i = 0; i < kCounterShards; ++i) {
+    shards_[i].value.store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t Counter::GetValue() const {
+  uint64_t total = 0;
+  for (size_t i = 0; i < kCounterShards; ++i) {
+    total += shards_[i].value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+Gauge::Gauge(const std::string& name, const std::string& help) : Metric(METRIC_GAUGE, name, help), value_(0) {}
+
+HistogramSnapshot::HistogramSnapshot() : count(0), sum(0), buckets() {}
+
+uint64_t HistogramSnapshot::ValueAtQuantile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+
+  if (q < 0) {
+    q = 0;
+  } else if (q > 1) {
+    q = 1;
+  }
+
+  uint64_t rank = static_cast<uint64_t>(q * count + 0.5);
+  if (rank == 0) {
+    rank = 1;
+  }
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return Histogram::BucketUpperBound(i);
+    }
+  }
+  return Histogram::BucketUpperBound(buckets.size() - 1);
+}
+
+Histogram::Histogram(const std::string& name, const std::string& help, double export_scale)
+    : Metric(METRIC_HISTOGRAM, name, help), export_scale_(export_scale), buckets_(), sum_(0) {
+  for (size_t i = 0; i < kBucketsCount; ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+double Histogram::GetExportScale() const {
+  return export_scale_;
+}
+
+HistogramSnapshot Histogram::TakeSnapshot() const {
+  HistogramSnapshot snapshot;
+  snapshot.buckets.resize(kBucketsCount);
+  for (size_t i = 0; i < kBucketsCount; ++i) {
+    const uint64_t hits = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.buckets[i] = hits;
+    snapshot.count += hits;
+  }
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+uint64_t Histogram::BucketUpperBound(size_t index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+
+  const size_t shift = index / kSubBuckets - 1;
+  const uint64_t sub = index % kSubBuckets;
+  const uint64_t lower = (kSubBuckets + sub) << shift;
+  return lower + ((uint64_t(1) << shift) - 1);
+}
+
+MetricsRegistry::MetricsRegistry() : metrics_mutex_(), metrics_() {}
+
+MetricsRegistry::~MetricsRegistry() {}
+
+Metric* MetricsRegistry::FindMetric(const std::string& name, metric_t type) const {
+  const auto it = metrics_.find(name);
+  if (it == metrics_.end()) {
+    return nullptr;
+  }
+
+  CHECK(it->second->GetType() == type) << "Metric " << name << " already registered with another type";
+  return it->second.get();
+}
+
+Counter* MetricsRegistry::GetCounter(const std::string& name, const std::string& help) {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  Metric* found = FindMetric(name, METRIC_COUNTER);
+  if (found) {
+    return static_cast<Counter*>(found);
+  }
+
+  Counter* counter = new Counter(name, help);
+  metrics_[name].reset(counter);
+  return counter;
+}
+
+Gauge* MetricsRegistry::GetGauge(const std::string& name, const std::string& help) {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  Metric* found = FindMetric(name, METRIC_GAUGE);
+  if (found) {
+    return static_cast<Gauge*>(found);
+  }
+
+  Gauge* gauge = new Gauge(name, help);
+  metrics_[name].reset(gauge);
+  return gauge;
+}
+
+Histogram* MetricsRegistry::GetHistogram(const std::string& name, const std::string& help, double export_scale) {
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  Metric* found = FindMetric(name, METRIC_HISTOGRAM);
+  if (found) {
+    return static_cast<Histogram*>(found);
+  }
+
+  Histogram* histogram = new Histogram(name, help, export_scale);
+  metrics_[name].reset(histogram);
+  return histogram;
+}
+
+Histogram* MetricsRegistry::GetLatencyHistogram(const std::string& name, const std::string& help) {
+  return GetHistogram(name, help, kNanosecondsToSeconds);
+}
+
+std::string MetricsRegistry::ExportPrometheus() const {
+  std::string out;
+  std::lock_guard<std::mutex> lock(metrics_mutex_);
+  for (const auto& entry : metrics_) {
+    const Metric* metric = entry.second.get();
+    const std::string& name = metric->GetName();
+    if (metric->GetType() == METRIC_COUNTER) {
+      AppendHeader(metric, "counter", &out);
+      out.append(name).append(" ").append(ConvertToString(static_cast<const Counter*>(metric)->GetValue()));
+      out.append("\n");
+    } else if (metric->GetType() == METRIC_GAUGE) {
+      AppendHeader(metric, "gauge", &out);
+      out.append(name).append(" ").append(ConvertToString(static_cast<const Gauge*>(metric)->GetValue()));
+      out.append("\n");
+    } else if (metric->GetType() == METRIC_HISTOGRAM) {
+      const Histogram* histogram = static_cast<const Histogram*>(metric);
+      const double scale = histogram->GetExportScale();
+      const HistogramSnapshot snapshot = histogram->TakeSnapshot();
+      AppendHeader(metric, "summary", &out);
+      for (double quantile : kExportQuantiles) {
+        out.append(name).append("{quantile=\"").append(ConvertToString(quantile, 3)).append("\"} ");
+        out.append(ScaledValue(snapshot.ValueAtQuantile(quantile), scale)).append("\n");
+      }
+      out.append(name).append("_sum ").append(ScaledValue(snapshot.sum, scale)).append("\n");
+      out.append(name).append("_count ").append(ConvertToString(snapshot.count)).append("\n");
+    }
+  }
+  return out;
+}
+
+}  // namespace metrics
+}  // namespace common
@@ -0,0 +1,321 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/net/buffer_chain.h>
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(OS_POSIX)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#include <algorithm>
+
+#include <common/eintr_wrapper.h>
+#include <common/net/net.h>
+
+namespace common {
+namespace net {
+
+const size_t BufferChain::kBlockSize;
+const size_t BufferChain::kMaxSpareBlocks;
+const size_t BufferChain::kMaxIovecs;
+const size_t BufferChain::kAdoptThreshold;
+
+BufferChain::Segment::Segment() : block(), adopted(), capacity(0), head(0), tail(0) {}
+
+BufferChain::Segment::Segment(block_t&& block)
+    : block(std::move(block)), adopted(), capacity(kBlockSize), head(0), tail(0) {}
+
+BufferChain::Segment::Segment(char_buffer_t&& buffer)
+    : block(), adopted(std::move(buffer)), capacity(adopted.size()), head(0), tail(adopted.size()) {}
+
+char* BufferChain::Segment::GetData() {
+  return block ? block.get() : adopted.data();
+}
+
+const char* BufferChain::Segment::GetData() const {
+  return block ? block.get() : adopted.data();
+}
+
+bool BufferChain::Segment::IsPooled() const {
+  return static_cast<bool>(block);
+}
+
+size_t BufferChain::Segment::GetSize() const {
+  return tail - head;
+}
+
+size_t BufferChain::Segment::GetFreeSpace() const {
+  return IsPooled() ? capacity - tail : 0;
+}
+
+BufferChain::BufferChain() : segments_(), spare_blocks_(), size_(0) {}
+
+BufferChain::~BufferChain() {}
+
+size_t BufferChain::GetSize() const {
+  return size_;
+}
+
+bool BufferChain::IsEmpty() const {
+  return size_ == 0;
+}
+
+size_t BufferChain::GetSegmentsCount() const {
+  return segments_.size();
+}
+
+void BufferChain::Append(const void* data, size_t size) {
+  if (!data || !size) {
+    return;
+  }
+
+  const char* pos = static_cast<const char*>(data);
+  while (size) {
+    if (segments_.empty() || segments_.back().GetFreeSpace() == 0) {
+      segments_.emplace_back(TakeBlock());
+    }
+
+    Segment& last = segments_.back();
+    const size_t chunk = std::min(size, last.GetFreeSpace());
+    memcpy(last.GetData() + last.tail, pos, chunk);
+    last.tail += chunk;
+    size_ += chunk;
+    pos += chunk;
+    size -= chunk;
+  }
+}
+
+void BufferChain::Append(char_buffer_t&& buffer) {
+  if (buffer.size() < kAdoptThreshold) {
+    Append(buffer.data(), buffer.size());
+    return;
+  }
+
+  size_ += buffer.size();
+  segments_.emplace_back(std::move(buffer));
+}
+
+size_t BufferChain::Peek(void* out, size_t size) const {
+  if (!out) {
+    return 0;
+  }
+
+  char* pos = static_cast<char*>(out);
+  size_t copied = 0;
+  for (auto it = segments_.begin(); it != segments_.end() && copied < size; ++it) {
+    const size_t chunk = std::min(size - copied, it->GetSize());
+    memcpy(pos + copied, it->GetData() + it->head, chunk);
+    copied += chunk;
+  }
+  return copied;
+}
+
+size_t BufferChain::Read(void* out, size_t size) {
+  const size_t copied = Peek(out, size);
+  Consume(copied);
+  return copied;
+}
+
+void BufferChain::Consume(size_t size) {
+  size = std::min(size, size_);
+  size_ -= size;
+  while (size) {
+    Segment& first = segments_.front();
+    const size_t chunk = std::min(size, first.GetSize());
+    first.head += chunk;
+    size -= chunk;
+    if (first.head == first.tail) {
+      if (first.IsPooled()) {
+        ReturnBlock(std::move(first.block));
+      }
+      segments_.pop_front();
+    }
+  }
+}
+
+void BufferChain::Clear() {
+  Consume(size_);
+  segments_.clear();
+}
+
+ErrnoError BufferChain::WriteToSocket(socket_descr_t fd, size_t* nwrite_out) {
+  if (fd == INVALID_SOCKET_VALUE || !nwrite_out) {
+    return make_error_perror("BufferChain::WriteToSocket", EINVAL);
+  }
+
+  if (IsEmpty()) {
+    *nwrite_out = 0;
+    return ErrnoError();
+  }
+
+#if defined(OS_POSIX)
+  struct iovec iov[kMaxIovecs];
+  size_t count = 0;
+  for (auto it = segments_.begin(); it != segments_.end() && count < kMaxIovecs; ++it) {
+    if (it->GetSize() == 0) {
+      continue;
+    }
+    iov[count].iov_base = it->GetData() + it->head;
+    iov[count].iov_len = it->GetSize();
+    count++;
+  }
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = count;
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+  ssize_t lnwritten = HANDLE_EINTR(sendmsg(fd, &msg, MSG_NOSIGNAL));
+#else
+  ssize_t lnwritten = HANDLE_EINTR(sendmsg(fd, &msg, 0));
+#endif
+  if (lnwritten == ERROR_RESULT_VALUE && errno == ENOTSOCK) {
+    lnwritten = HANDLE_EINTR(writev(fd, iov, static_cast<int>(count)));
+  }
+  if (lnwritten == ERROR_RESULT_VALUE) {
+    return make_error_perror("writev", errno);
+  }
+
+  const size_t nwritten = lnwritten;
+#else
+  const Segment& first = segments_.front();
+  size_t nwritten = 0;
+  ErrnoError err = write_to_tcp_socket(fd, first.GetData() + first.head, first.GetSize(), &nwritten);
+  if (err) {
+    return err;
+  }
+#endif
+
+  Consume(nwritten);
+  *nwrite_out = nwritten;
+  return ErrnoError();
+}
+
+ErrnoError BufferChain::ReadFromSocket(socket_descr_t fd, size_t max_size, size_t* nread_out) {
+  if (fd == INVALID_SOCKET_VALUE || !max_size || !nread_out) {
+    return make_error_perror("BufferChain::ReadFromSocket", EINVAL);
+  }
+
+  // free space of the last block first, then at most one fresh block
+  char* tail_space = nullptr;
+  size_t tail_len = 0;
+  if (!segments_.empty() && segments_.back().GetFreeSpace()) {
+    Segment& last = segments_.back();
+    tail_space = last.GetData() + last.tail;
+    tail_len = std::min(max_size, last.GetFreeSpace());
+  }
+
+  block_t extra;
+  size_t extra_len = 0;
+  if (tail_len < max_size) {
+    extra = TakeBlock();
+    extra_len = std::min(max_size - tail_len, kBlockSize);
+  }
+
+#if defined(OS_POSIX)
+  struct iovec iov[2];
+  int count = 0;
+  if (tail_len) {
+    iov[count].iov_base = tail_space;
+    iov[count].iov_len = tail_len;
+    count++;
+  }
+  if (extra_len) {
+    iov[count].iov_base = extra.get();
+    iov[count].iov_len = extra_len;
+    count++;
+  }
+
+  ssize_t lnread = HANDLE_EINTR(readv(fd, iov, count));
+  if (lnread == ERROR_RESULT_VALUE) {
+    if (extra) {
+      ReturnBlock(std::move(extra));
+    }
+    return make_error_perror("readv", errno);
+  }
+
+  if (lnread == 0) {
+    if (extra) {
+      ReturnBlock(std::move(extra));
+    }
+    return make_errno_error(ECONNRESET);
+  }
+
+  size_t nread = lnread;
+#else
+  size_t nread = 0;
+  ErrnoError err = tail_len ? read_from_tcp_socket(fd, tail_space, tail_len, &nread)
+                            : read_from_tcp_socket(fd, extra.get(), extra_len, &nread);
+  if (err) {
+    if (extra) {
+      ReturnBlock(std::move(extra));
+    }
+    return err;
+  }
+#endif
+
+  *nread_out = nread;
+  size_ += nread;
+  const size_t to_tail = tail_space ? std::min(nread, tail_len) : 0;
+  if (to_tail) {
+    segments_.back().tail += to_tail;
+  }
+
+  const size_t to_extra = nread - to_tail;
+  if (to_extra) {
+    segments_.emplace_back(std::move(extra));
+    segments_.back().tail = to_extra;
+  } else if (extra) {
+    ReturnBlock(std::move(extra));
+  }
+  return ErrnoError();
+}
+
+BufferChain::block_t BufferChain::TakeBlock() {
+  if (spare_blocks_.empty()) {
+    return block_t(new char[kBlockSize]);
+  }
+
+  block_t block = std::move(spare_blocks_.back());
+  spare_blocks_.pop_back();
+  return block;
+}
+
+void BufferChain::ReturnBlock(block_t&& block) {
+  if (spare_blocks_.size() < kMaxSpareBlocks) {
+    spare_blocks_.push_back(std::move(block));
+  }
+}
+
+}  // namespace net
+}  // namespace common
@@ -0,0 +1,317 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/net/file_transfer.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(OS_POSIX)
+#include <poll.h>
+#endif
+
+#if defined(OS_LINUX)
+#include <sys/sendfile.h>
+#endif
+
+#include <algorithm>
+
+#include <common/eintr_wrapper.h>
+#include <common/net/net.h>
+
+namespace common {
+namespace net {
+
+namespace {
+
+ErrnoError unexpected_eof_error() {
+  return make_error_perror("FileTransfer", EIO);
+}
+
+bool is_would_block(ErrnoError err) {
+  return err && (err->GetErrorCode() == EAGAIN || err->GetErrorCode() == EWOULDBLOCK);
+}
+
+}  // namespace
+
+const size_t FileTransfer::kDefaultChunkSize;
+
+FileTransfer::FileTransfer(descriptor_t file_fd, off_t offset, size_t size, socket_descr_t out_fd)
+    : file_fd_(file_fd),
+      offset_(offset),
+      left_(size),
+      sent_(0),
+      out_fd_(out_fd),
+      writer_(),
+      mode_(COPY),
+      seekable_(false),
+      pipe_{INVALID_DESCRIPTOR, INVALID_DESCRIPTOR},
+      in_pipe_(0),
+      buffer_(),
+      buffer_pos_(0) {
+  Init();
+}
+
+FileTransfer::FileTransfer(descriptor_t file_fd, off_t offset, size_t size, write_function_t writer)
+    : file_fd_(file_fd),
+      offset_(offset),
+      left_(size),
+      sent_(0),
+      out_fd_(INVALID_SOCKET_VALUE),
+      writer_(writer),
+      mode_(COPY),
+      seekable_(false),
+      pipe_{INVALID_DESCRIPTOR, INVALID_DESCRIPTOR},
+      in_pipe_(0),
+      buffer_(),
+      buffer_pos_(0) {
+  Init();
+}
+
+FileTransfer::~FileTransfer() {
+  for (descriptor_t fd : pipe_) {
+    if (fd != INVALID_DESCRIPTOR) {
+      ::close(fd);
+    }
+  }
+}
+
+void FileTransfer::Init() {
+  seekable_ = lseek(file_fd_, 0, SEEK_CUR) != ERROR_RESULT_VALUE;
+  if (out_fd_ == INVALID_SOCKET_VALUE) {
+    return;
+  }
+
+  writer_ = [this](const void* data, size_t size, size_t* nwrite_out) {
+    return write_to_tcp_socket(out_fd_, data, size, nwrite_out);
+  };
+
+#if defined(OS_LINUX)
+  struct stat st;
+  if (fstat(file_fd_, &st) == ERROR_RESULT_VALUE) {
+    return;
+  }
+
+  if (S_ISREG(st.st_mode)) {
+    mode_ = SENDFILE;
+    return;
+  }
+
+  if (pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) != ERROR_RESULT_VALUE) {
+    mode_ = SPLICE;
+  }
+#endif
+}
+
+FileTransfer::TransferMode FileTransfer::GetMode() const {
+  return mode_;
+}
+
+size_t FileTransfer::GetSent() const {
+  return sent_;
+}
+
+size_t FileTransfer::GetLeft() const {
+  return left_;
+}
+
+bool FileTransfer::IsDone() const {
+  return left_ == 0;
+}
+
+ErrnoError FileTransfer::Step(size_t max_chunk, size_t* nsent) {
+  if (!max_chunk || !nsent || file_fd_ == INVALID_DESCRIPTOR) {
+    return make_error_perror("FileTransfer::Step", EINVAL);
+  }
+
+  *nsent = 0;
+  if (IsDone()) {
+    return ErrnoError();
+  }
+
+  const size_t count = std::min(left_, max_chunk);
+  size_t lsent = 0;
+  ErrnoError err;
+  if (mode_ == SENDFILE) {
+    err = StepSendFile(count, &lsent);
+  } else if (mode_ == SPLICE) {
+    err = StepSplice(count, &lsent);
+  } else {
+    err = StepCopy(count, &lsent);
+  }
+
+  if (err) {
+    return err;
+  }
+
+  left_ -= lsent;
+  sent_ += lsent;
+  *nsent = lsent;
+  return ErrnoError();
+}
+
+ErrnoError FileTransfer::Run(size_t max_chunk) {
+  while (!IsDone()) {
+    size_t nsent = 0;
+    ErrnoError err = Step(max_chunk, &nsent);
+    if (!is_would_block(err)) {
+      if (err) {
+        return err;
+      }
+      continue;
+    }
+
+#if defined(OS_POSIX)
+    // blocking semantic on a non blocking socket
+    if (out_fd_ == INVALID_SOCKET_VALUE) {
+      return err;
+    }
+    struct pollfd fds[1];
+    fds[0].fd = out_fd_;
+    fds[0].events = POLLOUT;
+    fds[0].revents = 0;
+    if (HANDLE_EINTR(poll(fds, 1, -1)) == ERROR_RESULT_VALUE) {
+      return make_error_perror("poll", errno);
+    }
+#else
+    return err;
+#endif
+  }
+
+  return ErrnoError();
+}
+
+ErrnoError FileTransfer::StepSendFile(size_t count, size_t* nsent) {
+#if defined(OS_LINUX)
+  off_t off = offset_;
+  ssize_t res = HANDLE_EINTR(sendfile(out_fd_, file_fd_, &off, count));
+  if (res == ERROR_RESULT_VALUE) {
+    if ((errno == EINVAL || errno == ENOSYS) && sent_ == 0) {
+      // file system without sendfile support
+      mode_ = COPY;
+      return StepCopy(count, nsent);
+    }
+    return make_error_perror("sendfile", errno);
+  }
+
+  if (res == 0) {
+    return unexpected_eof_error();
+  }
+
+  offset_ = off;
+  *nsent = res;
+  return ErrnoError();
+#else
+  return StepCopy(count, nsent);
+#endif
+}
+
+ErrnoError FileTransfer::StepSplice(size_t count, size_t* nsent) {
+#if defined(OS_LINUX)
+  if (in_pipe_ == 0) {
+    loff_t off = offset_;
+    ssize_t res = HANDLE_EINTR(
+        splice(file_fd_, seekable_ ? &off : nullptr, pipe_[1], nullptr, count, SPLICE_F_MOVE | SPLICE_F_NONBLOCK));
+    if (res == ERROR_RESULT_VALUE) {
+      return make_error_perror("splice", errno);
+    }
+    if (res == 0) {
+      return unexpected_eof_error();
+    }
+
+    if (seekable_) {
+      offset_ = off;
+    }
+    in_pipe_ = res;
+  }
+
+  const unsigned int more = left_ > in_pipe_ ? SPLICE_F_MORE : 0;
+  ssize_t res =
+      HANDLE_EINTR(splice(pipe_[0], nullptr, out_fd_, nullptr, in_pipe_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK | more));
+  if (res == ERROR_RESULT_VALUE) {
+    return make_error_perror("splice", errno);
+  }
+
+  in_pipe_ -= res;
+  *nsent = res;
+  return ErrnoError();
+#else
+  return StepCopy(count, nsent);
+#endif
+}
+
+ErrnoError FileTransfer::StepCopy(size_t count, size_t* nsent) {
+  if (!writer_) {
+    return make_error_perror("FileTransfer::StepCopy", EINVAL);
+  }
+
+  if (buffer_pos_ == buffer_.size()) {
+    buffer_.resize(count);
+    ssize_t res;
+#if defined(OS_POSIX)
+    if (seekable_) {
+      res = HANDLE_EINTR(pread(file_fd_, buffer_.data(), count, offset_));
+    } else {
+      res = HANDLE_EINTR(read(file_fd_, buffer_.data(), count));
+    }
+#else
+    if (seekable_ && lseek(file_fd_, offset_, SEEK_SET) == ERROR_RESULT_VALUE) {
+      return make_error_perror("lseek", errno);
+    }
+    res = read(file_fd_, buffer_.data(), count);
+#endif
+    if (res == ERROR_RESULT_VALUE) {
+      buffer_.clear();
+      return make_error_perror("read", errno);
+    }
+    if (res == 0) {
+      buffer_.clear();
+      return unexpected_eof_error();
+    }
+
+    offset_ += res;
+    buffer_.resize(res);
+    buffer_pos_ = 0;
+  }
+
+  size_t nwrite = 0;
+  ErrnoError err = writer_(buffer_.data() + buffer_pos_, buffer_.size() - buffer_pos_, &nwrite);
+  if (err) {
+    return err;
+  }
+
+  buffer_pos_ += nwrite;
+  *nsent = nwrite;
+  return ErrnoError();
+}
+
+}  // namespace net
+}  // namespace common
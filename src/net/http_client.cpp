@@ -31,6 +31,12 @@
 #include <string.h>
 #include <unistd.h>
 
+#if defined(OS_POSIX)
+#include <poll.h>
+#else
+#include <winsock2.h>
+#endif
+
 #include <common/convert2string.h>
 #include <common/file_system/file.h>
 #include <common/file_system/file_system.h>
@@ -46,6 +52,52 @@
 namespace common {
 namespace net {
 
+namespace {
+
+// An idle keep-alive connection must stay silent, readable means the server
+// closed it (or sent garbage) and it can't carry the next request.
+bool IsIdleSocketReadable(socket_descr_t fd) {
+#if defined(OS_POSIX)
+  struct pollfd fds[1];
+  fds[0].fd = fd;
+  fds[0].events = POLLIN;
+  fds[0].revents = 0;
+  int res = poll(fds, 1, 0);
+#else
+  fd_set read_set;
+  FD_ZERO(&read_set);
+  FD_SET(fd, &read_set);
+  struct timeval tv = {0, 0};
+  int res = select(fd + 1, &read_set, nullptr, nullptr, &tv);
+#endif
+  return res != 0;
+}
+
+// Streams the body straight into |file_path|, the file is removed on failure.
+Error ReadResponseToFile(IHttpClient* cl, const file_system::ascii_file_string_path& file_path) {
+  ErrnoError errn = file_system::remove_file(file_path.GetPath());
+  if (errn) {
+    return make_error_from_errno(errn);
+  }
+
+  file_system::File file;
+  errn = file.Open(file_path, file_system::File::FLAG_CREATE | file_system::File::FLAG_WRITE);
+  if (errn) {
+    return make_error_from_errno(errn);
+  }
+
+  http::HttpResponse lresp;
+  Error err = cl->ReadResponseToDescriptor(&lresp, file.GetFd());
+  file.Close();
+  if (err) {
+    ignore_result(file_system::remove_file(file_path.GetPath()));
+    return err;
+  }
+  return Error();
+}
+
+}  // namespace
+
 Error IHttpClient::PostFile(const url_t& path,
                             const file_system::ascii_file_string_path& file_path,
                             const http::headers_t& extra_headers) {
@@ -135,116 +187,236 @@ Error IHttpClient::SendRequest(const http::HttpRequest& request_headers) {
 }
 
 Error IHttpClient::ReadResponse(http::HttpResponse* response) {
-  if (!response || !last_request_) {
+  if (!response) {
     return make_error_inval();
   }
 
-  static const size_t kHeaderBufInitialSize = 16 * 1024;  // 16K
-  char* data_head = new char[kHeaderBufInitialSize];
-  size_t nread_head = 0;
-  ErrnoError err = sock_->Read(data_head, kHeaderBufInitialSize, &nread_head);
-  if (err || nread_head == 0) {
-    delete[] data_head;
-    return make_error_from_errno(err);
+  http::HttpResponse::body_t body;
+  auto collect_cb = [&body](const char* data, size_t size) {
+    body.insert(body.end(), data, data + size);
+    return ErrnoError();
+  };
+  Error err = ReadResponse(response, collect_cb);
+  if (err) {
+    return err;
   }
 
-  size_t not_parsed;
-  Error parse_error = http::parse_http_response(std::string(data_head, nread_head), response, &not_parsed);
-  if (parse_error) {
-    delete[] data_head;
-    return parse_error;
+  if (!body.empty()) {
+    response->SetBody(body);
   }
+  return Error();
+}
 
-  if (last_request_->GetMethod() == http::HM_HEAD) {  // head without body
-    delete[] data_head;
-    return Error();
+Error IHttpClient::ReadResponse(http::HttpResponse* response, body_callback_t on_body) {
+  if (!response || !on_body || !last_request_) {
+    return make_error_inval();
+  }
+
+  keep_alive_ = false;
+  Error err = ReadResponseHeaders(response);
+  if (err) {
+    return err;
   }
 
-  if (!response->IsEmptyBody()) {
-    CHECK_EQ(not_parsed, 0);
-    delete[] data_head;
+  bool keep_alive = response->GetProtocol() == http::HP_1_1;
+  const http::header_t* connection = response->GetHeader(http::HT_CONNECTION);
+  if (connection) {
+    keep_alive = EqualsASCII(connection->value, "keep-alive", false);
+  }
+
+  const http::http_status status = response->GetStatus();
+  const bool without_body = last_request_->GetMethod() == http::HM_HEAD || status < http::HS_OK ||
+                            status == http::HS_NO_CONTENT || status == http::HS_NOT_MODIFIED;
+  if (without_body) {
+    keep_alive_ = keep_alive;
     return Error();
   }
 
-  bool chunked = false;
-  http::header_t encoding;
-  if (response->FindHeaderByKey("Transfer-Encoding", false, &encoding)) {
-    chunked = EqualsASCII(encoding.value, "chunked", false);
+  const http::header_t* encoding = response->GetHeader(http::HT_TRANSFER_ENCODING);
+  if (encoding && EqualsASCII(encoding->value, "chunked", false)) {
+    err = ReadBodyChunked(on_body);
+  } else {
+    const http::header_t* cont = response->GetHeader(http::HT_CONTENT_LENGTH);
+    size_t body_len = 0;
+    if (cont) {
+      if (!ConvertFromString(cont->value, &body_len)) {
+        return make_error("Invalid Content-Length");
+      }
+      err = ReadBodyByLength(body_len, on_body);
+    } else {
+      // body is delimited by closing the connection
+      keep_alive = false;
+      err = ReadBodyUntilClose(on_body);
+    }
   }
 
-  http::header_t cont;
-  if (chunked || !response->FindHeaderByKey("Content-Length", false, &cont)) {  // try to get body
-    http::HttpResponse::body_t body;
-    if (not_parsed) {
-      const char* body_str = data_head + nread_head - not_parsed;
-      body = MAKE_CHAR_BUFFER_SIZE(body_str, not_parsed);
+  if (err) {
+    return err;
+  }
+
+  keep_alive_ = keep_alive;
+  return Error();
+}
+
+Error IHttpClient::ReadResponseToDescriptor(http::HttpResponse* response, descriptor_t fd) {
+  if (fd == INVALID_DESCRIPTOR) {
+    return make_error_inval();
+  }
+
+  auto write_cb = [fd](const char* data, size_t size) {
+    while (size) {
+      size_t nwrite = 0;
+      ErrnoError errn = file_system::write_to_descriptor(fd, data, size, &nwrite);
+      if (errn) {
+        return errn;
+      }
+      data += nwrite;
+      size -= nwrite;
+    }
+    return ErrnoError();
+  };
+  return ReadResponse(response, write_cb);
+}
+
+bool IHttpClient::IsKeepAlive() const {
+  return keep_alive_;
+}
+
+Error IHttpClient::ReadResponseHeaders(http::HttpResponse* response) {
+  static const size_t kMaxHeadersSize = 64 * 1024;  // 64K
+  static const char kHeadersEnd[] = "\r\n\r\n";
+  static const size_t kHeadersEndSize = sizeof(kHeadersEnd) - 1;
+
+  size_t search_from = 0;
+  while (true) {
+    const StringPiece data(read_buffer_.data(), read_buffer_.size());
+    const size_t pos = data.find(StringPiece(kHeadersEnd, kHeadersEndSize), search_from);
+    if (pos != StringPiece::npos) {
+      const size_t headers_size = pos + kHeadersEndSize;
+      size_t not_parsed = 0;
+      Error err = http::parse_http_response(std::string(read_buffer_.data(), headers_size), response, &not_parsed);
+      if (err) {
+        return err;
+      }
+      read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + headers_size);
+      return Error();
+    }
+
+    if (read_buffer_.size() > kMaxHeadersSize) {
+      return make_error("Too large response headers");
+    }
+
+    // the delimiter can be split between two reads
+    search_from = read_buffer_.size() < kHeadersEndSize ? 0 : read_buffer_.size() - kHeadersEndSize + 1;
+    size_t nread = 0;
+    ErrnoError errn = FillReadBuffer(&nread);
+    if (errn) {
+      return make_error_from_errno(errn);
+    }
+    if (nread == 0) {
+      return make_error("Connection closed before response headers");
+    }
+  }
+}
+
+Error IHttpClient::ReadBodyByLength(size_t body_len, const body_callback_t& on_body) {
+  while (body_len) {
+    if (read_buffer_.empty()) {
+      size_t nread = 0;
+      ErrnoError errn = FillReadBuffer(&nread);
+      if (errn || nread == 0) {
+        return make_error("Invalid body read");
+      }
     }
 
-    size_t read_size = kHeaderBufInitialSize;
-    do {
+    const size_t portion = std::min(body_len, read_buffer_.size());
+    ErrnoError errn = on_body(read_buffer_.data(), portion);
+    if (errn) {
+      return make_error_from_errno(errn);
+    }
+    read_buffer_.erase(read_buffer_.begin(), read_buffer_.begin() + portion);
+    body_len -= portion;
+  }
+  return Error();
+}
+
+Error IHttpClient::ReadBodyChunked(const body_callback_t& on_body) {
+  http::HttpChunkedDecoder dec;
+  while (true) {
+    if (read_buffer_.empty()) {
       size_t nread = 0;
-      err = sock_->Read(data_head, read_size, &nread);
-      if (err || nread == 0) {
-        break;
+      ErrnoError errn = FillReadBuffer(&nread);
+      if (errn) {
+        return make_error_from_errno(errn);
       }
-      body += std::string(data_head, nread);
-    } while (!err);
-
-    if (chunked) {
-      http::HttpChunkedDecoder dec;
-      int res;
-      common::Error cerr = dec.FilterBuf(body.data(), body.size(), &res);
-      if (cerr) {
-        delete[] data_head;
-        return cerr;
+      if (nread == 0) {
+        return make_error("Connection closed inside chunked body");
       }
+    }
+
+    // decodes in place, data after the last chunk stays right behind the decoded part
+    int decoded = 0;
+    Error err = dec.FilterBuf(read_buffer_.data(), static_cast<int>(read_buffer_.size()), &decoded);
+    if (err) {
+      return err;
+    }
 
-      if (res == 0 && !dec.reached_eof()) {
-        return common::make_error_inval();
+    if (decoded) {
+      ErrnoError errn = on_body(read_buffer_.data(), decoded);
+      if (errn) {
+        return make_error_from_errno(errn);
       }
-      body.resize(res);
     }
 
-    response->SetBody(body);
-    delete[] data_head;
-    return Error();
+    if (dec.reached_eof()) {
+      const size_t after_eof = dec.bytes_after_eof();
+      read_buffer_.erase(read_buffer_.begin(), read_buffer_.end() - after_eof);
+      return Error();
+    }
+    read_buffer_.clear();
   }
+}
 
-  size_t body_len = 0;
-  if (!(ConvertFromString(cont.value, &body_len) && body_len)) {
-    delete[] data_head;
-    return Error();
-  }
+Error IHttpClient::ReadBodyUntilClose(const body_callback_t& on_body) {
+  while (true) {
+    if (!read_buffer_.empty()) {
+      ErrnoError errn = on_body(read_buffer_.data(), read_buffer_.size());
+      if (errn) {
+        return make_error_from_errno(errn);
+      }
+      read_buffer_.clear();
+    }
 
-  char* data = new char[body_len];
-  const size_t rest = body_len - not_parsed;
-  if (not_parsed) {
-    const char* body_str = data_head + nread_head - not_parsed;
-    memcpy(data, body_str, not_parsed);
+    size_t nread = 0;
+    ErrnoError errn = FillReadBuffer(&nread);
+    if (errn) {
+      return make_error_from_errno(errn);
+    }
+    if (nread == 0) {
+      return Error();
+    }
   }
+}
 
-  size_t total = 0;          // how many bytes we've readed
-  size_t bytes_left = rest;  // how many we have left to read
+ErrnoError IHttpClient::FillReadBuffer(size_t* nread) {
+  static const size_t kReadSize = 16 * 1024;  // 16K
 
-  while (total < rest) {
-    size_t n = 0;
-    size_t diff = not_parsed + total;
-    char* start = data + diff;
-    err = sock_->Read(start, bytes_left, &n);
-    if (err || n == 0) {
-      delete[] data_head;
-      delete[] data;
-      return make_error("Invalid body read");
+  const size_t offset = read_buffer_.size();
+  read_buffer_.resize(offset + kReadSize);
+  size_t lnread = 0;
+  ErrnoError errn = sock_->Read(read_buffer_.data() + offset, kReadSize, &lnread);
+  read_buffer_.resize(offset + lnread);
+  if (errn) {
+    // sockets report an orderly shutdown as a bare ECONNRESET, callers see it as a zero sized read
+    if (errn->Equals(*make_errno_error(ECONNRESET))) {
+      *nread = 0;
+      return ErrnoError();
     }
-    total += n;
-    bytes_left -= n;
+    return errn;
   }
 
-  http::HttpResponse::body_t body(MAKE_CHAR_BUFFER_SIZE(data, body_len));
-  response->SetBody(body);
-  delete[] data_head;
-  delete[] data;
-  return Error();
+  *nread = lnread;
+  return ErrnoError();
 }
 
 IHttpClient::~IHttpClient() {
@@ -252,7 +424,7 @@ IHttpClient::~IHttpClient() {
   sock_ = nullptr;
 }
 
-IHttpClient::IHttpClient(ISocket* sock) : sock_(sock) {
+IHttpClient::IHttpClient(ISocket* sock) : sock_(sock), last_request_(), read_buffer_(), keep_alive_(false) {
   CHECK(sock) << "Socket must be passed!";
 }
 
@@ -260,10 +432,16 @@ ISocket* IHttpClient::GetSocket() const {
   return sock_;
 }
 
+void IHttpClient::ResetReadState() {
+  read_buffer_.clear();
+  keep_alive_ = false;
+}
+
 HttpClient::HttpClient(const HostAndPort& host) : IHttpClient(new ClientSocketTcp(host)) {}
 
 ErrnoError HttpClient::Connect(struct timeval* tv) {
   ClientSocketTcp* sock = static_cast<ClientSocketTcp*>(GetSocket());
+  ResetReadState();
   return sock->Connect(tv);
 }
 
@@ -274,6 +452,7 @@ bool HttpClient::IsConnected() const {
 
 ErrnoError HttpClient::Disconnect() {
   ClientSocketTcp* sock = static_cast<ClientSocketTcp*>(GetSocket());
+  ResetReadState();
   return sock->Disconnect();
 }
 
@@ -287,6 +466,97 @@ HostAndPort HttpClient::GetHost() const {
   return sock->GetHost();
 }
 
+bool HttpClient::IsReusable() const {
+  if (!IsKeepAlive() || !IsConnected()) {
+    return false;
+  }
+
+  ClientSocketTcp* sock = static_cast<ClientSocketTcp*>(GetSocket());
+  return !IsIdleSocketReadable(sock->GetFd());
+}
+
+const size_t HttpClientPool::kDefaultMaxIdlePerHost;
+
+HttpClientPool::HttpClientPool(size_t max_idle_per_host) : max_idle_per_host_(max_idle_per_host), idle_mutex_(), idle_() {}
+
+HttpClientPool::~HttpClientPool() {
+  Clear();
+}
+
+ErrnoError HttpClientPool::Acquire(const HostAndPort& host, client_t* client, struct timeval* tv) {
+  if (!host.IsValid() || !client) {
+    return make_errno_error_inval();
+  }
+
+  const std::string key = ConvertToString(host);
+  {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    auto it = idle_.find(key);
+    if (it != idle_.end()) {
+      std::vector<client_t>& clients = it->second;
+      while (!clients.empty()) {
+        client_t cl = std::move(clients.back());
+        clients.pop_back();
+        if (cl->IsReusable()) {
+          *client = std::move(cl);
+          return ErrnoError();
+        }
+        ignore_result(cl->Disconnect());
+      }
+    }
+  }
+
+  client_t cl(new HttpClient(host));
+  ErrnoError errn = cl->Connect(tv);
+  if (errn) {
+    return errn;
+  }
+
+  *client = std::move(cl);
+  return ErrnoError();
+}
+
+void HttpClientPool::Release(client_t client) {
+  if (!client) {
+    return;
+  }
+
+  if (client->IsReusable()) {
+    const std::string key = ConvertToString(client->GetHost());
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    std::vector<client_t>& clients = idle_[key];
+    if (clients.size() < max_idle_per_host_) {
+      clients.push_back(std::move(client));
+      return;
+    }
+  }
+
+  ignore_result(client->Disconnect());
+}
+
+size_t HttpClientPool::GetIdleCount(const HostAndPort& host) const {
+  std::unique_lock<std::mutex> lock(idle_mutex_);
+  auto it = idle_.find(ConvertToString(host));
+  if (it == idle_.end()) {
+    return 0;
+  }
+  return it->second.size();
+}
+
+void HttpClientPool::Clear() {
+  std::map<std::string, std::vector<client_t>> idle;
+  {
+    std::unique_lock<std::mutex> lock(idle_mutex_);
+    idle.swap(idle_);
+  }
+
+  for (auto& host_clients : idle) {
+    for (auto& cl : host_clients.second) {
+      ignore_result(cl->Disconnect());
+    }
+  }
+}
+
 Error GetHttpFile(const uri::GURL& url,
                   const file_system::ascii_file_string_path& file_path,
                   const http::headers_t& extra_headers,
@@ -309,38 +579,8 @@ Error GetHttpFile(const uri::GURL& url,
     return err;
   }
 
-  http::HttpResponse lresp;
-  err = cl.ReadResponse(&lresp);
+  err = ReadResponseToFile(&cl, file_path);
   cl.Disconnect();
-  if (err) {
-    return err;
-  }
-
-  errn = file_system::remove_file(file_path.GetPath());
-  if (errn) {
-    return make_error_from_errno(errn);
-  }
-
-  file_system::File file;
-  errn = file.Open(file_path, file_system::File::FLAG_CREATE | file_system::File::FLAG_WRITE);
-  if (errn) {
-    return make_error_from_errno(errn);
-  }
-
-  size_t out;
-  auto body = lresp.GetBody();
-  errn = file.WriteBuffer(body, &out);
-  file.Close();
-
-  if (out != body.size()) {
-    ignore_result(file_system::remove_file(file_path.GetPath()));
-    return common::make_error("failed to save file");
-  }
-
-  if (errn) {
-    ignore_result(file_system::remove_file(file_path.GetPath()));
-    return make_error_from_errno(errn);
-  }
   return err;
 }
 
@@ -377,6 +617,7 @@ HttpsClient::HttpsClient(const common::net::HostAndPort& host) : base_class(new
 
 common::ErrnoError HttpsClient::Connect(struct timeval* tv) {
   ClientSocketTcpTls* sock = static_cast<ClientSocketTcpTls*>(GetSocket());
+  ResetReadState();
   return sock->Connect(tv);
 }
 
@@ -387,6 +628,7 @@ bool HttpsClient::IsConnected() const {
 
 common::ErrnoError HttpsClient::Disconnect() {
   ClientSocketTcpTls* sock = static_cast<ClientSocketTcpTls*>(GetSocket());
+  ResetReadState();
   return sock->Disconnect();
 }
 
@@ -422,38 +664,8 @@ Error GetHttpsFile(const uri::GURL& url,
     return err;
   }
 
-  http::HttpResponse lresp;
-  err = cl.ReadResponse(&lresp);
+  err = ReadResponseToFile(&cl, file_path);
   cl.Disconnect();
-  if (err) {
-    return err;
-  }
-
-  errn = file_system::remove_file(file_path.GetPath());
-  if (errn) {
-    return make_error_from_errno(errn);
-  }
-
-  file_system::File file;
-  errn = file.Open(file_path, file_system::File::FLAG_CREATE | file_system::File::FLAG_WRITE);
-  if (errn) {
-    return make_error_from_errno(errn);
-  }
-
-  size_t out;
-  auto body = lresp.GetBody();
-  errn = file.WriteBuffer(body, &out);
-  file.Close();
-
-  if (out != body.size()) {
-    ignore_result(file_system::remove_file(file_path.GetPath()));
-    return common::make_error("failed to save file");
-  }
-
-  if (errn) {
-    ignore_result(file_system::remove_file(file_path.GetPath()));
-    return make_error_from_errno(errn);
-  }
   return err;
 }
 
@@ -489,6 +701,7 @@ HttpsClient::HttpsClient(const common::net::HostAndPort& host) : base_class(new
 
 common::ErrnoError HttpsClient::Connect(struct timeval* tv) {
   ClientSocketTcp* sock = static_cast<ClientSocketTcp*>(GetSocket());
+  ResetReadState();
   return sock->Connect(tv);
 }
 
@@ -499,6 +712,7 @@ bool HttpsClient::IsConnected() const {
 
 common::ErrnoError HttpsClient::Disconnect() {
   ClientSocketTcp* sock = static_cast<ClientSocketTcp*>(GetSocket());
+  ResetReadState();
   return sock->Disconnect();
 }
 
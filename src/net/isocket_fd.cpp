@@ -81,6 +81,14 @@ ErrnoError ISocketFd::SendFileImpl(descriptor_t file_fd, off_t offset, size_t fi
 }
 #endif
 
+bool ISocketFd::IsZeroCopySendSupported() const {
+  return true;
+}
+
+bool ISocketFd::IsRawReadSupported() const {
+  return true;
+}
+
 ErrnoError ISocketFd::SendFile(descriptor_t file_fd, off_t offset, size_t file_size) {
   DCHECK(IsValid());
   const socket_descr_t fd = GetFd();
@@ -30,6 +30,7 @@
 #include <common/net/net.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <string.h>
 #include <sys/stat.h>
 
 #if defined(OS_POSIX)
@@ -37,6 +38,7 @@
 #include <netdb.h>
 #include <netinet/in.h>
 #include <poll.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #else
@@ -45,87 +47,15 @@
 #include <ws2tcpip.h>
 #endif
 
-#if defined(OS_MACOSX) || defined(OS_FREEBSD)
-#include <sys/types.h>
-#include <sys/uio.h>
-#elif defined(OS_LINUX)
-#include <sys/sendfile.h>
-#endif
-
 #if defined(COMPILER_MSVC)
 #include <io.h>
 #endif
 
 #include <common/eintr_wrapper.h>
+#include <common/net/file_transfer.h>
 #include <common/sprintf.h>
 #include <common/time.h>
 
-#if defined(OS_WIN) || defined(OS_ANDROID) || defined(OS_MACOSX) || defined(OS_FREEBSD) || defined(OS_IOS)
-
-#define BUF_SIZE 8192
-
-namespace {
-
-ssize_t sendfile(common::net::socket_descr_t out_fd, descriptor_t in_fd, off_t* offset, size_t count) {
-  off_t orig = 0;
-  char buf[BUF_SIZE] = {0};
-
-  if (offset) {
-    /* Save current file offset and set offset to value in '*offset' */
-
-    orig = lseek(in_fd, 0, SEEK_CUR);
-    if (orig == -1) {
-      return ERROR_RESULT_VALUE;
-    }
-    if (lseek(in_fd, *offset, SEEK_SET) == -1) {
-      return ERROR_RESULT_VALUE;
-    }
-  }
-
-  ssize_t totSent = 0;
-
-  while (count > 0) {
-    ssize_t num_read = read(in_fd, buf, BUF_SIZE);
-    if (num_read == ERROR_RESULT_VALUE) {
-      return ERROR_RESULT_VALUE;
-    }
-    if (num_read == 0) {
-      break; /* EOF */
-    }
-
-    size_t numSent = 0;
-    common::ErrnoError err = common::net::write_to_tcp_socket(out_fd, buf, static_cast<size_t>(num_read), &numSent);
-    if (err) {
-      return ERROR_RESULT_VALUE;
-    }
-
-    if (numSent == 0) {
-      return ERROR_RESULT_VALUE;
-    }
-
-    count -= numSent;
-    totSent += numSent;
-  }
-
-  if (offset) {
-    /* Return updated file offset in '*offset', and reset the file offset
-       to the value it had when we were called. */
-
-    *offset = lseek(in_fd, 0, SEEK_CUR);
-    if (*offset == -1) {
-      return ERROR_RESULT_VALUE;
-    }
-    if (lseek(in_fd, orig, SEEK_SET) == -1) {
-      return ERROR_RESULT_VALUE;
-    }
-  }
-
-  return totSent;
-}
-
-}  // namespace
-#endif
-
 namespace {
 bool compare_addr(const struct addrinfo* a, const struct addrinfo* b) {
   if (a->ai_family != b->ai_family) {
@@ -670,6 +600,28 @@ ErrnoError set_blocking_socket(socket_descr_t sock, bool blocking) {
 #endif
 }
 
+ErrnoError get_unread_bytes(socket_descr_t sock, size_t* nbytes_out) {
+  if (sock == INVALID_SOCKET_VALUE || !nbytes_out) {
+    return make_error_perror("get_unread_bytes", EINVAL);
+  }
+
+#if defined(OS_POSIX)
+  int avail = 0;
+  if (ioctl(sock, FIONREAD, &avail) < 0) {
+    return make_error_perror("ioctl(FIONREAD)", errno);
+  }
+#else
+  unsigned long avail = 0;
+  int res = ioctlsocket(sock, FIONREAD, &avail);
+  if (res == SOCKET_ERROR) {
+    return make_error_perror("ioctlsocket", errno);
+  }
+#endif
+
+  *nbytes_out = avail;
+  return ErrnoError();
+}
+
 #if defined(OS_POSIX)
 ErrnoError write_ev_to_socket(socket_descr_t fd, const struct iovec* iovec, int count, size_t* nwritten_out) {
   if (fd == INVALID_SOCKET_VALUE || !iovec || count <= 0 || !nwritten_out) {
@@ -736,6 +688,89 @@ ErrnoError read_from_socket(socket_descr_t fd, void* buf, size_t size, size_t* n
   *nread_out = lnread;
   return ErrnoError();
 }
+
+ErrnoError send_descriptor(socket_descr_t unix_sock, descriptor_t fd) {
+  if (unix_sock == INVALID_SOCKET_VALUE || fd == INVALID_DESCRIPTOR) {
+    return make_error_perror("send_descriptor", EINVAL);
+  }
+
+  char byte = 0;
+  struct iovec iov;
+  iov.iov_base = &byte;
+  iov.iov_len = sizeof(byte);
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(descriptor_t))];
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(descriptor_t));
+  memcpy(CMSG_DATA(cmsg), &fd, sizeof(descriptor_t));
+
+  ssize_t res = HANDLE_EINTR(::sendmsg(unix_sock, &msg, 0));
+  if (res == ERROR_RESULT_VALUE) {
+    return make_error_perror("sendmsg", errno);
+  }
+  return ErrnoError();
+}
+
+ErrnoError recv_descriptor(socket_descr_t unix_sock, descriptor_t* fd_out) {
+  if (unix_sock == INVALID_SOCKET_VALUE || !fd_out) {
+    return make_error_perror("recv_descriptor", EINVAL);
+  }
+
+  char byte = 0;
+  struct iovec iov;
+  iov.iov_base = &byte;
+  iov.iov_len = sizeof(byte);
+
+  union {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE(sizeof(descriptor_t))];
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+#if defined(OS_LINUX)
+  ssize_t res = HANDLE_EINTR(::recvmsg(unix_sock, &msg, MSG_CMSG_CLOEXEC));
+#else
+  ssize_t res = HANDLE_EINTR(::recvmsg(unix_sock, &msg, 0));
+#endif
+  if (res == ERROR_RESULT_VALUE) {
+    return make_error_perror("recvmsg", errno);
+  }
+
+  if (res == 0) {
+    return make_errno_error(ECONNRESET);
+  }
+
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN(sizeof(descriptor_t))) {
+      memcpy(fd_out, CMSG_DATA(cmsg), sizeof(descriptor_t));
+      return ErrnoError();
+    }
+  }
+
+  return make_error_perror("recv_descriptor", EBADMSG);
+}
 #endif
 
 ErrnoError write_to_tcp_socket(socket_descr_t fd, const void* data, size_t size, size_t* nwritten_out) {
@@ -821,33 +856,8 @@ ErrnoError send_file_to_fd(socket_descr_t sock, descriptor_t fd, off_t offset, s
     return make_error_perror("send_file_to_fd", EINVAL);
   }
 
-#if 0
-  for (size_t size_to_send = size; size_to_send > 0;) {
-    off_t off = offset;
-    ssize_t sent = sendfile(sock, fd, &off, size_to_send);
-    if (sent == ERROR_RESULT_VALUE) {
-      return make_error_perror("sendfile", errno);
-    } else if (sent == 0) {
-      return ErrnoError();
-    }
-
-    offset += sent;
-    size_to_send -= sent;
-  }
-#endif
-
-  off_t off = offset;
-  ssize_t res = 0;
-  ssize_t rtotal = 0;
-  while (off < size) {
-    if ((res = sendfile(sock, fd, &off, size)) == ERROR_RESULT_VALUE) {
-      return make_error_perror("sendfile", errno);
-    } else {
-      rtotal += res;
-    }
-  }
-
-  return ErrnoError();
+  FileTransfer transfer(fd, offset, size, sock);
+  return transfer.Run();
 }
 
 ErrnoError send_file(const std::string& path, const HostAndPort& to) {
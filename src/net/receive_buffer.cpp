@@ -0,0 +1,129 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/net/receive_buffer.h>
+
+#include <string.h>
+
+#include <utility>
+
+namespace common {
+namespace net {
+
+const size_t ReceiveBuffer::kBlockSize;
+const size_t ReceiveBuffer::kMaxIdleCapacity;
+
+ReceiveBuffer::ReceiveBuffer() : data_(), capacity_(0), head_(0), tail_(0) {}
+
+ReceiveBuffer::~ReceiveBuffer() {}
+
+const char* ReceiveBuffer::GetData() const {
+  return data_.get() + head_;
+}
+
+char* ReceiveBuffer::GetData() {
+  return data_.get() + head_;
+}
+
+size_t ReceiveBuffer::GetSize() const {
+  return tail_ - head_;
+}
+
+bool ReceiveBuffer::IsEmpty() const {
+  return head_ == tail_;
+}
+
+size_t ReceiveBuffer::GetCapacity() const {
+  return capacity_;
+}
+
+size_t ReceiveBuffer::GetFreeSpace() const {
+  return capacity_ - tail_;
+}
+
+char* ReceiveBuffer::PrepareWrite(size_t min_size, size_t* available_out) {
+  if (GetFreeSpace() < min_size) {
+    Reserve(min_size);
+  }
+
+  if (available_out) {
+    *available_out = GetFreeSpace();
+  }
+  return data_.get() + tail_;
+}
+
+void ReceiveBuffer::CommitWrite(size_t size) {
+  DCHECK_LE(size, GetFreeSpace());
+  tail_ += size;
+}
+
+void ReceiveBuffer::Consume(size_t size) {
+  DCHECK_LE(size, GetSize());
+  head_ += size;
+  if (head_ != tail_) {
+    return;
+  }
+
+  head_ = tail_ = 0;
+  if (capacity_ > kMaxIdleCapacity) {
+    data_.reset();
+    capacity_ = 0;
+  }
+}
+
+void ReceiveBuffer::Clear() {
+  Consume(GetSize());
+}
+
+void ReceiveBuffer::Reserve(size_t min_free) {
+  const size_t size = GetSize();
+  if (head_ && capacity_ - size >= min_free) {
+    memmove(data_.get(), data_.get() + head_, size);
+    head_ = 0;
+    tail_ = size;
+    return;
+  }
+
+  size_t capacity = capacity_ ? capacity_ : kBlockSize;
+  while (capacity - size < min_free) {
+    capacity *= 2;
+  }
+
+  std::unique_ptr<char[]> data(new char[capacity]);
+  if (size) {
+    memcpy(data.get(), data_.get() + head_, size);
+  }
+  data_ = std::move(data);
+  capacity_ = capacity;
+  head_ = 0;
+  tail_ = size;
+}
+
+}  // namespace net
+}  // namespace common
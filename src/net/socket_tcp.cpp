@@ -111,7 +111,11 @@ bool ClientSocketTcp::IsConnected() const {
   return IsValid();
 }
 
-ServerSocketTcp::ServerSocketTcp(const HostAndPort& host) : base_class(INVALID_SOCKET_VALUE), host_(host) {}
+ServerSocketTcp::ServerSocketTcp(const HostAndPort& host)
+    : base_class(INVALID_SOCKET_VALUE), host_(host), inherited_fd_(INVALID_SOCKET_VALUE) {}
+
+ServerSocketTcp::ServerSocketTcp(const HostAndPort& host, socket_descr_t listening_fd)
+    : base_class(INVALID_SOCKET_VALUE), host_(host), inherited_fd_(listening_fd) {}
 
 HostAndPort ServerSocketTcp::GetHost() const {
   return host_;
@@ -127,7 +131,15 @@ ErrnoError ServerSocketTcp::Bind(bool reuseaddr) {
   socket_descr_t fd = linfo.fd();
   addrinfo* ainf = linfo.addr_info();
   socket_info lbinfo;
-  err = bind(fd, ainf, reuseaddr, &lbinfo);  // init sockaddr
+  if (inherited_fd_ != INVALID_SOCKET_VALUE) {
+    // already bound and listening, only the address info is taken from the resolved host
+    ignore_result(close(fd));
+    fd = inherited_fd_;
+    inherited_fd_ = INVALID_SOCKET_VALUE;
+    err = getsockname(fd, ainf, &lbinfo);  // init sockaddr
+  } else {
+    err = bind(fd, ainf, reuseaddr, &lbinfo);  // init sockaddr
+  }
   if (err) {
     return err;
   }
@@ -169,6 +181,9 @@ IServerSocketEv::~IServerSocketEv() {}
 
 ServerSocketEvTcp::ServerSocketEvTcp(const HostAndPort& host) : sock_(host) {}
 
+ServerSocketEvTcp::ServerSocketEvTcp(const HostAndPort& host, socket_descr_t listening_fd)
+    : sock_(host, listening_fd) {}
+
 socket_descr_t ServerSocketEvTcp::GetFd() const {
   return sock_.GetFd();
 }
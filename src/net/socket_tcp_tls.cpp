@@ -30,18 +30,41 @@
 #include <common/net/socket_tcp_tls.h>
 
 #if defined(HAVE_OPENSSL)
+#include <errno.h>
 #include <openssl/err.h>
 #include <openssl/ssl.h>
 #endif
 
 #if defined(HAVE_OPENSSL)
+#include <common/net/file_transfer.h>
 #include <common/net/net.h>  // for bind, accept, close, etc
 #include <common/sprintf.h>
 
-#define BUF_SIZE 8192
+// kTLS is available since OpenSSL 3.0
+#if defined(SSL_OP_ENABLE_KTLS) && OPENSSL_VERSION_NUMBER >= 0x30000000L
+#define HAVE_KTLS 1
+#else
+#define HAVE_KTLS 0
+#endif
 
 namespace {
 
+const unsigned char kSessionIdContext[] = "common::net::ServerSocketTcpTls";
+
+// Queued writers retry a write which wanted more room from their own copy of the data, and take partial writes.
+const long kWriteModes = SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER | SSL_MODE_ENABLE_PARTIAL_WRITE;
+
+int NewClientSession(SSL* ssl, SSL_SESSION* session) {
+  const common::net::ClientSocketTcpTls* sock = static_cast<common::net::ClientSocketTcpTls*>(SSL_get_app_data(ssl));
+  if (!sock) {
+    return 0;
+  }
+
+  // with TLS 1.3 tickets arrive after the handshake, this is called from SSL_read then
+  common::net::TlsClientSessionCache::GetInstance().Put(sock->GetHost(), session);
+  return 1;
+}
+
 SSL_CTX* InitClientContext() {
   SSL_library_init();
   SSLeay_add_ssl_algorithms();
@@ -56,7 +79,22 @@ SSL_CTX* InitClientContext() {
     return nullptr;
   }
 
-  return SSL_CTX_new(method);
+  SSL_CTX* ctx = SSL_CTX_new(method);
+  if (!ctx) {
+    return nullptr;
+  }
+
+  SSL_CTX_set_mode(ctx, kWriteModes);
+  // sessions are kept per host in TlsClientSessionCache, not in the context
+  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(ctx, NewClientSession);
+  return ctx;
+}
+
+// shared by all client connections, resumed sessions must come from a compatible context
+SSL_CTX* GetClientContext() {
+  static SSL_CTX* ctx = InitClientContext();
+  return ctx;
 }
 
 SSL_CTX* InitServerContext() {
@@ -79,6 +117,7 @@ SSL_CTX* InitServerContext() {
   }
 
   SSL_CTX_set_cipher_list(ctx, "ALL:eNULL");
+  SSL_CTX_set_mode(ctx, kWriteModes);
   return ctx;
 }
 
@@ -127,82 +166,144 @@ common::ErrnoError LoadCertificatesContext(SSL_CTX* ctx, const std::string& cert
   return common::ErrnoError();
 }
 
+common::ErrnoError ApplyServerSettings(SSL_CTX* ctx, const common::net::TlsServerSettings& settings) {
+  if (settings.session_cache_size) {
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx, settings.session_cache_size);
+  } else {
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  }
+  SSL_CTX_set_timeout(ctx, settings.session_timeout_sec);
+  SSL_CTX_set_session_id_context(ctx, kSessionIdContext, sizeof(kSessionIdContext) - 1);
+
+  if (settings.session_tickets) {
+    SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+  } else {
+    SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+  }
+
+  if (!settings.ticket_keys.empty()) {
+    common::char_buffer_t keys = settings.ticket_keys;
+    if (SSL_CTX_set_tlsext_ticket_keys(ctx, keys.data(), keys.size()) != 1) {
+      return common::make_errno_error(
+          common::MemSPrintf("Invalid session ticket keys size: %lu", settings.ticket_keys.size()), EINVAL);
+    }
+  }
+
+#if HAVE_KTLS
+  if (settings.kernel_tls) {
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+  } else {
+    SSL_CTX_clear_options(ctx, SSL_OP_ENABLE_KTLS);
+  }
+#endif
+  return common::ErrnoError();
+}
+
+// WANT_READ/WANT_WRITE of non blocking sockets become EAGAIN so callers can wait for readiness.
+common::ErrnoError MakeSSLError(SSL* ssl, int ret, const char* function) {
+  const int saved_errno = errno;
+  const int ssl_err = SSL_get_error(ssl, ret);
+  switch (ssl_err) {
+    case SSL_ERROR_WANT_READ:
+    case SSL_ERROR_WANT_WRITE:
+      return common::make_error_perror(function, EAGAIN);
+    case SSL_ERROR_ZERO_RETURN:
+      return common::make_errno_error(ECONNRESET);
+    case SSL_ERROR_SYSCALL:
+      ERR_clear_error();
+      return common::make_error_perror(function, saved_errno ? saved_errno : ECONNRESET);
+    default: {
+      char str[256];
+      ERR_error_string_n(ERR_get_error(), str, sizeof(str));
+      ERR_clear_error();
+      return common::make_errno_error(common::MemSPrintf("%s failed, err: %s", function, str), EPROTO);
+    }
+  }
+}
+
 common::ErrnoError SSLWrite(SSL* ssl, const void* data, size_t size, size_t* nwrite_out) {
   int len = SSL_write(ssl, data, size);
-  if (len < 0) {
-    int err = SSL_get_error(ssl, len);
-    char* str = ERR_error_string(err, nullptr);
-    return common::make_errno_error(str, EINTR);
+  if (len <= 0) {
+    return MakeSSLError(ssl, len, "SSL_write");
   }
 
   *nwrite_out = len;
   return common::ErrnoError();
 }
 
-ssize_t sendfilessl(SSL* ssl, descriptor_t in_fd, off_t* offset, size_t count) {
-  off_t orig = 0;
-  char buf[BUF_SIZE] = {0};
-
-  if (offset) {
-    /* Save current file offset and set offset to value in '*offset' */
+}  // namespace
+#endif
 
-    orig = lseek(in_fd, 0, SEEK_CUR);
-    if (orig == -1) {
-      return ERROR_RESULT_VALUE;
-    }
-    if (lseek(in_fd, *offset, SEEK_SET) == -1) {
-      return ERROR_RESULT_VALUE;
-    }
-  }
+namespace common {
+namespace net {
 
-  ssize_t totSent = 0;
+#if defined(HAVE_OPENSSL)
+TlsClientSessionCache::TlsClientSessionCache() : mutex_(), sessions_() {}
 
-  while (count > 0) {
-    ssize_t num_read = read(in_fd, buf, BUF_SIZE);
-    if (num_read == ERROR_RESULT_VALUE) {
-      return ERROR_RESULT_VALUE;
-    }
-    if (num_read == 0) {
-      break; /* EOF */
-    }
+TlsClientSessionCache::~TlsClientSessionCache() {
+  Clear();
+}
 
-    size_t numSent = 0;
-    common::ErrnoError err = SSLWrite(ssl, buf, static_cast<size_t>(num_read), &numSent);
-    if (err) {
-      return ERROR_RESULT_VALUE;
-    }
+void TlsClientSessionCache::Put(const HostAndPort& host, SSL_SESSION* session) {
+  const std::string key = ConvertToString(host);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(key);
+  if (it != sessions_.end()) {
+    SSL_SESSION_free(it->second);
+    it->second = session;
+    return;
+  }
 
-    if (numSent == 0) {
-      return ERROR_RESULT_VALUE;
-    }
+  if (sessions_.size() >= kMaxSessions) {
+    SSL_SESSION_free(sessions_.begin()->second);
+    sessions_.erase(sessions_.begin());
+  }
+  sessions_[key] = session;
+}
 
-    count -= numSent;
-    totSent += numSent;
+SSL_SESSION* TlsClientSessionCache::Get(const HostAndPort& host) const {
+  const std::string key = ConvertToString(host);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(key);
+  if (it == sessions_.end()) {
+    return nullptr;
   }
 
-  if (offset) {
-    /* Return updated file offset in '*offset', and reset the file offset
-       to the value it had when we were called. */
+  SSL_SESSION_up_ref(it->second);
+  return it->second;
+}
 
-    *offset = lseek(in_fd, 0, SEEK_CUR);
-    if (*offset == -1) {
-      return ERROR_RESULT_VALUE;
-    }
-    if (lseek(in_fd, orig, SEEK_SET) == -1) {
-      return ERROR_RESULT_VALUE;
-    }
+void TlsClientSessionCache::Remove(const HostAndPort& host) {
+  const std::string key = ConvertToString(host);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(key);
+  if (it != sessions_.end()) {
+    SSL_SESSION_free(it->second);
+    sessions_.erase(it);
   }
+}
 
-  return totSent;
+void TlsClientSessionCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& session : sessions_) {
+    SSL_SESSION_free(session.second);
+  }
+  sessions_.clear();
 }
 
-}  // namespace
-#endif
+size_t TlsClientSessionCache::GetSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return sessions_.size();
+}
 
-namespace common {
-namespace net {
+TlsServerSettings::TlsServerSettings()
+    : session_cache_size(SSL_SESSION_CACHE_MAX_SIZE_DEFAULT),
+      session_timeout_sec(300),
+      session_tickets(true),
+      ticket_keys(),
+      kernel_tls(false) {}
 
-#if defined(HAVE_OPENSSL)
 TcpTlsSocketHolder::TcpTlsSocketHolder(const socket_info& info, SSL* ssl) : base_class(info), ssl_(ssl) {}
 
 TcpTlsSocketHolder::TcpTlsSocketHolder(socket_descr_t fd, SSL* ssl) : base_class(fd), ssl_(ssl) {}
@@ -211,6 +312,22 @@ bool TcpTlsSocketHolder::IsValid() const {
   return ssl_ != nullptr && base_class::IsValid();
 }
 
+bool TcpTlsSocketHolder::IsZeroCopySendSupported() const {
+#if HAVE_KTLS
+  return ssl_ && BIO_get_ktls_send(SSL_get_wbio(ssl_));
+#else
+  return false;
+#endif
+}
+
+bool TcpTlsSocketHolder::IsRawReadSupported() const {
+  return false;
+}
+
+bool TcpTlsSocketHolder::IsSessionReused() const {
+  return ssl_ && SSL_session_reused(ssl_);
+}
+
 common::net::socket_descr_t TcpTlsSocketHolder::GetFd() const {
   if (!ssl_) {
     return INVALID_SOCKET_VALUE;
@@ -232,14 +349,8 @@ common::ErrnoError TcpTlsSocketHolder::WriteImpl(const void* data, size_t size,
 
 common::ErrnoError TcpTlsSocketHolder::ReadImpl(void* out_data, size_t max_size, size_t* nread_out) {
   int len = SSL_read(ssl_, out_data, max_size);
-  if (len < 0) {
-    int err = SSL_get_error(ssl_, len);
-    char* str = ERR_error_string(err, nullptr);
-    return common::make_errno_error(str, EINTR);
-  }
-
-  if (len == 0) {
-    return make_errno_error(ECONNRESET);
+  if (len <= 0) {
+    return MakeSSLError(ssl_, len, "SSL_read");
   }
 
   *nread_out = len;
@@ -247,23 +358,23 @@ common::ErrnoError TcpTlsSocketHolder::ReadImpl(void* out_data, size_t max_size,
 }
 
 ErrnoError TcpTlsSocketHolder::SendFileImpl(descriptor_t file_fd, off_t offset, size_t file_size) {
-  for (size_t size_to_send = file_size; size_to_send > 0;) {
-    off_t off = offset;
-    ssize_t sent = sendfilessl(ssl_, file_fd, &off, size_to_send);
-    if (sent == ERROR_RESULT_VALUE) {
-      return make_error_perror("sendfile", errno);
-    } else if (sent == 0) {
-      return ErrnoError();
-    }
-
-    offset += sent;
-    size_to_send -= sent;
+  if (IsZeroCopySendSupported()) {
+    // the kernel encrypts, sendfile works as for plain sockets
+    return base_class::SendFileImpl(file_fd, offset, file_size);
   }
 
-  return ErrnoError();
+  // no zero copy through user space TLS, read by chunks and encrypt
+  FileTransfer transfer(file_fd, offset, file_size, [this](const void* data, size_t size, size_t* nwrite_out) {
+    return SSLWrite(ssl_, data, size, nwrite_out);
+  });
+  return transfer.Run();
 }
 
 common::ErrnoError TcpTlsSocketHolder::CloseImpl() {
+  if (ssl_ && SSL_is_init_finished(ssl_)) {
+    // close_notify, without it OpenSSL marks the session as not resumable
+    SSL_shutdown(ssl_);
+  }
   common::ErrnoError err = base_class::CloseImpl();
   if (ssl_) {
     SSL_free(ssl_);
@@ -285,7 +396,16 @@ void SocketTcpTls::SetHost(const HostAndPort& host) {
 
 SocketTcpTls::~SocketTcpTls() {}
 
-ClientSocketTcpTls::ClientSocketTcpTls(const HostAndPort& host) : base_class(host) {}
+ClientSocketTcpTls::ClientSocketTcpTls(const HostAndPort& host)
+    : base_class(host), session_resumption_(true), kernel_tls_(false) {}
+
+void ClientSocketTcpTls::SetSessionResumption(bool enabled) {
+  session_resumption_ = enabled;
+}
+
+void ClientSocketTcpTls::SetKernelTlsEnabled(bool enabled) {
+  kernel_tls_ = enabled;
+}
 
 common::ErrnoError ClientSocketTcpTls::Connect(struct timeval* tv) {
   common::net::ClientSocketTcp hs(GetHost());
@@ -294,36 +414,48 @@ common::ErrnoError ClientSocketTcpTls::Connect(struct timeval* tv) {
     return err;
   }
 
-  auto ctx = InitClientContext();
+  SSL_CTX* ctx = GetClientContext();
   if (!ctx) {
     ignore_result(hs.Disconnect());
     return common::make_errno_error_inval();
   }
 
   SSL* ssl = SSL_new(ctx);
-  SSL_CTX_free(ctx);
   if (!ssl) {
-    SSL_free(ssl);
     ignore_result(hs.Disconnect());
     return common::make_errno_error_inval();
   }
 
+  if (session_resumption_) {
+    SSL_set_app_data(ssl, this);  // for NewClientSession
+    SSL_SESSION* session = TlsClientSessionCache::GetInstance().Get(GetHost());
+    if (session) {
+      SSL_set_session(ssl, session);
+      SSL_SESSION_free(session);
+    }
+  }
+#if HAVE_KTLS
+  if (kernel_tls_) {
+    SSL_set_options(ssl, SSL_OP_ENABLE_KTLS);
+  }
+#endif
+
   SSL_set_fd(ssl, hs.GetFd());
   int e = SSL_connect(ssl);
-  if (e < 0) {
-    int err = SSL_get_error(ssl, e);
-    char* str = ERR_error_string(err, nullptr);
+  if (e <= 0) {
+    common::ErrnoError err = MakeSSLError(ssl, e, "SSL_connect");
     SSL_free(ssl);
     ignore_result(hs.Disconnect());
-    return common::make_errno_error(str, EINTR);
+    return err;
   }
 
   X509* cert = SSL_get_peer_certificate(ssl);
   if (cert == NULL) {
     SSL_free(ssl);
     ignore_result(hs.Disconnect());
-    return common::make_errno_error("Could not get a certificate", EINTR);
+    return common::make_errno_error("Could not get a certificate", EPROTO);
   }
+  X509_free(cert);
 
   SetInfo(hs.GetInfo());
   SetSSL(ssl);
@@ -338,7 +470,7 @@ bool ClientSocketTcpTls::IsConnected() const {
   return IsValid();
 }
 
-ServerSocketTcpTls::ServerSocketTcpTls(const HostAndPort& host) : base_class(host), ctx_(nullptr) {}
+ServerSocketTcpTls::ServerSocketTcpTls(const HostAndPort& host) : base_class(host), ctx_(nullptr), settings_() {}
 
 ErrnoError ServerSocketTcpTls::LoadCertificates(const std::string& cert, const std::string& key) {
   auto ctx = InitServerContext();
@@ -347,7 +479,11 @@ ErrnoError ServerSocketTcpTls::LoadCertificates(const std::string& cert, const s
   }
 
   auto err = LoadCertificatesContext(ctx, cert, key);
+  if (!err) {
+    err = ApplyServerSettings(ctx, settings_);
+  }
   if (err) {
+    SSL_CTX_free(ctx);
     return err;
   }
 
@@ -360,6 +496,18 @@ ErrnoError ServerSocketTcpTls::LoadCertificates(const std::string& cert, const s
   return ErrnoError();
 }
 
+ErrnoError ServerSocketTcpTls::SetSettings(const TlsServerSettings& settings) {
+  if (ctx_) {
+    ErrnoError err = ApplyServerSettings(ctx_, settings);
+    if (err) {
+      return err;
+    }
+  }
+
+  settings_ = settings;
+  return ErrnoError();
+}
+
 ErrnoError ServerSocketTcpTls::Accept(socket_info* info, SSL** out) {
   ErrnoError err = base_class::Accept(info);
   if (err) {
@@ -369,11 +517,11 @@ ErrnoError ServerSocketTcpTls::Accept(socket_info* info, SSL** out) {
   auto ssl = SSL_new(ctx_);
   SSL_set_fd(ssl, info->fd());
   int e = SSL_accept(ssl);
-  if (e < 0) {
-    int err = SSL_get_error(ssl, e);
-    char* str = ERR_error_string(err, nullptr);
+  if (e <= 0) {
+    ErrnoError ssl_err = MakeSSLError(ssl, e, "SSL_accept");
     SSL_free(ssl);
-    return common::make_errno_error(str, EINTR);
+    ignore_result(close(info->fd()));
+    return ssl_err;
   }
 
   *out = ssl;
@@ -423,6 +571,10 @@ ErrnoError ServerSocketEvTcpTls::LoadCertificates(const std::string& cert, const
   return sock_.LoadCertificates(cert, key);
 }
 
+ErrnoError ServerSocketEvTcpTls::SetSettings(const TlsServerSettings& settings) {
+  return sock_.SetSettings(settings);
+}
+
 #endif
 
 }  // namespace net
@@ -0,0 +1,253 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "proc_reader_linux.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <common/time.h>
+
+#include <algorithm>
+
+namespace common {
+namespace process {
+namespace internal {
+
+namespace {
+
+// getdents64 record, not exported by glibc headers.
+struct LinuxDirent64 {
+  uint64_t d_ino;
+  int64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+  char d_name[];
+};
+
+const char* SkipSpaces(const char* it, const char* end) {
+  while (it < end && (*it == ' ' || *it == '\t')) {
+    ++it;
+  }
+  return it;
+}
+
+const char* SkipField(const char* it, const char* end) {
+  while (it < end && *it != ' ' && *it != '\n') {
+    ++it;
+  }
+  return it;
+}
+
+}  // namespace
+
+ProcFile::ProcFile() : fd_(-1) {}
+
+ProcFile::~ProcFile() {
+  Close();
+}
+
+bool ProcFile::Open(const char* path) {
+  Close();
+  fd_ = open(path, O_RDONLY | O_CLOEXEC);
+  return fd_ != -1;
+}
+
+void ProcFile::Close() {
+  if (fd_ != -1) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+ssize_t ProcFile::Read(char* buffer, size_t size) const {
+  if (fd_ == -1 || size == 0) {
+    return -1;
+  }
+
+  ssize_t total = 0;
+  while (static_cast<size_t>(total) < size - 1) {
+    ssize_t res = pread(fd_, buffer + total, size - 1 - total, total);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    if (res == 0) {
+      break;
+    }
+    total += res;
+  }
+  buffer[total] = 0;
+  return total;
+}
+
+bool ProcFile::ReadDirectory(void (*cb)(const char* name, void* ctx), void* ctx) const {
+  if (fd_ == -1 || lseek(fd_, 0, SEEK_SET) != 0) {
+    return false;
+  }
+
+  alignas(LinuxDirent64) char buffer[4096];
+  while (true) {
+    long nread = syscall(SYS_getdents64, fd_, buffer, sizeof(buffer));
+    if (nread < 0) {
+      return false;
+    }
+    if (nread == 0) {
+      return true;
+    }
+
+    for (long pos = 0; pos < nread;) {
+      const LinuxDirent64* dent = reinterpret_cast<const LinuxDirent64*>(buffer + pos);
+      const char* name = dent->d_name;
+      if (!(name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0)))) {
+        cb(name, ctx);
+      }
+      pos += dent->d_reclen;
+    }
+  }
+}
+
+ssize_t ProcFile::CountDirectoryEntries() const {
+  ssize_t count = 0;
+  if (!ForEachDirectoryEntry([&count](const char*) { count++; })) {
+    return -1;
+  }
+  return count;
+}
+
+bool ParseProcUInt64(const char* data, size_t len, uint64_t* value) {
+  if (len == 0 || !value) {
+    return false;
+  }
+
+  uint64_t result = 0;
+  for (size_t i = 0; i < len; ++i) {
+    const char c = data[i];
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    result = result * 10 + (c - '0');
+  }
+  *value = result;
+  return true;
+}
+
+bool ParseProcStat(const char* data, size_t len, ProcStat* stat) {
+  if (!data || !stat) {
+    return false;
+  }
+
+  // The stat file is formatted as:
+  // pid (process name) data1 data2 .... dataN
+  // Look for the closing paren by scanning backwards, to avoid being fooled by
+  // processes with ')' in the name.
+  const char* end = data + len;
+  const char* open_paren = static_cast<const char*>(memchr(data, '(', len));
+  const char* close_paren = static_cast<const char*>(memrchr(data, ')', len));
+  if (!open_paren || !close_paren || open_paren > close_paren) {
+    return false;
+  }
+
+  const size_t comm_len = std::min<size_t>(close_paren - open_paren - 1, sizeof(stat->comm) - 1);
+  memcpy(stat->comm, open_paren + 1, comm_len);
+  stat->comm[comm_len] = 0;
+
+  // Fields after the name, numbered like in proc(5) minus 3: state is 0, utime 11, stime 12, num_threads 17,
+  // rss 21.
+  enum { kUtime = 11, kStime = 12, kNumThreads = 17, kRss = 21 };
+  uint64_t* const targets[] = {&stat->utime_ticks, &stat->stime_ticks, &stat->num_threads, &stat->rss_pages};
+  const int indexes[] = {kUtime, kStime, kNumThreads, kRss};
+
+  size_t found = 0;
+  const char* it = close_paren + 1;
+  for (int field = 0; it < end && found < arraysize(indexes); ++field) {
+    it = SkipSpaces(it, end);
+    const char* field_end = SkipField(it, end);
+    if (field == indexes[found]) {
+      if (!ParseProcUInt64(it, field_end - it, targets[found])) {
+        return false;
+      }
+      found++;
+    }
+    it = field_end;
+  }
+  return found == arraysize(indexes);
+}
+
+bool ReadProcStat(pid_t pid, ProcStat* stat) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid));
+
+  ProcFile file;
+  if (!file.Open(path)) {
+    return false;
+  }
+
+  char buffer[1024];
+  ssize_t len = file.Read(buffer, sizeof(buffer));
+  if (len <= 0) {
+    return false;
+  }
+  return ParseProcStat(buffer, len, stat);
+}
+
+bool FindProcValue(const char* data, size_t len, const char* key, uint64_t* value) {
+  const size_t key_len = strlen(key);
+  const char* end = data + len;
+  for (const char* line = data; line < end;) {
+    const char* line_end = static_cast<const char*>(memchr(line, '\n', end - line));
+    if (!line_end) {
+      line_end = end;
+    }
+
+    if (static_cast<size_t>(line_end - line) > key_len && memcmp(line, key, key_len) == 0 && line[key_len] == ':') {
+      const char* it = SkipSpaces(line + key_len + 1, line_end);
+      return ParseProcUInt64(it, SkipField(it, line_end) - it, value);
+    }
+    line = line_end + 1;
+  }
+  return false;
+}
+
+uint64_t ClockTicksToMilliseconds(uint64_t clock_ticks) {
+  // This queries the /proc-specific scaling factor which is
+  // conceptually the system hertz, it may be the case that this value is always 100.
+  static const uint64_t kHertz = sysconf(_SC_CLK_TCK);
+  return time::kMillisecondsPerSecond * clock_ticks / kHertz;
+}
+
+}  // namespace internal
+}  // namespace process
+}  // namespace common
@@ -0,0 +1,98 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <common/macros.h>
+
+// Allocation-free readers of /proc files, shared by ProcessMetrics and ProcessSampler.
+
+namespace common {
+namespace process {
+namespace internal {
+
+// Keeps a /proc file open, every Read() returns its current contents (procfs regenerates them on a read at offset 0).
+class ProcFile {
+ public:
+  ProcFile();
+  ~ProcFile();
+
+  bool Open(const char* path) WARN_UNUSED_RESULT;
+  void Close();
+  bool IsOpen() const { return fd_ != -1; }
+
+  // Reads at most |size| - 1 bytes and zero terminates them, returns the length or -1.
+  ssize_t Read(char* buffer, size_t size) const;
+
+  // For directories (opened with Open()), number of entries without "." and "..", -1 on error.
+  ssize_t CountDirectoryEntries() const;
+
+  // For directories, calls |cb(name)| for every entry except "." and "..".
+  template <typename Callback>
+  bool ForEachDirectoryEntry(Callback cb) const;
+
+ private:
+  bool ReadDirectory(void (*cb)(const char* name, void* ctx), void* ctx) const;
+
+  int fd_;
+  DISALLOW_COPY_AND_ASSIGN(ProcFile);
+};
+
+template <typename Callback>
+bool ProcFile::ForEachDirectoryEntry(Callback cb) const {
+  return ReadDirectory([](const char* name, void* ctx) { (*static_cast<Callback*>(ctx))(name); }, &cb);
+}
+
+struct ProcStat {
+  char comm[16];          // without parentheses, truncated like in the kernel
+  uint64_t utime_ticks;   // user mode time in clock ticks
+  uint64_t stime_ticks;   // kernel mode time in clock ticks
+  uint64_t num_threads;
+  uint64_t rss_pages;
+};
+
+// Parses the contents of /proc/<pid>/stat or /proc/<pid>/task/<tid>/stat.
+bool ParseProcStat(const char* data, size_t len, ProcStat* stat) WARN_UNUSED_RESULT;
+bool ReadProcStat(pid_t pid, ProcStat* stat) WARN_UNUSED_RESULT;
+
+// Finds "|key|:" at the start of a line (/proc/<pid>/status, io, smaps_rollup) and parses the number after it.
+bool FindProcValue(const char* data, size_t len, const char* key, uint64_t* value) WARN_UNUSED_RESULT;
+
+// Parses an unsigned decimal, the only number format used by the /proc files above.
+bool ParseProcUInt64(const char* data, size_t len, uint64_t* value) WARN_UNUSED_RESULT;
+
+uint64_t ClockTicksToMilliseconds(uint64_t clock_ticks);
+
+}  // namespace internal
+}  // namespace process
+}  // namespace common
@@ -0,0 +1,350 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/process/process_sampler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <common/metrics/metrics.h>
+
+#include "proc_reader_linux.h"
+
+namespace common {
+namespace process {
+
+namespace {
+
+// Large enough for status and smaps_rollup, stat and io are much shorter.
+const size_t kProcBufferSize = 4096;
+const uint64_t kNsPerMsec = 1000000;
+// Per thread stat files kept open between samples, the threads above it reopen their file on every sample.
+const size_t kMaxThreadFiles = 64;
+
+double CpuUsage(time64_t cpu_delta_msec, uint64_t elapsed_ns) {
+  if (elapsed_ns == 0 || cpu_delta_msec < 0) {
+    return 0;
+  }
+  return 100.0 * static_cast<double>(cpu_delta_msec * kNsPerMsec) / static_cast<double>(elapsed_ns);
+}
+
+}  // namespace
+
+class ProcessSampler::Files {
+ public:
+  internal::ProcFile stat;
+  internal::ProcFile status;
+  internal::ProcFile io;
+  internal::ProcFile smaps_rollup;
+  internal::ProcFile fd_dir;
+  internal::ProcFile task_dir;
+
+  size_t OpenCount() const {
+    return stat.IsOpen() + status.IsOpen() + io.IsOpen() + smaps_rollup.IsOpen() + fd_dir.IsOpen() + task_dir.IsOpen();
+  }
+};
+
+struct ProcessSampler::ThreadState {
+  internal::ProcFile stat;
+  time64_t last_cpu_msec = -1;
+  uint64_t generation = 0;
+  bool keep_open = false;  // counted in thread_files_
+};
+
+ProcessSampler::ProcessSampler(pid_t pid, size_t history_size)
+    : pid_(pid),
+      sample_threads_(true),
+      sample_pss_(false),
+      files_(),
+      thread_states_(),
+      thread_files_(0),
+      generation_(0),
+      last_sample_ns_(0),
+      last_cpu_msec_(0),
+      threads_scratch_(),
+      mutex_(),
+      history_(history_size ? history_size : 1),
+      history_head_(0),
+      history_count_(0),
+      threads_(),
+      stop_condition_(),
+      stop_(false),
+      thread_() {}
+
+ProcessSampler::~ProcessSampler() {
+  Stop();
+}
+
+void ProcessSampler::SetSampleThreads(bool enabled) {
+  sample_threads_ = enabled;
+}
+
+void ProcessSampler::SetSamplePss(bool enabled) {
+  sample_pss_ = enabled;
+}
+
+ErrnoError ProcessSampler::OpenFiles() {
+  std::unique_ptr<Files> files(new Files);
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/stat", static_cast<int>(pid_));
+  if (!files->stat.Open(path)) {
+    return make_errno_error(errno);
+  }
+
+  // The rest may be hidden by permissions or missing on old kernels (smaps_rollup appeared in 4.14).
+  snprintf(path, sizeof(path), "/proc/%d/status", static_cast<int>(pid_));
+  ignore_result(files->status.Open(path));
+  snprintf(path, sizeof(path), "/proc/%d/io", static_cast<int>(pid_));
+  ignore_result(files->io.Open(path));
+  if (sample_pss_) {
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", static_cast<int>(pid_));
+    ignore_result(files->smaps_rollup.Open(path));
+  }
+  snprintf(path, sizeof(path), "/proc/%d/fd", static_cast<int>(pid_));
+  ignore_result(files->fd_dir.Open(path));
+  if (sample_threads_) {
+    snprintf(path, sizeof(path), "/proc/%d/task", static_cast<int>(pid_));
+    ignore_result(files->task_dir.Open(path));
+  }
+
+  files_ = std::move(files);
+  return ErrnoError();
+}
+
+ErrnoError ProcessSampler::Start(time64_t interval_msec) {
+  if (thread_.joinable()) {
+    return make_errno_error(EALREADY);
+  }
+  if (interval_msec <= 0) {
+    return make_errno_error_inval();
+  }
+
+  if (!files_) {
+    ErrnoError err = OpenFiles();
+    if (err) {
+      return err;
+    }
+  }
+
+  if (!Sample()) {
+    return make_errno_error(ESRCH);
+  }
+
+  stop_ = false;
+  thread_ = std::thread(&ProcessSampler::Run, this, interval_msec);
+  return ErrnoError();
+}
+
+void ProcessSampler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  stop_condition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void ProcessSampler::Run(time64_t interval_msec) {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (stop_condition_.wait_for(lock, std::chrono::milliseconds(interval_msec), [this]() { return stop_; })) {
+        return;
+      }
+    }
+    ignore_result(Sample());
+  }
+}
+
+bool ProcessSampler::Sample() {
+  if (!files_ && OpenFiles()) {
+    return false;
+  }
+
+  char buffer[kProcBufferSize];
+  const uint64_t now_ns = metrics::MonotonicNowNs();
+  ProcessSample sample;
+  sample.timestamp_msec = time::current_utc_mstime();
+
+  internal::ProcStat stat;
+  ssize_t len = files_->stat.Read(buffer, sizeof(buffer));
+  if (len <= 0 || !internal::ParseProcStat(buffer, len, &stat)) {
+    return false;
+  }
+  sample.user_cpu_msec = internal::ClockTicksToMilliseconds(stat.utime_ticks);
+  sample.system_cpu_msec = internal::ClockTicksToMilliseconds(stat.stime_ticks);
+  sample.rss_bytes = stat.rss_pages * getpagesize();
+  sample.threads_count = stat.num_threads;
+
+  len = files_->status.Read(buffer, sizeof(buffer));
+  if (len > 0) {
+    ignore_result(internal::FindProcValue(buffer, len, "voluntary_ctxt_switches", &sample.voluntary_context_switches));
+    ignore_result(
+        internal::FindProcValue(buffer, len, "nonvoluntary_ctxt_switches", &sample.involuntary_context_switches));
+  }
+
+  len = files_->io.Read(buffer, sizeof(buffer));
+  if (len > 0) {
+    ignore_result(internal::FindProcValue(buffer, len, "read_bytes", &sample.read_bytes));
+    ignore_result(internal::FindProcValue(buffer, len, "write_bytes", &sample.write_bytes));
+  }
+
+  len = files_->smaps_rollup.Read(buffer, sizeof(buffer));
+  uint64_t pss_kb = 0;
+  if (len > 0 && internal::FindProcValue(buffer, len, "Pss", &pss_kb)) {
+    sample.pss_bytes = pss_kb * 1024;
+  }
+
+  ssize_t fds = files_->fd_dir.CountDirectoryEntries();
+  if (pid_ == getpid()) {
+    // Don't count the sampler's own /proc descriptors.
+    fds -= static_cast<ssize_t>(files_->OpenCount() + thread_files_);
+  }
+  sample.open_fds = fds > 0 ? fds : 0;
+
+  const time64_t cpu_msec = sample.user_cpu_msec + sample.system_cpu_msec;
+  const uint64_t elapsed_ns = last_sample_ns_ ? now_ns - last_sample_ns_ : 0;
+  sample.cpu_usage = CpuUsage(cpu_msec - last_cpu_msec_, elapsed_ns);
+  last_cpu_msec_ = cpu_msec;
+  last_sample_ns_ = now_ns;
+
+  const bool has_threads = SampleThreads(elapsed_ns);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  history_[history_head_] = sample;
+  history_head_ = (history_head_ + 1) % history_.size();
+  if (history_count_ < history_.size()) {
+    history_count_++;
+  }
+  if (has_threads) {
+    // Reuses the capacity of both vectors, no allocation once the thread count is stable.
+    threads_.assign(threads_scratch_.begin(), threads_scratch_.end());
+  }
+  return true;
+}
+
+bool ProcessSampler::SampleThreads(uint64_t elapsed_ns) {
+  if (!files_->task_dir.IsOpen()) {
+    return false;
+  }
+
+  threads_scratch_.clear();
+  const uint64_t generation = ++generation_;
+  bool ok = files_->task_dir.ForEachDirectoryEntry([this, generation, elapsed_ns](const char* name) {
+    const pid_t tid = static_cast<pid_t>(strtol(name, nullptr, 10));
+    if (tid <= 0) {
+      return;
+    }
+
+    std::unique_ptr<ThreadState>& state = thread_states_[tid];
+    if (!state) {
+      state.reset(new ThreadState);
+    }
+    if (!state->stat.IsOpen()) {
+      char path[64];
+      snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", static_cast<int>(pid_), static_cast<int>(tid));
+      if (!state->stat.Open(path)) {
+        return;  // exited meanwhile, dropped as stale below
+      }
+      state->keep_open = thread_files_ < kMaxThreadFiles;
+      if (state->keep_open) {
+        thread_files_++;
+      }
+    }
+    state->generation = generation;
+
+    char buffer[1024];
+    internal::ProcStat stat;
+    const ssize_t len = state->stat.Read(buffer, sizeof(buffer));
+    if (!state->keep_open) {
+      state->stat.Close();
+    }
+    if (len <= 0 || !internal::ParseProcStat(buffer, len, &stat)) {
+      return;
+    }
+
+    ThreadSample sample;
+    sample.tid = tid;
+    memcpy(sample.name, stat.comm, sizeof(sample.name));
+    sample.cpu_msec = internal::ClockTicksToMilliseconds(stat.utime_ticks + stat.stime_ticks);
+    if (state->last_cpu_msec >= 0) {
+      sample.cpu_usage = CpuUsage(sample.cpu_msec - state->last_cpu_msec, elapsed_ns);
+    }
+    state->last_cpu_msec = sample.cpu_msec;
+    threads_scratch_.push_back(sample);
+  });
+
+  for (auto it = thread_states_.begin(); it != thread_states_.end();) {
+    if (it->second->generation != generation) {
+      if (it->second->keep_open) {
+        thread_files_--;
+      }
+      it = thread_states_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  return ok;
+}
+
+bool ProcessSampler::GetLatest(ProcessSample* sample) const {
+  if (!sample) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (history_count_ == 0) {
+    return false;
+  }
+  *sample = history_[(history_head_ + history_.size() - 1) % history_.size()];
+  return true;
+}
+
+std::vector<ProcessSample> ProcessSampler::GetHistory() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<ProcessSample> result;
+  result.reserve(history_count_);
+  const size_t first = (history_head_ + history_.size() - history_count_) % history_.size();
+  for (size_t i = 0; i < history_count_; ++i) {
+    result.push_back(history_[(first + i) % history_.size()]);
+  }
+  return result;
+}
+
+std::vector<ThreadSample> ProcessSampler::GetThreads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return threads_;
+}
+
+}  // namespace process
+}  // namespace common
@@ -56,53 +56,30 @@ ErrnoError GenerateProtocoledMessage(const char_buffer_t& message, char** data,
 
 namespace detail {
 namespace {
-ErrnoError ReadDataSize(libev::IoClient* client, protocoled_size_t* sz) {
-  if (!client || !sz) {
-    return make_errno_error_inval();
-  }
-
-  protocoled_size_t lsz = 0;
-  size_t nread = 0;
-  ErrnoError err = client->Read(reinterpret_cast<char*>(&lsz), sizeof(protocoled_size_t), &nread);
-  if (err) {
-    return err;
+// Size of the first buffered message, 0 while its size prefix isn't complete.
+ErrnoError GetBufferedMessageSize(libev::IoClient* client, protocoled_size_t* sz) {
+  *sz = 0;
+  if (client->GetReadBufferSize() < sizeof(protocoled_size_t)) {
+    return ErrnoError();
   }
 
-  if (nread == 0) {
-    return make_errno_error("Connection closed", EAGAIN);
+  protocoled_size_t message_size = 0;
+  memcpy(&message_size, client->GetReadBuffer(), sizeof(protocoled_size_t));
+  message_size = NetToHost32(message_size);  // stable
+  if (message_size == 0) {
+    return make_errno_error(MemSPrintf("Invalid buffer size of command: %u", message_size), EAGAIN);
   }
 
-  if (nread != sizeof(protocoled_size_t)) {
-    return make_errno_error(
-        MemSPrintf("Error when reading needed to read: %lu bytes, but readed: %lu", sizeof(protocoled_size_t), nread),
-        EAGAIN);
+  if (message_size > MAX_COMMAND_LENGTH) {
+    return make_errno_error(MemSPrintf("Reached limit of command size: %u", message_size), EAGAIN);
   }
 
-  *sz = lsz;
+  *sz = message_size;
   return ErrnoError();
 }
 
-ErrnoError ReadMessage(libev::IoClient* client, char* out, protocoled_size_t size) {
-  if (!client || !out || size == 0) {
-    return make_errno_error_inval();
-  }
-
-  size_t nread;
-  ErrnoError err = client->Read(out, size, &nread);
-  if (err) {
-    return err;
-  }
-
-  if (nread == 0) {
-    return make_errno_error("Connection closed", EAGAIN);
-  }
-
-  if (nread != size) {
-    return make_errno_error(MemSPrintf("Error when reading needed to read: %lu bytes, but readed: %lu", size, nread),
-                            EAGAIN);
-  }
-
-  return ErrnoError();
+bool IsMessageBuffered(libev::IoClient* client, protocoled_size_t size) {
+  return size && client->GetReadBufferSize() >= sizeof(protocoled_size_t) + size;
 }
 }  // namespace
 
@@ -112,35 +89,42 @@ ErrnoError ReadCommand(libev::IoClient* client, IEDcoder* compressor, std::strin
   }
 
   protocoled_size_t message_size = 0;
-  ErrnoError err = ReadDataSize(client, &message_size);
-  if (err) {
-    return err;
-  }
+  while (true) {
+    ErrnoError err = GetBufferedMessageSize(client, &message_size);
+    if (err) {
+      return err;
+    }
 
-  message_size = NetToHost32(message_size);  // stable
-  if (message_size == 0) {
-    return make_errno_error(MemSPrintf("Invalid buffer size of command: %u", message_size), EAGAIN);
-  }
+    if (IsMessageBuffered(client, message_size)) {
+      break;
+    }
 
-  if (message_size > MAX_COMMAND_LENGTH) {
-    return make_errno_error(MemSPrintf("Reached limit of command size: %u", message_size), EAGAIN);
-  }
+    size_t nread = 0;
+    err = client->ReadToBuffer(&nread);
+    if (err) {
+      return err;
+    }
 
-  char* msg = static_cast<char*>(malloc(message_size));
-  err = ReadMessage(client, msg, message_size);
-  if (err) {
-    free(msg);
-    return err;
+    if (nread == 0) {
+      return make_errno_error("Connection closed", EAGAIN);
+    }
   }
 
+  const char* msg = client->GetReadBuffer() + sizeof(protocoled_size_t);
   const char_buffer_t compressed = MAKE_CHAR_BUFFER_SIZE(msg, message_size);
   char_buffer_t un_compressed;
   Error dec_err = compressor->Decode(compressed, &un_compressed);
-  free(msg);
+  client->ConsumeReadBuffer(sizeof(protocoled_size_t) + message_size);
   if (dec_err) {
     return make_errno_error(dec_err->GetDescription(), EINVAL);
   }
 
+  // the same read may have brought the next commands, their socket data is already consumed
+  protocoled_size_t next_size = 0;
+  if (!GetBufferedMessageSize(client, &next_size) && IsMessageBuffered(client, next_size)) {
+    client->ScheduleBufferedRead();
+  }
+
   *out = un_compressed.as_string();
   return ErrnoError();
 }
@@ -192,6 +176,18 @@ ErrnoError WriteResponse(libev::IoClient* client, IEDcoder* compressor, const Js
   return WriteMessage(client, compressor, resp);
 }
 
+metrics::Gauge* InFlightRequestsGauge() {
+  static metrics::Gauge* const in_flight =
+      METRICS()->GetGauge("common_json_rpc_in_flight_requests", "JSON-RPC requests waiting for a response");
+  return in_flight;
+}
+
+metrics::Histogram* RequestRoundTripHistogram() {
+  static metrics::Histogram* const round_trip = METRICS()->GetLatencyHistogram(
+      "common_json_rpc_round_trip_seconds", "Time between writing a JSON-RPC request and popping its response");
+  return round_trip;
+}
+
 }  // namespace detail
 
 }  // namespace json_rpc
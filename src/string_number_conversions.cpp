@@ -33,15 +33,55 @@
 #include <ctype.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <wctype.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cmath>
 #include <limits>
 #include <type_traits>
 
+// libstdc++ < 11 and older libc++ only ship the integral overloads.
+#if defined(__cpp_lib_to_chars)
+#define HAVE_FLOAT_CHARCONV 1
+#endif
+
 namespace common {
 
 namespace {
 
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes |value| right to left ending at |end|, two digits per division.
+template <typename CHAR, typename UINT>
+CHAR* FormatUnsigned(UINT value, CHAR* end) {
+  while (value >= 100) {
+    const size_t pos = static_cast<size_t>(value % 100) * 2;
+    value /= 100;
+    *--end = static_cast<CHAR>(kDigitPairs[pos + 1]);
+    *--end = static_cast<CHAR>(kDigitPairs[pos]);
+  }
+  if (value >= 10) {
+    const size_t pos = static_cast<size_t>(value) * 2;
+    *--end = static_cast<CHAR>(kDigitPairs[pos + 1]);
+    *--end = static_cast<CHAR>(kDigitPairs[pos]);
+  } else {
+    *--end = static_cast<CHAR>('0' + value);
+  }
+  return end;
+}
+
 template <typename STR, typename INT, typename UINT, bool NEG>
 struct IntToStringT {
   // This is to avoid a compiler warning about unary minus on unsigned type.
@@ -61,7 +101,10 @@ struct IntToStringT {
 
   template <typename INT2, typename UINT2>
   struct ToUnsignedT<INT2, UINT2, true> {
-    static UINT2 ToUnsigned(INT2 value) { return static_cast<UINT2>(value < 0 ? -value : value); }
+    static UINT2 ToUnsigned(INT2 value) {
+      // Negate in the unsigned domain, -INT_MIN overflows the signed one.
+      return value < 0 ? static_cast<UINT2>(0 - static_cast<UINT2>(value)) : static_cast<UINT2>(value);
+    }
   };
 
   // This set of templates is very similar to the above templates, but
@@ -82,33 +125,46 @@ struct IntToStringT {
     static bool TestNeg(INT2 value) { return value < 0; }
   };
 
-  static STR IntToString(INT value) {
-    // log10(2) ~= 0.3 bytes needed per bit or per byte log10(2**8) ~= 2.4.
-    // So round up to allocate 3 output characters per byte, plus 1 for '-'.
-    const int kOutputBufSize = 3 * sizeof(INT) + 1;
-
-    // Allocate the whole string right away, we will right back to front, and
-    // then return the substr of what we ended up using.
-    STR outbuf(kOutputBufSize, 0);
+  // log10(2) ~= 0.3 bytes needed per bit or per byte log10(2**8) ~= 2.4.
+  // So round up to allocate 3 output characters per byte, plus 1 for '-'.
+  static const size_t kOutputBufSize = 3 * sizeof(INT) + 1;
 
+  template <typename CHAR>
+  static CHAR* Format(INT value, CHAR* end) {
     bool is_neg = TestNegT<INT, NEG>::TestNeg(value);
     // Even though is_neg will never be true when INT is parameterized as
     // unsigned, even the presence of the unary operation causes a warning.
     UINT res = ToUnsignedT<INT, UINT, NEG>::ToUnsigned(value);
 
-    typename STR::iterator it(outbuf.end());
-    do {
-      --it;
-      DCHECK(it != outbuf.begin());
-      *it = static_cast<typename STR::value_type>((res % 10) + '0');
-      res /= 10;
-    } while (res != 0);
+    CHAR* it = FormatUnsigned(res, end);
     if (is_neg) {
-      --it;
-      DCHECK(it != outbuf.begin());
-      *it = static_cast<typename STR::value_type>('-');
+      *--it = static_cast<CHAR>('-');
+    }
+    return it;
+  }
+
+  static STR IntToString(INT value) {
+    typename STR::value_type outbuf[kOutputBufSize];
+    typename STR::value_type* end = outbuf + kOutputBufSize;
+    return STR(Format(value, end), end);
+  }
+
+  static size_t ToChars(span<char> out, INT value) {
+    char outbuf[kOutputBufSize];
+    char* end = outbuf + kOutputBufSize;
+    char* begin = Format(value, end);
+    const size_t len = end - begin;
+    if (len > out.size()) {
+      return 0;
     }
-    return STR(it, outbuf.end());
+    memcpy(out.data(), begin, len);
+    return len;
+  }
+
+  static void AppendToString(std::string* out, INT value) {
+    char outbuf[kOutputBufSize];
+    char* end = outbuf + kOutputBufSize;
+    out->append(Format(value, end), end);
   }
 };
 
@@ -335,6 +391,175 @@ bool String16ToIntImpl(StringPiece16 input, VALUE* output) {
   return IteratorRangeToNumber<StringPiece16ToNumberTraits<VALUE, 10>>::Invoke(input.begin(), input.end(), output);
 }
 
+// Infinities keep the explicit sign the rest of the library parses back.
+template <typename FLOAT>
+const char* InfinityText(FLOAT value) {
+  if (value == std::numeric_limits<FLOAT>::infinity()) {
+    return PPLUS_INF;
+  }
+  if (value == -std::numeric_limits<FLOAT>::infinity()) {
+    return MINUS_INF;
+  }
+  return nullptr;
+}
+
+size_t CopyText(span<char> out, const char* text) {
+  const size_t len = strlen(text);
+  if (len > out.size()) {
+    return 0;
+  }
+  memcpy(out.data(), text, len);
+  return len;
+}
+
+#if !defined(HAVE_FLOAT_CHARCONV)
+// printf() never reports a partial write as an error, treat truncation as one.
+size_t PrintfResult(int res, span<char> out) {
+  if (res < 0 || static_cast<size_t>(res) >= out.size()) {
+    return 0;
+  }
+  return res;
+}
+#endif
+
+template <typename FLOAT>
+size_t FloatToChars(span<char> out, FLOAT value) {
+  if (const char* inf = InfinityText(value)) {
+    return CopyText(out, inf);
+  }
+#if defined(HAVE_FLOAT_CHARCONV)
+  const auto res = std::to_chars(out.data(), out.data() + out.size(), value);
+  if (res.ec != std::errc()) {
+    return 0;
+  }
+  return res.ptr - out.data();
+#else
+  // Not the shortest form, but enough digits to round trip.
+  const int digits = std::numeric_limits<FLOAT>::max_digits10;
+  return PrintfResult(SNPrintf(out.data(), out.size(), "%.*g", digits, static_cast<double>(value)), out);
+#endif
+}
+
+template <typename FLOAT>
+size_t FloatToFixedChars(span<char> out, FLOAT value, int prec) {
+  if (prec < 0) {
+    prec = 6;  // same default as printf
+  }
+  if (const char* inf = InfinityText(value)) {
+    return CopyText(out, inf);
+  }
+#if defined(HAVE_FLOAT_CHARCONV)
+  const auto res = std::to_chars(out.data(), out.data() + out.size(), value, std::chars_format::fixed, prec);
+  if (res.ec != std::errc()) {
+    return 0;
+  }
+  return res.ptr - out.data();
+#else
+  return PrintfResult(SNPrintf(out.data(), out.size(), "%.*f", prec, static_cast<double>(value)), out);
+#endif
+}
+
+template <typename FLOAT>
+void AppendFloatToString(std::string* out, FLOAT value) {
+  char buffer[kMaxNumberChars];
+  const size_t len = FloatToChars(span<char>(buffer, sizeof(buffer)), value);
+  DCHECK(len);
+  out->append(buffer, len);
+}
+
+template <typename FLOAT>
+void AppendFixedFloatToString(std::string* out, FLOAT value, int prec) {
+  char buffer[64];
+  size_t len = FloatToFixedChars(span<char>(buffer, sizeof(buffer)), value, prec);
+  if (len) {
+    out->append(buffer, len);
+    return;
+  }
+
+  // Integral part of up to max_exponent10 + 1 digits, sign, point and |prec|.
+  const size_t offset = out->size();
+  out->resize(offset + std::numeric_limits<FLOAT>::max_exponent10 + 4 + std::max(prec, 6));
+  len = FloatToFixedChars(span<char>(&(*out)[offset], out->size() - offset), value, prec);
+  DCHECK(len);
+  out->resize(offset + len);
+}
+
+template <typename FLOAT>
+std::string FloatToString(FLOAT value) {
+  std::string result;
+  AppendFloatToString(&result, value);
+  return result;
+}
+
+template <typename FLOAT>
+std::string FixedFloatToString(FLOAT value, int prec) {
+  std::string result;
+  AppendFixedFloatToString(&result, value, prec);
+  return result;
+}
+
+inline float StrToFloat(const char* str, char** endptr, float*) {
+  return strtof(str, endptr);
+}
+
+inline double StrToFloat(const char* str, char** endptr, double*) {
+  return strtod(str, endptr);
+}
+
+template <typename FLOAT>
+bool StringToFloatImpl(StringPiece input, FLOAT* output) {
+  const char* first = input.data();
+  const char* last = first + input.size();
+  // Accept an explicit plus sign, but not a sign after it.
+  if (first != last && *first == '+' && (last - first == 1 || first[1] != '-')) {
+    ++first;
+  }
+  if (first == last) {
+    *output = 0;
+    return false;
+  }
+
+#if defined(HAVE_FLOAT_CHARCONV)
+  const auto res = std::from_chars(first, last, *output);
+  if (res.ec == std::errc::invalid_argument) {
+    *output = 0;
+    return false;
+  }
+  if (res.ec == std::errc::result_out_of_range) {
+    // |*output| is left untouched, let strtod() pick +/-HUGE_VAL or zero.
+    // Some runtimes also report denormals this way, those are still exact.
+    const std::string copy(first, last);
+    *output = StrToFloat(copy.c_str(), nullptr, output);
+    return res.ptr == last && *output != 0 && std::isfinite(*output);
+  }
+  return res.ptr == last;
+#else
+  if (isspace(static_cast<unsigned char>(*first))) {
+    *output = 0;
+    return false;
+  }
+  const std::string copy(first, last);
+  char* endptr = nullptr;
+  errno = 0;
+  *output = StrToFloat(copy.c_str(), &endptr, output);
+  return errno == 0 && endptr == copy.c_str() + copy.size();
+#endif
+}
+
+template <typename FLOAT>
+bool String16ToFloatImpl(StringPiece16 input, FLOAT* output) {
+  std::string ascii;
+  ascii.reserve(input.size());
+  for (auto c : input) {
+    if (c > 0x7F) {
+      *output = 0;
+      return false;
+    }
+    ascii.push_back(static_cast<char>(c));
+  }
+  return StringToFloatImpl(ascii, output);
+}
+
 }  // namespace
 
 std::string NumberToString(int value) {
@@ -386,55 +611,19 @@ string16 NumberToString16(unsigned long long value) {
 }
 
 std::string NumberToString(float value, int prec) {
-  if (value == std::numeric_limits<float>::infinity()) {
-    return PPLUS_INF;
-  }
-  if (value == std::numeric_limits<float>::infinity()) {
-    return MINUS_INF;
-  }
-
-  char buffer[16];
-  if (prec == 0) {
-    SNPrintf(buffer, sizeof(buffer), "%.0f", value);
-  } else if (prec == 1) {
-    SNPrintf(buffer, sizeof(buffer), "%.1f", value);
-  } else if (prec == 2) {
-    SNPrintf(buffer, sizeof(buffer), "%.2f", value);
-  } else if (prec == 3) {
-    SNPrintf(buffer, sizeof(buffer), "%.3f", value);
-  } else if (prec == 4) {
-    SNPrintf(buffer, sizeof(buffer), "%.4f", value);
-  } else {
-    SNPrintf(buffer, sizeof(buffer), "%f", value);
-  }
-
-  return buffer;
+  return FixedFloatToString(value, prec);
 }
 
 std::string NumberToString(double value, int prec) {
-  if (value == std::numeric_limits<double>::infinity()) {
-    return PPLUS_INF;
-  }
-  if (value == std::numeric_limits<double>::infinity()) {
-    return MINUS_INF;
-  }
+  return FixedFloatToString(value, prec);
+}
 
-  char buffer[32];
-  if (prec == 0) {
-    SNPrintf(buffer, sizeof(buffer), "%.0lf", value);
-  } else if (prec == 1) {
-    SNPrintf(buffer, sizeof(buffer), "%.1lf", value);
-  } else if (prec == 2) {
-    SNPrintf(buffer, sizeof(buffer), "%.2lf", value);
-  } else if (prec == 3) {
-    SNPrintf(buffer, sizeof(buffer), "%.3lf", value);
-  } else if (prec == 4) {
-    SNPrintf(buffer, sizeof(buffer), "%.4lf", value);
-  } else {
-    SNPrintf(buffer, sizeof(buffer), "%lf", value);
-  }
+std::string NumberToString(float value) {
+  return FloatToString(value);
+}
 
-  return buffer;
+std::string NumberToString(double value) {
+  return FloatToString(value);
 }
 
 string16 NumberToString16(float value, int prec) {
@@ -455,6 +644,86 @@ string16 NumberToString16(double value, int prec) {
 #endif
 }
 
+size_t ToChars(span<char> out, int value) {
+  return IntToStringT<std::string, int, unsigned int, true>::ToChars(out, value);
+}
+
+size_t ToChars(span<char> out, unsigned int value) {
+  return IntToStringT<std::string, int, unsigned int, false>::ToChars(out, value);
+}
+
+size_t ToChars(span<char> out, long value) {
+  return IntToStringT<std::string, long, unsigned long, true>::ToChars(out, value);
+}
+
+size_t ToChars(span<char> out, unsigned long value) {
+  return IntToStringT<std::string, long, unsigned long, false>::ToChars(out, value);
+}
+
+size_t ToChars(span<char> out, long long value) {
+  return IntToStringT<std::string, long long, unsigned long long, true>::ToChars(out, value);
+}
+
+size_t ToChars(span<char> out, unsigned long long value) {
+  return IntToStringT<std::string, long long, unsigned long long, false>::ToChars(out, value);
+}
+
+size_t ToChars(span<char> out, float value) {
+  return FloatToChars(out, value);
+}
+
+size_t ToChars(span<char> out, double value) {
+  return FloatToChars(out, value);
+}
+
+size_t ToChars(span<char> out, float value, int prec) {
+  return FloatToFixedChars(out, value, prec);
+}
+
+size_t ToChars(span<char> out, double value, int prec) {
+  return FloatToFixedChars(out, value, prec);
+}
+
+void AppendToString(std::string* out, int value) {
+  IntToStringT<std::string, int, unsigned int, true>::AppendToString(out, value);
+}
+
+void AppendToString(std::string* out, unsigned int value) {
+  IntToStringT<std::string, int, unsigned int, false>::AppendToString(out, value);
+}
+
+void AppendToString(std::string* out, long value) {
+  IntToStringT<std::string, long, unsigned long, true>::AppendToString(out, value);
+}
+
+void AppendToString(std::string* out, unsigned long value) {
+  IntToStringT<std::string, long, unsigned long, false>::AppendToString(out, value);
+}
+
+void AppendToString(std::string* out, long long value) {
+  IntToStringT<std::string, long long, unsigned long long, true>::AppendToString(out, value);
+}
+
+void AppendToString(std::string* out, unsigned long long value) {
+  IntToStringT<std::string, long long, unsigned long long, false>::AppendToString(out, value);
+}
+
+void AppendToString(std::string* out, float value) {
+  AppendFloatToString(out, value);
+}
+
+void AppendToString(std::string* out, double value) {
+  AppendFloatToString(out, value);
+}
+
+void AppendToString(std::string* out, float value, int prec) {
+  AppendFixedFloatToString(out, value, prec);
+}
+
+void AppendToString(std::string* out, double value, int prec) {
+  AppendFixedFloatToString(out, value, prec);
+}
+
 bool StringToInt(StringPiece input, int* output) {
   return StringToIntImpl(input, output);
 }
@@ -495,13 +764,21 @@ bool StringToSizeT(StringPiece16 input, size_t* output) {
   return String16ToIntImpl(input, output);
 }
 
-/*bool StringToDouble(StringPiece input, double* output) {
-  return StringToDoubleImpl(input, input.data(), output);
+bool StringToDouble(StringPiece input, double* output) {
+  return StringToFloatImpl(input, output);
 }
 
 bool StringToDouble(StringPiece16 input, double* output) {
-  return StringToDoubleImpl(input, reinterpret_cast<const uint16_t*>(input.data()), output);
-}*/
+  return String16ToFloatImpl(input, output);
+}
+
+bool StringToFloat(StringPiece input, float* output) {
+  return StringToFloatImpl(input, output);
+}
+
+bool StringToFloat(StringPiece16 input, float* output) {
+  return String16ToFloatImpl(input, output);
+}
 
 std::string HexEncode(const void* bytes, size_t size) {
   static const char kHexChars[] = "0123456789ABCDEF";
@@ -35,6 +35,8 @@
 
 #include <algorithm>
 
+#include "utf_simd.h"
+
 namespace common {
 
 namespace {
@@ -359,38 +361,16 @@ bool ContainsOnlyChars(const StringPiece16& input, const StringPiece16& characte
   return input.find_first_not_of(characters) == StringPiece16::npos;
 }
 
-template <class STR>
-static bool DoIsStringASCII(const STR& str) {
-  for (size_t i = 0; i < str.length(); i++) {
-    typename ToUnsigned<typename STR::value_type>::Unsigned c = str[i];
-    if (c > 0x7F) {
-      return false;
-    }
-  }
-  return true;
-}
-
 bool IsStringASCII(const StringPiece& str) {
-  return DoIsStringASCII(str);
+  return internal::IsASCII(str.data(), str.length());
 }
 
 bool IsStringASCII(const string16& str) {
-  return DoIsStringASCII(str);
+  return internal::IsASCII(str.data(), str.length());
 }
 
 bool IsStringUTF8(const std::string& str) {
-  const char* src = str.data();
-  int32_t src_len = static_cast<int32_t>(str.length());
-  int32_t char_index = 0;
-
-  while (char_index < src_len) {
-    int32_t code_point;
-    CBU8_NEXT(src, char_index, src_len, code_point);
-    if (!IsValidCharacter(code_point)) {
-      return false;
-    }
-  }
-  return true;
+  return internal::IsValidUTF8(str.data(), str.length(), true);
 }
 
 template <typename Str>
@@ -31,6 +31,8 @@
 #include <common/types.h>
 #include <string.h>
 
+#include <utility>
+
 #if defined(ARCH_CPU_ARM_FAMILY)
 #if defined(OS_ANDROID) || defined(OS_LINUX) || defined(OS_CHROMEOS)
 #include <asm/hwcap.h>
@@ -58,6 +60,11 @@ CPU::CPU() {
   Initialize();
 }
 
+const CPU& CPU::Current() {
+  static const CPU* cpu = new CPU;
+  return *cpu;
+}
+
 namespace {
 
 #if defined(ARCH_CPU_X86_FAMILY)
@@ -83,6 +90,21 @@ void __cpuid(int cpu_info[4], int info_type) {
 }
 
 #endif
+// _xgetbv returns the value of an Intel Extended Control Register (XCR).
+// Currently only XCR0 is defined by Intel so |xcr| should always be zero.
+uint64_t xgetbv(uint32_t xcr) {
+  uint32_t eax, edx;
+
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(xcr));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+
+#else
+
+uint64_t xgetbv(uint32_t xcr) {
+  return _xgetbv(xcr);
+}
+
 #endif  // !defined(COMPILER_MSVC)
 
 #endif  // ARCH_CPU_X86_FAMILY
@@ -181,6 +203,31 @@ void CPU::Initialize() {
     // announce themselves. Hypervisors trap CPUID and sometimes return
     // different results to underlying hardware.
     is_running_in_vm_ = (cpu_info[2] & 0x80000000) != 0;
+
+    has_mmx_ = (cpu_info[3] & 0x00800000) != 0;
+    has_sse_ = (cpu_info[3] & 0x02000000) != 0;
+    has_sse2_ = (cpu_info[3] & 0x04000000) != 0;
+    has_sse3_ = (cpu_info[2] & 0x00000001) != 0;
+    has_ssse3_ = (cpu_info[2] & 0x00000200) != 0;
+    has_sse41_ = (cpu_info[2] & 0x00080000) != 0;
+    has_sse42_ = (cpu_info[2] & 0x00100000) != 0;
+    has_popcnt_ = (cpu_info[2] & 0x00800000) != 0;
+    has_aesni_ = (cpu_info[2] & 0x02000000) != 0;
+
+    // AVX instructions will generate an illegal instruction exception unless
+    //   a) they are supported by the CPU,
+    //   b) XSAVE is supported by the CPU and
+    //   c) XSAVE is enabled by the kernel.
+    // See http://software.intel.com/en-us/blogs/2011/04/14/is-avx-enabled
+    const bool has_osxsave = (cpu_info[2] & 0x08000000) != 0;
+    const uint64_t xcr0 = has_osxsave ? xgetbv(0) : 0;
+    has_avx_ = (cpu_info[2] & 0x10000000) != 0 && (cpu_info[2] & 0x04000000) != 0 && has_osxsave &&
+               (xcr0 & 6) == 6;  // XMM and YMM state
+    has_fma3_ = has_avx_ && (cpu_info[2] & 0x00001000) != 0;
+    has_avx2_ = has_avx_ && (cpu_info7[1] & 0x00000020) != 0;
+    has_avx512f_ = has_avx2_ && (cpu_info7[1] & 0x00010000) != 0 && (xcr0 & 0xE6) == 0xE6;  // opmask and ZMM state
+    has_bmi2_ = (cpu_info7[1] & 0x00000100) != 0;
+    has_sha_ = (cpu_info7[1] & 0x20000000) != 0;
   }
 
   // Get the brand string of the cpu.
@@ -203,6 +250,12 @@ void CPU::Initialize() {
     cpu_brand_ = cpu_string;
   }
 #elif defined(ARCH_CPU_ARM_FAMILY)
+#if defined(ARCH_CPU_ARM64)
+  // Advanced SIMD is mandatory on ARMv8-A.
+  has_neon_ = true;
+#elif defined(OS_ANDROID) || defined(OS_LINUX) || defined(OS_CHROMEOS)
+  has_neon_ = (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#endif
 #if defined(OS_ANDROID) || defined(OS_LINUX) || defined(OS_CHROMEOS)
   cpu_brand_ = *CpuInfoBrand();
 #elif defined(OS_MACOSX)
@@ -215,5 +268,25 @@ void CPU::Initialize() {
 #endif
 }
 
+std::string CPU::GetFeatures() const {
+  const std::pair<bool, const char*> features[] = {
+      {has_mmx_, "mmx"},       {has_sse_, "sse"},       {has_sse2_, "sse2"},       {has_sse3_, "sse3"},
+      {has_ssse3_, "ssse3"},   {has_sse41_, "sse41"},   {has_sse42_, "sse42"},     {has_popcnt_, "popcnt"},
+      {has_avx_, "avx"},       {has_avx2_, "avx2"},     {has_avx512f_, "avx512f"}, {has_fma3_, "fma3"},
+      {has_aesni_, "aesni"},   {has_sha_, "sha"},       {has_bmi2_, "bmi2"},       {has_neon_, "neon"}};
+
+  std::string result;
+  for (const auto& feature : features) {
+    if (!feature.first) {
+      continue;
+    }
+    if (!result.empty()) {
+      result += ' ';
+    }
+    result += feature.second;
+  }
+  return result;
+}
+
 }  // namespace system_info
 }  // namespace common
@@ -0,0 +1,288 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/system_info/cpu_topology.h>
+
+#include <common/convert2string.h>
+#include <common/string_number_conversions.h>
+#include <common/string_split.h>
+#include <common/string_util.h>
+
+#if defined(OS_LINUX)
+#include <common/file_system/file_system.h>
+#include <dirent.h>
+#include <string.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <utility>
+
+namespace common {
+namespace system_info {
+
+namespace {
+
+#if defined(OS_LINUX)
+const char kSysfsCpuPath[] = "/sys/devices/system/cpu/";
+
+bool ReadSysfsString(const std::string& path, std::string* value) {
+  std::string contents;
+  if (!file_system::read_file_to_string(path, &contents)) {
+    return false;
+  }
+  TrimWhitespaceASCII(contents, TRIM_ALL, value);
+  return true;
+}
+
+size_t ReadSysfsSizeT(const std::string& path, size_t def) {
+  std::string value;
+  size_t result = 0;
+  if (!ReadSysfsString(path, &value) || !StringToSizeT(value, &result)) {
+    return def;
+  }
+  return result;
+}
+
+// Cache sizes look like "32K" or "8192K".
+size_t ParseCacheSize(const std::string& value) {
+  if (value.empty()) {
+    return 0;
+  }
+
+  size_t multiplier = 1;
+  std::string digits = value;
+  const char suffix = value.back();
+  if (suffix == 'K') {
+    multiplier = 1024;
+  } else if (suffix == 'M') {
+    multiplier = 1024 * 1024;
+  } else if (suffix == 'G') {
+    multiplier = 1024 * 1024 * 1024;
+  }
+  if (multiplier != 1) {
+    digits.pop_back();
+  }
+
+  size_t size = 0;
+  if (!StringToSizeT(digits, &size)) {
+    return 0;
+  }
+  return size * multiplier;
+}
+
+size_t ReadCpuNumaNode(const std::string& cpu_path) {
+  DIR* dirp = opendir(cpu_path.c_str());
+  if (!dirp) {
+    return 0;
+  }
+
+  size_t node = 0;
+  struct dirent* dent;
+  while ((dent = readdir(dirp)) != nullptr) {
+    if (strncmp(dent->d_name, "node", 4) == 0 && StringToSizeT(dent->d_name + 4, &node)) {
+      break;
+    }
+  }
+  closedir(dirp);
+  return node;
+}
+
+void ReadCpuCaches(lcpu_count_t cpu, const std::string& cpu_path, std::vector<CpuCache>* caches) {
+  for (size_t index = 0;; ++index) {
+    const std::string cache_path = cpu_path + "cache/index" + ConvertToString(index) + "/";
+    std::string type;
+    if (!ReadSysfsString(cache_path + "type", &type)) {
+      return;
+    }
+
+    CpuCache cache;
+    std::string shared;
+    if (!ReadSysfsString(cache_path + "shared_cpu_list", &shared) || !ParseCpuList(shared, &cache.shared_cpus)) {
+      cache.shared_cpus = {cpu};
+    }
+    // Every cache is listed by each CPU sharing it, keep it once.
+    if (cache.shared_cpus.empty() || cache.shared_cpus.front() != cpu) {
+      continue;
+    }
+
+    std::string size;
+    ignore_result(ReadSysfsString(cache_path + "size", &size));
+    cache.level = static_cast<int>(ReadSysfsSizeT(cache_path + "level", 0));
+    cache.type = type == "Data" ? CACHE_DATA : (type == "Instruction" ? CACHE_INSTRUCTION : CACHE_UNIFIED);
+    cache.size = ParseCacheSize(size);
+    cache.line_size = ReadSysfsSizeT(cache_path + "coherency_line_size", 0);
+    caches->push_back(cache);
+  }
+}
+
+bool DetectFromSysfs(std::vector<LogicalCpu>* cpus, std::vector<CpuCache>* caches) {
+  std::string online;
+  std::vector<lcpu_count_t> ids;
+  if (!ReadSysfsString(std::string(kSysfsCpuPath) + "online", &online) || !ParseCpuList(online, &ids) ||
+      ids.empty()) {
+    return false;
+  }
+
+  for (lcpu_count_t id : ids) {
+    const std::string cpu_path = std::string(kSysfsCpuPath) + "cpu" + ConvertToString(id) + "/";
+    LogicalCpu cpu;
+    cpu.id = id;
+    // physical_package_id is -1 on some platforms, which doesn't parse and falls back to 0.
+    cpu.core = ReadSysfsSizeT(cpu_path + "topology/core_id", id);
+    cpu.package = ReadSysfsSizeT(cpu_path + "topology/physical_package_id", 0);
+    cpu.numa_node = ReadCpuNumaNode(cpu_path);
+    cpu.smt_index = 0;
+    cpus->push_back(cpu);
+    ReadCpuCaches(id, cpu_path, caches);
+  }
+  return true;
+}
+#endif
+
+}  // namespace
+
+bool ParseCpuList(const std::string& list, std::vector<lcpu_count_t>* cpus) {
+  if (!cpus) {
+    return false;
+  }
+
+  std::vector<lcpu_count_t> result;
+  for (const std::string& range : SplitString(list, ",", TRIM_WHITESPACE, SPLIT_WANT_NONEMPTY)) {
+    const size_t dash = range.find('-');
+    size_t first = 0;
+    size_t last = 0;
+    if (dash == std::string::npos) {
+      if (!StringToSizeT(range, &first)) {
+        return false;
+      }
+      last = first;
+    } else if (!StringToSizeT(StringPiece(range).substr(0, dash), &first) ||
+               !StringToSizeT(StringPiece(range).substr(dash + 1), &last) || last < first) {
+      return false;
+    }
+
+    for (size_t cpu = first; cpu <= last; ++cpu) {
+      result.push_back(cpu);
+    }
+  }
+
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  *cpus = std::move(result);
+  return true;
+}
+
+CpuTopology::CpuTopology() : cpus_(), caches_(), cores_count_(0), packages_count_(0), numa_nodes_() {}
+
+CpuTopology::CpuTopology(const std::vector<LogicalCpu>& cpus, const std::vector<CpuCache>& caches)
+    : cpus_(cpus), caches_(caches), cores_count_(0), packages_count_(0), numa_nodes_() {
+  std::sort(cpus_.begin(), cpus_.end(), [](const LogicalCpu& lhs, const LogicalCpu& rhs) { return lhs.id < rhs.id; });
+
+  // sysfs core ids repeat in every package and can have holes, number (package, core) pairs from 0.
+  std::map<std::pair<size_t, size_t>, size_t> cores;
+  for (const LogicalCpu& cpu : cpus_) {
+    cores.insert(std::make_pair(std::make_pair(cpu.package, cpu.core), 0));
+  }
+  size_t core_index = 0;
+  for (auto& core : cores) {
+    core.second = core_index++;
+  }
+  cores_count_ = cores.size();
+
+  std::vector<size_t> siblings_seen(cores_count_, 0);
+  std::vector<size_t> packages;
+  for (LogicalCpu& cpu : cpus_) {
+    cpu.core = cores[std::make_pair(cpu.package, cpu.core)];
+    cpu.smt_index = siblings_seen[cpu.core]++;
+    packages.push_back(cpu.package);
+    numa_nodes_.push_back(cpu.numa_node);
+  }
+
+  std::sort(packages.begin(), packages.end());
+  packages_count_ = std::unique(packages.begin(), packages.end()) - packages.begin();
+  std::sort(numa_nodes_.begin(), numa_nodes_.end());
+  numa_nodes_.erase(std::unique(numa_nodes_.begin(), numa_nodes_.end()), numa_nodes_.end());
+}
+
+CpuTopology CpuTopology::Detect() {
+  std::vector<LogicalCpu> cpus;
+  std::vector<CpuCache> caches;
+#if defined(OS_LINUX)
+  if (DetectFromSysfs(&cpus, &caches)) {
+    return CpuTopology(cpus, caches);
+  }
+  cpus.clear();
+  caches.clear();
+#endif
+
+  const lcpu_count_t count = std::max(std::thread::hardware_concurrency(), 1u);
+  for (lcpu_count_t id = 0; id < count; ++id) {
+    cpus.push_back({id, id, 0, 0, 0});
+  }
+  return CpuTopology(cpus, caches);
+}
+
+const CpuTopology& CpuTopology::Current() {
+  static const CpuTopology topology = Detect();
+  return topology;
+}
+
+std::vector<lcpu_count_t> CpuTopology::GetCoreCpus(size_t core) const {
+  std::vector<lcpu_count_t> result;
+  for (const LogicalCpu& cpu : cpus_) {
+    if (cpu.core == core) {
+      result.push_back(cpu.id);
+    }
+  }
+  return result;
+}
+
+std::vector<lcpu_count_t> CpuTopology::GetNumaNodeCpus(size_t node) const {
+  std::vector<lcpu_count_t> result;
+  for (const LogicalCpu& cpu : cpus_) {
+    if (cpu.numa_node == node) {
+      result.push_back(cpu.id);
+    }
+  }
+  return result;
+}
+
+const LogicalCpu* CpuTopology::FindCpu(lcpu_count_t id) const {
+  auto it = std::lower_bound(cpus_.begin(), cpus_.end(), id,
+                             [](const LogicalCpu& cpu, lcpu_count_t value) { return cpu.id < value; });
+  if (it == cpus_.end() || it->id != id) {
+    return nullptr;
+  }
+  return &*it;
+}
+
+}  // namespace system_info
+}  // namespace common
@@ -17,6 +17,7 @@
 #include <iostream>
 
 #include <common/system_info/cpu_info.h>
+#include <common/system_info/cpu_topology.h>
 #include <common/system_info/system_info.h>
 #include <common/time.h>
 
@@ -72,6 +73,12 @@ int main(int argc, char** argv) {
   std::cout << "Vendor: " << cpu.vendor_name() << std::endl;
   std::cout << "Cpu brand: " << cpu.cpu_brand() << std::endl;
   std::cout << "VM: " << cpu.is_running_in_vm() << std::endl;
+  std::cout << "Cpu features: " << cpu.GetFeatures() << std::endl;
+  const auto& topology = common::system_info::CpuTopology::Current();
+  std::cout << "Logical cpus: " << topology.GetLogicalCpusCount() << std::endl;
+  std::cout << "Physical cores: " << topology.GetPhysicalCoresCount() << std::endl;
+  std::cout << "Packages: " << topology.GetPackagesCount() << std::endl;
+  std::cout << "NUMA nodes: " << topology.GetNumaNodesCount() << std::endl;
   std::cout << "VSystem: " << vsystem << std::endl;
   std::cout << "VRole: " << vrole << std::endl;
   std::cout << "RAM bytes total: " << ram_bytes_total << std::endl;
@@ -29,11 +29,28 @@
 
 #include <common/text_decoders/iedcoder.h>
 
+#include <common/static_string_map.h>
+
 namespace common {
 
-const std::array<const char*, ENCODER_DECODER_NUM_TYPES> edecoder_types = {
+constexpr std::array<const char*, ENCODER_DECODER_NUM_TYPES> edecoder_types = {
     {"NoComression", "Base64", "Zlib", "BZip2", "LZ4", "Snappy", "Hex", "XHex", "Unicode", "UUnicode", "HtmlEscape"}};
 
+namespace {
+
+constexpr StaticStringMap<EDType, ENCODER_DECODER_NUM_TYPES> MakeEDTypesMap() {
+  StaticStringMapEntry<EDType> entries[ENCODER_DECODER_NUM_TYPES] = {};
+  for (size_t i = 0; i < edecoder_types.size(); ++i) {
+    entries[i] = {edecoder_types[i], static_cast<EDType>(i)};
+  }
+  return StaticStringMap<EDType, ENCODER_DECODER_NUM_TYPES>(entries);
+}
+
+constexpr auto kEDTypesMap = MakeEDTypesMap();
+static_assert(kEDTypesMap.IsPerfect(), "encoder types table has no perfect hash");
+
+}  // namespace
+
 std::string ConvertToString(EDType type) {
   if (type >= 0 && type < edecoder_types.size()) {
     return edecoder_types[type];
@@ -48,14 +65,13 @@ bool ConvertFromString(const std::string& from, EDType* out) {
     return false;
   }
 
-  for (size_t i = 0; i < edecoder_types.size(); ++i) {
-    if (from == edecoder_types[i]) {
-      *out = static_cast<EDType>(i);
-      return true;
-    }
+  const EDType* type = kEDTypesMap.FindCaseSensitive(from);
+  if (!type) {
+    return false;
   }
 
-  return false;
+  *out = *type;
+  return true;
 }
 
 IEDcoder::~IEDcoder() {}
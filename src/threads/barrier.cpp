@@ -12,24 +12,40 @@
     along with Rixjob.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #include <common/threads/barrier.h>
 
+#include "futex.h"
+
 namespace common {
 namespace threads {
 
-barrier::barrier(size_t count) : threshold_(count), count_(count), generation_(0) {}
+barrier::barrier(size_t count)
+    : threshold_(static_cast<uint32_t>(count)), count_(threshold_), generation_(0), sleepers_(0) {}
 
 void barrier::Wait() {
-  std::unique_lock<std::mutex> lock(mutex_);
-  size_t gen = generation_;
-
-  if (--count_ == 0) {
-    generation_++;
-    count_ = threshold_;
-    cond_.notify_all();
-  } else {
-    cond_.wait(lock, [this, gen] { return gen != generation_; });
+  const uint32_t gen = generation_.load(std::memory_order_acquire);
+
+  if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // Nobody can arrive for the next round before the generation changes.
+    count_.store(threshold_, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_seq_cst) != 0) {
+      internal::FutexWakeAll(&generation_);
+    }
+    return;
+  }
+
+  auto released = [this, gen]() { return generation_.load(std::memory_order_acquire) != gen; };
+  if (internal::SpinUntil(released)) {
+    return;
+  }
+
+  sleepers_.fetch_add(1, std::memory_order_seq_cst);
+  while (!released()) {
+    internal::FutexWait(&generation_, gen, INFINITE_TIMEOUT_MSEC);
   }
+  sleepers_.fetch_sub(1, std::memory_order_relaxed);
 }
 
 }  // namespace threads
@@ -0,0 +1,170 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "futex.h"
+
+#include <time.h>
+
+#include <thread>
+
+#if defined(OS_LINUX)
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace common {
+namespace threads {
+namespace internal {
+
+#if defined(OS_LINUX)
+namespace {
+
+int Futex(const std::atomic<uint32_t>* word, int op, uint32_t value, const struct timespec* timeout) {
+  // std::atomic<uint32_t> is layout compatible with the 32 bit futex word.
+  return syscall(SYS_futex, reinterpret_cast<const uint32_t*>(word), op | FUTEX_PRIVATE_FLAG, value, timeout, nullptr,
+                 0);
+}
+
+}  // namespace
+
+bool FutexWait(const std::atomic<uint32_t>* word, uint32_t expected, time64_t milliseconds) {
+  struct timespec timeout;
+  struct timespec* ptimeout = nullptr;
+  if (milliseconds != INFINITE_TIMEOUT_MSEC) {
+    timeout.tv_sec = milliseconds / 1000;
+    timeout.tv_nsec = (milliseconds % 1000) * 1000000;
+    ptimeout = &timeout;
+  }
+
+  if (Futex(word, FUTEX_WAIT, expected, ptimeout) == -1 && errno == ETIMEDOUT) {
+    return false;
+  }
+  // woken up, value already changed (EAGAIN) or interrupted (EINTR)
+  return true;
+}
+
+void FutexWakeOne(const std::atomic<uint32_t>* word) {
+  Futex(word, FUTEX_WAKE, 1, nullptr);
+}
+
+void FutexWakeAll(const std::atomic<uint32_t>* word) {
+  Futex(word, FUTEX_WAKE, INT_MAX, nullptr);
+}
+#else
+namespace {
+
+struct WaitBucket {
+  std::mutex mutex;
+  std::condition_variable cond;
+};
+
+WaitBucket* GetWaitBucket(const std::atomic<uint32_t>* word) {
+  static constexpr size_t kBucketsCount = 64;
+  static WaitBucket buckets[kBucketsCount];
+  return &buckets[(reinterpret_cast<uintptr_t>(word) >> 4) % kBucketsCount];
+}
+
+void WakeBucket(const std::atomic<uint32_t>* word) {
+  WaitBucket* bucket = GetWaitBucket(word);
+  // Taking the lock orders the wakeup after a waiter which has checked the value but not blocked yet.
+  std::lock_guard<std::mutex> lock(bucket->mutex);
+  bucket->cond.notify_all();
+}
+
+}  // namespace
+
+bool FutexWait(const std::atomic<uint32_t>* word, uint32_t expected, time64_t milliseconds) {
+  WaitBucket* bucket = GetWaitBucket(word);
+  std::unique_lock<std::mutex> lock(bucket->mutex);
+  if (word->load() != expected) {
+    return true;
+  }
+  if (milliseconds == INFINITE_TIMEOUT_MSEC) {
+    bucket->cond.wait(lock);
+    return true;
+  }
+  return bucket->cond.wait_for(lock, std::chrono::milliseconds(milliseconds)) == std::cv_status::no_timeout;
+}
+
+void FutexWakeOne(const std::atomic<uint32_t>* word) {
+  // buckets are shared between addresses, waking a single waiter could pick the wrong one
+  WakeBucket(word);
+}
+
+void FutexWakeAll(const std::atomic<uint32_t>* word) {
+  WakeBucket(word);
+}
+#endif
+
+bool ShouldSpin() {
+  static const bool smp = std::thread::hardware_concurrency() > 1;
+  return smp;
+}
+
+void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+time64_t FutexDeadline(time64_t milliseconds) {
+  if (milliseconds == INFINITE_TIMEOUT_MSEC) {
+    return INFINITE_TIMEOUT_MSEC;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<time64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000 + milliseconds;
+}
+
+time64_t FutexRemaining(time64_t deadline) {
+  if (deadline == INFINITE_TIMEOUT_MSEC) {
+    return INFINITE_TIMEOUT_MSEC;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  const time64_t left = deadline - (static_cast<time64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000);
+  return left > 0 ? left : 0;
+}
+
+}  // namespace internal
+}  // namespace threads
+}  // namespace common
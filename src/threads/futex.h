@@ -0,0 +1,79 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include <common/threads/event.h>  // for INFINITE_TIMEOUT_MSEC
+
+// Wait-on-address primitive shared by Event, Latch, barrier and Parker. On Linux this is futex(2) on the private
+// futex hash, elsewhere it is emulated with a small table of mutex/condition variable buckets keyed by address.
+
+namespace common {
+namespace threads {
+namespace internal {
+
+// Blocks while |*word| == |expected| for at most |milliseconds| (INFINITE_TIMEOUT_MSEC waits forever). Returns false
+// if the timeout expired. Spurious wakeups are possible, callers always re-check their condition.
+bool FutexWait(const std::atomic<uint32_t>* word, uint32_t expected, time64_t milliseconds);
+
+// Wakes one (or all) threads blocked in FutexWait() on |word|. |word| must be modified before the call.
+void FutexWakeOne(const std::atomic<uint32_t>* word);
+void FutexWakeAll(const std::atomic<uint32_t>* word);
+
+// Busy waits a bounded number of iterations until |pred| holds, so that short handoffs do not pay for a syscall.
+// Does nothing on a single CPU where the other side cannot make progress while we spin.
+bool ShouldSpin();
+void CpuRelax();
+
+template <typename Pred>
+bool SpinUntil(Pred pred) {
+  static constexpr int kSpinIterations = 128;
+  if (!ShouldSpin()) {
+    return false;
+  }
+  for (int i = 0; i < kSpinIterations; ++i) {
+    if (pred()) {
+      return true;
+    }
+    CpuRelax();
+  }
+  return false;
+}
+
+// Monotonic deadline helpers for waits which may be woken several times before the condition holds.
+time64_t FutexDeadline(time64_t milliseconds);
+time64_t FutexRemaining(time64_t deadline);
+
+}  // namespace internal
+}  // namespace threads
+}  // namespace common
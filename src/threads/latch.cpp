@@ -0,0 +1,93 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/threads/latch.h>
+
+#include <common/logger.h>
+
+#include "futex.h"
+
+namespace common {
+namespace threads {
+
+Latch::Latch(uint32_t count) : count_(count), waiters_(0) {}
+
+void Latch::CountDown(uint32_t n) {
+  const uint32_t prev = count_.fetch_sub(n, std::memory_order_seq_cst);
+  DCHECK_GE(prev, n) << "latch counted down below zero";
+  if (prev == n && waiters_.load(std::memory_order_seq_cst) != 0) {
+    internal::FutexWakeAll(&count_);
+  }
+}
+
+void Latch::ArriveAndWait(uint32_t n) {
+  CountDown(n);
+  Wait();
+}
+
+bool Latch::TryWait() const {
+  return count_.load(std::memory_order_acquire) == 0;
+}
+
+void Latch::Wait() {
+  ignore_result(WaitFor(INFINITE_TIMEOUT_MSEC));
+}
+
+bool Latch::WaitFor(time64_t milliseconds) {
+  if (TryWait()) {
+    return true;
+  }
+  if (milliseconds == 0) {
+    return false;
+  }
+  if (internal::SpinUntil([this]() { return TryWait(); })) {
+    return true;
+  }
+
+  const time64_t deadline = internal::FutexDeadline(milliseconds);
+  bool done = false;
+  waiters_.fetch_add(1, std::memory_order_seq_cst);
+  while (true) {
+    const uint32_t count = count_.load(std::memory_order_acquire);
+    if (count == 0) {
+      done = true;
+      break;
+    }
+    const time64_t left = internal::FutexRemaining(deadline);
+    if (left == 0) {
+      break;
+    }
+    internal::FutexWait(&count_, count, left);
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+  return done;
+}
+
+}  // namespace threads
+}  // namespace common
@@ -0,0 +1,148 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/threads/parallel.h>
+
+#include <limits>
+#include <memory>
+
+#include <common/threads/latch.h>
+#include <common/threads/thread_pool.h>
+
+namespace common {
+namespace threads {
+
+namespace {
+
+// Latch counts in 32 bits, longer ranges run as several jobs.
+const size_t kMaxJobChunks = std::numeric_limits<uint32_t>::max();
+
+// Shared between the caller and the helpers posted to the pool. Helpers may start after the caller has returned,
+// they only touch |body| and |cancel| after claiming a chunk, which is impossible once every chunk is claimed.
+struct ParallelJob {
+  ParallelJob(size_t begin, size_t end, size_t grain, const parallel_chunk_t* body, const CancellationFlag* cancel)
+      : begin(begin),
+        end(end),
+        grain(grain),
+        chunks((end - begin + grain - 1) / grain),
+        body(body),
+        cancel(cancel),
+        next(0),
+        done(static_cast<uint32_t>(chunks)),
+        cancelled(false) {}
+
+  // Runs chunks until none are left to claim.
+  void Work() {
+    while (true) {
+      const size_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+      if (chunk >= chunks) {
+        return;
+      }
+      if (cancel && cancel->IsCancelled()) {
+        cancelled.store(true, std::memory_order_relaxed);
+      } else {
+        const size_t chunk_begin = begin + chunk * grain;
+        (*body)(chunk_begin, chunk_begin + std::min(grain, end - chunk_begin));
+      }
+      done.CountDown();
+    }
+  }
+
+  const size_t begin;
+  const size_t end;
+  const size_t grain;
+  const size_t chunks;
+  const parallel_chunk_t* const body;
+  const CancellationFlag* const cancel;
+  std::atomic<size_t> next;
+  Latch done;
+  std::atomic<bool> cancelled;
+};
+
+size_t ParticipatingThreads(ThreadPool* pool) {
+  return (pool && pool->IsRunning() ? pool->GetThreadsCount() : 0) + 1;
+}
+
+}  // namespace
+
+size_t ParallelGrainSize(ThreadPool* pool, size_t begin, size_t end, size_t grain) {
+  if (grain != 0) {
+    return grain;
+  }
+  if (begin >= end) {
+    return 1;
+  }
+  const size_t chunks = ParticipatingThreads(pool) * 4;
+  return std::max<size_t>(1, (end - begin + chunks - 1) / chunks);
+}
+
+bool ParallelFor(ThreadPool* pool,
+                 size_t begin,
+                 size_t end,
+                 size_t grain,
+                 const parallel_chunk_t& body,
+                 const CancellationFlag* cancel) {
+  if (begin >= end) {
+    return !(cancel && cancel->IsCancelled());
+  }
+
+  grain = ParallelGrainSize(pool, begin, end, grain);
+  const size_t chunks = (end - begin + grain - 1) / grain;
+  const size_t helpers = std::min(ParticipatingThreads(pool) - 1, chunks - 1);
+  if (helpers == 0) {
+    for (size_t chunk_begin = begin; chunk_begin < end;) {
+      if (cancel && cancel->IsCancelled()) {
+        return false;
+      }
+      const size_t chunk_end = chunk_begin + std::min(grain, end - chunk_begin);
+      body(chunk_begin, chunk_end);
+      chunk_begin = chunk_end;
+    }
+    return true;
+  }
+
+  for (size_t job_begin = begin; job_begin < end;) {
+    const size_t job_end = (end - job_begin) / grain >= kMaxJobChunks ? job_begin + kMaxJobChunks * grain : end;
+    std::shared_ptr<ParallelJob> job = std::make_shared<ParallelJob>(job_begin, job_end, grain, &body, cancel);
+    for (size_t i = 0; i < helpers; ++i) {
+      pool->Post([job]() { job->Work(); });
+    }
+    job->Work();
+    // only chunks already running on helpers are left
+    job->done.Wait();
+    if (job->cancelled.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    job_begin = job_end;
+  }
+  return true;
+}
+
+}  // namespace threads
+}  // namespace common
@@ -0,0 +1,87 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/threads/parker.h>
+
+#include "futex.h"
+
+namespace common {
+namespace threads {
+
+Parker::Parker() : state_(EMPTY) {}
+
+bool Parker::TryConsumeToken() {
+  uint32_t notified = NOTIFIED;
+  return state_.compare_exchange_strong(notified, EMPTY, std::memory_order_acquire, std::memory_order_relaxed);
+}
+
+void Parker::Park() {
+  ignore_result(ParkFor(INFINITE_TIMEOUT_MSEC));
+}
+
+bool Parker::ParkFor(time64_t milliseconds) {
+  if (TryConsumeToken()) {
+    return true;
+  }
+  if (milliseconds == 0) {
+    return false;
+  }
+  if (internal::SpinUntil([this]() { return TryConsumeToken(); })) {
+    return true;
+  }
+
+  uint32_t empty = EMPTY;
+  if (!state_.compare_exchange_strong(empty, PARKED, std::memory_order_acquire, std::memory_order_acquire)) {
+    // Unpark() slipped in between, only the owner moves the state away from NOTIFIED.
+    state_.store(EMPTY, std::memory_order_relaxed);
+    return true;
+  }
+
+  const time64_t deadline = internal::FutexDeadline(milliseconds);
+  while (true) {
+    const time64_t left = internal::FutexRemaining(deadline);
+    if (left == 0) {
+      // Give up the PARKED state, a concurrent Unpark() still counts as a wakeup.
+      return state_.exchange(EMPTY, std::memory_order_acquire) == NOTIFIED;
+    }
+    internal::FutexWait(&state_, PARKED, left);
+    if (TryConsumeToken()) {
+      return true;
+    }
+  }
+}
+
+void Parker::Unpark() {
+  if (state_.exchange(NOTIFIED, std::memory_order_release) == PARKED) {
+    internal::FutexWakeOne(&state_);
+  }
+}
+
+}  // namespace threads
+}  // namespace common
@@ -28,90 +28,82 @@
 */
 
 #include <common/threads/event.h>
-#include <pthread.h>
-#include <sys/time.h>  // for timeval, gettimeofday
 
-namespace common {
-namespace {
-
-int wait_condition(pthread_cond_t* condition, pthread_mutex_t* mutex, time64_t milliseconds) {
-  if (milliseconds != INFINITE_TIMEOUT_MSEC) {
-    // Converting from seconds and microseconds (1e-6) plus
-    // milliseconds (1e-3) to seconds and nanoseconds (1e-9).
-    struct timespec ts;
-    struct timeval tv;
-    gettimeofday(&tv, nullptr);
-    ts.tv_sec = tv.tv_sec + (milliseconds / 1000);
-    ts.tv_nsec = tv.tv_usec * 1000 + (milliseconds % 1000) * 1000000;
-    // Handle overflow.
-    if (ts.tv_nsec >= 1000000000) {
-      ts.tv_sec++;
-      ts.tv_nsec -= 1000000000;
-    }
-
-    return pthread_cond_timedwait(condition, mutex, &ts);
-  }
+#include <atomic>
 
-  return pthread_cond_wait(condition, mutex);
-}
+#include "futex.h"
 
-}  // namespace
+namespace common {
 namespace threads {
 
 struct Event::event_t {
-  event_t() : event_status(0), is_manual_reset(0) {
-    pthread_mutex_init(&event_mutex, nullptr);
-    pthread_cond_init(&event_cond, nullptr);
-  }
+  event_t(bool manual_reset, bool initially_signaled)
+      : state(initially_signaled ? 1 : 0), waiters(0), is_manual_reset(manual_reset) {}
 
-  ~event_t() {
-    pthread_mutex_destroy(&event_mutex);
-    pthread_cond_destroy(&event_cond);
+  bool TryAcquire() {
+    if (is_manual_reset) {
+      return state.load(std::memory_order_acquire) != 0;
+    }
+    // Exactly one thread resets an auto reset event, all the others see it unsignaled.
+    uint32_t signaled = 1;
+    return state.compare_exchange_strong(signaled, 0, std::memory_order_acquire, std::memory_order_relaxed);
   }
 
-  pthread_mutex_t event_mutex;
-  pthread_cond_t event_cond;
-  int event_status;
-  int is_manual_reset;
+  std::atomic<uint32_t> state;  // futex word, 1 when signaled
+  std::atomic<uint32_t> waiters;
+  const bool is_manual_reset;
 };
 
-Event::Event(int manual_reset, int initially_signaled) : event_(new event_t) {
-  event_->is_manual_reset = manual_reset;
-  event_->event_status = initially_signaled;
-}
+Event::Event(int manual_reset, int initially_signaled) : event_(new event_t(manual_reset, initially_signaled)) {}
 
 Event::~Event() {
   delete event_;
 }
 
 void Event::Set() {
-  pthread_mutex_lock(&event_->event_mutex);
-  event_->event_status = 1;
-  pthread_cond_broadcast(&event_->event_cond);
-  pthread_mutex_unlock(&event_->event_mutex);
+  event_->state.store(1, std::memory_order_seq_cst);
+  // Paired with the waiters increment before blocking: either the waiter sees the new state or we see the waiter.
+  if (event_->waiters.load(std::memory_order_seq_cst) == 0) {
+    return;
+  }
+  if (event_->is_manual_reset) {
+    internal::FutexWakeAll(&event_->state);
+  } else {
+    internal::FutexWakeOne(&event_->state);
+  }
 }
 
 void Event::Reset() {
-  pthread_mutex_lock(&event_->event_mutex);
-  event_->event_status = 0;
-  pthread_mutex_unlock(&event_->event_mutex);
+  event_->state.store(0, std::memory_order_release);
+}
+
+bool Event::IsSignaled() const {
+  return event_->state.load(std::memory_order_acquire) != 0;
 }
 
 bool Event::Wait(time64_t milliseconds) {
-  pthread_mutex_lock(&event_->event_mutex);
-  int error = 0;
-  while (!event_->event_status && error == 0) {
-    error = wait_condition(&event_->event_cond, &event_->event_mutex, milliseconds);
+  if (event_->TryAcquire()) {
+    return true;
+  }
+  if (milliseconds == 0) {
+    return false;
   }
-  // NOTE(liulk): Exactly one thread will auto-reset this event. All
-  // the other threads will think it's unsignaled. This seems to be
-  // consistent with auto-reset events in WEBRTC_WIN
-  if (error == 0 && !event_->is_manual_reset) {
-    event_->event_status = 0;
+  if (internal::SpinUntil([this]() { return event_->TryAcquire(); })) {
+    return true;
   }
-  pthread_mutex_unlock(&event_->event_mutex);
 
-  return (error == 0);
+  const time64_t deadline = internal::FutexDeadline(milliseconds);
+  bool acquired = false;
+  event_->waiters.fetch_add(1, std::memory_order_seq_cst);
+  while (!(acquired = event_->TryAcquire())) {
+    const time64_t left = internal::FutexRemaining(deadline);
+    if (left == 0) {
+      break;
+    }
+    internal::FutexWait(&event_->state, 0, left);
+  }
+  event_->waiters.fetch_sub(1, std::memory_order_relaxed);
+  return acquired;
 }
 
 }  // namespace threads
@@ -28,6 +28,7 @@
 */
 
 #include <common/threads/platform_thread.h>
+#include <common/threads/thread_context.h>
 #include <sched.h>  // for sched_get_priority_max, etc
 
 #if defined(OS_LINUX) || defined(OS_ANDROID)
@@ -107,7 +108,7 @@ struct ThreadParams {
 void* threadFunc(void* params) {
   ThreadParams* thread_params = static_cast<ThreadParams*>(params);
 
-  platform_thread_id_t tid = PlatformThread::GetCurrentId();
+  platform_thread_id_t tid = CurrentThreadId();
   *(thread_params->tid_) = tid;
   void* result = thread_params->cl(thread_params->args);
   delete thread_params;
@@ -28,6 +28,7 @@
 */
 
 #include <common/threads/thread.h>
+#include <common/threads/thread_context.h>
 #include <common/threads/thread_manager.h>
 
 namespace common {
@@ -55,7 +56,7 @@ PlatformThreadHandle invalid_thread_handle() {
 }
 
 PlatformThreadHandle current_thread_handle() {
-  return PlatformThreadHandle(PlatformThread::GetCurrentHandle(), PlatformThread::GetCurrentId());
+  return PlatformThreadHandle(PlatformThread::GetCurrentHandle(), CurrentThreadId());
 }
 
 template void WrapThread(Thread<void>* thread);
@@ -0,0 +1,68 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/threads/thread_context.h>
+
+#if defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+namespace common {
+namespace threads {
+namespace internal {
+
+thread_local ThreadContext g_thread_context = {invalid_tid, nullptr, nullptr, THREAD_ROLE_UNKNOWN};
+
+#if defined(HAVE_PTHREAD)
+namespace {
+
+void ResetTidAfterFork() {
+  // Only the forking thread survives, with the tid of the parent in its copy of the TLS.
+  g_thread_context.tid = PlatformThread::GetCurrentId();
+}
+
+void RegisterForkHandler() {
+  pthread_atfork(nullptr, nullptr, &ResetTidAfterFork);
+}
+
+}  // namespace
+#endif
+
+platform_thread_id_t InitCurrentThreadId() {
+#if defined(HAVE_PTHREAD)
+  static pthread_once_t fork_handler_once = PTHREAD_ONCE_INIT;
+  pthread_once(&fork_handler_once, &RegisterForkHandler);
+#endif
+  g_thread_context.tid = PlatformThread::GetCurrentId();
+  return g_thread_context.tid;
+}
+
+}  // namespace internal
+}  // namespace threads
+}  // namespace common
@@ -32,18 +32,20 @@
 namespace common {
 namespace threads {
 
-ThreadManager::ThreadManager() : key_(0), main_thread_(new Thread<int>) {
-  PlatformThread::InitTlsKey(&key_);
-
-  main_thread_->handle_ = PlatformThreadHandle(PlatformThread::GetCurrentHandle(), PlatformThread::GetCurrentId());
+ThreadManager::ThreadManager() : main_thread_(new Thread<int>) {
+  main_thread_->handle_ = PlatformThreadHandle(PlatformThread::GetCurrentHandle(), CurrentThreadId());
   main_thread_->event_.Set();
   WrapThread(main_thread_);
+  CurrentThreadContext()->role = THREAD_ROLE_MAIN;
 }
 
 ThreadManager::~ThreadManager() {
   UnWrapThread(main_thread_);
+  ThreadContext* context = CurrentThreadContext();
+  if (context->thread == main_thread_) {
+    context->thread = nullptr;
+  }
   delete main_thread_;
-  PlatformThread::ReleaseTlsKey(key_);
 }
 
 }  // namespace threads
@@ -0,0 +1,187 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/threads/thread_placement.h>
+
+#if defined(OS_LINUX)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+namespace common {
+namespace threads {
+
+namespace {
+
+#if defined(OS_LINUX) && defined(SYS_set_mempolicy)
+// linux/mempolicy.h, not pulled in to avoid the dependency on kernel headers.
+const int kMemPolicyPreferred = 1;
+
+bool PreferNumaNode(size_t node) {
+  const size_t kBitsPerWord = sizeof(unsigned long) * 8;
+  std::vector<unsigned long> nodemask(node / kBitsPerWord + 1, 0);
+  nodemask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  return syscall(SYS_set_mempolicy, kMemPolicyPreferred, nodemask.data(), nodemask.size() * kBitsPerWord + 1) == 0;
+}
+#endif
+
+// Logical CPUs in the order threads are placed on them by PLACEMENT_SPREAD.
+std::vector<const system_info::LogicalCpu*> SpreadOrder(const system_info::CpuTopology& topology) {
+  std::vector<std::vector<const system_info::LogicalCpu*>> per_node;
+  for (size_t node : topology.GetNumaNodes()) {
+    std::vector<const system_info::LogicalCpu*> cpus;
+    for (const system_info::LogicalCpu& cpu : topology.GetCpus()) {
+      if (cpu.numa_node == node) {
+        cpus.push_back(&cpu);
+      }
+    }
+    std::stable_sort(cpus.begin(), cpus.end(),
+                     [](const system_info::LogicalCpu* lhs, const system_info::LogicalCpu* rhs) {
+                       return lhs->smt_index < rhs->smt_index;
+                     });
+    per_node.push_back(cpus);
+  }
+
+  std::vector<const system_info::LogicalCpu*> order;
+  for (size_t i = 0; order.size() < topology.GetLogicalCpusCount(); ++i) {
+    for (const auto& cpus : per_node) {
+      if (i < cpus.size()) {
+        order.push_back(cpus[i]);
+      }
+    }
+  }
+  return order;
+}
+
+}  // namespace
+
+ThreadPlacement MakeThreadPlacement(const system_info::CpuTopology& topology, PlacementPolicy policy, size_t index) {
+  ThreadPlacement placement;
+  const auto& cpus = topology.GetCpus();
+  if (cpus.empty()) {
+    return placement;
+  }
+
+  switch (policy) {
+    case PLACEMENT_COMPACT: {
+      // Ids of SMT siblings aren't adjacent on most x86 systems, walk cores instead.
+      std::vector<const system_info::LogicalCpu*> order;
+      for (const system_info::LogicalCpu& cpu : cpus) {
+        order.push_back(&cpu);
+      }
+      std::stable_sort(order.begin(), order.end(),
+                       [](const system_info::LogicalCpu* lhs, const system_info::LogicalCpu* rhs) {
+                         if (lhs->numa_node != rhs->numa_node) {
+                           return lhs->numa_node < rhs->numa_node;
+                         }
+                         return lhs->core < rhs->core;
+                       });
+      const system_info::LogicalCpu* cpu = order[index % order.size()];
+      placement.cpus = {cpu->id};
+      placement.numa_node = cpu->numa_node;
+      break;
+    }
+    case PLACEMENT_SPREAD: {
+      const auto order = SpreadOrder(topology);
+      const system_info::LogicalCpu* cpu = order[index % order.size()];
+      placement.cpus = {cpu->id};
+      placement.numa_node = cpu->numa_node;
+      break;
+    }
+    case PLACEMENT_PHYSICAL_CORE: {
+      // Cores in spread order, so a group smaller than the machine still uses every node.
+      std::vector<size_t> cores;
+      std::vector<size_t> nodes;
+      for (const system_info::LogicalCpu* cpu : SpreadOrder(topology)) {
+        if (cpu->smt_index == 0) {
+          cores.push_back(cpu->core);
+          nodes.push_back(cpu->numa_node);
+        }
+      }
+      const size_t slot = index % cores.size();
+      placement.cpus = topology.GetCoreCpus(cores[slot]);
+      placement.numa_node = nodes[slot];
+      break;
+    }
+    case PLACEMENT_NUMA_NODE: {
+      const auto& nodes = topology.GetNumaNodes();
+      placement.numa_node = nodes[index % nodes.size()];
+      placement.cpus = topology.GetNumaNodeCpus(placement.numa_node);
+      break;
+    }
+    default:
+      break;
+  }
+
+  if (topology.GetNumaNodesCount() < 2) {
+    placement.numa_node = ThreadPlacement::kAnyNode;
+  }
+  return placement;
+}
+
+ThreadPlacement MakeThreadPlacement(PlacementPolicy policy, size_t index) {
+  if (policy == PLACEMENT_NONE) {
+    return ThreadPlacement();
+  }
+  return MakeThreadPlacement(system_info::CpuTopology::Current(), policy, index);
+}
+
+bool ApplyThreadPlacement(const ThreadPlacement& placement) {
+  if (!placement.IsPinned()) {
+    return true;
+  }
+
+#if defined(OS_LINUX)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (lcpu_count_t cpu : placement.cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpu_set);
+    }
+  }
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    return false;
+  }
+
+#if defined(SYS_set_mempolicy)
+  if (placement.numa_node != ThreadPlacement::kAnyNode && !PreferNumaNode(placement.numa_node)) {
+    return false;
+  }
+#endif
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace threads
+}  // namespace common
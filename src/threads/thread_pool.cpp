@@ -29,22 +29,39 @@
 
 #include <common/threads/thread_pool.h>
 
+#include <common/logger.h>
+#include <common/metrics/metrics.h>
+
 namespace common {
 namespace threads {
 
-ThreadPool::ThreadPool() : workers_(), tasks_(), queue_mutex_(), condition_(), stop_(false) {}
+ThreadPool::ThreadPool()
+    : workers_(),
+      tasks_(),
+      queue_mutex_(),
+      condition_(),
+      stop_(false),
+      placement_(PLACEMENT_NONE),
+      queued_(METRICS()->GetGauge("common_thread_pool_queued_tasks", "Tasks waiting for a thread pool worker")),
+      executed_(METRICS()->GetCounter("common_thread_pool_tasks_total", "Tasks executed by thread pools")),
+      wait_time_(METRICS()->GetLatencyHistogram("common_thread_pool_task_wait_seconds",
+                                                "Time tasks spend queued before a worker picks them up")) {}
 
-ThreadPool::~ThreadPool() {}
+ThreadPool::~ThreadPool() {
+  queued_->Sub(tasks_.size());
+}
 
 void ThreadPool::Post(task_t task) {
   {
     std::lock_guard<std::mutex> lock(queue_mutex_);
-    tasks_.push(task);
+    tasks_.push({std::move(task), metrics::MonotonicNowNs()});
+    queued_->Increment();
   }
   condition_.notify_one();
 }
 
-void ThreadPool::Start(size_t count_threads) {
+void ThreadPool::Start(size_t count_threads, PlacementPolicy placement) {
+  placement_ = placement;
   InitWork(count_threads);
 }
 
@@ -59,12 +76,22 @@ void ThreadPool::Restart() {
   InitWork(workers_.size());
 }
 
+size_t ThreadPool::GetThreadsCount() const {
+  return workers_.size();
+}
+
+bool ThreadPool::IsRunning() const {
+  return !stop_ && !workers_.empty();
+}
+
 void ThreadPool::InitWork(size_t threads) {
   workers_.clear();
   tasks_t q;
   tasks_.swap(q);
+  queued_->Sub(q.size());
+  stop_ = false;
   for (uint16_t i = 0; i < threads; ++i) {
-    workers_.push_back(thread_t(&ThreadPool::RunWork, this));
+    workers_.push_back(thread_t(&ThreadPool::RunWork, this, i));
   }
 }
 
@@ -74,7 +101,11 @@ void ThreadPool::WaitFinishWork() {
   }
 }
 
-void ThreadPool::RunWork() {
+void ThreadPool::RunWork(size_t index) {
+  if (!ApplyThreadPlacement(MakeThreadPlacement(placement_, index))) {
+    WARNING_LOG() << "Failed to place thread pool worker " << index;
+  }
+
   task_t task;
   while (true) {
     {
@@ -85,9 +116,13 @@ void ThreadPool::RunWork() {
       if (stop_) {
         return;
       }
-      task = tasks_.front();
+      queued_task_t& front = tasks_.front();
+      wait_time_->Record(metrics::MonotonicNowNs() - front.posted_ns);
+      task = std::move(front.task);
       tasks_.pop();
+      queued_->Decrement();
     }
+    executed_->Increment();
     task();
   }
 }
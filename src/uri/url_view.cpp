@@ -0,0 +1,241 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <common/uri/url_view.h>
+
+#include <common/static_string_map.h>
+#include <common/string_util.h>
+#include <common/uri/gurl.h>
+#include <common/uri/url_constants.h>
+#include <common/uri/url_parse_internal.h>
+#include <common/uri/url_util.h>
+
+namespace common {
+namespace uri {
+
+namespace {
+
+constexpr StaticStringMapEntry<KnownScheme> kKnownSchemes[] = {
+    {"http", KNOWN_SCHEME_HTTP},     {"https", KNOWN_SCHEME_HTTPS},   {"ws", KNOWN_SCHEME_WS},
+    {"wss", KNOWN_SCHEME_WSS},       {"ftp", KNOWN_SCHEME_FTP},       {"file", KNOWN_SCHEME_FILE},
+    {"dev", KNOWN_SCHEME_DEV},       {"gs", KNOWN_SCHEME_GS},         {"s3", KNOWN_SCHEME_S3},
+    {"unknown", KNOWN_SCHEME_UNKNOWN}, {"udp", KNOWN_SCHEME_UDP},     {"rtp", KNOWN_SCHEME_RTP},
+    {"srt", KNOWN_SCHEME_SRT},       {"tcp", KNOWN_SCHEME_TCP},       {"rtmp", KNOWN_SCHEME_RTMP},
+    {"rtmps", KNOWN_SCHEME_RTMPS},   {"rtmpt", KNOWN_SCHEME_RTMPT},   {"rtmpe", KNOWN_SCHEME_RTMPE},
+    {"rtmfp", KNOWN_SCHEME_RTMFP},   {"webrtc", KNOWN_SCHEME_WEBRTC}, {"webrtcs", KNOWN_SCHEME_WEBRTCS},
+    {"rtsp", KNOWN_SCHEME_RTSP},     {"data", KNOWN_SCHEME_DATA},     {"tel", KNOWN_SCHEME_TEL}};
+constexpr auto kKnownSchemesMap = MakeStaticStringMap(kKnownSchemes);
+static_assert(kKnownSchemesMap.IsPerfect(), "known scheme table has no perfect hash");
+
+void ParseWithScheme(KnownScheme scheme, const char* spec, int spec_len, const Component& scheme_comp, Parsed* parsed) {
+  // Mirrors the parser selection of uri::Canonicalize().
+  switch (scheme) {
+    case KNOWN_SCHEME_FILE:
+      ParseFileURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_DEV:
+      ParseDevURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_GS:
+      ParseGsURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_S3:
+      ParseS3URL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_UNKNOWN:
+      ParseUnknownURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_UDP:
+      ParseUdpURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_RTP:
+      ParseRtpURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_SRT:
+      ParseSrtURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_TCP:
+      ParseTcpURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_RTMP:
+    case KNOWN_SCHEME_RTMPS:
+    case KNOWN_SCHEME_RTMPT:
+    case KNOWN_SCHEME_RTMPE:
+    case KNOWN_SCHEME_RTMFP:
+      ParseRtmpURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_WEBRTC:
+    case KNOWN_SCHEME_WEBRTCS:
+      ParseWebRTCURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_RTSP:
+      ParseRtspURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_HTTP:
+    case KNOWN_SCHEME_HTTPS:
+    case KNOWN_SCHEME_WS:
+    case KNOWN_SCHEME_WSS:
+    case KNOWN_SCHEME_FTP:
+      ParseStandardURL(spec, spec_len, parsed);
+      return;
+    case KNOWN_SCHEME_OTHER:
+      if (uri::IsStandard(spec, scheme_comp)) {
+        ParseStandardURL(spec, spec_len, parsed);
+        return;
+      }
+      break;
+    default:
+      break;
+  }
+  ParsePathURL(spec, spec_len, true, parsed);
+}
+
+}  // namespace
+
+KnownScheme LookupKnownScheme(StringPiece scheme) {
+  if (scheme.empty()) {
+    return KNOWN_SCHEME_NONE;
+  }
+
+  const KnownScheme* known = kKnownSchemesMap.Find(scheme);
+  return known ? *known : KNOWN_SCHEME_OTHER;
+}
+
+UrlView::UrlView() : spec_(), parsed_(), known_scheme_(KNOWN_SCHEME_NONE), is_valid_(false) {}
+
+UrlView::UrlView(StringPiece spec) : spec_(spec), parsed_(), known_scheme_(KNOWN_SCHEME_NONE), is_valid_(false) {
+  if (spec_.empty() || spec_.size() > kMaxURLChars) {
+    return;
+  }
+
+  const char* data = spec_.data();
+  const int len = static_cast<int>(spec_.size());
+  if (data[0] == '/') {
+    ParsePathInternal(data, MakeRange(0, len), &parsed_.path, &parsed_.query, &parsed_.ref);
+    is_valid_ = true;
+    return;
+  }
+
+  Component scheme;
+  if (!ExtractScheme(data, len, &scheme)) {
+    return;
+  }
+  known_scheme_ = LookupKnownScheme(ComponentPiece(scheme));
+  ParseWithScheme(known_scheme_, data, len, scheme, &parsed_);
+  is_valid_ = parsed_.scheme.is_valid();
+}
+
+bool UrlView::IsStandard() const {
+  switch (known_scheme_) {
+    case KNOWN_SCHEME_NONE:
+    case KNOWN_SCHEME_DATA:
+    case KNOWN_SCHEME_TEL:
+      return false;
+    case KNOWN_SCHEME_OTHER:
+      return uri::IsStandard(spec_.data(), parsed_.scheme);
+    default:
+      return true;
+  }
+}
+
+bool UrlView::SchemeIs(StringPiece lower_ascii_scheme) const {
+  if (!parsed_.scheme.is_valid()) {
+    return lower_ascii_scheme.empty();
+  }
+  return LowerCaseEqualsASCII(scheme_piece(), lower_ascii_scheme);
+}
+
+bool UrlView::SchemeIsHTTPOrHTTPS() const {
+  return known_scheme_ == KNOWN_SCHEME_HTTP || known_scheme_ == KNOWN_SCHEME_HTTPS;
+}
+
+bool UrlView::SchemeIsWSOrWSS() const {
+  return known_scheme_ == KNOWN_SCHEME_WS || known_scheme_ == KNOWN_SCHEME_WSS;
+}
+
+int UrlView::IntPort() const {
+  if (parsed_.port.is_nonempty()) {
+    return ParsePort(spec_.data(), parsed_.port);
+  }
+  return PORT_UNSPECIFIED;
+}
+
+StringPiece UrlView::PathForRequestPiece() const {
+  if (!parsed_.path.is_nonempty()) {
+    return StringPiece("/", 1);
+  }
+
+  int path_len = parsed_.path.len;
+  if (parsed_.query.is_valid()) {
+    path_len = parsed_.query.end() - parsed_.path.begin;
+  }
+  return StringPiece(spec_.data() + parsed_.path.begin, path_len);
+}
+
+bool UrlView::CanonicalizePathForRequest(CanonOutput* output) const {
+  if (!is_valid_) {
+    return false;
+  }
+
+  Component out_component;
+  bool success = true;
+  if (parsed_.path.is_nonempty()) {
+    success = CanonicalizePath(spec_.data(), parsed_.path, output, &out_component);
+  } else {
+    output->push_back('/');
+  }
+  if (parsed_.query.is_valid()) {
+    CanonicalizeQuery(spec_.data(), parsed_.query, nullptr, output, &out_component);
+  }
+  return success;
+}
+
+bool UrlView::Canonicalize(CanonOutput* output, Parsed* output_parsed) const {
+  if (!is_valid_ || is_origin_form()) {
+    return false;
+  }
+  return uri::Canonicalize(spec_.data(), static_cast<int>(spec_.size()), true, nullptr, output, output_parsed);
+}
+
+GURL UrlView::ToGURL() const {
+  if (!is_valid_ || is_origin_form()) {
+    return GURL();
+  }
+  return GURL(spec_);
+}
+
+StringPiece UrlView::ComponentPiece(const Component& comp) const {
+  if (comp.len <= 0) {
+    return StringPiece();
+  }
+  return StringPiece(spec_.data() + comp.begin, comp.len);
+}
+
+}  // namespace uri
+}  // namespace common
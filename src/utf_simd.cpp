@@ -0,0 +1,602 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include "utf_simd.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <common/icu_utf.h>
+#include <common/system_info/cpu_info.h>
+#include <common/utf_string_conversion_utils.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define UTF_HAVE_SSE2 1
+#endif
+
+#if defined(ARCH_CPU_X86_FAMILY) && defined(__GNUC__)
+#include <immintrin.h>
+#define UTF_HAVE_AVX2 1
+#define UTF_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace common {
+namespace internal {
+
+namespace {
+
+const uint64_t kHighBits8 = UINT64_C(0x8080808080808080);
+const uint64_t kHighBits16 = UINT64_C(0xFF80FF80FF80FF80);
+
+#if defined(UTF_HAVE_AVX2)
+bool CpuHasAvx2() {
+  return system_info::CPU::Current().has_avx2();
+}
+#endif
+
+inline uint64_t LoadWord(const void* src) {
+  uint64_t word;
+  memcpy(&word, src, sizeof(word));
+  return word;
+}
+
+// Scalar ----------------------------------------------------------------------
+
+template <typename CHAR>
+bool IsASCIIScalar(const CHAR* src, size_t src_len, uint64_t high_bits) {
+  const size_t chars_per_word = sizeof(uint64_t) / sizeof(CHAR);
+  uint64_t all = 0;
+  size_t i = 0;
+  for (; i + chars_per_word <= src_len; i += chars_per_word) {
+    all |= LoadWord(src + i);
+  }
+  bool ascii = (all & high_bits) == 0;
+  for (; i < src_len; ++i) {
+    ascii &= static_cast<uint32_t>(src[i]) < 0x80;
+  }
+  return ascii;
+}
+
+// Copies the leading ASCII run of |src| widened to |dest| (when given), returns its length.
+template <typename DEST_CHAR>
+size_t CopyASCIIPrefix(const uint8_t* src, size_t src_len, DEST_CHAR* dest) {
+  size_t i = 0;
+#if defined(UTF_HAVE_SSE2)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= src_len; i += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const int mask = _mm_movemask_epi8(bytes);
+    if (mask) {
+      const size_t run = __builtin_ctz(mask);
+      for (size_t j = 0; dest && j < run; ++j) {
+        dest[i + j] = src[i + j];
+      }
+      return i + run;
+    }
+    if (!dest) {
+      continue;
+    }
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    if (sizeof(DEST_CHAR) == 2) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), lo);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8), hi);
+    } else if (sizeof(DEST_CHAR) == 4) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 4), _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8), _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 12), _mm_unpackhi_epi16(hi, zero));
+    } else {
+      for (size_t j = 0; j < 16; ++j) {
+        dest[i + j] = src[i + j];
+      }
+    }
+  }
+#else
+  for (; i + sizeof(uint64_t) <= src_len; i += sizeof(uint64_t)) {
+    if (LoadWord(src + i) & kHighBits8) {
+      break;
+    }
+    for (size_t j = 0; dest && j < sizeof(uint64_t); ++j) {
+      dest[i + j] = src[i + j];
+    }
+  }
+#endif
+  for (; i < src_len && src[i] < 0x80; ++i) {
+    if (dest) {
+      dest[i] = src[i];
+    }
+  }
+  return i;
+}
+
+// Decodes the well-formed sequence at |src| (Unicode table 3-7), returns its length or 0 if it is malformed.
+inline size_t DecodeSequence(const uint8_t* src, size_t src_len, uint32_t* code_point) {
+  const uint8_t lead = src[0];
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    if (src_len < 2 || (src[1] & 0xC0) != 0x80) {
+      return 0;
+    }
+    *code_point = ((lead & 0x1F) << 6) | (src[1] & 0x3F);
+    return 2;
+  }
+  if (lead >= 0xE0 && lead <= 0xEF) {
+    const uint8_t lo = lead == 0xE0 ? 0xA0 : 0x80;
+    const uint8_t hi = lead == 0xED ? 0x9F : 0xBF;
+    if (src_len < 3 || src[1] < lo || src[1] > hi || (src[2] & 0xC0) != 0x80) {
+      return 0;
+    }
+    *code_point = ((lead & 0x0F) << 12) | ((src[1] & 0x3F) << 6) | (src[2] & 0x3F);
+    return 3;
+  }
+  if (lead >= 0xF0 && lead <= 0xF4) {
+    const uint8_t lo = lead == 0xF0 ? 0x90 : 0x80;
+    const uint8_t hi = lead == 0xF4 ? 0x8F : 0xBF;
+    if (src_len < 4 || src[1] < lo || src[1] > hi || (src[2] & 0xC0) != 0x80 || (src[3] & 0xC0) != 0x80) {
+      return 0;
+    }
+    *code_point = ((lead & 0x07) << 18) | ((src[1] & 0x3F) << 12) | ((src[2] & 0x3F) << 6) | (src[3] & 0x3F);
+    return 4;
+  }
+  return 0;
+}
+
+bool IsValidUTF8Scalar(const uint8_t* src, size_t src_len, bool reject_noncharacters) {
+  size_t i = 0;
+  while (i < src_len) {
+    if (src[i] < 0x80) {
+      i += CopyASCIIPrefix<char>(src + i, src_len - i, nullptr);
+      continue;
+    }
+    uint32_t code_point;
+    const size_t length = DecodeSequence(src + i, src_len - i, &code_point);
+    if (!length || (reject_noncharacters && !IsValidCharacter(code_point))) {
+      return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+size_t DecodedLengthScalar(const uint8_t* src, size_t src_len, bool count_four_byte_leads) {
+  size_t length = 0;
+  for (size_t i = 0; i < src_len; ++i) {
+    length += (src[i] & 0xC0) != 0x80;
+    length += count_four_byte_leads && src[i] >= 0xF0;
+  }
+  return length;
+}
+
+// Adds the UTF-8 length of the unit at |*index|, consuming a surrogate pair as a whole.
+inline bool AddUTF8Length(const char16* src, size_t src_len, size_t* index, size_t* utf8_len) {
+  const uint32_t unit = src[*index];
+  if (unit < 0x80) {
+    *utf8_len += 1;
+  } else if (unit < 0x800) {
+    *utf8_len += 2;
+  } else if (!CBU16_IS_SURROGATE(unit)) {
+    *utf8_len += 3;
+  } else {
+    if (!CBU16_IS_SURROGATE_LEAD(unit) || *index + 1 >= src_len || !CBU16_IS_TRAIL(src[*index + 1])) {
+      return false;
+    }
+    *utf8_len += 4;
+    ++*index;
+  }
+  ++*index;
+  return true;
+}
+
+#if defined(UTF_HAVE_AVX2)
+
+// AVX2 ------------------------------------------------------------------------
+
+// Lookup table validation (Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"): each byte is
+// classified by the high nibble of itself and by both nibbles of the byte before it, an error bit that survives all
+// three lookups marks a malformed sequence.
+const uint8_t kTooShort = 1 << 0;   // 11______ 0_______ or 11______ 11______
+const uint8_t kTooLong = 1 << 1;    // 0_______ 10______
+const uint8_t kOverlong3 = 1 << 2;  // 11100000 100_____
+const uint8_t kTooLarge = 1 << 3;   // 11110100 1001____ and above
+const uint8_t kSurrogate = 1 << 4;  // 11101101 101_____
+const uint8_t kOverlong2 = 1 << 5;  // 1100000_ 10______
+const uint8_t kTooLarge1000 = 1 << 6;  // 11110101 1000____ and above
+const uint8_t kOverlong4 = 1 << 6;     // 11110000 1000____
+const uint8_t kTwoConts = 1 << 7;      // 10______ 10______
+const uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) const uint8_t kByte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2,
+    kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4};
+
+alignas(16) const uint8_t kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    kCarry | kOverlong2,
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000};
+
+alignas(16) const uint8_t kByte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort};
+
+// A lead byte in the last three positions of a block still needs continuation bytes from the next one.
+alignas(32) const uint8_t kIncompleteMax[32] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+                                                0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xEF, 0xDF, 0xBF};
+
+struct UTF8CheckerAvx2 {
+  __m256i error;
+  __m256i prev_input;
+  __m256i prev_incomplete;
+  __m256i noncharacters;
+};
+
+UTF_AVX2_TARGET inline __m256i Table16(const uint8_t* table) {
+  return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+UTF_AVX2_TARGET inline __m256i HighNibbles(__m256i input) {
+  return _mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0x0F));
+}
+
+// Bytes of |input| shifted right by N, the gap filled from the tail of |prev_input|.
+template <int N>
+UTF_AVX2_TARGET inline __m256i Prev(__m256i input, __m256i prev_input) {
+  return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+}
+
+UTF_AVX2_TARGET void CheckBlockAvx2(__m256i input, UTF8CheckerAvx2* checker) {
+  if (_mm256_movemask_epi8(input) == 0) {
+    checker->error = _mm256_or_si256(checker->error, checker->prev_incomplete);
+    checker->prev_incomplete = _mm256_setzero_si256();
+    checker->prev_input = input;
+    return;
+  }
+
+  const __m256i prev1 = Prev<1>(input, checker->prev_input);
+  const __m256i byte_1_high = _mm256_shuffle_epi8(Table16(kByte1High), HighNibbles(prev1));
+  const __m256i byte_1_low =
+      _mm256_shuffle_epi8(Table16(kByte1Low), _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)));
+  const __m256i byte_2_high = _mm256_shuffle_epi8(Table16(kByte2High), HighNibbles(input));
+  const __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+  // The third and fourth bytes of a sequence are the only continuations allowed after another continuation.
+  const __m256i prev2 = Prev<2>(input, checker->prev_input);
+  const __m256i prev3 = Prev<3>(input, checker->prev_input);
+  const __m256i is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80));
+  const __m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+  const __m256i must_be_continuation =
+      _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte), _mm256_set1_epi8(static_cast<char>(0x80)));
+  checker->error = _mm256_or_si256(checker->error, _mm256_xor_si256(must_be_continuation, special_cases));
+
+  // Non-characters all contain EF B7 (U+FDD0..U+FDEF) or BF BE/BF (U+xFFFE/U+xFFFF), flag blocks that might hold one.
+  const __m256i fdd0 = _mm256_and_si256(_mm256_cmpeq_epi8(prev1, _mm256_set1_epi8(static_cast<char>(0xEF))),
+                                        _mm256_cmpeq_epi8(input, _mm256_set1_epi8(static_cast<char>(0xB7))));
+  const __m256i fffe =
+      _mm256_and_si256(_mm256_cmpeq_epi8(prev1, _mm256_set1_epi8(static_cast<char>(0xBF))),
+                       _mm256_cmpeq_epi8(_mm256_or_si256(input, _mm256_set1_epi8(1)),
+                                         _mm256_set1_epi8(static_cast<char>(0xBF))));
+  checker->noncharacters = _mm256_or_si256(checker->noncharacters, _mm256_or_si256(fdd0, fffe));
+
+  checker->prev_incomplete =
+      _mm256_subs_epu8(input, _mm256_load_si256(reinterpret_cast<const __m256i*>(kIncompleteMax)));
+  checker->prev_input = input;
+}
+
+UTF_AVX2_TARGET bool IsValidUTF8Avx2(const uint8_t* src, size_t src_len, bool* noncharacters) {
+  UTF8CheckerAvx2 checker;
+  checker.error = _mm256_setzero_si256();
+  checker.prev_input = _mm256_setzero_si256();
+  checker.prev_incomplete = _mm256_setzero_si256();
+  checker.noncharacters = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 32 <= src_len; i += 32) {
+    CheckBlockAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), &checker);
+  }
+  if (i < src_len) {
+    // Zero padding is ASCII, so a sequence cut by the end of input is reported as too short.
+    alignas(32) uint8_t tail[32] = {0};
+    memcpy(tail, src + i, src_len - i);
+    CheckBlockAvx2(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)), &checker);
+  }
+  checker.error = _mm256_or_si256(checker.error, checker.prev_incomplete);
+  *noncharacters = !_mm256_testz_si256(checker.noncharacters, checker.noncharacters);
+  return _mm256_testz_si256(checker.error, checker.error);
+}
+
+UTF_AVX2_TARGET bool IsASCIIAvx2(const char* src, size_t src_len) {
+  size_t i = 0;
+  for (; i + 32 <= src_len; i += 32) {
+    if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)))) {
+      return false;
+    }
+  }
+  return IsASCIIScalar(src + i, src_len - i, kHighBits8);
+}
+
+UTF_AVX2_TARGET bool IsASCIIAvx2(const char16* src, size_t src_len) {
+  const __m256i high_bits = _mm256_set1_epi16(static_cast<int16_t>(0xFF80));
+  const size_t units_per_block = sizeof(__m256i) / sizeof(char16);
+  size_t i = 0;
+  for (; i + units_per_block <= src_len; i += units_per_block) {
+    const __m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    if (!_mm256_testz_si256(units, high_bits)) {
+      return false;
+    }
+  }
+  return IsASCIIScalar(src + i, src_len - i, kHighBits16);
+}
+
+UTF_AVX2_TARGET size_t DecodedLengthAvx2(const uint8_t* src, size_t src_len, bool count_four_byte_leads) {
+  // Signed compare: continuation bytes 0x80..0xBF are the only ones at or below -65.
+  const __m256i continuation_max = _mm256_set1_epi8(-65);
+  const __m256i four_byte_lead = _mm256_set1_epi8(static_cast<char>(0xF0));
+  size_t length = 0;
+  size_t i = 0;
+  for (; i + 32 <= src_len; i += 32) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    const uint32_t leads = _mm256_movemask_epi8(_mm256_cmpgt_epi8(bytes, continuation_max));
+    length += __builtin_popcount(leads);
+    if (count_four_byte_leads) {
+      const __m256i is_four = _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, four_byte_lead), bytes);
+      length += __builtin_popcount(static_cast<uint32_t>(_mm256_movemask_epi8(is_four)));
+    }
+  }
+  return length + DecodedLengthScalar(src + i, src_len - i, count_four_byte_leads);
+}
+
+UTF_AVX2_TARGET bool UTF8LengthOfUTF16Avx2(const char16* src, size_t src_len, size_t* utf8_len) {
+  const size_t units_per_block = sizeof(__m256i) / sizeof(char16);
+  const __m256i surrogate_mask = _mm256_set1_epi16(static_cast<int16_t>(0xF800));
+  const __m256i surrogate_base = _mm256_set1_epi16(static_cast<int16_t>(0xD800));
+  const __m256i one_byte_max = _mm256_set1_epi16(0x7F);
+  const __m256i two_byte_max = _mm256_set1_epi16(0x7FF);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t length = 0;
+  size_t i = 0;
+  while (i + units_per_block <= src_len) {
+    const __m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    const __m256i surrogates = _mm256_cmpeq_epi16(_mm256_and_si256(units, surrogate_mask), surrogate_base);
+    if (!_mm256_testz_si256(surrogates, surrogates)) {
+      const size_t block_end = i + units_per_block;
+      while (i < block_end) {
+        if (!AddUTF8Length(src, src_len, &i, &length)) {
+          return false;
+        }
+      }
+      continue;
+    }
+    // movemask yields two bits per 16-bit lane.
+    const uint32_t one_byte = _mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_subs_epu16(units, one_byte_max), zero));
+    const uint32_t up_to_two = _mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_subs_epu16(units, two_byte_max), zero));
+    length += 3 * units_per_block - (__builtin_popcount(one_byte) + __builtin_popcount(up_to_two)) / 2;
+    i += units_per_block;
+  }
+  while (i < src_len) {
+    if (!AddUTF8Length(src, src_len, &i, &length)) {
+      return false;
+    }
+  }
+  *utf8_len = length;
+  return true;
+}
+
+#endif  // defined(UTF_HAVE_AVX2)
+
+template <typename DEST_CHAR>
+size_t ConvertValidUTF8T(const uint8_t* src, size_t src_len, DEST_CHAR* dest) {
+  DEST_CHAR* out = dest;
+  size_t i = 0;
+  while (i < src_len) {
+    const uint8_t lead = src[i];
+    if (lead < 0x80) {
+      const size_t run = CopyASCIIPrefix(src + i, src_len - i, out);
+      i += run;
+      out += run;
+      continue;
+    }
+    uint32_t code_point;
+    if (lead < 0xE0) {
+      code_point = ((lead & 0x1F) << 6) | (src[i + 1] & 0x3F);
+      i += 2;
+    } else if (lead < 0xF0) {
+      code_point = ((lead & 0x0F) << 12) | ((src[i + 1] & 0x3F) << 6) | (src[i + 2] & 0x3F);
+      i += 3;
+    } else {
+      code_point =
+          ((lead & 0x07) << 18) | ((src[i + 1] & 0x3F) << 12) | ((src[i + 2] & 0x3F) << 6) | (src[i + 3] & 0x3F);
+      i += 4;
+    }
+    if (sizeof(DEST_CHAR) == 2 && code_point > 0xFFFF) {
+      *out++ = static_cast<DEST_CHAR>((code_point >> 10) + 0xD7C0);
+      *out++ = static_cast<DEST_CHAR>((code_point & 0x3FF) | 0xDC00);
+    } else {
+      *out++ = static_cast<DEST_CHAR>(code_point);
+    }
+  }
+  return out - dest;
+}
+
+}  // namespace
+
+bool IsASCII(const char* src, size_t src_len) {
+#if defined(UTF_HAVE_AVX2)
+  if (CpuHasAvx2()) {
+    return IsASCIIAvx2(src, src_len);
+  }
+#endif
+#if defined(UTF_HAVE_SSE2)
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+  return CopyASCIIPrefix<char>(bytes, src_len, nullptr) == src_len;
+#else
+  return IsASCIIScalar(src, src_len, kHighBits8);
+#endif
+}
+
+bool IsASCII(const char16* src, size_t src_len) {
+#if defined(UTF_HAVE_AVX2)
+  if (CpuHasAvx2()) {
+    return IsASCIIAvx2(src, src_len);
+  }
+#endif
+  return IsASCIIScalar(src, src_len, kHighBits16);
+}
+
+bool IsValidUTF8(const char* src, size_t src_len, bool reject_noncharacters) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+#if defined(UTF_HAVE_AVX2)
+  if (CpuHasAvx2()) {
+    bool noncharacters = false;
+    if (!IsValidUTF8Avx2(bytes, src_len, &noncharacters)) {
+      return false;
+    }
+    // Candidates are rare in real text, recheck exactly only when one was seen.
+    return !reject_noncharacters || !noncharacters || IsValidUTF8Scalar(bytes, src_len, true);
+  }
+#endif
+  return IsValidUTF8Scalar(bytes, src_len, reject_noncharacters);
+}
+
+size_t UTF16LengthOfValidUTF8(const char* src, size_t src_len) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+#if defined(UTF_HAVE_AVX2)
+  if (CpuHasAvx2()) {
+    return DecodedLengthAvx2(bytes, src_len, true);
+  }
+#endif
+  return DecodedLengthScalar(bytes, src_len, true);
+}
+
+size_t UTF32LengthOfValidUTF8(const char* src, size_t src_len) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+#if defined(UTF_HAVE_AVX2)
+  if (CpuHasAvx2()) {
+    return DecodedLengthAvx2(bytes, src_len, false);
+  }
+#endif
+  return DecodedLengthScalar(bytes, src_len, false);
+}
+
+size_t ConvertValidUTF8(const char* src, size_t src_len, char16* dest) {
+  return ConvertValidUTF8T(reinterpret_cast<const uint8_t*>(src), src_len, dest);
+}
+
+#if defined(WCHAR_T_IS_UTF32)
+size_t ConvertValidUTF8(const char* src, size_t src_len, wchar_t* dest) {
+  return ConvertValidUTF8T(reinterpret_cast<const uint8_t*>(src), src_len, dest);
+}
+#endif
+
+bool UTF8LengthOfUTF16(const char16* src, size_t src_len, size_t* utf8_len) {
+#if defined(UTF_HAVE_AVX2)
+  if (CpuHasAvx2()) {
+    return UTF8LengthOfUTF16Avx2(src, src_len, utf8_len);
+  }
+#endif
+  size_t length = 0;
+  size_t i = 0;
+  while (i < src_len) {
+    if (!AddUTF8Length(src, src_len, &i, &length)) {
+      return false;
+    }
+  }
+  *utf8_len = length;
+  return true;
+}
+
+size_t ConvertValidUTF16(const char16* src, size_t src_len, char* dest) {
+  char* out = dest;
+  size_t i = 0;
+  while (i < src_len) {
+    uint32_t unit = src[i];
+#if defined(UTF_HAVE_SSE2)
+    if (unit < 0x80 && sizeof(char16) == 2) {
+      const __m128i high_bits = _mm_set1_epi16(static_cast<int16_t>(0xFF80));
+      bool narrowed = false;
+      for (; i + 8 <= src_len; i += 8, out += 8) {
+        const __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, high_bits), _mm_setzero_si128())) != 0xFFFF) {
+          break;
+        }
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(units, units));
+        narrowed = true;
+      }
+      if (narrowed) {
+        continue;
+      }
+    }
+#endif
+    ++i;
+    if (unit < 0x80) {
+      *out++ = static_cast<char>(unit);
+      continue;
+    }
+    if (CBU16_IS_LEAD(unit)) {
+      unit = CBU16_GET_SUPPLEMENTARY(unit, src[i]);
+      ++i;
+    }
+    if (unit < 0x800) {
+      *out++ = static_cast<char>(0xC0 | (unit >> 6));
+    } else if (unit < 0x10000) {
+      *out++ = static_cast<char>(0xE0 | (unit >> 12));
+      *out++ = static_cast<char>(0x80 | ((unit >> 6) & 0x3F));
+    } else {
+      *out++ = static_cast<char>(0xF0 | (unit >> 18));
+      *out++ = static_cast<char>(0x80 | ((unit >> 12) & 0x3F));
+      *out++ = static_cast<char>(0x80 | ((unit >> 6) & 0x3F));
+    }
+    *out++ = static_cast<char>(0x80 | (unit & 0x3F));
+  }
+  return out - dest;
+}
+
+}  // namespace internal
+}  // namespace common
@@ -0,0 +1,68 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+#include <common/string16.h>
+
+// Block-at-a-time kernels behind IsStringASCII(), IsStringUTF8() and the UTF-8 <-> UTF-16/32 conversions. The
+// implementation is picked once at runtime: AVX2 (32 bytes per step) when the CPU has it, otherwise SSE2 (16 bytes per
+// step) or a portable word-at-a-time loop.
+
+namespace common {
+namespace internal {
+
+bool IsASCII(const char* src, size_t src_len);
+bool IsASCII(const char16* src, size_t src_len);
+
+// Returns true if |src| is well-formed UTF-8: no overlong forms, surrogates, code points above U+10FFFF or truncated
+// sequences. With |reject_noncharacters| non-characters are refused as well, see IsValidCharacter().
+bool IsValidUTF8(const char* src, size_t src_len, bool reject_noncharacters);
+
+// Exact number of code units |src| decodes to, |src| must be valid UTF-8.
+size_t UTF16LengthOfValidUTF8(const char* src, size_t src_len);
+size_t UTF32LengthOfValidUTF8(const char* src, size_t src_len);
+
+// Decodes valid UTF-8 into |dest|, which must have room for the length computed above. Returns the number of code
+// units written.
+size_t ConvertValidUTF8(const char* src, size_t src_len, char16* dest);
+#if defined(WCHAR_T_IS_UTF32)
+size_t ConvertValidUTF8(const char* src, size_t src_len, wchar_t* dest);
+#endif
+
+// Computes the exact UTF-8 length of |src|, returns false on an unpaired surrogate.
+bool UTF8LengthOfUTF16(const char16* src, size_t src_len, size_t* utf8_len);
+
+// Encodes UTF-16 accepted by UTF8LengthOfUTF16() into |dest|. Returns the number of bytes written.
+size_t ConvertValidUTF16(const char16* src, size_t src_len, char* dest);
+
+}  // namespace internal
+}  // namespace common
@@ -30,6 +30,8 @@
 #include <common/utf_string_conversion_utils.h>
 #include <common/utf_string_conversions.h>
 
+#include "utf_simd.h"
+
 namespace common {
 
 namespace {
@@ -58,13 +60,58 @@ bool ConvertUnicode(const SRC_CHAR* src, size_t src_len, DEST_STRING* output) {
   return success;
 }
 
+inline size_t DecodedLength(const char* src, size_t src_len, const char16*) {
+  return internal::UTF16LengthOfValidUTF8(src, src_len);
+}
+
+#if defined(WCHAR_T_IS_UTF32)
+inline size_t DecodedLength(const char* src, size_t src_len, const wchar_t*) {
+  return internal::UTF32LengthOfValidUTF8(src, src_len);
+}
+#endif
+
+// Valid input is validated, measured and decoded in bulk straight into an exactly sized output; anything else goes
+// through ConvertUnicode() so that every malformed sequence is replaced the same way as before.
+template <typename DEST_STRING>
+bool ConvertFromUTF8(const char* src, size_t src_len, DEST_STRING* output) {
+  typedef typename DEST_STRING::value_type DEST_CHAR;
+  if (!internal::IsValidUTF8(src, src_len, false)) {
+    PrepareForUTF16Or32Output(src, src_len, output);
+    return ConvertUnicode(src, src_len, output);
+  }
+
+  output->resize(DecodedLength(src, src_len, static_cast<const DEST_CHAR*>(nullptr)));
+  if (!output->empty()) {
+    internal::ConvertValidUTF8(src, src_len, &(*output)[0]);
+  }
+  return true;
+}
+
+bool ConvertFromUTF16(const char16* src, size_t src_len, std::string* output) {
+  size_t utf8_len = 0;
+  if (!internal::UTF8LengthOfUTF16(src, src_len, &utf8_len)) {
+    PrepareForUTF8Output(src, src_len, output);
+    return ConvertUnicode(src, src_len, output);
+  }
+
+  output->resize(utf8_len);
+  if (utf8_len) {
+    internal::ConvertValidUTF16(src, src_len, &(*output)[0]);
+  }
+  return true;
+}
+
 }  // namespace
 
 // UTF-8 <-> Wide --------------------------------------------------------------
 
 bool WideToUTF8(const wchar_t* src, size_t src_len, std::string* output) {
+#if defined(WCHAR_T_IS_UTF16)
+  return ConvertFromUTF16(src, src_len, output);
+#else
   PrepareForUTF8Output(src, src_len, output);
   return ConvertUnicode(src, src_len, output);
+#endif
 }
 
 std::string WideToUTF8(const std::wstring& wide) {
@@ -76,8 +123,7 @@ std::string WideToUTF8(const std::wstring& wide) {
 }
 
 bool UTF8ToWide(const char* src, size_t src_len, std::wstring* output) {
-  PrepareForUTF16Or32Output(src, src_len, output);
-  return ConvertUnicode(src, src_len, output);
+  return ConvertFromUTF8(src, src_len, output);
 }
 
 std::wstring UTF8ToWide(const StringPiece& utf8) {
@@ -146,8 +192,7 @@ std::wstring UTF16ToWide(const string16& utf16) {
 #if defined(UNICODE)
 
 bool UTF8ToUTF16(const char* src, size_t src_len, string16* output) {
-  PrepareForUTF16Or32Output(src, src_len, output);
-  return ConvertUnicode(src, src_len, output);
+  return ConvertFromUTF8(src, src_len, output);
 }
 
 string16 UTF8ToUTF16(const StringPiece& utf8) {
@@ -159,8 +204,7 @@ string16 UTF8ToUTF16(const StringPiece& utf8) {
 }
 
 bool UTF16ToUTF8(const char16* src, size_t src_len, std::string* output) {
-  PrepareForUTF8Output(src, src_len, output);
-  return ConvertUnicode(src, src_len, output);
+  return ConvertFromUTF16(src, src_len, output);
 }
 
 std::string UTF16ToUTF8(const string16& utf16) {
@@ -1057,24 +1057,19 @@ bool HashValue::Equals(const Value* other) const {
     return false;
   }
 
-  const HashValue* other_zset = static_cast<const HashValue*>(other);
-  const_iterator lhs_it, rhs_it;
-  for (lhs_it = begin(), rhs_it = other_zset->begin(); lhs_it != end() && rhs_it != other_zset->end();
-       ++lhs_it, ++rhs_it) {
-    string_t rkey = (*rhs_it).first;
-    Value* rval = (*rhs_it).second;
-    string_t lkey = (*lhs_it).first;
-    Value* lval = (*lhs_it).second;
+  const HashValue* other_hash = static_cast<const HashValue*>(other);
+  if (hash_.size() != other_hash->hash_.size()) {
+    return false;
+  }
 
-    if (lkey != rkey || !lval->Equals(rval)) {
+  // unordered, iteration order of two equal hashes may differ
+  for (const_iterator lhs_it = begin(); lhs_it != end(); ++lhs_it) {
+    const_iterator rhs_it = other_hash->hash_.find(lhs_it->first);
+    if (rhs_it == other_hash->hash_.end() || !lhs_it->second->Equals(rhs_it->second)) {
       return false;
     }
   }
 
-  if (lhs_it != end() || rhs_it != other_zset->end()) {
-    return false;
-  }
-
   return true;
 }
 
@@ -0,0 +1,70 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace common {
+namespace benchmarks {
+
+// Corpora are checked in next to the benchmarks, so that numbers of two
+// builds are comparable.
+inline std::string LoadCorpus(const std::string& name) {
+  std::ifstream file(std::string(PROJECT_BENCHMARK_CORPUS_DIR "/") + name, std::ios::binary);
+  std::stringstream data;
+  data << file.rdbuf();
+  return data.str();
+}
+
+inline std::vector<std::string> SplitCorpus(const std::string& data, const std::string& separator) {
+  std::vector<std::string> result;
+  size_t start = 0;
+  while (start < data.size()) {
+    size_t pos = data.find(separator, start);
+    if (pos == std::string::npos) {
+      pos = data.size();
+    }
+    if (pos != start) {
+      result.push_back(data.substr(start, pos - start));
+    }
+    start = pos + separator.size();
+  }
+  return result;
+}
+
+inline std::vector<std::string> LoadCorpusLines(const std::string& name) {
+  return SplitCorpus(LoadCorpus(name), "\n");
+}
+
+}  // namespace benchmarks
+}  // namespace common
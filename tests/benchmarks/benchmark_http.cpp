@@ -0,0 +1,193 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <common/http/http.h>
+#include <common/http/http2_huffman.h>
+#include <common/string_util.h>
+#include <common/uri/gurl.h>
+#include <common/uri/url_view.h>
+
+#include "benchmark_corpus.h"
+
+namespace {
+
+std::vector<std::string> LoadRequests() {
+  std::vector<std::string> requests = common::benchmarks::SplitCorpus(
+      common::benchmarks::LoadCorpus("http_requests.txt"), "%%\n");
+  for (size_t i = 0; i < requests.size(); ++i) {
+    std::string crlf;
+    common::ReplaceChars(requests[i], "\n", "\r\n", &crlf);
+    requests[i] = crlf;
+  }
+  return requests;
+}
+
+void BM_ParseHttpRequest(benchmark::State& state) {
+  const std::vector<std::string> requests = LoadRequests();
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& raw : requests) {
+      common::http::HttpRequest request;
+      auto result = common::http::parse_http_request(raw, &request);
+      benchmark::DoNotOptimize(result);
+      benchmark::DoNotOptimize(request.GetHeader(common::http::HT_HOST));
+      bytes += raw.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+  state.SetItemsProcessed(state.iterations() * requests.size());
+}
+BENCHMARK(BM_ParseHttpRequest);
+
+const char* const kRequestUrls[] = {"/index.html", "/api/v1/streams/42?fields=name,status&limit=20",
+                                    "https://api.example.com:8443/media/upload?id=634b73204d946566900b7c13#part",
+                                    "rtmp://live.example.com/app/stream_key"};
+
+void BM_GURLPathForRequest(benchmark::State& state) {
+  for (auto _ : state) {
+    for (const char* url : kRequestUrls) {
+      const common::uri::GURL gurl(url);
+      benchmark::DoNotOptimize(gurl.is_valid() ? gurl.PathForRequestPiece() : common::StringPiece());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * arraysize(kRequestUrls));
+}
+BENCHMARK(BM_GURLPathForRequest);
+
+void BM_UrlViewPathForRequest(benchmark::State& state) {
+  for (auto _ : state) {
+    for (const char* url : kRequestUrls) {
+      const common::uri::UrlView view(url);
+      benchmark::DoNotOptimize(view.PathForRequestPiece());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * arraysize(kRequestUrls));
+}
+BENCHMARK(BM_UrlViewPathForRequest);
+
+void BM_HttpHeaderLookup(benchmark::State& state) {
+  const std::vector<std::string> requests = LoadRequests();
+  std::vector<common::http::HttpRequest> parsed(requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    auto result = common::http::parse_http_request(requests[i], &parsed[i]);
+    benchmark::DoNotOptimize(result);
+  }
+
+  const char* keys[] = {"Host", "content-length", "Connection", "Upgrade", "Sec-WebSocket-Key", "X-Request-Id"};
+  for (auto _ : state) {
+    for (const auto& request : parsed) {
+      for (const char* key : keys) {
+        common::http::header_t header;
+        benchmark::DoNotOptimize(request.FindHeaderByKey(key, false, &header));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * parsed.size() * arraysize(keys));
+}
+BENCHMARK(BM_HttpHeaderLookup);
+
+void BM_Http2HuffmanEncode(benchmark::State& state) {
+  const std::vector<std::string> strings = common::benchmarks::LoadCorpusLines("hpack_strings.txt");
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& str : strings) {
+      common::buffer_t out;
+      benchmark::DoNotOptimize(common::http2::http2_huffman_encode(
+          out, reinterpret_cast<const uint8_t*>(str.data()), static_cast<uint32_t>(str.size())));
+      bytes += str.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_Http2HuffmanEncode);
+
+void BM_Http2HuffmanDecode(benchmark::State& state) {
+  const std::vector<std::string> strings = common::benchmarks::LoadCorpusLines("hpack_strings.txt");
+  std::vector<common::buffer_t> encoded(strings.size());
+  for (size_t i = 0; i < strings.size(); ++i) {
+    common::http2::http2_huffman_encode(encoded[i], reinterpret_cast<const uint8_t*>(strings[i].data()),
+                                        static_cast<uint32_t>(strings[i].size()));
+  }
+
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const common::buffer_t& enc : encoded) {
+      common::http2::http2_hd_huff_decode_context ctx;
+      common::http2::http2_huffman_decode_context_init(&ctx);
+      common::buffer_t out;
+      benchmark::DoNotOptimize(
+          common::http2::http2_huffman_decode(&ctx, out, enc.data(), static_cast<uint32_t>(enc.size()), 1));
+      bytes += enc.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_Http2HuffmanDecode);
+
+// Paths of a static file server, mixed case and one unknown extension.
+const char* const kStaticPaths[] = {"/index.html", "/css/site.css", "/js/app.js",  "/img/logo.PNG",
+                                    "/img/photo.jpeg", "/fonts/font.woff2", "/video/clip.mp4", "/data/dump.xyz"};
+
+void BM_MimeTypesGetType(benchmark::State& state) {
+  for (auto _ : state) {
+    for (const char* path : kStaticPaths) {
+      benchmark::DoNotOptimize(common::http::MimeTypes::GetType(path));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * arraysize(kStaticPaths));
+}
+BENCHMARK(BM_MimeTypesGetType);
+
+void BM_MimeTypesGetExtension(benchmark::State& state) {
+  const char* const types[] = {"text/html", "text/css", "application/javascript", "image/png",
+                               "image/jpeg", "font/woff2", "video/mp4", "application/x-unknown"};
+  for (auto _ : state) {
+    for (const char* type : types) {
+      benchmark::DoNotOptimize(common::http::MimeTypes::GetExtension(type));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * arraysize(types));
+}
+BENCHMARK(BM_MimeTypesGetExtension);
+
+void BM_ConvertFromStringHttpMethod(benchmark::State& state) {
+  const std::string methods[] = {"GET", "HEAD", "POST", "PUT"};
+  for (auto _ : state) {
+    for (const std::string& method : methods) {
+      common::http::http_method out;
+      benchmark::DoNotOptimize(common::ConvertFromString(method, &out));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * arraysize(methods));
+}
+BENCHMARK(BM_ConvertFromStringHttpMethod);
+
+}  // namespace
@@ -0,0 +1,79 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <common/protocols/json_rpc/json_rpc.h>
+
+#include "benchmark_corpus.h"
+
+namespace {
+
+void BM_JsonRPCParseRequest(benchmark::State& state) {
+  const std::vector<std::string> messages = common::benchmarks::LoadCorpusLines("json_rpc.txt");
+  size_t bytes = 0;
+  for (auto _ : state) {
+    for (const std::string& message : messages) {
+      common::protocols::json_rpc::JsonRPCRequest request;
+      common::Error err = common::protocols::json_rpc::ParseJsonRPCRequest(message, &request);
+      benchmark::DoNotOptimize(err);
+      bytes += message.size();
+    }
+  }
+  state.SetBytesProcessed(bytes);
+  state.SetItemsProcessed(state.iterations() * messages.size());
+}
+BENCHMARK(BM_JsonRPCParseRequest);
+
+void BM_JsonRPCMakeRequest(benchmark::State& state) {
+  const std::vector<std::string> messages = common::benchmarks::LoadCorpusLines("json_rpc.txt");
+  std::vector<common::protocols::json_rpc::JsonRPCRequest> requests;
+  for (const std::string& message : messages) {
+    common::protocols::json_rpc::JsonRPCRequest request;
+    common::Error err = common::protocols::json_rpc::ParseJsonRPCRequest(message, &request);
+    if (err) {
+      state.SkipWithError(err->GetDescription().c_str());
+      return;
+    }
+    requests.push_back(request);
+  }
+
+  for (auto _ : state) {
+    for (const auto& request : requests) {
+      std::string out;
+      common::Error err = common::protocols::json_rpc::MakeJsonRPCRequest(request, &out);
+      benchmark::DoNotOptimize(err);
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * requests.size());
+}
+BENCHMARK(BM_JsonRPCMakeRequest);
+
+}  // namespace
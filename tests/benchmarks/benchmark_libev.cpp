@@ -0,0 +1,392 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <common/libev/event_loop.h>
+#include <common/libev/io_loop_observer.h>
+#include <common/libev/tcp/tcp_client.h>
+#include <common/libev/tcp/tcp_server.h>
+#include <common/libev/websocket/websocket_client.h>
+#include <common/libev/websocket/websocket_server.h>
+#include <common/net/socket_tcp.h>
+#include <common/threads/thread_context.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace {
+
+class ReadyLoopObserver : public common::libev::EvLoopObserver {
+ public:
+  void PreLooped(common::libev::LibEvLoop* loop) override { UNUSED(loop); }
+  void Started(common::libev::LibEvLoop* loop) override {
+    UNUSED(loop);
+    ready.set_value();
+  }
+  void Stopped(common::libev::LibEvLoop* loop) override { UNUSED(loop); }
+  void PostLooped(common::libev::LibEvLoop* loop) override { UNUSED(loop); }
+  void TimerEmited(common::libev::LibEvLoop* loop, common::libev::timer_id_t id) override {
+    UNUSED(loop);
+    UNUSED(id);
+  }
+
+  std::promise<void> ready;
+};
+
+void BM_ExecInLoopThreadLatency(benchmark::State& state) {
+  ReadyLoopObserver observer;
+  common::libev::LibEvLoop loop;
+  loop.SetObserver(&observer);
+  std::thread loop_thread([&loop]() { ignore_result(loop.Exec()); });
+  observer.ready.get_future().wait();
+
+  for (auto _ : state) {
+    std::atomic<bool> done(false);
+    loop.ExecInLoopThread([&done]() { done.store(true, std::memory_order_release); });
+    while (!done.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  loop.Stop();
+  loop_thread.join();
+}
+BENCHMARK(BM_ExecInLoopThreadLatency)->UseRealTime();
+
+void BM_GetCurrentIdSyscall(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(common::threads::PlatformThread::GetCurrentId());
+  }
+}
+BENCHMARK(BM_GetCurrentIdSyscall);
+
+void BM_CurrentThreadIdCached(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(common::threads::CurrentThreadId());
+  }
+}
+BENCHMARK(BM_CurrentThreadIdCached);
+
+// Timer registration does two loop thread checks per round trip, like RegisterClient/CloseClient.
+void BM_CreateRemoveTimer(benchmark::State& state) {
+  ReadyLoopObserver observer;
+  common::libev::LibEvLoop loop;
+  loop.SetObserver(&observer);
+  std::thread loop_thread([&loop]() { ignore_result(loop.Exec()); });
+  observer.ready.get_future().wait();
+
+  std::promise<void> done;
+  loop.ExecInLoopThread([&loop, &state, &done]() {
+    for (auto _ : state) {
+      common::libev::timer_id_t id = loop.CreateTimer(60, false);
+      loop.RemoveTimer(id);
+    }
+    done.set_value();
+  });
+  done.get_future().wait();
+
+  loop.Stop();
+  loop_thread.join();
+}
+BENCHMARK(BM_CreateRemoveTimer);
+
+// Writes back everything a client sends.
+class EchoHandler : public common::libev::IoLoopObserver {
+ public:
+  void PreLooped(common::libev::IoLoop* server) override {
+    UNUSED(server);
+    ready.set_value();
+  }
+
+  void Accepted(common::libev::IoClient* client) override { UNUSED(client); }
+  void Moved(common::libev::IoLoop* server, common::libev::IoClient* client) override {
+    UNUSED(server);
+    UNUSED(client);
+  }
+  void Closed(common::libev::IoClient* client) override { UNUSED(client); }
+  void TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) override {
+    UNUSED(server);
+    UNUSED(id);
+  }
+  void Accepted(common::libev::IoChild* child) override { UNUSED(child); }
+  void Moved(common::libev::IoLoop* server, common::libev::IoChild* child) override {
+    UNUSED(server);
+    UNUSED(child);
+  }
+  void ChildStatusChanged(common::libev::IoChild* child, int status, int signal) override {
+    UNUSED(child);
+    UNUSED(status);
+    UNUSED(signal);
+  }
+
+  void DataReceived(common::libev::IoClient* client) override {
+    char buff[64 * 1024];
+    size_t nread = 0;
+    common::ErrnoError err = client->SingleRead(buff, sizeof(buff), &nread);
+    if (err || nread == 0) {
+      ignore_result(client->Close());
+      delete client;
+      return;
+    }
+
+    size_t nwrite = 0;
+    err = client->Write(buff, nread, &nwrite);
+    if (err) {
+      ignore_result(client->Close());
+      delete client;
+    }
+  }
+  void DataReadyToWrite(common::libev::IoClient* client) override { UNUSED(client); }
+  void WriteQueueHigh(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void WriteQueueLow(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+
+  void Accepted(common::libev::AsyncIoClient* client) override { UNUSED(client); }
+  void Moved(common::libev::IoLoop* server, common::libev::AsyncIoClient* client) override {
+    UNUSED(server);
+    UNUSED(client);
+  }
+  void Closed(common::libev::AsyncIoClient* client) override { UNUSED(client); }
+  void AsyncDataWriteCompleted(common::libev::AsyncIoClient* client, size_t bytes_written) override {
+    UNUSED(client);
+    UNUSED(bytes_written);
+  }
+  void AsyncDataReadCompleted(common::libev::AsyncIoClient* client, size_t bytes_read) override {
+    UNUSED(client);
+    UNUSED(bytes_read);
+  }
+  void AsyncWriteQueueHigh(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void AsyncWriteQueueLow(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+
+  void PostLooped(common::libev::IoLoop* server) override { UNUSED(server); }
+
+  std::promise<void> ready;
+};
+
+void BM_TcpEchoThroughput(benchmark::State& state) {
+  EchoHandler handler;
+  auto sock = new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT));
+  common::libev::tcp::TcpServer server(sock, false, &handler);
+  if (server.Bind(true) || server.Listen(5)) {
+    state.SkipWithError("can't listen");
+    return;
+  }
+
+  std::thread server_thread([&server]() { ignore_result(server.Exec()); });
+  handler.ready.get_future().wait();
+
+  common::net::ClientSocketTcp client(server.GetHost());
+  if (client.Connect()) {
+    state.SkipWithError("can't connect");
+    server.Stop();
+    server_thread.join();
+    return;
+  }
+
+  const std::string message(state.range(0), 'x');
+  std::string reply(message.size(), 0);
+  for (auto _ : state) {
+    size_t nwrite = 0;
+    if (client.Write(message.data(), message.size(), &nwrite) || nwrite != message.size()) {
+      state.SkipWithError("write failed");
+      break;
+    }
+
+    size_t total = 0;
+    while (total < reply.size()) {
+      size_t nread = 0;
+      if (client.Read(&reply[total], reply.size() - total, &nread) || nread == 0) {
+        state.SkipWithError("read failed");
+        break;
+      }
+      total += nread;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * message.size() * 2);
+
+  ignore_result(client.Close());
+  server.Stop();
+  server_thread.join();
+}
+BENCHMARK(BM_TcpEchoThroughput)->Arg(64)->Arg(4 * 1024)->Arg(32 * 1024)->UseRealTime();
+
+// Upgrades the connection and echoes every frame back, unmasked as a server sends it.
+class WebSocketEchoHandler : public EchoHandler {
+ public:
+  void DataReceived(common::libev::IoClient* client) override {
+    auto* wclient = static_cast<common::libev::websocket::WebSocketServerClient*>(client);
+    common::ErrnoError err = wclient->Step() == common::libev::websocket::ZERO ? Upgrade(wclient) : Echo(wclient);
+    if (err) {
+      ignore_result(client->Close());
+      delete client;
+    }
+  }
+
+ private:
+  static common::ErrnoError Upgrade(common::libev::websocket::WebSocketServerClient* client) {
+    // the benchmark client sends the whole handshake with one write
+    char buff[4096];
+    size_t nread = 0;
+    common::ErrnoError err = client->SingleRead(buff, sizeof(buff), &nread);
+    if (err) {
+      return err;
+    }
+
+    common::http::HttpRequest request;
+    std::pair<common::http::http_status, common::Error> result =
+        common::http::parse_http_request(std::string(buff, nread), &request);
+    const common::http::header_t* key = request.GetHeader(common::http::HT_SEC_WEBSOCKET_KEY);
+    if (result.second || !key) {
+      return common::make_errno_error_inval();
+    }
+    return client->SendSwitchProtocolsResponse(key->value, common::http::headers_t(),
+                                               common::libev::http::HttpServerInfo());
+  }
+
+  static common::ErrnoError Echo(common::libev::websocket::WebSocketServerClient* client) {
+    common::ErrnoError send_err;
+    common::ErrnoError err = client->ProcessFrame([client, &send_err](char* data, size_t size) {
+      if (!send_err) {
+        send_err = client->SendFrame(data, size);
+      }
+    });
+    return err ? err : send_err;
+  }
+};
+
+// Masked text frame as a client sends it, payloads below 64K.
+std::string MakeClientFrame(const std::string& payload) {
+  const char key[4] = {0x12, 0x34, 0x56, 0x78};
+  std::string frame(1, '\x81');
+  if (payload.size() < 126) {
+    frame += static_cast<char>(0x80 | payload.size());
+  } else {
+    frame += static_cast<char>(0x80 | 126);
+    frame += static_cast<char>(payload.size() >> 8);
+    frame += static_cast<char>(payload.size() & 0xff);
+  }
+  frame.append(key, sizeof(key));
+  for (size_t i = 0; i < payload.size(); ++i) {
+    frame += static_cast<char>(payload[i] ^ key[i % 4]);
+  }
+  return frame;
+}
+
+bool ReadExactly(common::net::ClientSocketTcp* client, char* out, size_t size) {
+  size_t total = 0;
+  while (total < size) {
+    size_t nread = 0;
+    if (client->Read(out + total, size - total, &nread) || nread == 0) {
+      return false;
+    }
+    total += nread;
+  }
+  return true;
+}
+
+void BM_WebSocketEchoThroughput(benchmark::State& state) {
+  WebSocketEchoHandler handler;
+  auto sock = new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT));
+  common::libev::websocket::WebSocketServer server(sock, false, &handler);
+  if (server.Bind(true) || server.Listen(5)) {
+    state.SkipWithError("can't listen");
+    return;
+  }
+
+  std::thread server_thread([&server]() { ignore_result(server.Exec()); });
+  handler.ready.get_future().wait();
+
+  common::net::ClientSocketTcp client(server.GetHost());
+  if (client.Connect()) {
+    state.SkipWithError("can't connect");
+    server.Stop();
+    server_thread.join();
+    return;
+  }
+
+  const std::string handshake =
+      "GET /echo HTTP/1.1\r\n"
+      "Host: localhost\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+      "Sec-WebSocket-Version: 13\r\n\r\n";
+  size_t nwrite = 0;
+  std::string response;
+  if (!client.Write(handshake.data(), handshake.size(), &nwrite)) {
+    char buff[1024];
+    size_t nread = 0;
+    while (response.find("\r\n\r\n") == std::string::npos && !client.Read(buff, sizeof(buff), &nread) && nread) {
+      response.append(buff, nread);
+    }
+  }
+  if (response.find(" 101 ") == std::string::npos) {
+    state.SkipWithError("handshake failed");
+    ignore_result(client.Close());
+    server.Stop();
+    server_thread.join();
+    return;
+  }
+
+  const std::string message(state.range(0), 'x');
+  const std::string frame = MakeClientFrame(message);
+  // unmasked reply: 2 byte header, 2 more for the 16 bit length
+  std::string reply((message.size() < 126 ? 2 : 4) + message.size(), 0);
+  for (auto _ : state) {
+    if (client.Write(frame.data(), frame.size(), &nwrite) || nwrite != frame.size()) {
+      state.SkipWithError("write failed");
+      break;
+    }
+    if (!ReadExactly(&client, &reply[0], reply.size())) {
+      state.SkipWithError("read failed");
+      break;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * message.size() * 2);
+
+  ignore_result(client.Close());
+  server.Stop();
+  server_thread.join();
+}
+BENCHMARK(BM_WebSocketEchoThroughput)->Arg(64)->Arg(4 * 1024)->Arg(32 * 1024)->UseRealTime();
+
+}  // namespace
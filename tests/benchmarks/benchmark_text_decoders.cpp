@@ -0,0 +1,96 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <common/text_decoders/iedcoder.h>
+#include <common/text_decoders/iedcoder_factory.h>
+
+#include <memory>
+
+#include "benchmark_corpus.h"
+
+namespace {
+
+std::unique_ptr<common::IEDcoder> MakeCoder(benchmark::State& state) {
+  const common::EDType type = static_cast<common::EDType>(state.range(0));
+  state.SetLabel(common::ConvertToString(type));
+  return std::unique_ptr<common::IEDcoder>(common::CreateEDCoder(type));
+}
+
+void BM_EDcoderEncode(benchmark::State& state) {
+  const std::unique_ptr<common::IEDcoder> coder = MakeCoder(state);
+  const std::string text = common::benchmarks::LoadCorpus("text.txt");
+  if (!coder) {
+    state.SkipWithError("not available");
+    return;
+  }
+
+  for (auto _ : state) {
+    common::char_buffer_t out;
+    common::Error err = coder->Encode(text, &out);
+    if (err) {
+      state.SkipWithError(err->GetDescription().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_EDcoderEncode)->DenseRange(common::ED_NONE, common::ENCODER_DECODER_NUM_TYPES - 1);
+
+void BM_EDcoderDecode(benchmark::State& state) {
+  const std::unique_ptr<common::IEDcoder> coder = MakeCoder(state);
+  const std::string text = common::benchmarks::LoadCorpus("text.txt");
+  if (!coder) {
+    state.SkipWithError("not available");
+    return;
+  }
+
+  common::char_buffer_t encoded;
+  common::Error err = coder->Encode(text, &encoded);
+  if (err) {
+    state.SkipWithError(err->GetDescription().c_str());
+    return;
+  }
+
+  for (auto _ : state) {
+    common::char_buffer_t out;
+    err = coder->Decode(encoded, &out);
+    if (err) {
+      state.SkipWithError(err->GetDescription().c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_EDcoderDecode)->DenseRange(common::ED_NONE, common::ENCODER_DECODER_NUM_TYPES - 1);
+
+}  // namespace
@@ -0,0 +1,112 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <common/threads/event.h>
+#include <common/threads/thread_pool.h>
+#include <common/threads/ts_queue.h>
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+void BM_TsQueueThroughput(benchmark::State& state) {
+  const int count = static_cast<int>(state.range(0));
+  common::threads::ts_queue<int> queue;
+  for (auto _ : state) {
+    std::thread producer([&queue, count]() {
+      for (int i = 0; i < count; ++i) {
+        queue.Push(i);
+      }
+    });
+
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+      queue.Pop(&value);
+    }
+    benchmark::DoNotOptimize(value);
+    producer.join();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_TsQueueThroughput)->Arg(1 << 14)->UseRealTime();
+
+void BM_ThreadPoolThroughput(benchmark::State& state) {
+  const size_t tasks = 1 << 14;
+  common::threads::ThreadPool pool;
+  pool.Start(state.range(0));
+  for (auto _ : state) {
+    std::atomic<size_t> done(0);
+    for (size_t i = 0; i < tasks; ++i) {
+      pool.Post([&done]() { done.fetch_add(1, std::memory_order_relaxed); });
+    }
+    while (done.load(std::memory_order_relaxed) != tasks) {
+      std::this_thread::yield();
+    }
+  }
+  pool.Stop();
+  state.SetItemsProcessed(state.iterations() * tasks);
+}
+BENCHMARK(BM_ThreadPoolThroughput)->Arg(1)->Arg(4)->UseRealTime();
+
+void BM_EventSetWaitUncontended(benchmark::State& state) {
+  common::threads::Event event(0, 0);
+  for (auto _ : state) {
+    event.Set();
+    benchmark::DoNotOptimize(event.Wait(0));
+  }
+}
+BENCHMARK(BM_EventSetWaitUncontended);
+
+void BM_EventPingPong(benchmark::State& state) {
+  common::threads::Event ping(0, 0);
+  common::threads::Event pong(0, 0);
+  std::atomic<bool> stop(false);
+  std::thread peer([&]() {
+    while (true) {
+      ping.Wait(INFINITE_TIMEOUT_MSEC);
+      if (stop.load()) {
+        break;
+      }
+      pong.Set();
+    }
+  });
+  for (auto _ : state) {
+    ping.Set();
+    pong.Wait(INFINITE_TIMEOUT_MSEC);
+  }
+  stop = true;
+  ping.Set();
+  peer.join();
+}
+BENCHMARK(BM_EventPingPong)->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,109 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <common/string_util.h>
+#include <common/utf_string_conversions.h>
+
+#include <string>
+
+#include "benchmark_corpus.h"
+
+namespace {
+
+// ASCII-heavy prose, CJK (3 byte sequences) and emoji (4 byte sequences, surrogate pairs in UTF-16).
+const char* const kCorpora[] = {"text.txt", "cjk.txt", "emoji.txt"};
+
+std::string LoadUTF8Corpus(benchmark::State& state) {
+  const char* name = kCorpora[state.range(0)];
+  state.SetLabel(name);
+  return common::benchmarks::LoadCorpus(name);
+}
+
+void BM_IsStringASCII(benchmark::State& state) {
+  const std::string text = LoadUTF8Corpus(state);
+  // Only the ASCII bytes of the corpus, so that the whole input is scanned.
+  std::string ascii;
+  for (char c : text) {
+    if (static_cast<unsigned char>(c) < 0x80) {
+      ascii.push_back(c);
+    }
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(common::IsStringASCII(ascii));
+  }
+  state.SetBytesProcessed(state.iterations() * ascii.size());
+}
+BENCHMARK(BM_IsStringASCII)->Arg(0);
+
+void BM_IsStringUTF8(benchmark::State& state) {
+  const std::string text = LoadUTF8Corpus(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(common::IsStringUTF8(text));
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_IsStringUTF8)->DenseRange(0, 2);
+
+void BM_UTF8ToUTF16(benchmark::State& state) {
+  const std::string text = LoadUTF8Corpus(state);
+  for (auto _ : state) {
+    common::string16 out;
+    benchmark::DoNotOptimize(common::UTF8ToUTF16(text.data(), text.size(), &out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF8ToUTF16)->DenseRange(0, 2);
+
+void BM_UTF16ToUTF8(benchmark::State& state) {
+  const std::string text = LoadUTF8Corpus(state);
+  const common::string16 utf16 = common::UTF8ToUTF16(text);
+  for (auto _ : state) {
+    std::string out;
+    benchmark::DoNotOptimize(common::UTF16ToUTF8(utf16.data(), utf16.size(), &out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF16ToUTF8)->DenseRange(0, 2);
+
+void BM_UTF8ToWide(benchmark::State& state) {
+  const std::string text = LoadUTF8Corpus(state);
+  for (auto _ : state) {
+    std::wstring out;
+    benchmark::DoNotOptimize(common::UTF8ToWide(text.data(), text.size(), &out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_UTF8ToWide)->DenseRange(0, 2);
+
+}  // namespace
@@ -0,0 +1,83 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <common/value.h>
+
+#include <memory>
+
+#include "benchmark_corpus.h"
+
+namespace {
+
+// Hash of |width| entries, each an array of scalars and a nested hash, |depth| levels deep.
+common::Value* MakeTree(const std::vector<std::string>& words, size_t width, size_t depth, size_t* seed) {
+  common::HashValue* hash = common::Value::CreateHashValue();
+  for (size_t i = 0; i < width; ++i) {
+    const std::string& key = words[(*seed)++ % words.size()];
+    common::ArrayValue* array = common::Value::CreateArrayValue();
+    array->AppendInteger(static_cast<int>(*seed));
+    array->AppendDouble(static_cast<double>(*seed) / 7);
+    array->AppendBoolean(*seed % 2 == 0);
+    array->AppendBasicString(words[(*seed)++ % words.size()]);
+    if (depth > 1) {
+      array->Append(MakeTree(words, width, depth - 1, seed));
+    }
+    hash->Insert(key + std::to_string(i), array);
+  }
+  return hash;
+}
+
+std::unique_ptr<common::Value> MakeCorpusTree(size_t width, size_t depth) {
+  const std::vector<std::string> words =
+      common::benchmarks::SplitCorpus(common::benchmarks::LoadCorpus("text.txt"), " ");
+  size_t seed = 0;
+  return std::unique_ptr<common::Value>(MakeTree(words, width, depth, &seed));
+}
+
+void BM_ValueDeepCopy(benchmark::State& state) {
+  const std::unique_ptr<common::Value> tree = MakeCorpusTree(state.range(0), state.range(1));
+  for (auto _ : state) {
+    std::unique_ptr<common::Value> copy(tree->DeepCopy());
+    benchmark::DoNotOptimize(copy.get());
+  }
+}
+BENCHMARK(BM_ValueDeepCopy)->Args({8, 2})->Args({8, 4})->Args({32, 2});
+
+void BM_ValueEquals(benchmark::State& state) {
+  const std::unique_ptr<common::Value> tree = MakeCorpusTree(state.range(0), state.range(1));
+  const std::unique_ptr<common::Value> copy(tree->DeepCopy());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tree->Equals(copy.get()));
+  }
+}
+BENCHMARK(BM_ValueEquals)->Args({8, 2})->Args({8, 4})->Args({32, 2});
+
+}  // namespace
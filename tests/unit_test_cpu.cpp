@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 
 #include <common/system_info/cpu_info.h>
+#include <common/system_info/cpu_topology.h>
+#include <common/threads/thread_placement.h>
+
+#include <thread>
 
 TEST(Cpu, CurrentCpuInfo) {
   const auto c1 = common::system_info::CPU();
@@ -10,3 +14,94 @@ TEST(Cpu, CurrentCpuInfo) {
 
   GTEST_ASSERT_EQ(c1_br, c2_br);
 }
+
+TEST(Cpu, Features) {
+  const auto cpu = common::system_info::CPU();
+#if defined(ARCH_CPU_X86_64)
+  ASSERT_TRUE(cpu.has_sse2());
+  ASSERT_NE(cpu.GetFeatures().find("sse2"), std::string::npos);
+#endif
+  if (cpu.has_avx2()) {
+    ASSERT_TRUE(cpu.has_avx());
+  }
+}
+
+TEST(Cpu, ParseCpuList) {
+  std::vector<common::lcpu_count_t> cpus;
+  ASSERT_TRUE(common::system_info::ParseCpuList("0-3,8,10-11", &cpus));
+  ASSERT_EQ(cpus, std::vector<common::lcpu_count_t>({0, 1, 2, 3, 8, 10, 11}));
+  ASSERT_TRUE(common::system_info::ParseCpuList("5\n", &cpus));
+  ASSERT_EQ(cpus, std::vector<common::lcpu_count_t>({5}));
+  ASSERT_FALSE(common::system_info::ParseCpuList("3-1", &cpus));
+  ASSERT_FALSE(common::system_info::ParseCpuList("a", &cpus));
+}
+
+namespace {
+
+// Two sockets, one NUMA node each, 2 cores with 2 hardware threads per socket. Like on most x86 boxes the SMT
+// siblings of cpu N are N + 4 and core ids restart in every package.
+common::system_info::CpuTopology DualSocketTopology() {
+  std::vector<common::system_info::LogicalCpu> cpus;
+  for (common::lcpu_count_t id = 0; id < 8; ++id) {
+    const size_t package = (id % 4) / 2;
+    cpus.push_back({id, id % 2, package, package, 0});
+  }
+  return common::system_info::CpuTopology(cpus);
+}
+
+}  // namespace
+
+TEST(Cpu, Topology) {
+  const auto topology = DualSocketTopology();
+  ASSERT_EQ(topology.GetLogicalCpusCount(), 8);
+  ASSERT_EQ(topology.GetPhysicalCoresCount(), 4);
+  ASSERT_EQ(topology.GetPackagesCount(), 2);
+  ASSERT_EQ(topology.GetNumaNodesCount(), 2);
+  ASSERT_EQ(topology.GetNumaNodeCpus(1), std::vector<common::lcpu_count_t>({2, 3, 6, 7}));
+  ASSERT_EQ(topology.GetCoreCpus(topology.FindCpu(5)->core), std::vector<common::lcpu_count_t>({1, 5}));
+  ASSERT_EQ(topology.FindCpu(5)->smt_index, 1);
+
+  const auto& current = common::system_info::CpuTopology::Current();
+  ASSERT_GE(current.GetLogicalCpusCount(), 1);
+  ASSERT_GE(current.GetPhysicalCoresCount(), 1);
+  ASSERT_LE(current.GetPhysicalCoresCount(), current.GetLogicalCpusCount());
+  ASSERT_GE(current.GetNumaNodesCount(), 1);
+}
+
+TEST(Cpu, Placement) {
+  using common::threads::MakeThreadPlacement;
+  const auto topology = DualSocketTopology();
+
+  // siblings first, then the next core of the same node
+  ASSERT_EQ(MakeThreadPlacement(topology, common::threads::PLACEMENT_COMPACT, 0).cpus,
+            std::vector<common::lcpu_count_t>({0}));
+  ASSERT_EQ(MakeThreadPlacement(topology, common::threads::PLACEMENT_COMPACT, 1).cpus,
+            std::vector<common::lcpu_count_t>({4}));
+  ASSERT_EQ(MakeThreadPlacement(topology, common::threads::PLACEMENT_COMPACT, 2).cpus,
+            std::vector<common::lcpu_count_t>({1}));
+
+  // alternate nodes, no SMT sibling until every core is used
+  std::vector<common::lcpu_count_t> spread;
+  for (size_t i = 0; i < 4; ++i) {
+    const auto placement = MakeThreadPlacement(topology, common::threads::PLACEMENT_SPREAD, i);
+    ASSERT_EQ(placement.cpus.size(), 1);
+    ASSERT_EQ(placement.numa_node, i % 2);
+    spread.push_back(placement.cpus[0]);
+  }
+  ASSERT_EQ(spread, std::vector<common::lcpu_count_t>({0, 2, 1, 3}));
+
+  const auto core = MakeThreadPlacement(topology, common::threads::PLACEMENT_PHYSICAL_CORE, 1);
+  ASSERT_EQ(core.cpus, std::vector<common::lcpu_count_t>({2, 6}));
+  ASSERT_EQ(core.numa_node, 1);
+
+  const auto node = MakeThreadPlacement(topology, common::threads::PLACEMENT_NUMA_NODE, 2);
+  ASSERT_EQ(node.cpus, std::vector<common::lcpu_count_t>({0, 1, 4, 5}));
+  ASSERT_EQ(node.numa_node, 0);
+
+  ASSERT_FALSE(MakeThreadPlacement(topology, common::threads::PLACEMENT_NONE, 0).IsPinned());
+
+  // pinning to the CPUs the process may already use always works
+  const auto current = MakeThreadPlacement(common::threads::PLACEMENT_NUMA_NODE, 0);
+  std::thread worker([&current]() { ASSERT_TRUE(common::threads::ApplyThreadPlacement(current)); });
+  worker.join();
+}
@@ -29,10 +29,15 @@
 
 #include <gtest/gtest.h>
 
+#include <fcntl.h>
+
 #include <common/convert2string.h>
+#include <common/file_system/file_system.h>
+#include <common/hash/digest.h>
 #include <common/hash/md5.h>
 #include <common/hash/sha1.h>
 #include <common/hash/sha256.h>
+#include <common/utils.h>
 
 TEST(hash, md5) {
   common::hash::MD5_CTX ctx;
@@ -80,3 +85,70 @@ TEST(hash, sha256) {
   ASSERT_TRUE(is_ok);
   ASSERT_EQ(hexed, "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08");
 }
+
+TEST(hash, sha_multiblock) {
+  const std::string two_blocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  common::hash::Digest sha1(common::hash::Digest::SHA1);
+  sha1.Update(two_blocks.data(), two_blocks.size());
+  ASSERT_EQ(sha1.FinalHex(), "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+
+  common::hash::Digest sha256(common::hash::Digest::SHA256);
+  sha256.Update(two_blocks.data(), two_blocks.size());
+  ASSERT_EQ(sha256.FinalHex(), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+  // million 'a' fed in odd sized chunks crosses every buffering branch
+  const std::string chunk(997, 'a');
+  size_t left = 1000000;
+  while (left) {
+    const size_t len = std::min(left, chunk.size());
+    sha1.Update(chunk.data(), len);
+    sha256.Update(chunk.data(), len);
+    left -= len;
+  }
+  ASSERT_EQ(sha1.FinalHex(), "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+  ASSERT_EQ(sha256.FinalHex(), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST(hash, crc64) {
+  const common::buffer_t check = MAKE_BUFFER("123456789");
+  ASSERT_EQ(common::utils::hash::crc64(0, check), UINT64_C(0xe9c6d914c4b8d9ca));
+
+  common::buffer_t data;
+  for (size_t i = 0; i < 1031; ++i) {
+    data.push_back(static_cast<common::byte_t>(i * 31 + 7));
+  }
+  uint64_t bytewise = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    bytewise = common::utils::hash::crc64(bytewise, &data[i], 1);
+  }
+  ASSERT_EQ(common::utils::hash::crc64(0, data), bytewise);
+
+  common::hash::Digest crc(common::hash::Digest::CRC64);
+  crc.Update(check);
+  ASSERT_EQ(crc.FinalHex(), "e9c6d914c4b8d9ca");
+}
+
+TEST(hash, digest_from_descriptor) {
+  const std::string path = PROJECT_TEST_SOURCES_DIR "/unit_test_hash.cpp";
+  std::string contents;
+  ASSERT_TRUE(common::file_system::read_file_to_string(path, &contents));
+
+  const common::hash::Digest::Type types[] = {common::hash::Digest::MD5, common::hash::Digest::SHA1,
+                                              common::hash::Digest::SHA256, common::hash::Digest::CRC64};
+  for (auto type : types) {
+    common::hash::Digest whole(type);
+    whole.Update(contents.data(), contents.size());
+    const common::buffer_t expected = whole.Final();
+    ASSERT_EQ(expected.size(), whole.GetLength());
+
+    descriptor_t fd = INVALID_DESCRIPTOR;
+    common::ErrnoError err = common::file_system::open_descriptor(path, O_RDONLY, &fd);
+    ASSERT_FALSE(err);
+    common::hash::Digest streamed(type);
+    err = streamed.UpdateFromDescriptor(fd, nullptr, contents.size());
+    ASSERT_FALSE(err);
+    ASSERT_EQ(streamed.Final(), expected);
+    err = common::file_system::close_descriptor(fd);
+    ASSERT_FALSE(err);
+  }
+}
@@ -31,6 +31,9 @@
 #include <common/file_system/file_system.h>
 #include <common/http/http2.h>
 #include <common/net/http_client.h>
+#include <common/net/socket_tcp.h>
+#include <common/string_util.h>
+#include <common/threads/thread_manager.h>
 #include <gtest/gtest.h>
 
 using namespace common;
@@ -114,6 +117,22 @@ TEST(Http, parse_GET) {
   ASSERT_TRUE(r5.GetBody().empty());
 }
 
+TEST(Http, parse_canonical_path) {
+  // the target reaches the handlers canonicalised, dot segments can't leave the root
+  const std::pair<std::string, std::string> targets[] = {
+      {"/static/../../etc/passwd", "/etc/passwd"},
+      {"/static/%2e%2e/%2E%2E/etc/passwd", "/etc/passwd"},
+      {"/a/./b/../c?x=../y", "/a/c?x=../y"},
+      {"/a b", "/a%20b"}};
+  for (const auto& target : targets) {
+    http::HttpRequest req;
+    const std::string request = "GET " + target.first + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::pair<http::http_status, Error> err = http::parse_http_request(request, &req);
+    ASSERT_FALSE(err.second);
+    ASSERT_EQ(req.GetRelativeUrl(), target.second);
+  }
+}
+
 TEST(Http, parse_HEAD) {
   http::HttpRequest r3;
   const std::string request3 =
@@ -177,6 +196,62 @@ void checkFrameData(const http2::frame_base& frame,
   ASSERT_EQ(memcmp(rdata, rawdata, rawdata_size), 0);
 }
 
+TEST(Http, header_tokens) {
+  for (int i = 0; i < http::HT_COUNT; ++i) {
+    const http::http_header_token token = static_cast<http::http_header_token>(i);
+    const std::string name = http::GetHeaderTokenName(token);
+    ASSERT_EQ(http::LookupHeaderToken(name), token);
+    ASSERT_EQ(http::LookupHeaderToken(StringToLowerASCII(name)), token);
+    ASSERT_EQ(http::LookupHeaderToken(StringToUpperASCII(name)), token);
+  }
+  ASSERT_EQ(http::LookupHeaderToken("Hosts"), http::HT_UNKNOWN);
+  ASSERT_EQ(http::LookupHeaderToken("Hoxt"), http::HT_UNKNOWN);
+  // in the shared table for HPACK only
+  ASSERT_EQ(http::LookupHeaderToken("Accept-Charset"), http::HT_UNKNOWN);
+  ASSERT_EQ(http::LookupHeaderToken(":path"), http::HT_UNKNOWN);
+  ASSERT_EQ(http::LookupHeaderToken(std::string()), http::HT_UNKNOWN);
+  ASSERT_EQ(http::GetHeaderTokenName(http::HT_UNKNOWN), nullptr);
+
+  http::HttpRequest req;
+  const std::string request =
+      "GET /chat HTTP/1.1\r\n"
+      "host: example.com\r\n"
+      "Upgrade: websocket\r\n"
+      "X-Custom: first\r\n"
+      "Set-Cookie: a=1\r\n"
+      "set-cookie: b=2\r\n"
+      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n";
+  std::pair<http::http_status, Error> err = http::parse_http_request(request, &req);
+  ASSERT_FALSE(err.second);
+  ASSERT_EQ(req.GetHeaders().size(), 6);
+
+  const http::header_t* host = req.GetHeader(http::HT_HOST);
+  ASSERT_TRUE(host);
+  ASSERT_EQ(host->value, "example.com");
+  ASSERT_EQ(req.GetURL().host(), "example.com");
+  ASSERT_EQ(req.GetHeader(http::HT_UPGRADE)->value, "websocket");
+  ASSERT_EQ(req.GetHeader(http::HT_SEC_WEBSOCKET_KEY)->value, "dGhlIHNhbXBsZSBub25jZQ==");
+  ASSERT_FALSE(req.GetHeader(http::HT_CONTENT_LENGTH));
+  ASSERT_EQ(req.GetHeader(http::HT_SET_COOKIE)->value, "a=1");
+
+  http::header_t hdr;
+  ASSERT_TRUE(req.FindHeaderByKey("X-CUSTOM", false, &hdr));
+  ASSERT_EQ(hdr.value, "first");
+  ASSERT_FALSE(req.FindHeaderByKey("X-CUSTOM", true, &hdr));
+  ASSERT_FALSE(req.FindHeaderByKey("Host", true, &hdr));
+  ASSERT_TRUE(req.FindHeaderByKey("set-cookie", true, &hdr));
+  ASSERT_EQ(hdr.value, "b=2");
+
+  req.RemoveHeaderByKey("Set-Cookie", true);
+  ASSERT_EQ(req.GetHeaders().size(), 5);
+  ASSERT_EQ(req.GetHeader(http::HT_SET_COOKIE)->value, "b=2");
+  ASSERT_EQ(req.GetHeader(http::HT_HOST)->value, "example.com");
+
+  ASSERT_TRUE(req.FindHeaderByKeyAndChange("Upgrade", false, http::HttpHeader("Content-Length", "0")));
+  ASSERT_FALSE(req.GetHeader(http::HT_UPGRADE));
+  ASSERT_EQ(req.GetHeader(http::HT_CONTENT_LENGTH)->value, "0");
+}
+
 TEST(Http2, parse_frames) {
   http2::frame_base fr;
   ASSERT_FALSE(fr.IsValid());
@@ -505,6 +580,96 @@ TEST(http_client, get) {
   ASSERT_FALSE(err);
 }
 
+namespace {
+const char* const kKeepAliveResponses[] = {
+    "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n4\r\ndefg\r\n0\r\n\r\n",
+    "HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nuntil close"};
+
+void exec_keep_alive_serv(net::ServerSocketTcp* serv) {
+  net::socket_info inf;
+  ErrnoError err = serv->Accept(&inf);
+  ASSERT_FALSE(err);
+
+  net::TcpSocketHolder client(inf);
+  for (const char* response : kKeepAliveResponses) {
+    std::string request;
+    while (request.find("\r\n\r\n") == std::string::npos) {
+      char buff[1024];
+      size_t nread = 0;
+      err = client.Read(buff, sizeof(buff), &nread);
+      ASSERT_FALSE(err);
+      ASSERT_NE(nread, 0);
+      request.append(buff, nread);
+    }
+
+    size_t nwrite = 0;
+    err = client.Write(response, strlen(response), &nwrite);
+    ASSERT_FALSE(err);
+  }
+  err = client.Close();
+  ASSERT_FALSE(err);
+}
+}  // namespace
+
+TEST(HttpClientPool, keep_alive) {
+  net::ServerSocketTcp serv(net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT));
+  ErrnoError err = serv.Bind(true);
+  ASSERT_FALSE(err);
+  err = serv.Listen(5);
+  ASSERT_FALSE(err);
+  const net::HostAndPort host = serv.GetHost();
+  auto serv_thread = THREAD_MANAGER()->CreateThread(&exec_keep_alive_serv, &serv);
+  ASSERT_TRUE(serv_thread->Start());
+
+  net::HttpClientPool pool;
+  net::HttpClientPool::client_t cl;
+  err = pool.Acquire(host, &cl);
+  ASSERT_FALSE(err);
+  const net::HttpClient* first = cl.get();
+
+  Error err2 = cl->Get("/1", {});
+  ASSERT_FALSE(err2);
+  http::HttpResponse resp;
+  err2 = cl->ReadResponse(&resp);
+  ASSERT_FALSE(err2);
+  ASSERT_EQ(resp.GetBody(), MAKE_CHAR_BUFFER("hello"));
+  ASSERT_TRUE(cl->IsKeepAlive());
+  pool.Release(std::move(cl));
+  ASSERT_EQ(pool.GetIdleCount(host), 1);
+
+  err = pool.Acquire(host, &cl);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(cl.get(), first);
+  err2 = cl->Get("/2", {});
+  ASSERT_FALSE(err2);
+  std::string streamed;
+  err2 = cl->ReadResponse(&resp, [&streamed](const char* data, size_t size) {
+    streamed.append(data, size);
+    return ErrnoError();
+  });
+  ASSERT_FALSE(err2);
+  ASSERT_EQ(streamed, "abcdefg");
+  ASSERT_TRUE(cl->IsKeepAlive());
+  pool.Release(std::move(cl));
+
+  err = pool.Acquire(host, &cl);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(cl.get(), first);
+  err2 = cl->Get("/3", {});
+  ASSERT_FALSE(err2);
+  err2 = cl->ReadResponse(&resp);
+  ASSERT_FALSE(err2);
+  ASSERT_EQ(resp.GetBody(), MAKE_CHAR_BUFFER("until close"));
+  ASSERT_FALSE(cl->IsKeepAlive());
+  pool.Release(std::move(cl));
+  ASSERT_EQ(pool.GetIdleCount(host), 0);
+
+  serv_thread->Join();
+  err = serv.Close();
+  ASSERT_FALSE(err);
+}
+
 #if defined(HAVE_OPENSSL)
 TEST(https_client, get_file) {
   auto const path = common::file_system::prepare_path("~/1.png");
@@ -547,3 +712,26 @@ TEST(https_client, post) {
 }
 
 #endif
+
+TEST(Http, mime_types) {
+  ASSERT_STREQ(http::MimeTypes::GetType("index.html"), "text/html");
+  ASSERT_STREQ(http::MimeTypes::GetType("/img/logo.PNG"), "image/png");
+  ASSERT_STREQ(http::MimeTypes::GetType("js"), "application/javascript");
+  ASSERT_STREQ(http::MimeTypes::GetType(".css"), "text/css");
+  ASSERT_FALSE(http::MimeTypes::GetType("archive.unknown"));
+
+  // the first extension listed for a type
+  ASSERT_STREQ(http::MimeTypes::GetExtension("video/3gpp"), "3gp");
+  ASSERT_STREQ(http::MimeTypes::GetExtension("IMAGE/PNG"), "png");
+  ASSERT_FALSE(http::MimeTypes::GetExtension("application/x-unknown"));
+
+  http::http_method method;
+  ASSERT_TRUE(ConvertFromString("HEAD", &method));
+  ASSERT_EQ(method, http::HM_HEAD);
+  ASSERT_FALSE(ConvertFromString("head", &method));
+  ASSERT_FALSE(ConvertFromString("PUT", &method));
+
+  http::http_protocol protocol;
+  ASSERT_TRUE(ConvertFromString(HTTP_1_1_PROTOCOL_NAME, &protocol));
+  ASSERT_EQ(protocol, http::HP_1_1);
+}
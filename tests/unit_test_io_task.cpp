@@ -0,0 +1,168 @@
+/*  Copyright (C) 2014-2022 FastoGT. All right reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+        * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above
+    copyright notice, this list of conditions and the following disclaimer
+    in the documentation and/or other materials provided with the
+    distribution.
+        * Neither the name of FastoGT. nor the names of its
+    contributors may be used to endorse or promote products derived from
+    this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+    "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+    LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+    A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+
+#include <common/libev/io_task.h>
+#include <common/libev/tcp/tcp_client.h>
+#include <common/net/net.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#if defined(HAVE_IO_TASK_COROUTINES)
+namespace coro = common::libev::coro;
+
+namespace {
+
+struct TaskLog {
+  std::vector<std::string> items;
+  common::ErrnoError err;
+  bool finished = false;
+};
+
+// Length prefixed frames: one byte of length, then the payload, which is echoed back.
+coro::IoTask EchoFrames(common::libev::IoStream* stream, TaskLog* log) {
+  while (true) {
+    coro::IoReadResult header = co_await coro::ReadExactly(stream, 1);
+    if (header.err) {
+      log->err = header.err;
+      break;
+    }
+    coro::IoReadResult payload = co_await coro::ReadExactly(stream, static_cast<uint8_t>(header.data[0]));
+    if (payload.err) {
+      log->err = payload.err;
+      break;
+    }
+    log->items.push_back(payload.data.as_string());
+    if (payload.data.empty()) {
+      continue;  // IoClient::Write() rejects empty buffers
+    }
+    common::ErrnoError err = co_await coro::Write(stream, payload.data);
+    if (err) {
+      log->err = err;
+      break;
+    }
+  }
+  log->finished = true;
+}
+
+coro::IoTask ReadLines(common::libev::IoStream* stream, TaskLog* log) {
+  while (true) {
+    coro::IoReadResult line = co_await coro::ReadUntil(stream, "\n");
+    if (line.err) {
+      log->err = line.err;
+      break;
+    }
+    log->items.push_back(line.data.as_string());
+  }
+  log->finished = true;
+}
+
+std::string ReadAvailable(int fd) {
+  char buffer[256];
+  const ssize_t nread = read(fd, buffer, sizeof(buffer));
+  return nread > 0 ? std::string(buffer, nread) : std::string();
+}
+
+}  // namespace
+
+TEST(Libev, IoTaskFrames) {
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  common::libev::tcp::TcpClient client(nullptr, common::net::socket_info(sv[0]));
+  common::libev::IoStream stream(&client);
+
+  TaskLog log;
+  EchoFrames(&stream, &log);
+  ASSERT_TRUE(stream.IsReadPending());
+  ASSERT_FALSE(log.finished);
+
+  // a frame split over reads resumes the coroutine once it is complete
+  ASSERT_EQ(write(sv[1], "\x05he", 3), 3);
+  ASSERT_FALSE(stream.OnDataReceived());
+  ASSERT_TRUE(log.items.empty());
+  ASSERT_EQ(write(sv[1], "llo", 3), 3);
+  ASSERT_FALSE(stream.OnDataReceived());
+  ASSERT_EQ(log.items, std::vector<std::string>({"hello"}));
+  ASSERT_EQ(ReadAvailable(sv[1]), "hello");
+
+  // several frames in one read are all served before OnDataReceived() returns
+  ASSERT_EQ(write(sv[1], "\x03" "abc\x01x\x00\x02yz", 10), 10);
+  ASSERT_FALSE(stream.OnDataReceived());
+  ASSERT_EQ(log.items, std::vector<std::string>({"hello", "abc", "x", "", "yz"}));
+  ASSERT_EQ(ReadAvailable(sv[1]), "abcxyz");
+  ASSERT_EQ(client.GetReadBufferSize(), 0);
+
+  // the peer closing the connection ends the coroutine
+  close(sv[1]);
+  ASSERT_TRUE(stream.OnDataReceived());
+  ASSERT_TRUE(log.finished);
+  ASSERT_TRUE(log.err);
+  ASSERT_EQ(log.err->GetErrorCode(), ECONNRESET);
+  ASSERT_FALSE(stream.IsReadPending());
+  ASSERT_FALSE(client.Close());
+}
+
+TEST(Libev, IoTaskBufferedRead) {
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  common::libev::tcp::TcpClient client(nullptr, common::net::socket_info(sv[0]));
+
+  TaskLog log;
+  {
+    common::libev::IoStream stream(&client);
+    // data buffered before the coroutine starts resumes it synchronously, without touching the descriptor
+    ASSERT_EQ(write(sv[1], "one\ntwo\npar", 11), 11);
+    ASSERT_FALSE(stream.OnDataReceived());
+    ASSERT_EQ(client.GetReadBufferSize(), 11);
+
+    ReadLines(&stream, &log);
+    ASSERT_EQ(log.items, std::vector<std::string>({"one\n", "two\n"}));
+    ASSERT_TRUE(stream.IsReadPending());
+    ASSERT_EQ(std::string(client.GetReadBuffer(), client.GetReadBufferSize()), "par");
+
+    ASSERT_EQ(write(sv[1], "tial\n", 5), 5);
+    ASSERT_FALSE(stream.OnDataReceived());
+    ASSERT_EQ(log.items, std::vector<std::string>({"one\n", "two\n", "partial\n"}));
+    ASSERT_FALSE(log.finished);
+
+    // destroying the stream cancels the pending read and ends the coroutine
+  }
+  ASSERT_TRUE(log.finished);
+  ASSERT_TRUE(log.err);
+  ASSERT_EQ(log.err->GetErrorCode(), ECANCELED);
+
+  close(sv[1]);
+  ASSERT_FALSE(client.Close());
+}
+#endif
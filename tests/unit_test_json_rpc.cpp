@@ -31,7 +31,14 @@
 
 #include <json-c/json_object.h>
 
+#include <common/libev/tcp/tcp_client.h>
+#include <common/net/net.h>
 #include <common/protocols/json_rpc/json_rpc.h>
+#include <common/protocols/json_rpc/protocol_client.h>
+#include <common/text_decoders/none_edcoder.h>
+
+#include <arpa/inet.h>
+#include <sys/socket.h>
 
 #define METHOD "test"
 
@@ -168,3 +175,43 @@ TEST(json_rpc_response, parse_error) {
   ASSERT_EQ(PARSE_ERROR_CODE, jerr->code);
   ASSERT_FALSE(result.message);
 }
+
+namespace {
+std::string MakeProtocoledCommand(const std::string& command) {
+  const uint32_t size = htonl(command.size());
+  return std::string(reinterpret_cast<const char*>(&size), sizeof(size)) + command;
+}
+}  // namespace
+
+TEST(json_rpc_protocol, coalesced_commands) {
+  using namespace common::protocols::json_rpc;
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  // a redundant read fails with EAGAIN instead of blocking
+  ASSERT_FALSE(common::net::set_blocking_socket(sv[0], false));
+  ProtocolClient<common::libev::tcp::TcpClient> client(std::make_shared<common::NoneEDcoder>(), nullptr,
+                                                       common::net::socket_info(sv[0]));
+
+  // both commands and the head of the third come with a single read
+  const std::string third = MakeProtocoledCommand(RESULT_19);
+  const std::string stream =
+      MakeProtocoledCommand(RESULT_19) + MakeProtocoledCommand(METHOD_NON_EXISTS) + third.substr(0, 6);
+  ASSERT_EQ(write(sv[1], stream.data(), stream.size()), static_cast<ssize_t>(stream.size()));
+
+  std::string command;
+  ASSERT_FALSE(client.ReadCommand(&command));
+  ASSERT_EQ(command, RESULT_19);
+  ASSERT_FALSE(client.ReadCommand(&command));
+  ASSERT_EQ(command, METHOD_NON_EXISTS);
+  common::ErrnoError err = client.ReadCommand(&command);
+  ASSERT_TRUE(err);
+  ASSERT_EQ(err->GetErrorCode(), EAGAIN);
+
+  ASSERT_EQ(write(sv[1], third.data() + 6, third.size() - 6), static_cast<ssize_t>(third.size() - 6));
+  ASSERT_FALSE(client.ReadCommand(&command));
+  ASSERT_EQ(command, RESULT_19);
+  ASSERT_EQ(client.GetReadBufferSize(), 0);
+
+  ASSERT_FALSE(client.Close());
+  close(sv[1]);
+}
@@ -33,13 +33,32 @@
 #include <common/uri/gurl.h>
 
 #include <common/libev/async_io_client.h>
+#include <common/libev/async_tcp_client.h>
+#include <common/libev/event_io.h>
+#include <common/libev/inotify/inotify_client.h>
+#include <common/libev/inotify/inotify_client_observer.h>
 #include <common/libev/io_loop_observer.h>
+#include <common/libev/io_stream.h>
+#include <common/libev/loop_watchdog.h>
 #include <common/libev/tcp/tcp_client.h>
 #include <common/libev/tcp/tcp_server.h>
 
+#include <common/file_system/file_system.h>
 #include <common/threads/thread_manager.h>
 
 #include <common/net/net.h>
+#if defined(HAVE_OPENSSL)
+#include <common/net/socket_tcp_tls.h>
+
+#include "test_tls_certificate.h"
+#endif
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <thread>
 
 namespace {
 const common::net::HostAndPort g_hs("localhost", 8013);
@@ -88,6 +107,14 @@ class ServerHandler : public common::libev::IoLoopObserver {
   void DataReceived(common::libev::IoClient* client) override { UNUSED(client); }
 
   void DataReadyToWrite(common::libev::IoClient* client) override { UNUSED(client); }
+  void WriteQueueHigh(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void WriteQueueLow(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
 
   void Accepted(common::libev::AsyncIoClient* client) override { UNUSED(client); }
   void Moved(common::libev::IoLoop* server, common::libev::AsyncIoClient* client) override {
@@ -104,6 +131,14 @@ class ServerHandler : public common::libev::IoLoopObserver {
     UNUSED(client);
     UNUSED(bytes_read);
   }
+  void AsyncWriteQueueHigh(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void AsyncWriteQueueLow(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
 
   void PostLooped(common::libev::IoLoop* server) override {
     std::vector<common::libev::IoClient*> cl = server->GetClients();
@@ -229,6 +264,14 @@ class ServerWebHandler : public common::libev::IoLoopObserver {
   }
 
   void DataReadyToWrite(common::libev::IoClient* client) override { UNUSED(client); }
+  void WriteQueueHigh(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void WriteQueueLow(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
 
   void Accepted(common::libev::AsyncIoClient* client) override { UNUSED(client); }
   void Moved(common::libev::IoLoop* server, common::libev::AsyncIoClient* client) override {
@@ -245,6 +288,14 @@ class ServerWebHandler : public common::libev::IoLoopObserver {
     UNUSED(client);
     UNUSED(bytes_read);
   }
+  void AsyncWriteQueueHigh(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void AsyncWriteQueueLow(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
 
   void PostLooped(common::libev::IoLoop* server) override {
     std::vector<common::libev::IoClient*> cl = server->GetClients();
@@ -257,6 +308,1080 @@ void ExitHttpServer(common::libev::tcp::TcpServer* ser) {
   ser->Stop();
 }
 
+TEST(Libev, BufferedRead) {
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+  common::libev::tcp::TcpClient client(nullptr, common::net::socket_info(sv[0]));
+  ASSERT_EQ(client.GetReadBufferSize(), 0);
+
+  ASSERT_EQ(write(sv[1], "pingpong", 8), 8);
+  size_t nread = 0;
+  ASSERT_FALSE(client.ReadToBuffer(&nread));
+  ASSERT_EQ(nread, 8);
+  ASSERT_EQ(std::string(client.GetReadBuffer(), client.GetReadBufferSize()), "pingpong");
+  client.ConsumeReadBuffer(4);
+  ASSERT_EQ(std::string(client.GetReadBuffer(), client.GetReadBufferSize()), "pong");
+
+  // the partial message stays in front of the new data
+  ASSERT_EQ(write(sv[1], "!", 1), 1);
+  ASSERT_FALSE(client.ReadToBuffer(&nread));
+  ASSERT_EQ(nread, 1);
+  ASSERT_EQ(std::string(client.GetReadBuffer(), client.GetReadBufferSize()), "pong!");
+  client.ConsumeReadBuffer(5);
+  ASSERT_EQ(client.GetReadBufferSize(), 0);
+  ASSERT_EQ(client.GetReadBytes(), 9);
+
+  ASSERT_FALSE(client.Close());
+  close(sv[1]);
+}
+
+namespace {
+
+// Handles one line per DataReceived like the message based protocols, the rest stays buffered.
+class LineLoopHandler : public ServerHandler {
+ public:
+  LineLoopHandler() : peer_(INVALID_DESCRIPTOR), stop_timer_(INVALID_TIMER_ID) {}
+
+  void PreLooped(common::libev::IoLoop* server) override {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    peer_ = sv[1];
+    auto* client = new common::libev::tcp::TcpClient(server, common::net::socket_info(sv[0]));
+    ASSERT_TRUE(server->RegisterClient(client));
+    ASSERT_EQ(write(peer_, "one\ntwo\nthree\n", 14), 14);
+  }
+
+  void DataReceived(common::libev::IoClient* client) override {
+    if (!HasLine(client)) {
+      size_t nread = 0;
+      ASSERT_FALSE(client->ReadToBuffer(&nread));
+    }
+    if (!HasLine(client)) {
+      return;
+    }
+
+    const char* buff = client->GetReadBuffer();
+    const size_t line_len = std::find(buff, buff + client->GetReadBufferSize(), '\n') - buff;
+    lines_.push_back(std::string(buff, line_len));
+    client->ConsumeReadBuffer(line_len + 1);
+    if (HasLine(client)) {
+      client->ScheduleBufferedRead();
+    } else if (stop_timer_ == INVALID_TIMER_ID) {
+      // a late duplicate would show up meanwhile
+      stop_timer_ = client->GetServer()->CreateTimer(0.05, false);
+    }
+  }
+
+  void TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) override {
+    ASSERT_EQ(id, stop_timer_);
+    for (common::libev::IoClient* client : server->GetClients()) {
+      ASSERT_FALSE(client->Close());
+      delete client;
+    }
+    server->Stop();
+  }
+
+  void PostLooped(common::libev::IoLoop* server) override {
+    ServerHandler::PostLooped(server);
+    close(peer_);
+  }
+
+  const std::vector<std::string>& lines() const { return lines_; }
+
+ private:
+  static bool HasLine(common::libev::IoClient* client) {
+    const char* buff = client->GetReadBuffer();
+    return buff && std::find(buff, buff + client->GetReadBufferSize(), '\n') != buff + client->GetReadBufferSize();
+  }
+
+  int peer_;
+  common::libev::timer_id_t stop_timer_;
+  std::vector<std::string> lines_;
+};
+
+}  // namespace
+
+TEST(Libev, ScheduleBufferedRead) {
+  LineLoopHandler hand;
+  common::libev::tcp::TcpServer server(
+      new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT)), false, &hand);
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+  ASSERT_EQ(server.Exec(), EXIT_SUCCESS);
+  // every line arrived with one read, each is handled exactly once
+  ASSERT_EQ(hand.lines(), std::vector<std::string>({"one", "two", "three"}));
+}
+
+TEST(Libev, WriteAdvances) {
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+  std::string data(1024 * 1024, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i % 251);
+  }
+
+  std::string received;
+  std::thread reader([&received, &sv]() {
+    char buff[4096];
+    ssize_t res;
+    while ((res = read(sv[1], buff, sizeof(buff))) > 0) {
+      received.append(buff, res);
+    }
+  });
+
+  common::libev::tcp::TcpClient client(nullptr, common::net::socket_info(sv[0]));
+  size_t nwrite = 0;
+  ASSERT_FALSE(client.Write(data.data(), data.size(), &nwrite));
+  ASSERT_EQ(nwrite, data.size());
+  ASSERT_FALSE(client.Close());
+  reader.join();
+  close(sv[1]);
+  ASSERT_EQ(received, data);
+}
+
+TEST(Libev, QueuedWrites) {
+  const std::string chunk(64 * 1024, 'q');
+  for (auto policy : {common::libev::IoClient::SLOW_CONSUMER_NOTIFY, common::libev::IoClient::SLOW_CONSUMER_DROP,
+                      common::libev::IoClient::SLOW_CONSUMER_DISCONNECT}) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    ASSERT_FALSE(common::net::set_blocking_socket(sv[0], false));
+    ASSERT_FALSE(common::net::set_blocking_socket(sv[1], false));
+
+    common::libev::tcp::TcpClient client(nullptr, common::net::socket_info(sv[0]));
+    client.EnableWriteQueue(4 * chunk.size(), policy);
+
+    // the socket buffer fills up, the rest is queued instead of failing with EAGAIN
+    size_t accepted = 0;
+    size_t last_nwrite = 0;
+    common::ErrnoError err;
+    while (!err && !client.IsWriteQueueFull()) {
+      err = client.Write(chunk.data(), chunk.size(), &last_nwrite);
+      accepted += last_nwrite;
+    }
+    ASSERT_GT(client.GetWroteBytes(), 0);
+
+    if (policy == common::libev::IoClient::SLOW_CONSUMER_NOTIFY) {
+      ASSERT_FALSE(err);
+      ASSERT_GT(client.GetPendingWriteBytes(), 4 * chunk.size());
+
+      size_t received = 0;
+      while (client.GetPendingWriteBytes()) {
+        char buff[4096];
+        ssize_t res;
+        while ((res = read(sv[1], buff, sizeof(buff))) > 0) {
+          received += res;
+        }
+        err = client.FlushWriteQueue();
+        ASSERT_TRUE(!err || err->GetErrorCode() == EAGAIN);
+      }
+      char buff[4096];
+      ssize_t res;
+      while ((res = read(sv[1], buff, sizeof(buff))) > 0) {
+        received += res;
+      }
+      ASSERT_FALSE(client.IsWriteQueueFull());
+      ASSERT_EQ(received, accepted);
+      ASSERT_EQ(client.GetWroteBytes(), accepted);
+    } else if (policy == common::libev::IoClient::SLOW_CONSUMER_DROP) {
+      ASSERT_TRUE(err);
+      ASSERT_EQ(err->GetErrorCode(), ENOBUFS);
+      ASSERT_LE(client.GetPendingWriteBytes(), 4 * chunk.size());
+
+      // a write larger than the limit is refused even when nothing is queued
+      int big_sv[2];
+      ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, big_sv), 0);
+      ASSERT_FALSE(common::net::set_blocking_socket(big_sv[0], false));
+      common::libev::tcp::TcpClient big(nullptr, common::net::socket_info(big_sv[0]));
+      big.EnableWriteQueue(chunk.size() / 2, policy);
+      size_t nwrite = 1;
+      err = big.Write(chunk.data(), chunk.size(), &nwrite);
+      ASSERT_TRUE(err);
+      ASSERT_EQ(err->GetErrorCode(), ENOBUFS);
+      ASSERT_EQ(nwrite, 0);
+      ASSERT_EQ(big.GetWroteBytes(), 0);
+      ignore_result(big.Close());
+      close(big_sv[1]);
+    } else {
+      ASSERT_TRUE(err);
+      ASSERT_EQ(err->GetErrorCode(), ECONNABORTED);
+      ASSERT_EQ(client.GetPendingWriteBytes(), 0);
+      // the chunk which overflowed the queue was dropped with it
+      ASSERT_EQ(last_nwrite, 0);
+    }
+    ignore_result(client.Close());
+    close(sv[1]);
+  }
+}
+
+#if defined(HAVE_OPENSSL)
+namespace {
+
+// Connects |peer| (blocking) to a local TLS listener and returns the accepted side of the connection.
+common::net::TcpTlsSocketHolder* ConnectTls(common::net::ClientSocketTcpTls* peer) {
+  const std::string cert = "/tmp/common_unit_test_libev_tls_cert.pem";
+  const std::string key = "/tmp/common_unit_test_libev_tls_key.pem";
+  common::net::ServerSocketTcpTls server(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT));
+  const bool listening = WriteSelfSignedCertificate(cert, key) && !server.LoadCertificates(cert, key) &&
+                         !server.Bind(true) && !server.Listen(1);
+  remove(cert.c_str());
+  remove(key.c_str());
+  if (!listening) {
+    return nullptr;
+  }
+
+  common::net::socket_info info;
+  SSL* ssl = nullptr;
+  std::thread acceptor([&server, &info, &ssl]() { ignore_result(server.Accept(&info, &ssl)); });
+  peer->SetHost(server.GetHost());
+  const bool connected = !peer->Connect();
+  acceptor.join();
+  ignore_result(server.Close());
+  if (!connected || !ssl) {
+    return nullptr;
+  }
+  return new common::net::TcpTlsSocketHolder(info, ssl);
+}
+
+}  // namespace
+
+TEST(Libev, TlsQueuedWrites) {
+  common::net::ClientSocketTcpTls peer(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT));
+  common::net::TcpTlsSocketHolder* holder = ConnectTls(&peer);
+  ASSERT_TRUE(holder);
+
+  common::libev::tcp::TcpClient client(nullptr, holder);  // owns |holder|
+  ASSERT_FALSE(client.SetBlocking(false));
+  client.EnableWriteQueue(256 * 1024 * 1024);
+
+  // the peer doesn't read, SSL_write runs out of socket buffer in the middle of a record and the rest is queued
+  std::string sent;
+  for (char fill = 'a'; client.GetPendingWriteBytes() < 1024 * 1024 && sent.size() < 128 * 1024 * 1024;
+       fill = fill == 'z' ? 'a' : fill + 1) {
+    const std::string chunk(64 * 1024 + 7, fill);
+    size_t nwrite = 0;
+    ASSERT_FALSE(client.Write(chunk.data(), chunk.size(), &nwrite));
+    ASSERT_EQ(nwrite, chunk.size());
+    sent += chunk;
+  }
+  ASSERT_GT(client.GetPendingWriteBytes(), 0);
+
+  std::string received;
+  std::thread reader([&peer, &received, &sent]() {
+    char buff[16 * 1024];
+    size_t nread = 0;
+    while (received.size() < sent.size() && !peer.Read(buff, sizeof(buff), &nread)) {
+      received.append(buff, nread);
+    }
+  });
+
+  // the retries come from the queue, another buffer than the one of the first attempt
+  common::ErrnoError err;
+  while (client.GetPendingWriteBytes()) {
+    err = client.FlushWriteQueue();
+    if (err && err->GetErrorCode() != EAGAIN) {
+      break;
+    }
+    err = common::ErrnoError();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  if (err) {
+    ignore_result(client.Close());  // unblocks the reader
+  }
+  reader.join();
+  ASSERT_FALSE(err) << err->GetDescription();
+  ASSERT_EQ(received.size(), sent.size());
+  ASSERT_TRUE(received == sent);
+  ASSERT_EQ(client.GetWroteBytes(), sent.size());
+
+  ASSERT_FALSE(client.Close());
+  ASSERT_FALSE(peer.Disconnect());
+}
+#endif
+
+namespace {
+
+class WatermarkClient : public common::libev::tcp::AsyncTcpClient {
+ public:
+  explicit WatermarkClient(const common::net::socket_info& info)
+      : AsyncTcpClient(nullptr, info), high_count(0), low_count(0) {}
+
+  void OnWriteQueueHigh(size_t pending_bytes) override {
+    EXPECT_GT(pending_bytes, 8 * 1024);
+    high_count++;
+  }
+  void OnWriteQueueLow(size_t pending_bytes) override {
+    EXPECT_LE(pending_bytes, 2 * 1024);
+    low_count++;
+  }
+
+  size_t high_count;
+  size_t low_count;
+};
+
+}  // namespace
+
+TEST(Libev, AsyncWriteWatermarks) {
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  ASSERT_FALSE(common::net::set_blocking_socket(sv[1], false));
+
+  WatermarkClient client{common::net::socket_info(sv[0])};
+  client.SetWriteWatermarks(2 * 1024, 8 * 1024);
+
+  const std::string chunk(4 * 1024, 'a');
+  ASSERT_FALSE(client.Write(chunk.data(), chunk.size()));
+  ASSERT_FALSE(client.Write(chunk.data(), chunk.size()));
+  ASSERT_EQ(client.high_count, 0);
+  ASSERT_FALSE(client.Write(common::char_buffer_t(chunk.begin(), chunk.end())));
+  ASSERT_EQ(client.high_count, 1);
+  ASSERT_TRUE(client.IsWriteQueueFull());
+  ASSERT_EQ(client.GetPendingWriteBytes(), 3 * chunk.size());
+  ASSERT_FALSE(client.Write(chunk.data(), chunk.size()));
+  ASSERT_EQ(client.high_count, 1);
+
+  std::string received;
+  while (client.GetPendingWriteBytes()) {
+    client.HandleWriteEvent();
+    char buff[4096];
+    ssize_t res;
+    while ((res = read(sv[1], buff, sizeof(buff))) > 0) {
+      received.append(buff, res);
+    }
+  }
+  ASSERT_EQ(client.low_count, 1);
+  ASSERT_FALSE(client.IsWriteQueueFull());
+  ASSERT_EQ(received, chunk + chunk + chunk + chunk);
+  ASSERT_EQ(client.GetWroteBytes(), received.size());
+
+  ASSERT_EQ(write(sv[1], "ping", 4), 4);
+  client.HandleReadEvent();
+  ASSERT_EQ(client.GetAvailableReadData(), 4);
+  char ping[8] = {0};
+  size_t nread = 0;
+  ASSERT_FALSE(client.ReadAvailable(ping, sizeof(ping), &nread));
+  ASSERT_EQ(nread, 4);
+  ASSERT_STREQ(ping, "ping");
+
+  ASSERT_FALSE(client.Close());
+  close(sv[1]);
+}
+
+#if defined(HAVE_OPENSSL)
+TEST(Libev, AsyncTlsClient) {
+  common::net::ClientSocketTcpTls peer(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT));
+  std::unique_ptr<common::net::TcpTlsSocketHolder> holder(ConnectTls(&peer));
+  ASSERT_TRUE(holder);
+
+  common::libev::tcp::AsyncTcpClient client(nullptr, holder.get());
+  std::string sent;
+  for (char fill = 'a'; sent.size() < 512 * 1024; fill = fill == 'z' ? 'a' : fill + 1) {
+    const std::string chunk(32 * 1024 + 3, fill);
+    ASSERT_FALSE(client.Write(chunk.data(), chunk.size()));
+    sent += chunk;
+  }
+
+  std::string received;
+  std::thread reader([&peer, &received, &sent]() {
+    char buff[16 * 1024];
+    size_t nread = 0;
+    while (received.size() < sent.size() && !peer.Read(buff, sizeof(buff), &nread)) {
+      received.append(buff, nread);
+    }
+  });
+  while (client.GetPendingWriteBytes()) {
+    client.HandleWriteEvent();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  reader.join();
+  // the peer decrypts what was sent, not the raw records
+  ASSERT_EQ(received.size(), sent.size());
+  ASSERT_TRUE(received == sent);
+  ASSERT_EQ(client.GetWroteBytes(), sent.size());
+
+  size_t nwrite = 0;
+  ASSERT_FALSE(peer.Write("ping", 4, &nwrite));
+  for (int i = 0; i < 1000 && client.GetAvailableReadData() < 4; ++i) {
+    client.HandleReadEvent();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(client.GetAvailableReadData(), 4);
+  char ping[8] = {0};
+  size_t nread = 0;
+  ASSERT_FALSE(client.ReadAvailable(ping, sizeof(ping), &nread));
+  ASSERT_EQ(nread, 4);
+  ASSERT_STREQ(ping, "ping");
+
+  ASSERT_FALSE(client.Close());
+  ASSERT_FALSE(peer.Disconnect());
+}
+#endif
+
+class StartedLoopObserver : public common::libev::EvLoopObserver {
+ public:
+  void PreLooped(common::libev::LibEvLoop* loop) override { UNUSED(loop); }
+  void Started(common::libev::LibEvLoop* loop) override {
+    UNUSED(loop);
+    started.set_value();
+  }
+  void Stopped(common::libev::LibEvLoop* loop) override { UNUSED(loop); }
+  void PostLooped(common::libev::LibEvLoop* loop) override { UNUSED(loop); }
+  void TimerEmited(common::libev::LibEvLoop* loop, common::libev::timer_id_t id) override {
+    UNUSED(loop);
+    UNUSED(id);
+  }
+
+  std::promise<void> started;
+};
+
+TEST(Libev, Watchdog) {
+  std::vector<common::libev::SlowCallbackInfo> slow;
+  std::promise<common::libev::LoopStallInfo> stall;
+
+  common::libev::LoopWatchdogSettings settings;
+  settings.slow_callback_msec = 20;
+  settings.stall_timeout_msec = 100;
+  settings.on_slow_callback = [&slow](const common::libev::SlowCallbackInfo& info) { slow.push_back(info); };
+  settings.on_stall = [&stall](const common::libev::LoopStallInfo& info) { stall.set_value(info); };
+
+  StartedLoopObserver observer;
+  common::libev::LibEvLoop loop;
+  loop.SetObserver(&observer);
+  loop.EnableWatchdog(settings);
+  std::thread loop_thread([&loop]() { ignore_result(loop.Exec()); });
+  observer.started.get_future().wait();
+
+  loop.ExecInLoopThread([]() { std::this_thread::sleep_for(std::chrono::milliseconds(300)); });
+  const common::libev::LoopStallInfo stall_info = stall.get_future().get();
+  ASSERT_EQ(stall_info.callback, "exec_in_loop");
+  ASSERT_GE(stall_info.stalled_msec, 100);
+#if defined(OS_LINUX)
+  ASSERT_FALSE(stall_info.stack.empty());
+#endif
+
+  loop.Stop();
+  loop_thread.join();
+  loop.DisableWatchdog();
+
+  ASSERT_EQ(slow.size(), 1);
+  ASSERT_EQ(slow[0].callback, "exec_in_loop");
+  ASSERT_EQ(slow[0].target, "ExecInLoopThread");
+  ASSERT_GE(slow[0].duration_msec, 300);
+}
+
+TEST(Libev, Backends) {
+  const common::libev::LoopBackend backends[] = {common::libev::LOOP_BACKEND_POLL, common::libev::LOOP_BACKEND_EPOLL,
+                                                 common::libev::LOOP_BACKEND_IOURING};
+  for (common::libev::LoopBackend backend : backends) {
+    common::libev::LibEvLoop loop(backend);
+    if (!common::libev::LibEvLoop::IsBackendSupported(backend)) {
+      ASSERT_NE(loop.GetBackend(), backend);
+      continue;
+    }
+    ASSERT_EQ(loop.GetBackend(), backend);
+
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    StartedLoopObserver observer;
+    loop.SetObserver(&observer);
+    std::thread loop_thread([&loop]() { ignore_result(loop.Exec()); });
+    observer.started.get_future().wait();
+
+    // runs on the loop thread: failures must not skip the promise, the test thread waits for it
+    std::promise<void> readable;
+    common::libev::LibevIO io;
+    ASSERT_EQ(write(sv[1], "x", 1), 1);
+    loop.ExecInLoopThread([&]() {
+      auto cb = [&readable](common::libev::LibEvLoop* loop, common::libev::LibevIO* io,
+                            common::libev::flags_t revents) {
+        UNUSED(loop);
+        EXPECT_TRUE(revents & common::libev::EV_READ);
+        io->Stop();
+        readable.set_value();
+      };
+      if (!io.Init(&loop, cb, sv[0], common::libev::EV_READ)) {
+        ADD_FAILURE() << "Can't watch the socket";
+        readable.set_value();
+        return;
+      }
+      io.Start();
+    });
+    readable.get_future().wait();
+
+    loop.Stop();
+    loop_thread.join();
+    close(sv[0]);
+    close(sv[1]);
+  }
+}
+
+TEST(Libev, ObjectPools) {
+  common::libev::tcp::TcpServer server(
+      new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT)), false);
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+  server.SetObjectPoolsEnabled(true);
+  ASSERT_TRUE(server.GetObjectPoolsStats().empty());
+
+  std::thread server_thread([&server]() { ignore_result(server.Exec()); });
+  common::net::ClientSocketTcp client(server.GetHost());
+  ASSERT_FALSE(client.Connect());
+
+  // TcpClient, its TcpSocketHolder, LibevIO watcher and ev_io handle once the connection is accepted
+  size_t in_use = 0;
+  for (int i = 0; i < 1000 && in_use < 4; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    in_use = 0;
+    for (const common::memory::SlabPoolStats& stats : server.GetObjectPoolsStats()) {
+      in_use += stats.objects_in_use;
+    }
+  }
+  ASSERT_GE(in_use, 4);
+
+  server.Stop();
+  server_thread.join();
+  in_use = 0;
+  for (const common::memory::SlabPoolStats& stats : server.GetObjectPoolsStats()) {
+    in_use += stats.objects_in_use;
+  }
+  ASSERT_EQ(in_use, 0);
+  ASSERT_FALSE(client.Disconnect());
+}
+
+namespace {
+
+size_t WaitForClients(common::libev::tcp::TcpServer* server, size_t expected) {
+  size_t clients = 0;
+  for (int i = 0; i < 1000 && clients != expected; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::promise<size_t> count;
+    server->ExecInLoopThread([server, &count]() { count.set_value(server->GetClients().size()); });
+    clients = count.get_future().get();
+  }
+  return clients;
+}
+
+}  // namespace
+
+TEST(Libev, DrainAndHandoff) {
+  const common::net::HostAndPort host = common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT);
+  common::libev::tcp::TcpServer old_server(new common::net::ServerSocketEvTcp(host), false);
+  ASSERT_FALSE(old_server.Bind(true));
+  ASSERT_FALSE(old_server.Listen(5));
+  std::thread old_thread([&old_server]() { ignore_result(old_server.Exec()); });
+
+  common::net::ClientSocketTcp old_client(old_server.GetHost());
+  ASSERT_FALSE(old_client.Connect());
+  ASSERT_EQ(WaitForClients(&old_server, 1), 1);
+
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  ASSERT_FALSE(old_server.SendListener(sv[0]));
+  common::net::socket_descr_t listening_fd = INVALID_SOCKET_VALUE;
+  ASSERT_FALSE(common::libev::tcp::TcpServer::ReceiveListener(sv[1], &listening_fd));
+  close(sv[0]);
+  close(sv[1]);
+
+  common::libev::tcp::TcpServer new_server(new common::net::ServerSocketEvTcp(host, listening_fd), false);
+  ASSERT_FALSE(new_server.Bind(true));
+  ASSERT_FALSE(new_server.Listen(5));
+  ASSERT_EQ(new_server.GetHost(), old_server.GetHost());
+  std::thread new_thread([&new_server]() { ignore_result(new_server.Exec()); });
+
+  // the idle connection is closed and the old loop exits
+  old_server.Drain(5000);
+  old_thread.join();
+  ASSERT_TRUE(old_server.IsDraining());
+  char buff[16];
+  size_t nread = 0;
+  common::ErrnoError err = old_client.Read(buff, sizeof(buff), &nread);
+  ASSERT_TRUE(err || nread == 0);
+  ASSERT_FALSE(old_client.Disconnect());
+
+  common::net::ClientSocketTcp new_client(new_server.GetHost());
+  ASSERT_FALSE(new_client.Connect());
+  ASSERT_EQ(WaitForClients(&new_server, 1), 1);
+
+  new_server.Stop();
+  new_thread.join();
+  ASSERT_FALSE(new_client.Disconnect());
+}
+
+TEST(Libev, DrainFlushesQueuedWrites) {
+  common::libev::tcp::TcpServer server(
+      new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT)), false);
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+  std::thread loop_thread([&server]() { ignore_result(server.Exec()); });
+
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  ASSERT_FALSE(common::net::set_blocking_socket(sv[0], false));
+  std::string data(1024 * 1024, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i % 251);
+  }
+
+  std::promise<size_t> queued;
+  server.ExecInLoopThread([&server, &sv, &data, &queued]() {
+    auto* client = new common::libev::tcp::TcpClient(&server, common::net::socket_info(sv[0]));
+    EXPECT_TRUE(server.RegisterClient(client));
+    client->EnableWriteQueue(2 * data.size());
+    size_t nwrite = 0;
+    EXPECT_FALSE(client->Write(data.data(), data.size(), &nwrite));
+    EXPECT_EQ(nwrite, data.size());
+    queued.set_value(client->GetPendingWriteBytes());
+  });
+  ASSERT_GT(queued.get_future().get(), 0);
+
+  // the client isn't idle while its output is queued, the peer gets everything before the close
+  server.Drain(5000);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::string received;
+  char buff[64 * 1024];
+  ssize_t res;
+  while ((res = read(sv[1], buff, sizeof(buff))) > 0) {
+    received.append(buff, res);
+  }
+  loop_thread.join();
+  close(sv[1]);
+  ASSERT_EQ(received, data);
+}
+
+namespace {
+
+// Answers "ping" with "pong" from a timer, like a handler handing the work to a thread pool.
+class DeferredReplyHandler : public ServerHandler {
+ public:
+  DeferredReplyHandler() : client_(nullptr), reply_timer_(INVALID_TIMER_ID) {}
+
+  void PreLooped(common::libev::IoLoop* server) override {
+    UNUSED(server);
+    started.set_value();
+  }
+
+  void DataReceived(common::libev::IoClient* client) override {
+    char buff[16];
+    size_t nread = 0;
+    if (client->SingleRead(buff, sizeof(buff), &nread) || nread == 0) {
+      return;
+    }
+    EXPECT_EQ(std::string(buff, nread), "ping");
+    client_ = client;
+    client_->SetRequestInFlight(true);
+    // later than the first drain check
+    reply_timer_ = client->GetServer()->CreateTimer(0.2, false);
+  }
+
+  void TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) override {
+    if (id != reply_timer_) {
+      return;
+    }
+    server->RemoveTimer(reply_timer_);
+    size_t nwrite = 0;
+    EXPECT_FALSE(client_->Write("pong", 4, &nwrite));
+    client_->SetRequestInFlight(false);
+  }
+
+  std::promise<void> started;
+
+ private:
+  common::libev::IoClient* client_;
+  common::libev::timer_id_t reply_timer_;
+};
+
+}  // namespace
+
+TEST(Libev, DrainWaitsForRequests) {
+  DeferredReplyHandler hand;
+  common::libev::tcp::TcpServer server(
+      new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT)), false, &hand);
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+  std::thread loop_thread([&server]() { ignore_result(server.Exec()); });
+  hand.started.get_future().wait();
+
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  // the request is still in the socket buffer when the drain starts, nothing has read it yet
+  server.ExecInLoopThread([&server, &sv]() {
+    auto* client = new common::libev::tcp::TcpClient(&server, common::net::socket_info(sv[0]));
+    EXPECT_TRUE(server.RegisterClient(client));
+    EXPECT_EQ(write(sv[1], "ping", 4), 4);
+  });
+  server.Drain(5000);
+
+  std::string received;
+  char buff[16];
+  ssize_t res;
+  while ((res = read(sv[1], buff, sizeof(buff))) > 0) {
+    received.append(buff, res);
+  }
+  loop_thread.join();
+  close(sv[1]);
+  ASSERT_EQ(received, "pong");
+}
+
+namespace {
+
+namespace inotify = common::libev::inotify;
+
+class InotifyRecorder : public common::libev::inotify::IoInotifyClientObserver {
+ public:
+  void HandleChanges(common::libev::inotify::IoInotifyClient* client,
+                     const common::file_system::ascii_directory_string_path& directory,
+                     const std::string& name,
+                     bool is_dir,
+                     uint32_t mask) override {
+    UNUSED(client);
+    UNUSED(is_dir);
+    changes.push_back(std::make_pair(directory.GetPath() + name, mask));
+  }
+
+  std::vector<std::pair<std::string, uint32_t>> changes;
+};
+
+class InotifyLoopHandler : public ServerHandler {
+ public:
+  explicit InotifyLoopHandler(const std::string& root) : root_(root), client_(nullptr) {}
+
+  void PreLooped(common::libev::IoLoop* server) override {
+    client_ = new common::libev::inotify::IoInotifyClient(server, &recorder);
+    client_->SetCoalescingWindow(50);
+    const auto root = common::file_system::ascii_directory_string_path(root_);
+    ASSERT_FALSE(client_->WatchDirectory(root, inotify::EV_IN_MODIFY | inotify::EV_IN_CLOSE_WRITE));
+
+    // three writes of one file are reported once
+    const std::string file = root_ + "/file.txt";
+    for (int i = 0; i < 3; ++i) {
+      FILE* f = fopen(file.c_str(), "a");
+      ASSERT_TRUE(f);
+      fputs("data", f);
+      fclose(f);
+    }
+    client_->ProcessRead();
+    ASSERT_EQ(client_->GetPendingChangesCount(), 1);
+    ASSERT_TRUE(recorder.changes.empty());
+  }
+
+  void TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) override {
+    if (client_->ProcessTimer(id) && client_->GetPendingChangesCount() == 0) {
+      server->Stop();
+    }
+  }
+
+  void PostLooped(common::libev::IoLoop* server) override {
+    UNUSED(server);
+    ASSERT_FALSE(client_->Close());
+    delete client_;
+    client_ = nullptr;
+  }
+
+  InotifyRecorder recorder;
+
+ private:
+  const std::string root_;
+  common::libev::inotify::IoInotifyClient* client_;
+};
+
+}  // namespace
+
+TEST(Libev, InotifyRecursive) {
+  char root_template[] = "/tmp/common_inotify_XXXXXX";
+  const std::string root = mkdtemp(root_template);
+  ASSERT_FALSE(common::file_system::create_directory(root + "/a/b", true));
+
+  InotifyRecorder recorder;
+  common::libev::inotify::IoInotifyClient client(nullptr, &recorder);
+  const auto root_path = common::file_system::ascii_directory_string_path(root);
+  ASSERT_FALSE(client.WatchDirectoryRecursive(root_path, inotify::EV_IN_CREATE | inotify::EV_IN_CLOSE_WRITE));
+  ASSERT_EQ(client.GetWatchesCount(), 3);
+
+  // a new tree is watched as a whole, entries created before its watch existed are reported too
+  ASSERT_FALSE(common::file_system::create_directory(root + "/c/d", true));
+  FILE* f = fopen((root + "/c/d/file.txt").c_str(), "w");
+  ASSERT_TRUE(f);
+  fclose(f);
+  client.ProcessRead();
+  ASSERT_EQ(client.GetWatchesCount(), 5);
+
+  bool file_reported = false;
+  for (const auto& change : recorder.changes) {
+    if (change.first == root + "/c/d/file.txt" && (change.second & inotify::EV_IN_CREATE)) {
+      file_reported = true;
+    }
+  }
+  ASSERT_TRUE(file_reported);
+
+  recorder.changes.clear();
+  f = fopen((root + "/a/b/nested.txt").c_str(), "w");
+  ASSERT_TRUE(f);
+  fclose(f);
+  client.ProcessRead();
+  ASSERT_EQ(recorder.changes.size(), 2);
+  ASSERT_EQ(recorder.changes[0].first, root + "/a/b/nested.txt");
+  ASSERT_TRUE(recorder.changes[0].second & inotify::EV_IN_CREATE);
+  ASSERT_TRUE(recorder.changes[1].second & inotify::EV_IN_CLOSE_WRITE);
+  ASSERT_FALSE(client.Close());
+  ASSERT_EQ(client.GetWatchesCount(), 0);
+
+  // coalescing needs the loop timers
+  InotifyLoopHandler hand(root);
+  common::libev::tcp::TcpServer server(
+      new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT)), false, &hand);
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+  ASSERT_EQ(server.Exec(), EXIT_SUCCESS);
+  ASSERT_EQ(hand.recorder.changes.size(), 1);
+  ASSERT_EQ(hand.recorder.changes[0].first, root + "/file.txt");
+  ASSERT_TRUE(hand.recorder.changes[0].second & inotify::EV_IN_MODIFY);
+  ASSERT_TRUE(hand.recorder.changes[0].second & inotify::EV_IN_CLOSE_WRITE);
+
+  ASSERT_FALSE(common::file_system::remove_directory(root, true));
+}
+
+namespace {
+
+// Length prefixed frames: one byte of length, then the payload.
+void ReadFrames(common::libev::IoStream* stream, std::vector<std::string>* frames) {
+  stream->ReadExactly(1, [stream, frames](common::ErrnoError err, const char* data, size_t size) {
+    if (err) {
+      ASSERT_EQ(err->GetErrorCode(), ECANCELED);
+      return;
+    }
+    ASSERT_EQ(size, 1);
+    stream->ReadExactly(static_cast<uint8_t>(data[0]),
+                        [stream, frames](common::ErrnoError err, const char* data, size_t size) {
+                          ASSERT_FALSE(err);
+                          frames->push_back(std::string(data, size));
+                          ReadFrames(stream, frames);
+                        });
+  });
+}
+
+class StreamLoopHandler : public ServerHandler {
+ public:
+  StreamLoopHandler() : client_(nullptr), stream_(nullptr), slept_(false) {}
+
+  void PreLooped(common::libev::IoLoop* server) override {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    peer_ = sv[1];
+    client_ = new common::libev::tcp::TcpClient(server, common::net::socket_info(sv[0]));
+    stream_ = new common::libev::IoStream(client_);
+    stream_->Sleep(20, [this, server](common::ErrnoError err) {
+      ASSERT_FALSE(err);
+      slept_ = true;
+      server->Stop();
+    });
+  }
+
+  void TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) override {
+    UNUSED(server);
+    ASSERT_TRUE(stream_->OnTimer(id));
+  }
+
+  void PostLooped(common::libev::IoLoop* server) override {
+    UNUSED(server);
+    delete stream_;
+    ASSERT_FALSE(client_->Close());
+    delete client_;
+    close(peer_);
+  }
+
+  bool slept() const { return slept_; }
+
+ private:
+  common::libev::tcp::TcpClient* client_;
+  common::libev::IoStream* stream_;
+  int peer_;
+  bool slept_;
+};
+
+}  // namespace
+
+TEST(Libev, IoStream) {
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  common::libev::tcp::TcpClient client(nullptr, common::net::socket_info(sv[0]));
+
+  std::vector<std::string> frames;
+  {
+    common::libev::IoStream stream(&client);
+    ReadFrames(&stream, &frames);
+
+    // frames split at every possible point, then several frames in one read
+    ASSERT_EQ(write(sv[1], "\x05he", 3), 3);
+    ASSERT_FALSE(stream.OnDataReceived());
+    ASSERT_TRUE(frames.empty());
+    ASSERT_EQ(write(sv[1], "llo\x03", 4), 4);
+    ASSERT_FALSE(stream.OnDataReceived());
+    ASSERT_EQ(frames.size(), 1);
+    ASSERT_EQ(write(sv[1], "a", 1), 1);
+    ASSERT_FALSE(stream.OnDataReceived());
+    ASSERT_EQ(write(sv[1], "bc\x01x\x00\x02yz", 8), 8);
+    ASSERT_FALSE(stream.OnDataReceived());
+    ASSERT_EQ(frames, std::vector<std::string>({"hello", "abc", "x", "", "yz"}));
+    ASSERT_TRUE(stream.IsReadPending());
+    ASSERT_EQ(client.GetReadBufferSize(), 0);
+
+    // destroying the stream cancels the pending read
+  }
+
+  common::libev::IoStream stream(&client);
+  std::string head;
+  auto read_head = [&head](common::ErrnoError err, const char* data, size_t size) {
+    ASSERT_FALSE(err);
+    head.assign(data, size);
+  };
+  stream.ReadUntil("\r\n\r\n", read_head);
+  ASSERT_EQ(write(sv[1], "GET / HTTP/1.1\r\nHost: a\r", 24), 24);
+  ASSERT_FALSE(stream.OnDataReceived());
+  ASSERT_TRUE(head.empty());
+  ASSERT_EQ(write(sv[1], "\n\r\nbody", 7), 7);
+  ASSERT_FALSE(stream.OnDataReceived());
+  ASSERT_EQ(head, "GET / HTTP/1.1\r\nHost: a\r\n\r\n");
+  ASSERT_EQ(std::string(client.GetReadBuffer(), client.GetReadBufferSize()), "body");
+
+  // the delimiter has to show up within |max_size| bytes
+  common::ErrnoError read_err;
+  auto expect_error = [&read_err](common::ErrnoError err, const char* data, size_t size) {
+    UNUSED(data);
+    UNUSED(size);
+    read_err = err;
+  };
+  stream.ReadUntil("\n", expect_error, 4);
+  ASSERT_TRUE(read_err);
+  ASSERT_EQ(read_err->GetErrorCode(), EMSGSIZE);
+
+  // the peer closing the connection fails the pending read
+  read_err = common::ErrnoError();
+  stream.ReadExactly(10, expect_error);
+  close(sv[1]);
+  ASSERT_TRUE(stream.OnDataReceived());
+  ASSERT_TRUE(read_err);
+  ASSERT_EQ(read_err->GetErrorCode(), ECONNRESET);
+  ASSERT_FALSE(stream.IsReadPending());
+  ASSERT_FALSE(client.Close());
+
+  // sleeps run on the loop timers
+  StreamLoopHandler hand;
+  common::libev::tcp::TcpServer server(
+      new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT)), false, &hand);
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+  ASSERT_EQ(server.Exec(), EXIT_SUCCESS);
+  ASSERT_TRUE(hand.slept());
+}
+
+namespace {
+
+class SendFileLoopHandler : public ServerHandler {
+ public:
+  SendFileLoopHandler(descriptor_t file_fd, size_t file_size, std::promise<void>* start_reading)
+      : file_fd_(file_fd),
+        file_size_(file_size),
+        start_reading_(start_reading),
+        timer_(INVALID_TIMER_ID),
+        peer_(INVALID_DESCRIPTOR),
+        ticks_while_sending_(0),
+        closed_(false) {}
+
+  void PreLooped(common::libev::IoLoop* server) override {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    peer_ = sv[1];
+    timer_ = server->CreateTimer(0.01, true);
+    auto* client = new common::libev::http::HttpServerClient(server, common::net::socket_info(sv[0]));
+    ASSERT_TRUE(server->RegisterClient(client));
+    auto done = [this, client](common::ErrnoError err, size_t sent) {
+      EXPECT_FALSE(err);
+      EXPECT_EQ(sent, file_size_);
+      // the owner closes and deletes the client once the file is out
+      ignore_result(client->Close());
+      delete client;
+    };
+    ASSERT_FALSE(client->SendFileByFdAsync(file_fd_, 0, file_size_, done));
+    // the transfer has its own duplicate of the descriptor
+    ASSERT_FALSE(common::file_system::close_descriptor(file_fd_));
+    ASSERT_TRUE(client->IsSendingFile());
+  }
+
+  void TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) override {
+    ASSERT_EQ(id, timer_);
+    // the peer doesn't read yet, the transfer can't finish but the loop keeps running
+    if (!closed_ && ++ticks_while_sending_ == 5) {
+      start_reading_->set_value();
+    }
+    if (ticks_while_sending_ > 1000) {
+      server->Stop();
+    }
+  }
+
+  void Closed(common::libev::IoClient* client) override {
+    UNUSED(client);
+    closed_ = true;
+    client->GetServer()->RemoveTimer(timer_);
+    client->GetServer()->Stop();
+  }
+
+  int peer() const { return peer_; }
+  size_t ticks_while_sending() const { return ticks_while_sending_; }
+  bool closed() const { return closed_; }
+
+ private:
+  const descriptor_t file_fd_;
+  const size_t file_size_;
+  std::promise<void>* const start_reading_;
+  common::libev::timer_id_t timer_;
+  int peer_;
+  size_t ticks_while_sending_;
+  bool closed_;
+};
+
+}  // namespace
+
+TEST(Libev, SendFileByFd) {
+  char path[] = "/tmp/common_send_file_XXXXXX";
+  const int file_fd = mkstemp(path);
+  ASSERT_NE(file_fd, INVALID_DESCRIPTOR);
+  // much larger than the socket buffers
+  std::string data(8 * 1024 * 1024, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>(i % 251);
+  }
+  size_t nwrite = 0;
+  ASSERT_FALSE(common::file_system::write_to_descriptor(file_fd, data.data(), data.size(), &nwrite));
+  ASSERT_EQ(nwrite, data.size());
+
+  std::promise<void> start_reading;
+  SendFileLoopHandler hand(file_fd, data.size(), &start_reading);
+  common::libev::tcp::TcpServer server(
+      new common::net::ServerSocketEvTcp(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT)), false, &hand);
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+
+  std::string received;
+  std::thread reader([&hand, &received, &start_reading]() {
+    start_reading.get_future().wait_for(std::chrono::seconds(5));
+    char buff[64 * 1024];
+    ssize_t res;
+    while ((res = read(hand.peer(), buff, sizeof(buff))) > 0) {
+      received.append(buff, res);
+    }
+  });
+  ASSERT_EQ(server.Exec(), EXIT_SUCCESS);
+  reader.join();
+  close(hand.peer());
+  ASSERT_FALSE(common::file_system::remove_file(path));
+
+  ASSERT_TRUE(hand.closed());
+  ASSERT_GE(hand.ticks_while_sending(), 5);
+  ASSERT_EQ(received, data);
+}
+
 TEST(Libev, Http) {
   ServerWebHandler hand(kHinf);
   auto sock = new common::net::ServerSocketEvTcp(g_hs);
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <common/memory/slab_pool.h>
+
+#include <thread>
+#include <vector>
+
+namespace {
+
+class Pooled : public common::memory::PoolAllocated {
+ public:
+  explicit Pooled(int value) : value_(value) {}
+  virtual ~Pooled() {}
+
+  int GetValue() const { return value_; }
+
+ private:
+  int value_;
+  char payload_[40];
+};
+
+}  // namespace
+
+TEST(SlabPool, reuse) {
+  common::memory::SlabPool pool(32, 4);
+  void* first = pool.Allocate();
+  void* second = pool.Allocate();
+  ASSERT_NE(first, second);
+  pool.Deallocate(first);
+  ASSERT_EQ(pool.Allocate(), first);
+
+  common::memory::SlabPoolStats stats = pool.GetStats();
+  ASSERT_EQ(stats.slabs, 1u);
+  ASSERT_EQ(stats.objects_in_use, 2u);
+  ASSERT_EQ(stats.objects_free, 2u);
+  ASSERT_EQ(stats.allocations, 3u);
+
+  for (int i = 0; i < 3; ++i) {
+    pool.Allocate();
+  }
+  ASSERT_EQ(pool.GetStats().slabs, 2u);
+
+  std::thread remote([&pool, second]() { pool.DeallocateRemote(second); });
+  remote.join();
+  ASSERT_EQ(pool.GetStats().remote_frees, 1u);
+  pool.Allocate();
+  pool.Allocate();
+  pool.Allocate();
+  ASSERT_EQ(pool.Allocate(), second);
+}
+
+TEST(SlabPool, pools_lifetime) {
+  common::memory::SlabPools* pools = new common::memory::SlabPools;
+  Pooled* heap = new Pooled(1);
+  std::vector<Pooled*> objects;
+  {
+    common::memory::SlabPools::ScopedCurrent scoped(pools);
+    ASSERT_EQ(common::memory::SlabPools::Current(), pools);
+    for (int i = 0; i < 100; ++i) {
+      objects.push_back(new Pooled(i));
+    }
+    delete objects.back();
+    objects.pop_back();
+    Pooled* reused = new Pooled(99);
+    ASSERT_EQ(reused->GetValue(), 99);
+    objects.push_back(reused);
+  }
+  ASSERT_EQ(common::memory::SlabPools::Current(), nullptr);
+
+  const std::vector<common::memory::SlabPoolStats> stats = pools->GetStats();
+  ASSERT_EQ(stats.size(), 1u);
+  ASSERT_EQ(stats[0].objects_in_use, 100u);
+  ASSERT_EQ(stats[0].allocations, 101u);
+
+  // objects outlive the owner and are freed from another thread
+  pools->Release();
+  std::thread remote([&objects]() {
+    for (Pooled* object : objects) {
+      delete object;
+    }
+  });
+  remote.join();
+  delete heap;
+}
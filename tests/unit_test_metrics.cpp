@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <common/metrics/metrics.h>
+#include <common/process/process_metrics.h>
+#if defined(OS_LINUX)
+#include <common/process/process_sampler.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <common/threads/thread_pool.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+TEST(Metrics, counter_and_gauge) {
+  common::metrics::Counter* counter = METRICS()->GetCounter("test_metrics_counter_total", "Test counter");
+  ASSERT_EQ(counter, METRICS()->GetCounter("test_metrics_counter_total", "Test counter"));
+  const uint64_t before = counter->GetValue();
+
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 4; ++i) {
+    writers.push_back(std::thread([counter]() {
+      for (int j = 0; j < 1000; ++j) {
+        counter->Increment();
+      }
+    }));
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  ASSERT_EQ(counter->GetValue(), before + 4000);
+
+  common::metrics::Gauge* gauge = METRICS()->GetGauge("test_metrics_gauge", "Test gauge");
+  gauge->Set(10);
+  gauge->Increment();
+  gauge->Sub(3);
+  ASSERT_EQ(gauge->GetValue(), 8);
+}
+
+TEST(Metrics, histogram_buckets) {
+  typedef common::metrics::Histogram Histogram;
+  for (uint64_t value : {0ULL, 1ULL, 7ULL, 8ULL, 9ULL, 15ULL, 16ULL, 1000ULL, 123456789ULL, ~0ULL}) {
+    const size_t index = Histogram::BucketIndex(value);
+    ASSERT_LT(index, static_cast<size_t>(Histogram::kBucketsCount));
+    ASSERT_GE(Histogram::BucketUpperBound(index), value);
+    if (index > 0) {
+      ASSERT_LT(Histogram::BucketUpperBound(index - 1), value);
+    }
+  }
+
+  Histogram* histogram = METRICS()->GetHistogram("test_metrics_histogram", "Test histogram");
+  for (uint64_t i = 1; i <= 100; ++i) {
+    histogram->Record(i);
+  }
+  const common::metrics::HistogramSnapshot snapshot = histogram->TakeSnapshot();
+  ASSERT_EQ(snapshot.count, 100u);
+  ASSERT_EQ(snapshot.sum, 5050u);
+  const uint64_t median = snapshot.ValueAtQuantile(0.5);
+  ASSERT_GE(median, 50u);
+  ASSERT_LE(median, 55u);
+  ASSERT_GE(snapshot.ValueAtQuantile(1), 100u);
+}
+
+TEST(Metrics, prometheus_export) {
+  METRICS()->GetCounter("test_metrics_export_total", "Exported counter")->Increment(3);
+  METRICS()->GetLatencyHistogram("test_metrics_export_seconds", "Exported latency")->Record(2000000000);
+
+  common::threads::ThreadPool pool;
+  pool.Start(1);
+  std::promise<void> done;
+  pool.Post([&done]() { done.set_value(); });
+  done.get_future().wait();
+  pool.Stop();
+
+  const std::string text = METRICS()->ExportPrometheus();
+  ASSERT_NE(text.find("# TYPE test_metrics_export_total counter\ntest_metrics_export_total 3\n"), std::string::npos);
+  ASSERT_NE(text.find("# TYPE test_metrics_export_seconds summary\n"), std::string::npos);
+  ASSERT_NE(text.find("test_metrics_export_seconds_sum 2.000000000\n"), std::string::npos);
+  ASSERT_NE(text.find("test_metrics_export_seconds_count 1\n"), std::string::npos);
+  ASSERT_NE(text.find("common_thread_pool_tasks_total "), std::string::npos);
+  ASSERT_NE(text.find("common_thread_pool_task_wait_seconds_count "), std::string::npos);
+}
+
+#if defined(OS_LINUX)
+TEST(Metrics, process_metrics) {
+  auto metrics = common::process::ProcessMetrics::CreateProcessMetrics(getpid());
+  ASSERT_GT(metrics->GetResidentSetSize(), 0);
+  ASSERT_GE(metrics->GetCumulativeCPUUsage(), 0);
+}
+
+TEST(Metrics, process_sampler) {
+  common::process::ProcessSampler sampler(getpid(), 4);
+  sampler.SetSamplePss(true);
+  common::process::ProcessSample sample;
+  ASSERT_FALSE(sampler.GetLatest(&sample));
+
+  ASSERT_TRUE(sampler.Sample());
+  ASSERT_TRUE(sampler.GetLatest(&sample));
+  ASSERT_GT(sample.rss_bytes, 0);
+  ASSERT_GE(sample.threads_count, 1);
+  ASSERT_GT(sample.open_fds, 0);
+  ASSERT_GT(sample.voluntary_context_switches + sample.involuntary_context_switches, 0);
+
+  // a busy thread shows up with its name and cpu time
+  std::atomic<bool> stop(false);
+  std::promise<pid_t> busy_tid;
+  std::thread busy([&stop, &busy_tid]() {
+    pthread_setname_np(pthread_self(), "sampler_busy");
+    busy_tid.set_value(static_cast<pid_t>(syscall(SYS_gettid)));
+    while (!stop.load()) {
+    }
+  });
+  const pid_t tid = busy_tid.get_future().get();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_TRUE(sampler.Sample());
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ASSERT_TRUE(sampler.Sample());
+  stop = true;
+  busy.join();
+
+  bool found = false;
+  for (const auto& thread : sampler.GetThreads()) {
+    if (thread.tid == tid) {
+      found = true;
+      ASSERT_STREQ(thread.name, "sampler_busy");
+      ASSERT_GT(thread.cpu_usage, 0);
+    }
+  }
+  ASSERT_TRUE(found);
+
+  // the ring buffer keeps the latest samples, oldest first
+  ASSERT_FALSE(sampler.Start(10));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  sampler.Stop();
+  const auto history = sampler.GetHistory();
+  ASSERT_EQ(history.size(), 4);
+  for (size_t i = 1; i < history.size(); ++i) {
+    ASSERT_LE(history[i - 1].timestamp_msec, history[i].timestamp_msec);
+    ASSERT_LE(history[i - 1].user_cpu_msec + history[i - 1].system_cpu_msec,
+              history[i].user_cpu_msec + history[i].system_cpu_msec);
+  }
+  ASSERT_GE(sampler.GetThreads().size(), 1);
+}
+
+TEST(Metrics, process_sampler_own_fds) {
+  size_t before = 0;
+  DIR* dir = opendir("/proc/self/fd");
+  ASSERT_TRUE(dir);
+  while (struct dirent* entry = readdir(dir)) {
+    if (entry->d_name[0] != '.') {
+      before++;
+    }
+  }
+  closedir(dir);
+  before--;  // the descriptor of |dir|
+
+  common::process::ProcessSampler sampler(getpid(), 1);
+  sampler.SetSamplePss(true);
+  ASSERT_TRUE(sampler.Sample());
+  common::process::ProcessSample sample;
+  ASSERT_TRUE(sampler.GetLatest(&sample));
+  ASSERT_EQ(sample.open_fds, before);
+}
+#endif
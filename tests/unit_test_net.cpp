@@ -1,8 +1,20 @@
+#include <common/net/buffer_chain.h>
+#include <common/net/file_transfer.h>
 #include <common/net/net.h>
+#include <common/net/receive_buffer.h>
 #include <common/net/socket_tcp.h>
+#include <common/net/socket_tcp_tls.h>
 #include <common/sprintf.h>
 #include <common/threads/thread_manager.h>
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <sys/socket.h>
+
+#if defined(HAVE_OPENSSL)
+#include "test_tls_certificate.h"
+#endif
+
+#include <thread>
 
 void exec_serv(common::net::ServerSocketTcp* serv) {
   common::net::socket_info inf;
@@ -242,3 +254,268 @@ TEST(SocketTcpIpv6, bindRandomWorkflow) {
   err = serv.Close();
   ASSERT_FALSE(err);
 }
+
+namespace {
+
+std::string MakeTransferPattern(size_t size) {
+  std::string data(size, 0);
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<char>(i * 31 + (i >> 8));
+  }
+  return data;
+}
+
+void ReadAvailable(int fd, std::string* out) {
+  char buff[16 * 1024];
+  while (true) {
+    ssize_t res = read(fd, buff, sizeof(buff));
+    if (res <= 0) {
+      return;
+    }
+    out->append(buff, res);
+  }
+}
+
+// drives |transfer| against a small non blocking socket buffer
+void RunTransfer(common::net::FileTransfer* transfer, int reader, std::string* received) {
+  size_t would_block = 0;
+  while (!transfer->IsDone()) {
+    size_t nsent = 0;
+    common::ErrnoError err = transfer->Step(64 * 1024, &nsent);
+    if (err) {
+      ASSERT_EQ(err->GetErrorCode(), EAGAIN);
+      would_block++;
+      ReadAvailable(reader, received);
+    }
+  }
+  ReadAvailable(reader, received);
+  ASSERT_GT(would_block, 0);
+}
+
+}  // namespace
+
+TEST(FileTransfer, sendfile_and_copy) {
+  const std::string data = MakeTransferPattern(3 * 1024 * 1024 + 17);
+  FILE* file = tmpfile();
+  ASSERT_TRUE(file);
+  ASSERT_EQ(fwrite(data.data(), 1, data.size(), file), data.size());
+  ASSERT_EQ(fflush(file), 0);
+  const int file_fd = fileno(file);
+
+  for (int i = 0; i < 2; ++i) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    ASSERT_FALSE(common::net::set_blocking_socket(sv[0], false));
+    ASSERT_FALSE(common::net::set_blocking_socket(sv[1], false));
+
+    const off_t offset = 5;
+    std::unique_ptr<common::net::FileTransfer> transfer;
+    if (i == 0) {
+      transfer.reset(new common::net::FileTransfer(file_fd, offset, data.size() - offset, sv[0]));
+      ASSERT_EQ(transfer->GetMode(), common::net::FileTransfer::SENDFILE);
+    } else {
+      const int out = sv[0];
+      auto writer = [out](const void* buf, size_t size, size_t* nwrite_out) {
+        return common::net::write_to_tcp_socket(out, buf, size, nwrite_out);
+      };
+      transfer.reset(new common::net::FileTransfer(file_fd, offset, data.size() - offset, writer));
+      ASSERT_EQ(transfer->GetMode(), common::net::FileTransfer::COPY);
+    }
+
+    std::string received;
+    RunTransfer(transfer.get(), sv[1], &received);
+    ASSERT_EQ(transfer->GetSent(), data.size() - offset);
+    ASSERT_TRUE(received == data.substr(offset));
+    // the file position is untouched
+    ASSERT_EQ(lseek(file_fd, 0, SEEK_CUR), static_cast<off_t>(data.size()));
+    close(sv[0]);
+    close(sv[1]);
+  }
+  fclose(file);
+}
+
+TEST(FileTransfer, splice_from_pipe) {
+  const std::string data = MakeTransferPattern(48 * 1024);
+  int pfd[2];
+  ASSERT_EQ(pipe(pfd), 0);
+  ASSERT_EQ(write(pfd[1], data.data(), data.size()), static_cast<ssize_t>(data.size()));
+  close(pfd[1]);
+
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  common::net::FileTransfer transfer(pfd[0], 0, data.size(), sv[0]);
+  ASSERT_EQ(transfer.GetMode(), common::net::FileTransfer::SPLICE);
+  ASSERT_FALSE(transfer.Run(4096));
+
+  std::string received;
+  ASSERT_FALSE(common::net::set_blocking_socket(sv[1], false));
+  ReadAvailable(sv[1], &received);
+  ASSERT_TRUE(received == data);
+
+  // the pipe is drained, more bytes can't come
+  common::net::FileTransfer tail(pfd[0], 0, 1, sv[0]);
+  size_t nsent = 0;
+  ASSERT_TRUE(tail.Step(1, &nsent));
+  close(pfd[0]);
+  close(sv[0]);
+  close(sv[1]);
+}
+
+TEST(BufferChain, append_and_consume) {
+  const std::string data = MakeTransferPattern(3 * common::net::BufferChain::kBlockSize + 100);
+  common::net::BufferChain chain;
+  ASSERT_TRUE(chain.IsEmpty());
+
+  chain.Append(data.data(), 100);
+  chain.Append(data.data() + 100, 10);
+  ASSERT_EQ(chain.GetSegmentsCount(), 1);
+
+  // big buffers are adopted as one segment
+  common::char_buffer_t big(data.begin() + 110, data.end());
+  const char* big_data = big.data();
+  chain.Append(std::move(big));
+  ASSERT_EQ(chain.GetSegmentsCount(), 2);
+  ASSERT_EQ(chain.GetSize(), data.size());
+
+  std::string out(data.size(), 0);
+  ASSERT_EQ(chain.Peek(&out[0], 50), 50);
+  ASSERT_EQ(chain.GetSize(), data.size());
+  ASSERT_EQ(chain.Read(&out[0], 105), 105);
+  ASSERT_EQ(chain.Read(&out[105], 10), 10);
+  ASSERT_EQ(chain.GetSegmentsCount(), 1);
+  char first = 0;
+  ASSERT_EQ(chain.Peek(&first, 1), 1);
+  ASSERT_EQ(first, big_data[5]);
+  ASSERT_EQ(chain.Read(&out[115], data.size()), data.size() - 115);
+  ASSERT_TRUE(out == data);
+  ASSERT_TRUE(chain.IsEmpty());
+  ASSERT_EQ(chain.GetSegmentsCount(), 0);
+}
+
+TEST(BufferChain, socket_roundtrip) {
+  const std::string data = MakeTransferPattern(2 * 1024 * 1024 + 3);
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  ASSERT_FALSE(common::net::set_blocking_socket(sv[0], false));
+  ASSERT_FALSE(common::net::set_blocking_socket(sv[1], false));
+
+  common::net::BufferChain out;
+  for (size_t pos = 0; pos < data.size(); pos += 1000) {
+    out.Append(data.data() + pos, std::min<size_t>(1000, data.size() - pos));
+  }
+
+  common::net::BufferChain in;
+  while (!out.IsEmpty()) {
+    size_t nwrite = 0;
+    common::ErrnoError err = out.WriteToSocket(sv[0], &nwrite);
+    if (err) {
+      ASSERT_EQ(err->GetErrorCode(), EAGAIN);
+    } else {
+      ASSERT_LE(nwrite, common::net::BufferChain::kMaxIovecs * common::net::BufferChain::kBlockSize);
+    }
+
+    while (true) {
+      size_t nread = 0;
+      err = in.ReadFromSocket(sv[1], 5000, &nread);
+      if (err) {
+        ASSERT_EQ(err->GetErrorCode(), EAGAIN);
+        break;
+      }
+      ASSERT_LE(nread, 5000);
+    }
+  }
+  ASSERT_EQ(in.GetSize(), data.size());
+
+  std::string received(data.size(), 0);
+  ASSERT_EQ(in.Read(&received[0], received.size()), data.size());
+  ASSERT_TRUE(received == data);
+
+  close(sv[0]);
+  size_t nread = 0;
+  common::ErrnoError err = in.ReadFromSocket(sv[1], 10, &nread);
+  ASSERT_TRUE(err);
+  ASSERT_EQ(err->GetErrorCode(), ECONNRESET);
+  close(sv[1]);
+}
+
+TEST(ReceiveBuffer, consume_and_grow) {
+  common::net::ReceiveBuffer buffer;
+  ASSERT_TRUE(buffer.IsEmpty());
+  ASSERT_EQ(buffer.GetCapacity(), 0);
+
+  size_t available = 0;
+  char* tail = buffer.PrepareWrite(4, &available);
+  ASSERT_EQ(available, common::net::ReceiveBuffer::kBlockSize);
+  memcpy(tail, "abcd", 4);
+  buffer.CommitWrite(4);
+  buffer.Consume(1);
+  ASSERT_EQ(std::string(buffer.GetData(), buffer.GetSize()), "bcd");
+
+  // compacts the consumed front before growing
+  tail = buffer.PrepareWrite(common::net::ReceiveBuffer::kBlockSize - 3, &available);
+  ASSERT_EQ(buffer.GetCapacity(), common::net::ReceiveBuffer::kBlockSize);
+  ASSERT_EQ(available, common::net::ReceiveBuffer::kBlockSize - 3);
+  ASSERT_EQ(std::string(buffer.GetData(), buffer.GetSize()), "bcd");
+
+  tail = buffer.PrepareWrite(common::net::ReceiveBuffer::kMaxIdleCapacity, &available);
+  ASSERT_GE(available, common::net::ReceiveBuffer::kMaxIdleCapacity);
+  memset(tail, 'x', available);
+  buffer.CommitWrite(available);
+  ASSERT_EQ(std::string(buffer.GetData(), 3), "bcd");
+  ASSERT_GT(buffer.GetCapacity(), common::net::ReceiveBuffer::kMaxIdleCapacity);
+
+  // a big burst doesn't pin memory once drained
+  buffer.Consume(buffer.GetSize());
+  ASSERT_TRUE(buffer.IsEmpty());
+  ASSERT_EQ(buffer.GetCapacity(), 0);
+}
+
+#if defined(HAVE_OPENSSL)
+TEST(SocketTcpTls, session_resumption) {
+  const std::string cert = "/tmp/common_unit_test_tls_cert.pem";
+  const std::string key = "/tmp/common_unit_test_tls_key.pem";
+  ASSERT_TRUE(WriteSelfSignedCertificate(cert, key));
+
+  common::net::ServerSocketTcpTls server(common::net::HostAndPort::CreateLocalHostIPV4(RANDOM_PORT));
+  ASSERT_FALSE(server.LoadCertificates(cert, key));
+  ASSERT_FALSE(server.Bind(true));
+  ASSERT_FALSE(server.Listen(5));
+
+  const int kConnections = 2;
+  std::thread server_thread([&server]() {
+    for (int i = 0; i < kConnections; ++i) {
+      common::net::socket_info info;
+      SSL* ssl = nullptr;
+      ASSERT_FALSE(server.Accept(&info, &ssl));
+      common::net::TcpTlsSocketHolder holder(info, ssl);
+      size_t nwrite = 0;
+      ASSERT_FALSE(holder.Write("ok", 2, &nwrite));
+      // until the client is gone
+      char buff[16];
+      size_t nread = 0;
+      while (!holder.Read(buff, sizeof(buff), &nread)) {
+      }
+      ASSERT_FALSE(holder.Close());
+    }
+  });
+
+  common::net::TlsClientSessionCache::GetInstance().Clear();
+  for (int i = 0; i < kConnections; ++i) {
+    common::net::ClientSocketTcpTls client(server.GetHost());
+    ASSERT_FALSE(client.Connect());
+    ASSERT_EQ(client.IsSessionReused(), i != 0);
+    // TLS 1.3 tickets arrive with the first read
+    char buff[2];
+    size_t nread = 0;
+    ASSERT_FALSE(client.Read(buff, sizeof(buff), &nread));
+    ASSERT_EQ(std::string(buff, nread), "ok");
+    ASSERT_FALSE(client.Disconnect());
+  }
+  ASSERT_EQ(common::net::TlsClientSessionCache::GetInstance().GetSize(), 1);
+
+  server_thread.join();
+  ASSERT_FALSE(server.Close());
+  remove(cert.c_str());
+  remove(key.c_str());
+}
+#endif
@@ -32,8 +32,12 @@
 #include <common/byte_writer.h>
 #include <common/convert2string.h>
 #include <common/sprintf.h>
+#include <common/static_string_map.h>
+#include <common/string_number_conversions.h>
 #include <common/string_piece.h>
+#include <common/icu_utf.h>
 #include <common/string_util.h>
+#include <common/utf_string_conversion_utils.h>
 #include <common/utf_string_conversions.h>
 
 #include <common/compress/base64.h>
@@ -47,6 +51,8 @@
 #include <common/qt/convert2string.h>
 #endif
 
+#include <random>
+
 #define OPENSSL_VERSION_NUMBER_EXAMPLE 0x00090301
 #define OPENSSL_VERSION_TEXT_EXAMPLE "0.9.3.1"
 
@@ -193,6 +199,129 @@ TEST(string, utils) {
   ASSERT_TRUE(common::StartsWithASCII(test_data_low, test_data_lower, false));
 }
 
+namespace {
+
+// Code point at a time reference for the block based UTF-8 routines.
+bool ReferenceIsStringUTF8(const std::string& str) {
+  const int32_t src_len = static_cast<int32_t>(str.length());
+  int32_t char_index = 0;
+  while (char_index < src_len) {
+    int32_t code_point;
+    CBU8_NEXT(str.data(), char_index, src_len, code_point);
+    if (!common::IsValidCharacter(code_point)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename SRC_CHAR, typename DEST_STRING>
+bool ReferenceConvert(const SRC_CHAR* src, size_t src_len, DEST_STRING* output) {
+  bool success = true;
+  output->clear();
+  const int32_t src_len32 = static_cast<int32_t>(src_len);
+  for (int32_t i = 0; i < src_len32; i++) {
+    uint32_t code_point;
+    if (common::ReadUnicodeCharacter(src, src_len32, &i, &code_point)) {
+      common::WriteUnicodeCharacter(code_point, output);
+    } else {
+      common::WriteUnicodeCharacter(0xFFFD, output);
+      success = false;
+    }
+  }
+  return success;
+}
+
+void AppendUTF8(uint32_t code_point, std::string* out) {
+  common::WriteUnicodeCharacter(code_point, out);
+}
+
+std::string RandomUTF8(std::mt19937* gen, size_t pieces, bool corrupt) {
+  std::string out;
+  for (size_t i = 0; i < pieces; ++i) {
+    switch ((*gen)() % 6) {
+      case 0:
+        out.append(1 + (*gen)() % 40, static_cast<char>('a' + (*gen)() % 26));
+        break;
+      case 1:
+        AppendUTF8(0x80 + (*gen)() % (0x800 - 0x80), &out);
+        break;
+      case 2:
+        AppendUTF8(0x4E00 + (*gen)() % 0x5000, &out);
+        break;
+      case 3:
+        AppendUTF8(0xE000 + (*gen)() % 0x2000, &out);
+        break;
+      case 4:
+        AppendUTF8(0x10000 + (*gen)() % 0x100000, &out);
+        break;
+      default:
+        AppendUTF8(0x1F600 + (*gen)() % 0x50, &out);
+        break;
+    }
+  }
+  if (corrupt && !out.empty()) {
+    out[(*gen)() % out.size()] = static_cast<char>((*gen)() % 256);
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(string, utf8_validation) {
+  const std::string bad[] = {"\xC0\x80",         "\xC1\xBF",         "\xE0\x80\x80",     "\xED\xA0\x80",
+                             "\xF0\x80\x80\x80", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xE2\x82",
+                             "\x80",             "\xE2\x82\xAC\xAC", "\xEF\xBF\xBF",     "\xEF\xB7\x90",
+                             "\xF0\x9F\xBF\xBE", "\xFF"};
+  const std::string good[] = {"\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xF4\x8F\xBF\xBD", "\xEF\xBF\xBD", "\xD0\x9F",
+                              "\xEF\xB7\xB0", "\xE4\xBF\xBE"};
+  // Shift every sample across the 16 and 32 byte block boundaries.
+  for (size_t shift = 0; shift < 40; ++shift) {
+    const std::string prefix(shift, 'x');
+    for (const std::string& sample : bad) {
+      ASSERT_FALSE(common::IsStringUTF8(prefix + sample)) << shift;
+      ASSERT_FALSE(common::IsStringUTF8(prefix + sample + std::string(40, 'y'))) << shift;
+    }
+    for (const std::string& sample : good) {
+      ASSERT_TRUE(common::IsStringUTF8(prefix + sample)) << shift;
+      ASSERT_TRUE(common::IsStringUTF8(prefix + sample + std::string(40, 'y'))) << shift;
+    }
+    ASSERT_TRUE(common::IsStringASCII(prefix));
+    ASSERT_FALSE(common::IsStringASCII(prefix + "\x80" + prefix));
+    ASSERT_FALSE(common::IsStringASCII(common::UTF8ToUTF16(prefix + "\xD0\x9F" + prefix)));
+    ASSERT_TRUE(common::IsStringASCII(common::UTF8ToUTF16(prefix)));
+  }
+  ASSERT_TRUE(common::IsStringUTF8(std::string()));
+  ASSERT_TRUE(common::IsStringUTF8(std::string("a\0b", 3)));
+}
+
+TEST(string, utf_conversions_match_reference) {
+  std::mt19937 gen(20140101);
+  for (size_t round = 0; round < 2000; ++round) {
+    const std::string utf8 = RandomUTF8(&gen, gen() % 24, round % 3 == 0);
+    ASSERT_EQ(ReferenceIsStringUTF8(utf8), common::IsStringUTF8(utf8)) << round;
+
+    common::string16 utf16, expected16;
+    ASSERT_EQ(ReferenceConvert(utf8.data(), utf8.size(), &expected16),
+              common::UTF8ToUTF16(utf8.data(), utf8.size(), &utf16));
+    ASSERT_EQ(expected16, utf16) << round;
+
+    std::wstring wide, expected_wide;
+    ASSERT_EQ(ReferenceConvert(utf8.data(), utf8.size(), &expected_wide),
+              common::UTF8ToWide(utf8.data(), utf8.size(), &wide));
+    ASSERT_EQ(expected_wide, wide) << round;
+
+    if (round % 5 == 0 && !utf16.empty()) {
+      // Unpaired surrogates take the replacement path.
+      utf16[gen() % utf16.size()] = static_cast<common::char16>(0xD800 + gen() % 0x800);
+    }
+    std::string back, expected8;
+    ASSERT_EQ(ReferenceConvert(utf16.data(), utf16.size(), &expected8),
+              common::UTF16ToUTF8(utf16.data(), utf16.size(), &back));
+    ASSERT_EQ(expected8, back) << round;
+  }
+}
+
 TEST(string, StringPiece) {
   const std::string sasha_string = "sasha";
   common::StringPiece str_sasha(sasha_string);
@@ -820,6 +949,122 @@ TEST(ConvertToString, double) {
   ASSERT_EQ(s, "3.141593");
 }
 
+TEST(ConvertToString, shortest) {
+  ASSERT_EQ(common::NumberToString(0.1), "0.1");
+  ASSERT_EQ(common::NumberToString(0.1f), "0.1");
+  ASSERT_EQ(common::NumberToString(-2.5), "-2.5");
+  ASSERT_EQ(common::NumberToString(1e21), "1e+21");
+  ASSERT_EQ(common::NumberToString(std::numeric_limits<double>::infinity()), PPLUS_INF);
+  ASSERT_EQ(common::NumberToString(-std::numeric_limits<double>::infinity()), MINUS_INF);
+
+  const double values[] = {3.141592653589793, 1.7976931348623157e308, 2.2250738585072014e-308, 5e-324, 123456789.125};
+  for (double val : values) {
+    double res;
+    ASSERT_TRUE(common::StringToDouble(common::NumberToString(val), &res));
+    ASSERT_EQ(val, res);
+  }
+}
+
+TEST(ConvertToString, fixed) {
+  ASSERT_EQ(common::NumberToString(2.5, 0), "2");
+  ASSERT_EQ(common::NumberToString(-0.125, 2), "-0.12");
+  ASSERT_EQ(common::NumberToString(1.0, 8), "1.00000000");
+  ASSERT_EQ(common::NumberToString(1e300, 1).size(), 303);
+  ASSERT_EQ(common::ConvertToCharBytes(1e300, 1).size(), 303);
+}
+
+TEST(ConvertToString, append_and_to_chars) {
+  std::string out = "v=";
+  common::AppendToString(&out, -42);
+  out += ',';
+  common::AppendToString(&out, std::numeric_limits<uint64_t>::max());
+  out += ',';
+  common::AppendToString(&out, 0.25);
+  out += ',';
+  common::AppendToString(&out, 1.0 / 3, 3);
+  ASSERT_EQ(out, "v=-42,18446744073709551615,0.25,0.333");
+
+  char buffer[common::kMaxNumberChars];
+  size_t len = common::ToChars(common::make_span(buffer, sizeof(buffer)), std::numeric_limits<int64_t>::min());
+  ASSERT_EQ(std::string(buffer, len), "-9223372036854775808");
+  len = common::ToChars(common::make_span(buffer, sizeof(buffer)), -2.2250738585072014e-308);
+  ASSERT_EQ(std::string(buffer, len), "-2.2250738585072014e-308");
+
+  char small[3];
+  ASSERT_EQ(common::ToChars(common::make_span(small, sizeof(small)), 1234), 0);
+  ASSERT_EQ(common::ToChars(common::make_span(small, sizeof(small)), 123), 3);
+  ASSERT_EQ(common::ToChars(common::make_span(small, sizeof(small)), 1.5, 2), 0);
+}
+
+TEST(StringToDouble, parse) {
+  double val;
+  ASSERT_TRUE(common::StringToDouble("0.1", &val));
+  ASSERT_EQ(val, 0.1);
+  ASSERT_TRUE(common::StringToDouble("+1.5e3", &val));
+  ASSERT_EQ(val, 1500.0);
+  ASSERT_TRUE(common::StringToDouble(common::UTF8ToUTF16("-7.25"), &val));
+  ASSERT_EQ(val, -7.25);
+
+  ASSERT_FALSE(common::StringToDouble("", &val));
+  ASSERT_FALSE(common::StringToDouble(" 1", &val));
+  ASSERT_FALSE(common::StringToDouble("1 ", &val));
+  ASSERT_FALSE(common::StringToDouble("+-1", &val));
+  ASSERT_FALSE(common::StringToDouble("abc", &val));
+  ASSERT_EQ(val, 0);
+  ASSERT_FALSE(common::StringToDouble("1e400", &val));
+  ASSERT_EQ(val, std::numeric_limits<double>::infinity());
+  ASSERT_FALSE(common::StringToDouble("-1e400", &val));
+  ASSERT_EQ(val, -std::numeric_limits<double>::infinity());
+
+  float fval;
+  ASSERT_TRUE(common::StringToFloat("3.4028234e38", &fval));
+  ASSERT_EQ(fval, 3.4028234e38f);
+  ASSERT_FALSE(common::ConvertFromString("abc", &fval));
+}
+
+namespace {
+
+enum Color { RED, GREEN, BLUE, CYAN };
+
+constexpr common::StaticStringMapEntry<Color> kColors[] = {
+    {"red", RED}, {"Green", GREEN}, {"blue", BLUE}, {"cyan", CYAN}, {"RED", BLUE}};
+constexpr auto kColorsMap = common::MakeStaticStringMap(kColors);
+static_assert(kColorsMap.IsPerfect(), "colors table has no perfect hash");
+
+}  // namespace
+
+TEST(StaticStringMap, lookup) {
+  ASSERT_EQ(*kColorsMap.Find("green"), GREEN);
+  ASSERT_EQ(*kColorsMap.Find("GREEN"), GREEN);
+  ASSERT_EQ(*kColorsMap.FindCaseSensitive("Green"), GREEN);
+  ASSERT_FALSE(kColorsMap.FindCaseSensitive("green"));
+  // "RED" duplicates "red" ignoring case, the first entry wins
+  ASSERT_EQ(*kColorsMap.Find("RED"), RED);
+  ASSERT_FALSE(kColorsMap.FindCaseSensitive("RED"));
+  ASSERT_FALSE(kColorsMap.Find("magenta"));
+  ASSERT_FALSE(kColorsMap.Find("re"));
+  ASSERT_FALSE(kColorsMap.Find(""));
+
+  // every key of a larger table is found, nothing else is
+  std::vector<std::string> names;
+  for (int i = 0; i < 500; ++i) {
+    names.push_back("key" + common::ConvertToString(i));
+  }
+  common::StaticStringMapEntry<int> entries[500] = {};
+  for (int i = 0; i < 500; ++i) {
+    entries[i] = {names[i].c_str(), i};
+  }
+  const common::StaticStringMap<int, 500> map(entries);
+  ASSERT_TRUE(map.IsPerfect());
+  for (int i = 0; i < 500; ++i) {
+    const int* value = map.Find(common::StringPiece("KEY" + common::ConvertToString(i)));
+    ASSERT_TRUE(value);
+    ASSERT_EQ(*value, i);
+  }
+  ASSERT_FALSE(map.Find("key500"));
+  ASSERT_FALSE(map.Find("key-1"));
+}
+
 TEST(ConvertToString, hex) {
   std::string china("你好");
   std::string hexed;
@@ -198,3 +198,15 @@ TEST(iedcoder, factory) {
     delete dec2;
   }
 }
+
+TEST(edcoder, types) {
+  for (size_t i = 0; i < common::ENCODER_DECODER_NUM_TYPES; ++i) {
+    const common::EDType type = static_cast<common::EDType>(i);
+    common::EDType parsed;
+    ASSERT_TRUE(common::ConvertFromString(common::ConvertToString(type), &parsed));
+    ASSERT_EQ(parsed, type);
+  }
+  common::EDType parsed;
+  ASSERT_FALSE(common::ConvertFromString("base64", &parsed));
+  ASSERT_FALSE(common::ConvertFromString("Base", &parsed));
+}
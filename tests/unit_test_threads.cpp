@@ -1,6 +1,22 @@
 #include <gtest/gtest.h>
 
+#include <common/threads/barrier.h>
+#include <common/threads/event.h>
+#include <common/threads/latch.h>
+#include <common/threads/parallel.h>
+#include <common/threads/parker.h>
 #include <common/threads/thread_manager.h>
+#include <common/threads/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
 
 std::shared_ptr<common::threads::Thread<void> > some_thread;
 void test() {
@@ -28,3 +44,209 @@ TEST(THREAD_MANAGER, tests) {
   some_thread->Join();
   ASSERT_EQ(some_thread->GetHandle(), common::threads::invalid_thread_handle());
 }
+
+void check_worker_context() {
+  common::threads::ThreadContext* context = common::threads::CurrentThreadContext();
+  ASSERT_EQ(context->role, common::threads::THREAD_ROLE_WORKER);
+  ASSERT_EQ(context->thread, some_thread.get());
+  ASSERT_EQ(common::threads::CurrentThreadId(), common::threads::PlatformThread::GetCurrentId());
+  ASSERT_EQ(common::threads::CurrentThreadId(), some_thread->GetHandle().GetTid());
+}
+
+TEST(THREAD_MANAGER, context) {
+  ASSERT_TRUE(THREAD_MANAGER()->IsMainThread());
+  ASSERT_EQ(common::threads::CurrentThreadContext()->role, common::threads::THREAD_ROLE_MAIN);
+  ASSERT_EQ(common::threads::CurrentThreadId(), common::threads::PlatformThread::GetCurrentId());
+
+  some_thread = THREAD_MANAGER()->CreateThread(&check_worker_context);
+  ASSERT_TRUE(some_thread->Start());
+  some_thread->Join();
+
+  // the cached id follows the process into a fork child
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {
+    _exit(common::threads::CurrentThreadId() == common::threads::PlatformThread::GetCurrentId() ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(Threads, event) {
+  common::threads::Event manual(1, 0);
+  ASSERT_FALSE(manual.IsSignaled());
+  ASSERT_FALSE(manual.Wait(0));
+  ASSERT_FALSE(manual.Wait(10));
+  manual.Set();
+  ASSERT_TRUE(manual.IsSignaled());
+  ASSERT_TRUE(manual.Wait(0));
+  ASSERT_TRUE(manual.Wait(INFINITE_TIMEOUT_MSEC));
+  manual.Reset();
+  ASSERT_FALSE(manual.Wait(0));
+
+  // auto reset: exactly one wait consumes the signal
+  common::threads::Event autoreset(0, 1);
+  ASSERT_TRUE(autoreset.IsSignaled());
+  ASSERT_TRUE(autoreset.Wait(0));
+  ASSERT_FALSE(autoreset.IsSignaled());
+  ASSERT_FALSE(autoreset.Wait(0));
+
+  // ping-pong through two auto reset events wakes parked waiters
+  common::threads::Event ping(0, 0);
+  common::threads::Event pong(0, 0);
+  const int rounds = 1000;
+  std::thread peer([&ping, &pong, rounds]() {
+    for (int i = 0; i < rounds; ++i) {
+      ping.Wait(INFINITE_TIMEOUT_MSEC);
+      pong.Set();
+    }
+  });
+  for (int i = 0; i < rounds; ++i) {
+    ping.Set();
+    ASSERT_TRUE(pong.Wait(INFINITE_TIMEOUT_MSEC));
+  }
+  peer.join();
+}
+
+TEST(Threads, latch_and_barrier) {
+  const uint32_t count = 4;
+  common::threads::Latch latch(count);
+  ASSERT_FALSE(latch.TryWait());
+  ASSERT_FALSE(latch.WaitFor(10));
+
+  common::threads::barrier phase(count);
+  std::atomic<uint32_t> arrived(0);
+  std::atomic<bool> mismatch(false);
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < count; ++i) {
+    threads.emplace_back([&]() {
+      latch.ArriveAndWait();
+      for (uint32_t round = 1; round <= 100; ++round) {
+        arrived.fetch_add(1);
+        phase.Wait();
+        // every thread of this round has arrived before anybody leaves the barrier
+        if (arrived.load() < round * count) {
+          mismatch = true;
+        }
+        phase.Wait();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(latch.TryWait());
+  ASSERT_FALSE(mismatch.load());
+  ASSERT_EQ(arrived.load(), 100 * count);
+}
+
+TEST(Threads, parker) {
+  common::threads::Parker parker;
+  ASSERT_FALSE(parker.ParkFor(0));
+  ASSERT_FALSE(parker.ParkFor(10));
+
+  // the token is remembered and several unparks collapse into one
+  parker.Unpark();
+  parker.Unpark();
+  ASSERT_TRUE(parker.ParkFor(0));
+  ASSERT_FALSE(parker.ParkFor(0));
+
+  std::atomic<bool> ready(false);
+  std::thread waker([&parker, &ready]() {
+    ready = true;
+    parker.Unpark();
+  });
+  while (!ready.load()) {
+    parker.Park();
+  }
+  waker.join();
+}
+
+TEST(Threads, parallel_algorithms) {
+  common::threads::ThreadPool pool;
+  pool.Start(3);
+
+  std::vector<uint64_t> values(100003);
+  std::iota(values.begin(), values.end(), 1);
+
+  // every index is visited exactly once
+  std::vector<std::atomic<int> > visits(values.size());
+  ASSERT_TRUE(common::threads::ParallelFor(&pool, 0, visits.size(), 1000, [&visits](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      visits[i].fetch_add(1);
+    }
+  }));
+  for (const auto& visit : visits) {
+    ASSERT_EQ(visit.load(), 1);
+  }
+
+  auto sum = [&values](size_t begin, size_t end, uint64_t init) {
+    return std::accumulate(values.begin() + begin, values.begin() + end, init);
+  };
+  auto plus = [](uint64_t left, uint64_t right) { return left + right; };
+  const uint64_t expected = std::accumulate(values.begin(), values.end(), uint64_t(0));
+  ASSERT_EQ(common::threads::ParallelReduce(&pool, 0, values.size(), 0, uint64_t(0), sum, plus), expected);
+  ASSERT_EQ(common::threads::ParallelReduce(&pool, 0, values.size(), 7, uint64_t(0), sum, plus), expected);
+  ASSERT_EQ(common::threads::ParallelReduce<uint64_t>(nullptr, 0, values.size(), 0, 0, sum, plus), expected);
+  ASSERT_EQ(common::threads::ParallelReduce<uint64_t>(&pool, 5, 5, 0, 42, sum, plus), 42u);
+
+  // combine is applied in chunk order
+  std::string letters = "abcdefghijklmnopqrstuvwxyz";
+  auto concat = [&letters](size_t begin, size_t end, std::string init) {
+    return init + letters.substr(begin, end - begin);
+  };
+  auto append = [](const std::string& left, const std::string& right) { return left + right; };
+  ASSERT_EQ(common::threads::ParallelReduce(&pool, 0, letters.size(), 3, std::string(), concat, append), letters);
+
+  std::mt19937 gen(42);
+  for (size_t size : {0, 1, 2, 17, 1000, 65537}) {
+    std::vector<int> data(size);
+    for (auto& item : data) {
+      item = static_cast<int>(gen() % 1000);
+    }
+    std::vector<int> sorted = data;
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_TRUE(common::threads::ParallelSort(&pool, data.begin(), data.end()));
+    ASSERT_EQ(data, sorted);
+  }
+
+  // nested use from a worker of a single thread pool does not deadlock
+  common::threads::ThreadPool single;
+  single.Start(1);
+  common::threads::Latch nested_done(1);
+  uint64_t nested = 0;
+  single.Post([&]() {
+    nested = common::threads::ParallelReduce(&single, 0, values.size(), 100, uint64_t(0), sum, plus);
+    nested_done.CountDown();
+  });
+  nested_done.Wait();
+  ASSERT_EQ(nested, expected);
+  single.Stop();
+
+  // chunks which did not start yet are skipped after cancellation
+  common::threads::CancellationFlag cancel;
+  std::atomic<size_t> processed(0);
+  ASSERT_FALSE(common::threads::ParallelFor(
+      &pool, 0, 1000, 1,
+      [&cancel, &processed](size_t begin, size_t end) {
+        processed.fetch_add(end - begin);
+        cancel.Cancel();
+      },
+      &cancel));
+  ASSERT_LT(processed.load(), 1000u);
+  ASSERT_FALSE(common::threads::ParallelFor(&pool, 0, 10, 1, [](size_t, size_t) {}, &cancel));
+
+  // a stopped pool runs every chunk on the calling thread
+  pool.Stop();
+  ASSERT_FALSE(pool.IsRunning());
+  const std::thread::id caller = std::this_thread::get_id();
+  std::atomic<size_t> foreign(0);
+  ASSERT_TRUE(common::threads::ParallelFor(&pool, 0, 100, 1, [caller, &foreign](size_t, size_t) {
+    if (std::this_thread::get_id() != caller) {
+      foreign.fetch_add(1);
+    }
+  }));
+  ASSERT_EQ(foreign.load(), 0u);
+}
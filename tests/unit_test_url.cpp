@@ -30,6 +30,8 @@
 #include <common/string_split.h>
 #include <common/string_util.h>
 #include <common/uri/gurl.h>
+#include <common/uri/url_constants.h>
+#include <common/uri/url_view.h>
 #include <gtest/gtest.h>
 
 #define HTTP_PATH "/home/index.html"
@@ -334,3 +336,78 @@ TEST(Url, IsValid) {
   ASSERT_EQ(spl.size(), 4);
   ASSERT_EQ(dvb.query(), "modulation=\"QAM 64\"&trans-mode=8k&bandwidth=8&frequency=514000000");
 }
+
+TEST(Url, View) {
+  const common::uri::UrlView http("http://user:pw@Example.com:8080/a/b?x=1&y=2#frag");
+  ASSERT_TRUE(http.is_valid());
+  ASSERT_FALSE(http.is_origin_form());
+  ASSERT_EQ(http.known_scheme(), common::uri::KNOWN_SCHEME_HTTP);
+  ASSERT_TRUE(http.SchemeIsHTTPOrHTTPS());
+  ASSERT_TRUE(http.IsStandard());
+  ASSERT_EQ(http.username_piece(), "user");
+  ASSERT_EQ(http.password_piece(), "pw");
+  ASSERT_EQ(http.host_piece(), "Example.com");
+  ASSERT_EQ(http.IntPort(), 8080);
+  ASSERT_EQ(http.path_piece(), "/a/b");
+  ASSERT_EQ(http.query_piece(), "x=1&y=2");
+  ASSERT_EQ(http.ref_piece(), "frag");
+  ASSERT_EQ(http.PathForRequestPiece(), "/a/b?x=1&y=2");
+  const common::uri::GURL canonical = http.ToGURL();
+  ASSERT_TRUE(canonical.is_valid());
+  ASSERT_EQ(canonical.host(), "example.com");
+  ASSERT_EQ(canonical.PathForRequest(), http.PathForRequestPiece().as_string());
+
+  const common::uri::UrlView target("/api/v1/items?id=3#top");
+  ASSERT_TRUE(target.is_valid());
+  ASSERT_TRUE(target.is_origin_form());
+  ASSERT_EQ(target.known_scheme(), common::uri::KNOWN_SCHEME_NONE);
+  ASSERT_FALSE(target.has_host());
+  ASSERT_EQ(target.path_piece(), "/api/v1/items");
+  ASSERT_EQ(target.query_piece(), "id=3");
+  ASSERT_EQ(target.ref_piece(), "top");
+  ASSERT_EQ(target.PathForRequestPiece(), "/api/v1/items?id=3");
+  ASSERT_FALSE(target.ToGURL().is_valid());
+  ASSERT_EQ(common::uri::UrlView("/").PathForRequestPiece(), "/");
+  ASSERT_EQ(common::uri::UrlView("http://host").PathForRequestPiece(), "/");
+
+  ASSERT_EQ(common::uri::UrlView("HTTPS://host/").known_scheme(), common::uri::KNOWN_SCHEME_HTTPS);
+  ASSERT_EQ(common::uri::UrlView("foo:bar").known_scheme(), common::uri::KNOWN_SCHEME_OTHER);
+  ASSERT_FALSE(common::uri::UrlView("foo:bar").IsStandard());
+  ASSERT_FALSE(common::uri::UrlView("").is_valid());
+  ASSERT_FALSE(common::uri::UrlView("no scheme here").is_valid());
+
+  const char* schemes[] = {common::uri::kHttpScheme,   common::uri::kHttpsScheme,  common::uri::kWsScheme,
+                           common::uri::kWssScheme,    common::uri::kFtpScheme,    common::uri::kFileScheme,
+                           common::uri::kDevScheme,    common::uri::kGsScheme,     common::uri::kS3Scheme,
+                           common::uri::kUnknownScheme, common::uri::kUdpScheme,   common::uri::kRtpScheme,
+                           common::uri::kSrtScheme,    common::uri::kTcpScheme,    common::uri::kRtmpScheme,
+                           common::uri::kRtmpsScheme,  common::uri::kRtmptScheme,  common::uri::kRtmpeScheme,
+                           common::uri::kRtmfpScheme,  common::uri::kWebRTCScheme, common::uri::kWebRTCsScheme,
+                           common::uri::kRtspScheme,   common::uri::kDataScheme,   common::uri::kTelScheme};
+  for (const char* scheme : schemes) {
+    const common::uri::KnownScheme known = common::uri::LookupKnownScheme(scheme);
+    ASSERT_NE(known, common::uri::KNOWN_SCHEME_OTHER) << scheme;
+    ASSERT_NE(known, common::uri::KNOWN_SCHEME_NONE) << scheme;
+  }
+  ASSERT_EQ(common::uri::LookupKnownScheme("rtmpx"), common::uri::KNOWN_SCHEME_OTHER);
+
+  // Canonical input parses into the same components as GURL.
+  const common::uri::UrlView udp(UDP_LINK_QUERY);
+  ASSERT_EQ(udp.known_scheme(), common::uri::KNOWN_SCHEME_UDP);
+  ASSERT_EQ(udp.host_piece(), "224.96.9.196");
+  ASSERT_EQ(udp.IntPort(), 2777);
+  ASSERT_EQ(udp.query_piece(), "localaddr=192.168.40.10");
+
+  const char* links[] = {WEBRTC_LINK, WEBRTCS_LINK, UDP_LINK, RTP_LINK, "rtsp://cam.local:8554/stream1",
+                         "tcp://127.0.0.1:6000", "srt://10.0.0.1:9000/live?mode=caller", "https://fastogt.com/a?b=c"};
+  for (const char* link : links) {
+    const common::uri::UrlView view(link);
+    const common::uri::GURL url(link);
+    ASSERT_TRUE(view.is_valid()) << link;
+    ASSERT_EQ(view.scheme_piece(), url.scheme_piece()) << link;
+    ASSERT_EQ(view.host_piece(), url.host_piece()) << link;
+    ASSERT_EQ(view.port_piece(), url.port_piece()) << link;
+    ASSERT_EQ(view.path_piece(), url.path_piece()) << link;
+    ASSERT_EQ(view.query_piece(), url.query_piece()) << link;
+  }
+}
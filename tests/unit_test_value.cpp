@@ -100,3 +100,26 @@ TEST(Value, create_and_get_complex_type) {
   ASSERT_TRUE(val_hash && val_hash->GetType() == common::Value::TYPE_HASH);
   delete val_hash;
 }
+
+TEST(Value, hash_equals_deep_copy) {
+  common::HashValue* hash = common::Value::CreateHashValue();
+  for (int i = 0; i < 64; ++i) {
+    hash->Insert("key" + std::to_string(i), common::Value::CreateInteger32Value(i));
+  }
+
+  common::HashValue* copy = hash->DeepCopy();
+  ASSERT_TRUE(hash->Equals(copy));
+  ASSERT_TRUE(copy->Equals(hash));
+
+  common::HashValue* other = common::Value::CreateHashValue();
+  for (int i = 63; i >= 0; --i) {
+    other->Insert("key" + std::to_string(i), common::Value::CreateInteger32Value(i == 7 ? 8 : i));
+  }
+  ASSERT_FALSE(hash->Equals(other));
+  ASSERT_TRUE(other->Insert("extra", common::Value::CreateNullValue()));
+  ASSERT_FALSE(hash->Equals(other));
+
+  delete other;
+  delete copy;
+  delete hash;
+}
@@ -35,6 +35,8 @@
 #include <common/net/net.h>
 #include <common/threads/thread_manager.h>
 
+#include <sys/socket.h>
+
 namespace {
 
 // Use real IoLoop for testing
@@ -63,4 +65,57 @@ TEST(WebSocket, DISABLED_InvalidFrame) {
   SUCCEED();
 }
 
+// Text frame as a client sends it, payloads up to 64K.
+std::string MakeTextFrame(const std::string& payload, bool masked) {
+  std::string frame(1, '\x81');
+  const char mask_bit = masked ? '\x80' : '\x00';
+  if (payload.size() < 126) {
+    frame += static_cast<char>(mask_bit | payload.size());
+  } else {
+    frame += static_cast<char>(mask_bit | 126);
+    frame += static_cast<char>(payload.size() >> 8);
+    frame += static_cast<char>(payload.size() & 0xff);
+  }
+
+  if (!masked) {
+    return frame + payload;
+  }
+
+  const char key[4] = {0x12, 0x34, 0x56, 0x78};
+  frame.append(key, sizeof(key));
+  for (size_t i = 0; i < payload.size(); ++i) {
+    frame += static_cast<char>(payload[i] ^ key[i % 4]);
+  }
+  return frame;
+}
+
+TEST(WebSocket, CoalescedFrames) {
+  int sv[2];
+  ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+  common::libev::websocket::WebSocketServerClient client(nullptr, common::net::socket_info(sv[0]));
+
+  const std::vector<std::string> payloads = {"hello", "abc", std::string(300, 'x'), "split frame"};
+  std::string stream;
+  for (size_t i = 0; i < payloads.size(); ++i) {
+    stream += MakeTextFrame(payloads[i], i % 2 == 0);
+  }
+
+  std::vector<std::string> received;
+  auto collect = [&received](char* data, size_t size) { received.push_back(std::string(data, size)); };
+
+  // three frames and the head of the last one arrive with a single read
+  const size_t split = stream.size() - 5;
+  ASSERT_EQ(write(sv[1], stream.data(), split), static_cast<ssize_t>(split));
+  ASSERT_FALSE(client.ProcessFrame(collect));
+  ASSERT_EQ(received, std::vector<std::string>(payloads.begin(), payloads.begin() + 3));
+
+  ASSERT_EQ(write(sv[1], stream.data() + split, stream.size() - split), static_cast<ssize_t>(stream.size() - split));
+  ASSERT_FALSE(client.ProcessFrame(collect));
+  ASSERT_EQ(received, payloads);
+  ASSERT_EQ(client.GetReadBufferSize(), 0);
+
+  ASSERT_FALSE(client.Close());
+  close(sv[1]);
+}
+
 }  // namespace
\ No newline at end of file
@@ -205,6 +205,14 @@ class ServerWebsockHandler : public common::libev::IoLoopObserver {
   }
 
   void DataReadyToWrite(common::libev::IoClient* client) override { UNUSED(client); }
+  void WriteQueueHigh(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void WriteQueueLow(common::libev::IoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
 
   void Accepted(common::libev::AsyncIoClient* client) override { UNUSED(client); }
   void Moved(common::libev::IoLoop* server, common::libev::AsyncIoClient* client) override {
@@ -221,6 +229,14 @@ class ServerWebsockHandler : public common::libev::IoLoopObserver {
     UNUSED(client);
     UNUSED(bytes_read);
   }
+  void AsyncWriteQueueHigh(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
+  void AsyncWriteQueueLow(common::libev::AsyncIoClient* client, size_t pending_bytes) override {
+    UNUSED(client);
+    UNUSED(pending_bytes);
+  }
 
   void PostLooped(common::libev::IoLoop* server) override {
     std::vector<common::libev::IoClient*> cl = server->GetClients();